@@ -39,33 +39,46 @@
                  :pb-type GameSystem$CollectionFactoryDesc}})
 
 (g/defnk produce-form-data
-  [_node-id factory-type prototype-resource load-dynamically dynamic-prototype]
+  [_node-id factory-type prototype-resource load-dynamically dynamic-prototype pool-size]
   {:form-ops {:user-data {:node-id _node-id}
               :set protobuf-forms-util/set-form-op
               :clear protobuf-forms-util/clear-form-op}
    :navigation false
    :sections [{:title (get-in factory-types [factory-type :title])
-               :fields [{:path [:prototype]
-                         :label "Prototype"
-                         :type :resource
-                         :filter (get-in factory-types [factory-type :ext])}
-                        {:path [:load-dynamically]
-                         :label "Load Dynamically"
-                         :type :boolean}
-                        {:path [:dynamic-prototype]
-                         :label "Dynamic Prototype"
-                         :type :boolean}]}]
-   :values {[:prototype] prototype-resource
-            [:load-dynamically] load-dynamically
-            [:dynamic-prototype] dynamic-prototype}})
+               :fields (cond-> [{:path [:prototype]
+                                 :label "Prototype"
+                                 :type :resource
+                                 :filter (get-in factory-types [factory-type :ext])}
+                                {:path [:load-dynamically]
+                                 :label "Load Dynamically"
+                                 :type :boolean}
+                                {:path [:dynamic-prototype]
+                                 :label "Dynamic Prototype"
+                                 :type :boolean}]
+
+                         (= :game-object factory-type)
+                         (conj {:path [:pool-size]
+                                :label "Pool Size"
+                                :type :integer}))}]
+   :values (cond-> {[:prototype] prototype-resource
+                    [:load-dynamically] load-dynamically
+                    [:dynamic-prototype] dynamic-prototype}
+
+             (= :game-object factory-type)
+             (assoc [:pool-size] pool-size))})
 
 (g/defnk produce-save-value
-  [prototype-resource load-dynamically dynamic-prototype factory-type]
+  [prototype-resource load-dynamically dynamic-prototype pool-size factory-type]
   (let [pb-class (-> factory-types factory-type :pb-type)]
-    (protobuf/make-map-without-defaults pb-class
-      :prototype (resource/resource->proj-path prototype-resource)
-      :load-dynamically load-dynamically
-      :dynamic-prototype dynamic-prototype)))
+    (cond-> (protobuf/make-map-without-defaults pb-class
+              :prototype (resource/resource->proj-path prototype-resource)
+              :load-dynamically load-dynamically
+              :dynamic-prototype dynamic-prototype)
+
+            ;; Only the game object factory has a pool size.
+            (and (= :game-object factory-type)
+                 (not= pool-size (protobuf/default GameSystem$FactoryDesc :pool-size)))
+            (assoc :pool-size pool-size))))
 
 (defn build-factory
   [resource dep-resources user-data]
@@ -99,10 +112,14 @@
   (let [pb-class (:pb-type (get factory-types factory-type))
         resolve-resource #(workspace/resolve-resource resource %)]
     (into [(g/set-property self :factory-type factory-type)]
-          (gu/set-properties-from-pb-map self pb-class any-factory-desc
-            prototype (resolve-resource :prototype)
-            load-dynamically :load-dynamically
-            dynamic-prototype :dynamic-prototype))))
+          (concat
+            (gu/set-properties-from-pb-map self pb-class any-factory-desc
+              prototype (resolve-resource :prototype)
+              load-dynamically :load-dynamically
+              dynamic-prototype :dynamic-prototype)
+            (when (= :game-object factory-type)
+              (gu/set-properties-from-pb-map self GameSystem$FactoryDesc any-factory-desc
+                pool-size :pool-size))))))
 
 ;; For these fields, we use the default from GameSystem$FactoryDesc in both
 ;; cases since we share a single defnode between two protobuf classes.
@@ -134,6 +151,10 @@
                                  {:type resource/Resource :ext (get-in factory-types [factory-type :ext])})))
   (property load-dynamically g/Bool (default (protobuf/default GameSystem$FactoryDesc :load-dynamically)))
   (property dynamic-prototype g/Bool (default (protobuf/default GameSystem$FactoryDesc :dynamic-prototype)))
+  (property pool-size g/Int (default (protobuf/default GameSystem$FactoryDesc :pool-size))
+            (dynamic visible (g/fnk [factory-type] (= :game-object factory-type)))
+            (dynamic error (g/fnk [_node-id pool-size]
+                             (validation/prop-error :fatal _node-id :pool-size validation/prop-negative? pool-size "Pool Size"))))
 
   (output form-data g/Any produce-form-data)
 
@@ -23,6 +23,7 @@
 #include <dlib/hash.h>
 #include <dlib/hashtable.h>
 #include "ddf.h"
+#include "ddf_image.h"
 #include "ddf_inputbuffer.h"
 #include "ddf_load.h"
 #include "ddf_save.h"
@@ -170,6 +171,14 @@ namespace dmDDF
         if (desc->m_MajorVersion != DDF_MAJOR_VERSION)
             return RESULT_VERSION_MISMATCH;
 
+        if (IsMessageImage(buffer, buffer_size))
+        {
+            // The pointers are already resolved when loading an image
+            if (options & OPTION_OFFSET_POINTERS)
+                return RESULT_INTERNAL_ERROR;
+            return DoLoadMessageImage(buffer, buffer_size, desc, out_message, size);
+        }
+
         LoadContext load_context(0, 0, true, options);
         Message dry_message = load_context.AllocMessage(desc);
 
@@ -176,6 +176,19 @@ namespace dmDDF
      */
     Result SaveMessageSize(const void* message, const Descriptor* desc, uint32_t* size);
 
+    /**
+     * Save message as a relocatable image. Loading an image with LoadMessage() only copies
+     * the data and fixes up the pointers, instead of decoding the message field by field.
+     * The image is only valid for the same struct layout, i.e. the same executable architecture
+     * and .proto version. LoadMessage() returns RESULT_VERSION_MISMATCH otherwise.
+     * Messages with pointer types (strings, bytes, repeated or nested fields) inside a "oneof" aren't supported.
+     * @param message Message
+     * @param desc DDF descriptor
+     * @param image Image output
+     * @return RESULT_OK on success
+     */
+    Result SaveMessageImage(const void* message, const Descriptor* desc, dmArray<uint8_t>& image);
+
     /**
      * Deep copy message
      * Use dmDDF::FreeMessage to free the message
@@ -0,0 +1,353 @@
+// Copyright 2020-2024 The Defold Foundation
+// Copyright 2014-2020 King
+// Copyright 2009-2014 Ragnar Svensson, Christian Murray
+// Licensed under the Defold License version 1.0 (the "License"); you may not use
+// this file except in compliance with the License.
+//
+// You may obtain a copy of the License, together with FAQs at
+// https://www.defold.com/license
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include <string.h>
+#include <dmsdk/dlib/static_assert.h>
+#include <dlib/hash.h>
+#include <dlib/math.h>
+#include <dlib/memory.h>
+#include <dlib/profile.h>
+#include "ddf_image.h"
+#include "ddf_util.h"
+
+namespace dmDDF
+{
+    DM_STATIC_ASSERT(sizeof(ImageHeader) == 32, Invalid_Struct_Size);
+
+    static const uint8_t IMAGE_MAGIC[4] = {'D', 'D', 'F', 'I'};
+
+    static uint32_t GetElementSize(const FieldDescriptor* field)
+    {
+        if (field->m_Type == TYPE_MESSAGE)
+            return field->m_MessageDescriptor->m_Size;
+        else if (field->m_Type == TYPE_STRING)
+            return sizeof(const char*);
+        return ScalarTypeSize(field->m_Type);
+    }
+
+    // Does the field (or any embedded message) contain pointers?
+    static bool HasPointers(const FieldDescriptor* field)
+    {
+        if (field->m_Label == LABEL_REPEATED || field->m_Type == TYPE_STRING || field->m_Type == TYPE_BYTES)
+            return true;
+        if (field->m_Type == TYPE_MESSAGE)
+        {
+            const Descriptor* desc = field->m_MessageDescriptor;
+            for (int i = 0; i < desc->m_FieldCount; ++i)
+            {
+                if (HasPointers(&desc->m_Fields[i]))
+                    return true;
+            }
+        }
+        return false;
+    }
+
+    static void HashLayout(HashState32* state, const Descriptor* desc)
+    {
+        uint32_t size = desc->m_Size;
+        uint32_t field_count = desc->m_FieldCount;
+        dmHashUpdateBuffer32(state, &desc->m_NameHash, sizeof(desc->m_NameHash));
+        dmHashUpdateBuffer32(state, &size, sizeof(size));
+        dmHashUpdateBuffer32(state, &field_count, sizeof(field_count));
+
+        for (int i = 0; i < desc->m_FieldCount; ++i)
+        {
+            const FieldDescriptor* field = &desc->m_Fields[i];
+            uint32_t values[] = {field->m_Number, field->m_Type, field->m_Label, field->m_Offset, field->m_OneOfIndex};
+            dmHashUpdateBuffer32(state, values, sizeof(values));
+
+            if (field->m_Type != TYPE_MESSAGE)
+                continue;
+
+            // Repeated messages may be recursive, but they are checked separately when the message is visited
+            if (field->m_Label == LABEL_REPEATED)
+            {
+                const Descriptor* sub_desc = field->m_MessageDescriptor;
+                uint32_t sub_size = sub_desc->m_Size;
+                dmHashUpdateBuffer32(state, &sub_desc->m_NameHash, sizeof(sub_desc->m_NameHash));
+                dmHashUpdateBuffer32(state, &sub_size, sizeof(sub_size));
+            }
+            else
+            {
+                HashLayout(state, field->m_MessageDescriptor);
+            }
+        }
+    }
+
+    uint32_t CalcLayoutHash(const Descriptor* desc)
+    {
+        HashState32 state;
+        dmHashInit32(&state, false);
+        uint32_t pointer_size = sizeof(void*);
+        dmHashUpdateBuffer32(&state, &pointer_size, sizeof(pointer_size));
+        HashLayout(&state, desc);
+        return dmHashFinal32(&state);
+    }
+
+    bool IsMessageImage(const void* buffer, uint32_t buffer_size)
+    {
+        return buffer_size >= sizeof(ImageHeader) && memcmp(buffer, IMAGE_MAGIC, sizeof(IMAGE_MAGIC)) == 0;
+    }
+
+    // ****************************************
+    // Writing
+
+    static uint32_t ImageAlloc(dmArray<uint8_t>& data, uint32_t size, uint32_t align)
+    {
+        uint32_t offset = DDFAlign(data.Size(), align);
+        uint32_t new_size = offset + size;
+        if (data.Capacity() < new_size)
+            data.OffsetCapacity(dmMath::Max(new_size - data.Capacity(), data.Capacity() / 2));
+        uint32_t old_size = data.Size();
+        data.SetSize(new_size);
+        memset(data.Begin() + old_size, 0, new_size - old_size);
+        return offset;
+    }
+
+    static void ImageSetOffset(dmArray<uint8_t>& data, uint32_t slot, uint32_t offset)
+    {
+        uintptr_t value = offset;
+        memcpy(data.Begin() + slot, &value, sizeof(value));
+    }
+
+    static uint32_t ImageWriteString(dmArray<uint8_t>& data, const char* str)
+    {
+        if (!str)
+            return 0;
+        uint32_t len = strlen(str) + 1;
+        uint32_t offset = ImageAlloc(data, len, 1);
+        memcpy(data.Begin() + offset, str, len);
+        return offset;
+    }
+
+    // The struct at 'offset' is already copied. Writes the pointed to data, and replaces the pointers with offsets
+    static Result ImageWriteMessage(dmArray<uint8_t>& data, const Descriptor* desc, const uint8_t* message, uint32_t offset)
+    {
+        for (int i = 0; i < desc->m_FieldCount; ++i)
+        {
+            const FieldDescriptor* field = &desc->m_Fields[i];
+            const uint8_t* src = message + field->m_Offset;
+            uint32_t slot = offset + field->m_Offset;
+
+            // There's no way to tell which member of a union is set
+            if (field->m_OneOfIndex != DDF_NO_ONE_OF_INDEX && HasPointers(field))
+                return RESULT_INTERNAL_ERROR;
+
+            if (field->m_Label == LABEL_REPEATED || field->m_Type == TYPE_BYTES)
+            {
+                const RepeatedField* repeated = (const RepeatedField*) src;
+                uint32_t count = repeated->m_ArrayCount;
+                if (count == 0)
+                {
+                    ImageSetOffset(data, slot, 0);
+                    continue;
+                }
+
+                uint32_t element_size = field->m_Type == TYPE_BYTES ? 1 : GetElementSize(field);
+                uint32_t array_offset = ImageAlloc(data, count * element_size, 16);
+                memcpy(data.Begin() + array_offset, (const void*) repeated->m_Array, count * element_size);
+                ImageSetOffset(data, slot, array_offset);
+
+                if (field->m_Type == TYPE_MESSAGE)
+                {
+                    for (uint32_t j = 0; j < count; ++j)
+                    {
+                        const uint8_t* element = (const uint8_t*) repeated->m_Array + j * element_size;
+                        Result r = ImageWriteMessage(data, field->m_MessageDescriptor, element, array_offset + j * element_size);
+                        if (r != RESULT_OK)
+                            return r;
+                    }
+                }
+                else if (field->m_Type == TYPE_STRING)
+                {
+                    const char** strings = (const char**) repeated->m_Array;
+                    for (uint32_t j = 0; j < count; ++j)
+                    {
+                        uint32_t str_offset = ImageWriteString(data, strings[j]);
+                        ImageSetOffset(data, array_offset + j * element_size, str_offset);
+                    }
+                }
+            }
+            else if (field->m_Type == TYPE_MESSAGE)
+            {
+                Result r = ImageWriteMessage(data, field->m_MessageDescriptor, src, slot);
+                if (r != RESULT_OK)
+                    return r;
+            }
+            else if (field->m_Type == TYPE_STRING)
+            {
+                uint32_t str_offset = ImageWriteString(data, *(const char**) src);
+                ImageSetOffset(data, slot, str_offset);
+            }
+        }
+        return RESULT_OK;
+    }
+
+    Result SaveMessageImage(const void* message, const Descriptor* desc, dmArray<uint8_t>& image)
+    {
+        image.SetSize(0);
+        uint32_t header_offset = ImageAlloc(image, sizeof(ImageHeader), 16);
+        assert(header_offset == 0);
+
+        // The data offsets are relative to the message, so we write it separately
+        dmArray<uint8_t> data;
+        data.SetCapacity(desc->m_Size * 4);
+        uint32_t root_offset = ImageAlloc(data, desc->m_Size, 16);
+        memcpy(data.Begin() + root_offset, message, desc->m_Size);
+
+        Result r = ImageWriteMessage(data, desc, (const uint8_t*) message, root_offset);
+        if (r != RESULT_OK)
+        {
+            image.SetSize(0);
+            return r;
+        }
+
+        ImageHeader header;
+        memset(&header, 0, sizeof(header));
+        memcpy(header.m_Magic, IMAGE_MAGIC, sizeof(IMAGE_MAGIC));
+        header.m_Version = IMAGE_VERSION;
+        header.m_PointerSize = sizeof(void*);
+        header.m_NameHash = desc->m_NameHash;
+        header.m_LayoutHash = CalcLayoutHash(desc);
+        header.m_DataSize = data.Size();
+        memcpy(image.Begin(), &header, sizeof(header));
+
+        if (image.Remaining() < data.Size())
+            image.OffsetCapacity(data.Size());
+        image.PushArray(data.Begin(), data.Size());
+        return RESULT_OK;
+    }
+
+    // ****************************************
+    // Loading
+
+    // Offsets are validated against the data size, and pointed to data must be placed after the struct
+    // containing the pointer. The latter guarantees that the relocation terminates, even for bad data.
+    static bool RelocateOffset(uint8_t* data, uint32_t data_size, uint32_t min_offset, uint64_t size, uint32_t align, void* slot)
+    {
+        uintptr_t offset;
+        memcpy(&offset, slot, sizeof(offset));
+        if (offset == 0)
+            return true; // null pointer
+        if (offset < min_offset || offset + size > data_size || (offset & (align - 1)) != 0)
+            return false;
+        uintptr_t ptr = (uintptr_t) data + offset;
+        memcpy(slot, &ptr, sizeof(ptr));
+        return true;
+    }
+
+    static bool RelocateString(uint8_t* data, uint32_t data_size, uint32_t min_offset, void* slot)
+    {
+        uintptr_t offset;
+        memcpy(&offset, slot, sizeof(offset));
+        if (offset == 0)
+            return true;
+        if (offset < min_offset || offset >= data_size || memchr(data + offset, 0, data_size - offset) == 0)
+            return false;
+        return RelocateOffset(data, data_size, min_offset, 1, 1, slot);
+    }
+
+    static Result RelocateMessage(uint8_t* data, uint32_t data_size, const Descriptor* desc, uint32_t offset)
+    {
+        uint32_t min_offset = offset + desc->m_Size;
+
+        for (int i = 0; i < desc->m_FieldCount; ++i)
+        {
+            const FieldDescriptor* field = &desc->m_Fields[i];
+            uint32_t slot_offset = offset + field->m_Offset;
+            void* slot = data + slot_offset;
+
+            if (field->m_Label == LABEL_REPEATED || field->m_Type == TYPE_BYTES)
+            {
+                RepeatedField* repeated = (RepeatedField*) slot;
+                uint32_t count = repeated->m_ArrayCount;
+                uint32_t element_size = field->m_Type == TYPE_BYTES ? 1 : GetElementSize(field);
+                if (count == 0)
+                {
+                    repeated->m_Array = 0;
+                    continue;
+                }
+
+                uintptr_t array_offset = repeated->m_Array;
+                if (array_offset == 0 || !RelocateOffset(data, data_size, min_offset, (uint64_t) count * element_size, 16, slot))
+                    return RESULT_WIRE_FORMAT_ERROR;
+
+                if (field->m_Type == TYPE_MESSAGE)
+                {
+                    for (uint32_t j = 0; j < count; ++j)
+                    {
+                        Result r = RelocateMessage(data, data_size, field->m_MessageDescriptor, array_offset + j * element_size);
+                        if (r != RESULT_OK)
+                            return r;
+                    }
+                }
+                else if (field->m_Type == TYPE_STRING)
+                {
+                    uint32_t strings_min_offset = array_offset + count * element_size;
+                    for (uint32_t j = 0; j < count; ++j)
+                    {
+                        if (!RelocateString(data, data_size, strings_min_offset, data + array_offset + j * element_size))
+                            return RESULT_WIRE_FORMAT_ERROR;
+                    }
+                }
+            }
+            else if (field->m_Type == TYPE_MESSAGE)
+            {
+                Result r = RelocateMessage(data, data_size, field->m_MessageDescriptor, slot_offset);
+                if (r != RESULT_OK)
+                    return r;
+            }
+            else if (field->m_Type == TYPE_STRING)
+            {
+                if (!RelocateString(data, data_size, min_offset, slot))
+                    return RESULT_WIRE_FORMAT_ERROR;
+            }
+        }
+        return RESULT_OK;
+    }
+
+    Result DoLoadMessageImage(const void* buffer, uint32_t buffer_size, const Descriptor* desc, void** out_message, uint32_t* size)
+    {
+        DM_PROFILE("DdfLoadMessageImage");
+
+        ImageHeader header;
+        memcpy(&header, buffer, sizeof(header));
+
+        if (header.m_Version != IMAGE_VERSION || header.m_PointerSize != sizeof(void*))
+            return RESULT_VERSION_MISMATCH;
+        if (header.m_NameHash != desc->m_NameHash)
+            return RESULT_FIELDTYPE_MISMATCH;
+        if (header.m_LayoutHash != CalcLayoutHash(desc))
+            return RESULT_VERSION_MISMATCH;
+        if (header.m_DataSize < desc->m_Size || header.m_DataSize > buffer_size - sizeof(ImageHeader))
+            return RESULT_WIRE_FORMAT_ERROR;
+
+        uint8_t* data = 0;
+        dmMemory::AlignedMalloc((void**)&data, 16, header.m_DataSize);
+        assert(data);
+        memcpy(data, (const uint8_t*) buffer + sizeof(ImageHeader), header.m_DataSize);
+
+        Result r = RelocateMessage(data, header.m_DataSize, desc, 0);
+        if (r != RESULT_OK)
+        {
+            dmMemory::AlignedFree(data);
+            return r;
+        }
+
+        if (size)
+            *size = header.m_DataSize;
+        *out_message = data;
+        return RESULT_OK;
+    }
+}
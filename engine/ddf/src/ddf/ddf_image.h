@@ -0,0 +1,54 @@
+// Copyright 2020-2024 The Defold Foundation
+// Copyright 2014-2020 King
+// Copyright 2009-2014 Ragnar Svensson, Christian Murray
+// Licensed under the Defold License version 1.0 (the "License"); you may not use
+// this file except in compliance with the License.
+//
+// You may obtain a copy of the License, together with FAQs at
+// https://www.defold.com/license
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#ifndef DDF_IMAGE_H
+#define DDF_IMAGE_H
+
+#include <stdint.h>
+#include "ddf.h"
+
+namespace dmDDF
+{
+    // A message image is the in-memory representation of a loaded message, where all pointers
+    // are stored as offsets from the start of the message data. Loading is a copy and a pointer fix up.
+    //
+    // Layout:
+    //   ImageHeader
+    //   message data (root struct at offset 0, followed by arrays, strings and bytes)
+    //
+    // The first byte 'D' would be a protobuf tag with wire type END_GROUP, which never starts a valid message.
+
+    const uint32_t IMAGE_VERSION = 1;
+
+    struct ImageHeader
+    {
+        uint8_t  m_Magic[4];    // "DDFI"
+        uint16_t m_Version;
+        uint8_t  m_PointerSize;
+        uint8_t  m_Reserved;
+        uint64_t m_NameHash;    // Descriptor::m_NameHash of the root message
+        uint32_t m_LayoutHash;  // See CalcLayoutHash()
+        uint32_t m_DataSize;    // Size of the message data following the header
+        uint32_t m_Pad[2];      // Keeps the message data 16 byte aligned
+    };
+
+    // Hash of the struct layout of the message, as compiled into the running executable
+    uint32_t CalcLayoutHash(const Descriptor* desc);
+
+    bool     IsMessageImage(const void* buffer, uint32_t buffer_size);
+
+    Result   DoLoadMessageImage(const void* buffer, uint32_t buffer_size, const Descriptor* desc, void** out_message, uint32_t* size);
+}
+
+#endif // DDF_IMAGE_H
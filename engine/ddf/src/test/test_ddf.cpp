@@ -22,10 +22,12 @@
 #include <jc_test/jc_test.h>
 
 #include "../ddf/ddf.h"
+#include "../ddf/ddf_image.h"
 #include <dlib/memory.h>
 #include <dlib/dstrings.h>
 #include <dlib/sys.h>
 #include <dlib/testutil.h>
+#include <dlib/time.h>
 
 /*
  * TODO:
@@ -906,6 +908,180 @@ TEST(OneOfTests, Nested)
     dmDDF::FreeMessage(message);
 }
 
+static void CreateNestedArray(TestDDF::NestedArray& pb_nested, int count1, int count2)
+{
+    pb_nested.set_d(1);
+    pb_nested.set_e(2);
+    for (int i = 0; i < count1; ++i)
+    {
+        TestDDF::NestedArraySub1* sub1 = pb_nested.add_array1();
+        sub1->set_b(i*2+0);
+        sub1->set_c(i*2+1);
+        for (int j = 0; j < count2; ++j)
+        {
+            TestDDF::NestedArraySub2* sub2 = sub1->add_array2();
+            sub2->set_a(j*10+i);
+        }
+    }
+}
+
+static void SaveImage(const std::string& pb_msg_str, const dmDDF::Descriptor* desc, dmArray<uint8_t>& image)
+{
+    void* message;
+    dmDDF::Result e = dmDDF::LoadMessage((void*) pb_msg_str.c_str(), pb_msg_str.size(), desc, &message);
+    ASSERT_EQ(dmDDF::RESULT_OK, e);
+    e = dmDDF::SaveMessageImage(message, desc, image);
+    ASSERT_EQ(dmDDF::RESULT_OK, e);
+    dmDDF::FreeMessage(message);
+}
+
+TEST(MessageImage, NestedArray)
+{
+    TestDDF::NestedArray pb_nested;
+    CreateNestedArray(pb_nested, 3, 4);
+    std::string pb_msg_str = pb_nested.SerializeAsString();
+
+    dmArray<uint8_t> image;
+    SaveImage(pb_msg_str, &DUMMY::TestDDF_NestedArray_DESCRIPTOR, image);
+
+    void* message;
+    dmDDF::Result e = dmDDF::LoadMessage(image.Begin(), image.Size(), &DUMMY::TestDDF_NestedArray_DESCRIPTOR, &message);
+    ASSERT_EQ(dmDDF::RESULT_OK, e);
+    DUMMY::TestDDF::NestedArray* nested = (DUMMY::TestDDF::NestedArray*) message;
+
+    ASSERT_EQ(pb_nested.d(), nested->m_D);
+    ASSERT_EQ(pb_nested.e(), nested->m_E);
+    ASSERT_EQ((uint32_t) pb_nested.array1_size(), nested->m_Array1.m_Count);
+    for (int i = 0; i < pb_nested.array1_size(); ++i)
+    {
+        ASSERT_EQ(pb_nested.array1(i).b(), nested->m_Array1[i].m_B);
+        ASSERT_EQ(pb_nested.array1(i).c(), nested->m_Array1[i].m_C);
+        ASSERT_EQ((uint32_t) pb_nested.array1(i).array2_size(), nested->m_Array1[i].m_Array2.m_Count);
+        for (int j = 0; j < pb_nested.array1(i).array2_size(); ++j)
+        {
+            ASSERT_EQ(pb_nested.array1(i).array2(j).a(), nested->m_Array1[i].m_Array2[j].m_A);
+        }
+    }
+
+    // The image loaded message must be identical to the decoded one
+    std::string msg_str2;
+    e = DDFSaveToString(message, &DUMMY::TestDDF_NestedArray_DESCRIPTOR, msg_str2);
+    ASSERT_EQ(dmDDF::RESULT_OK, e);
+    ASSERT_EQ(pb_msg_str, msg_str2);
+
+    dmDDF::FreeMessage(message);
+}
+
+TEST(MessageImage, Pointers)
+{
+    const char* values = "The quick brown fox";
+    const char* names[] = {"Vyvyan", "Rik", "", "Mike"};
+    TestDDF::ResolvePointers pb_msg;
+    pb_msg.set_data((uint8_t*)values, strlen(values)+1);
+    pb_msg.set_name("Bengan");
+    for (uint32_t i = 0; i < DM_ARRAY_SIZE(names); ++i)
+        pb_msg.add_names(names[i]);
+    std::string pb_msg_str = pb_msg.SerializeAsString();
+
+    dmArray<uint8_t> image;
+    SaveImage(pb_msg_str, &DUMMY::TestDDF_ResolvePointers_DESCRIPTOR, image);
+
+    DUMMY::TestDDF::ResolvePointers* msg;
+    uint32_t msg_size = 0;
+    dmDDF::Result e = dmDDF::LoadMessage(image.Begin(), image.Size(), &DUMMY::TestDDF_ResolvePointers_DESCRIPTOR, (void**)&msg, 0, &msg_size);
+    ASSERT_EQ(dmDDF::RESULT_OK, e);
+    ASSERT_EQ(image.Size() - (uint32_t) sizeof(dmDDF::ImageHeader), msg_size);
+
+    ASSERT_EQ(0U, ((uintptr_t) msg->m_Data.m_Data) & 15);
+    ASSERT_STREQ(values, (const char*) msg->m_Data.m_Data);
+    ASSERT_STREQ("Bengan", msg->m_Name);
+    ASSERT_EQ((uint32_t) DM_ARRAY_SIZE(names), msg->m_Names.m_Count);
+    for (uint32_t i = 0; i < DM_ARRAY_SIZE(names); ++i)
+        ASSERT_STREQ(names[i], msg->m_Names[i]);
+
+    dmDDF::FreeMessage(msg);
+
+    // Images are already resolved
+    e = dmDDF::LoadMessage(image.Begin(), image.Size(), &DUMMY::TestDDF_ResolvePointers_DESCRIPTOR, (void**)&msg, dmDDF::OPTION_OFFSET_POINTERS, &msg_size);
+    ASSERT_EQ(dmDDF::RESULT_INTERNAL_ERROR, e);
+}
+
+TEST(MessageImage, Invalid)
+{
+    TestDDF::NestedArray pb_nested;
+    CreateNestedArray(pb_nested, 2, 2);
+    std::string pb_msg_str = pb_nested.SerializeAsString();
+
+    dmArray<uint8_t> image;
+    SaveImage(pb_msg_str, &DUMMY::TestDDF_NestedArray_DESCRIPTOR, image);
+
+    void* message = 0;
+    dmDDF::Result e = dmDDF::LoadMessage(image.Begin(), image.Size(), &DUMMY::TestDDF_Mesh_DESCRIPTOR, &message);
+    ASSERT_EQ(dmDDF::RESULT_FIELDTYPE_MISMATCH, e);
+
+    e = dmDDF::LoadMessage(image.Begin(), image.Size() - 1, &DUMMY::TestDDF_NestedArray_DESCRIPTOR, &message);
+    ASSERT_EQ(dmDDF::RESULT_WIRE_FORMAT_ERROR, e);
+
+    dmDDF::ImageHeader* header = (dmDDF::ImageHeader*) image.Begin();
+    header->m_LayoutHash++;
+    e = dmDDF::LoadMessage(image.Begin(), image.Size(), &DUMMY::TestDDF_NestedArray_DESCRIPTOR, &message);
+    ASSERT_EQ(dmDDF::RESULT_VERSION_MISMATCH, e);
+    header->m_LayoutHash--;
+
+    // Point the array outside of the data
+    uint8_t* data = image.Begin() + sizeof(dmDDF::ImageHeader);
+    DUMMY::TestDDF::NestedArray* nested = (DUMMY::TestDDF::NestedArray*) data;
+    uintptr_t array_offset = (uintptr_t) nested->m_Array1.m_Data;
+    nested->m_Array1.m_Data = (DUMMY::TestDDF::NestedArraySub1*) (uintptr_t) header->m_DataSize;
+    e = dmDDF::LoadMessage(image.Begin(), image.Size(), &DUMMY::TestDDF_NestedArray_DESCRIPTOR, &message);
+    ASSERT_EQ(dmDDF::RESULT_WIRE_FORMAT_ERROR, e);
+
+    // Null array with elements
+    nested->m_Array1.m_Data = 0;
+    nested->m_Array1.m_Count = 1;
+    e = dmDDF::LoadMessage(image.Begin(), image.Size(), &DUMMY::TestDDF_NestedArray_DESCRIPTOR, &message);
+    ASSERT_EQ(dmDDF::RESULT_WIRE_FORMAT_ERROR, e);
+
+    nested->m_Array1.m_Data = (DUMMY::TestDDF::NestedArraySub1*) array_offset;
+    nested->m_Array1.m_Count = 2;
+    e = dmDDF::LoadMessage(image.Begin(), image.Size(), &DUMMY::TestDDF_NestedArray_DESCRIPTOR, &message);
+    ASSERT_EQ(dmDDF::RESULT_OK, e);
+    dmDDF::FreeMessage(message);
+}
+
+TEST(MessageImage, Benchmark)
+{
+    TestDDF::NestedArray pb_nested;
+    CreateNestedArray(pb_nested, 2000, 32);
+    std::string pb_msg_str = pb_nested.SerializeAsString();
+
+    dmArray<uint8_t> image;
+    SaveImage(pb_msg_str, &DUMMY::TestDDF_NestedArray_DESCRIPTOR, image);
+
+    const uint32_t iterations = 20;
+    uint64_t time_decode = 0;
+    uint64_t time_image = 0;
+    for (uint32_t i = 0; i < iterations; ++i)
+    {
+        void* message;
+        uint64_t start = dmTime::GetTime();
+        dmDDF::Result e = dmDDF::LoadMessage((void*) pb_msg_str.c_str(), pb_msg_str.size(), &DUMMY::TestDDF_NestedArray_DESCRIPTOR, &message);
+        time_decode += dmTime::GetTime() - start;
+        ASSERT_EQ(dmDDF::RESULT_OK, e);
+        dmDDF::FreeMessage(message);
+
+        start = dmTime::GetTime();
+        e = dmDDF::LoadMessage(image.Begin(), image.Size(), &DUMMY::TestDDF_NestedArray_DESCRIPTOR, &message);
+        time_image += dmTime::GetTime() - start;
+        ASSERT_EQ(dmDDF::RESULT_OK, e);
+        dmDDF::FreeMessage(message);
+    }
+
+    printf("LoadMessage: decode %.3f ms (%u bytes)  image %.3f ms (%u bytes)\n",
+            time_decode / (iterations * 1000.0), (uint32_t) pb_msg_str.size(),
+            time_image / (iterations * 1000.0), image.Size());
+}
+
 int main(int argc, char **argv)
 {
     dmDDF::RegisterAllTypes();
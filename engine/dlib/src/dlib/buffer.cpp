@@ -45,12 +45,18 @@ namespace dmBuffer
     };
     static const uint8_t GUARD_SIZE = sizeof(GUARD_VALUES);
 
+    // The number of periods of changes that are tracked. A new period starts when the changes are read,
+    // so several users reading the changes at their own pace still get the ranges, instead of the whole buffer
+    static const uint8_t DIRTY_PERIOD_COUNT = 4;
+
     struct Buffer
     {
         struct Stream
         {
             dmhash_t    m_Name;
             uint32_t    m_Offset;       // Offset from start of data segment (for non-interleaved buffers, gives ~4gb addressable space)
+            uint32_t    m_DirtyBegin[DIRTY_PERIOD_COUNT];   // The range of elements changed during each period, see Buffer::m_DirtyVersions
+            uint32_t    m_DirtyEnd[DIRTY_PERIOD_COUNT];
             uint8_t     m_ValueType;
             uint8_t     m_ValueCount;
         };
@@ -69,6 +75,9 @@ namespace dmBuffer
         uint32_t m_Stride;          // The struct size (in bytes)
         uint32_t m_Count;           // The number of "structs" in the buffer (e.g. vertex count)
         uint16_t m_ContentVersion;  // A running number, which user can use to signal content changes
+        uint16_t m_DirtyVersions[DIRTY_PERIOD_COUNT]; // The content version at the start of each tracked period
+        uint8_t  m_DirtyPeriod;     // The current period
+        uint8_t  m_DirtyPeriodCount;// The number of tracked periods
         uint8_t  m_NumStreams;
     };
 
@@ -282,6 +291,8 @@ namespace dmBuffer
             stream.m_ValueType  = decl.m_Type;
             stream.m_ValueCount = decl.m_Count;
             stream.m_Offset     = offsets[i];
+            memset(stream.m_DirtyBegin, 0, sizeof(stream.m_DirtyBegin));
+            memset(stream.m_DirtyEnd, 0, sizeof(stream.m_DirtyEnd));
         }
 
         // Write guard bytes after payload data
@@ -358,6 +369,9 @@ namespace dmBuffer
         buffer->m_Data = (void*)((uintptr_t)data_block + header_size);
         buffer->m_Stride = struct_size;
         buffer->m_ContentVersion = 0;
+        memset(buffer->m_DirtyVersions, 0, sizeof(buffer->m_DirtyVersions));
+        buffer->m_DirtyPeriod = 0;
+        buffer->m_DirtyPeriodCount = 1;
         new (&buffer->m_MetaDataArray) dmArray<Buffer::MetaData*>();
 
         CreateStreamsInterleaved(buffer, streams_decl, offsets);
@@ -591,6 +605,65 @@ namespace dmBuffer
         return RESULT_OK;
     }
 
+    static void AddDirtyRange(Buffer* buffer, Buffer::Stream* stream, uint32_t begin, uint32_t end)
+    {
+        uint8_t period = buffer->m_DirtyPeriod;
+        if (stream->m_DirtyBegin[period] == stream->m_DirtyEnd[period])
+        {
+            stream->m_DirtyBegin[period] = begin;
+            stream->m_DirtyEnd[period] = end;
+        }
+        else
+        {
+            stream->m_DirtyBegin[period] = dmMath::Min(stream->m_DirtyBegin[period], begin);
+            stream->m_DirtyEnd[period] = dmMath::Max(stream->m_DirtyEnd[period], end);
+        }
+    }
+
+    // Gets the range of elements of a stream changed since the version. Returns false if the changes aren't tracked anymore
+    static bool GetDirtyElements(const Buffer* buffer, const Buffer::Stream* stream, uint16_t since_version, uint32_t* out_begin, uint32_t* out_end)
+    {
+        uint32_t begin = 0xFFFFFFFF;
+        uint32_t end = 0;
+        uint16_t changes_since = buffer->m_ContentVersion - since_version;
+        for (uint8_t i = 0; i < buffer->m_DirtyPeriodCount; ++i)
+        {
+            uint8_t period = (buffer->m_DirtyPeriod + DIRTY_PERIOD_COUNT - i) % DIRTY_PERIOD_COUNT;
+            if (stream->m_DirtyBegin[period] != stream->m_DirtyEnd[period])
+            {
+                begin = dmMath::Min(begin, stream->m_DirtyBegin[period]);
+                end = dmMath::Max(end, stream->m_DirtyEnd[period]);
+            }
+
+            // Stop at the period during which the version was current
+            uint16_t changes_in_periods = buffer->m_ContentVersion - buffer->m_DirtyVersions[period];
+            if (changes_since <= changes_in_periods)
+            {
+                *out_begin = begin < end ? begin : 0;
+                *out_end = begin < end ? end : 0;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Starts a new period, if there were any changes during the current one
+    static void NextDirtyPeriod(Buffer* buffer)
+    {
+        if (buffer->m_DirtyVersions[buffer->m_DirtyPeriod] == buffer->m_ContentVersion) {
+            return;
+        }
+
+        uint8_t period = (buffer->m_DirtyPeriod + 1) % DIRTY_PERIOD_COUNT;
+        buffer->m_DirtyPeriod = period;
+        buffer->m_DirtyVersions[period] = buffer->m_ContentVersion;
+        buffer->m_DirtyPeriodCount = dmMath::Min((uint8_t)(buffer->m_DirtyPeriodCount + 1), DIRTY_PERIOD_COUNT);
+        for (uint8_t i = 0; i < buffer->m_NumStreams; ++i) {
+            buffer->m_Streams[i].m_DirtyBegin[period] = 0;
+            buffer->m_Streams[i].m_DirtyEnd[period] = 0;
+        }
+    }
+
     Result UpdateContentVersion(HBuffer hbuffer)
     {
         Buffer* buffer = g_BufferContext->Get(hbuffer);
@@ -598,6 +671,103 @@ namespace dmBuffer
             return RESULT_BUFFER_INVALID;
         }
         buffer->m_ContentVersion++;
+        for (uint8_t i = 0; i < buffer->m_NumStreams; ++i) {
+            AddDirtyRange(buffer, &buffer->m_Streams[i], 0, buffer->m_Count);
+        }
+        return RESULT_OK;
+    }
+
+    Result UpdateStreamContentVersion(HBuffer hbuffer, dmhash_t stream_name, uint32_t first_element, uint32_t element_count)
+    {
+        Buffer* buffer = g_BufferContext->Get(hbuffer);
+        if (!buffer) {
+            return RESULT_BUFFER_INVALID;
+        }
+
+        Buffer::Stream* stream = GetStream(buffer, stream_name);
+        if (stream == 0x0) {
+            return RESULT_STREAM_MISSING;
+        }
+
+        if (first_element > buffer->m_Count || element_count > buffer->m_Count - first_element) {
+            return RESULT_BUFFER_SIZE_ERROR;
+        }
+
+        buffer->m_ContentVersion++;
+        if (element_count > 0) {
+            AddDirtyRange(buffer, stream, first_element, first_element + element_count);
+        }
+        return RESULT_OK;
+    }
+
+    Result GetStreamDirtyRange(HBuffer hbuffer, dmhash_t stream_name, uint32_t since_version, uint32_t* out_first_element, uint32_t* out_element_count)
+    {
+        Buffer* buffer = g_BufferContext->Get(hbuffer);
+        if (!buffer) {
+            return RESULT_BUFFER_INVALID;
+        }
+
+        Buffer::Stream* stream = GetStream(buffer, stream_name);
+        if (stream == 0x0) {
+            return RESULT_STREAM_MISSING;
+        }
+
+        uint32_t begin = 0;
+        uint32_t end = 0;
+        if (buffer->m_ContentVersion != (uint16_t)since_version)
+        {
+            if (!GetDirtyElements(buffer, stream, (uint16_t)since_version, &begin, &end)) {
+                end = buffer->m_Count;
+            }
+            NextDirtyPeriod(buffer);
+        }
+        *out_first_element = begin;
+        *out_element_count = end - begin;
+        return RESULT_OK;
+    }
+
+    Result GetDirtyRange(HBuffer hbuffer, uint32_t since_version, uint32_t* out_offset, uint32_t* out_size)
+    {
+        Buffer* buffer = g_BufferContext->Get(hbuffer);
+        if (!buffer) {
+            return RESULT_BUFFER_INVALID;
+        }
+
+        *out_offset = 0;
+        *out_size = 0;
+
+        if (buffer->m_ContentVersion == (uint16_t)since_version) {
+            return RESULT_OK;
+        }
+
+        // The streams are interleaved, so the byte range spans from the first changed value
+        // of the first changed element, to the last changed value of the last changed element
+        uint32_t begin = 0xFFFFFFFF;
+        uint32_t end = 0;
+        for (uint8_t i = 0; i < buffer->m_NumStreams; ++i)
+        {
+            const Buffer::Stream& stream = buffer->m_Streams[i];
+            uint32_t first, last;
+            if (!GetDirtyElements(buffer, &stream, (uint16_t)since_version, &first, &last))
+            {
+                begin = 0;
+                end = buffer->m_Count * buffer->m_Stride;
+                break;
+            }
+            if (first == last) {
+                continue;
+            }
+            uint32_t value_size = GetSizeForValueType((ValueType)stream.m_ValueType) * stream.m_ValueCount;
+            begin = dmMath::Min(begin, first * buffer->m_Stride + stream.m_Offset);
+            end = dmMath::Max(end, (last - 1) * buffer->m_Stride + stream.m_Offset + value_size);
+        }
+
+        if (begin < end)
+        {
+            *out_offset = begin;
+            *out_size = end - begin;
+        }
+        NextDirtyPeriod(buffer);
         return RESULT_OK;
     }
 
@@ -35,6 +35,9 @@ namespace dmHttpServer
         dmSocket::Socket m_Socket;
         uint16_t         m_RequestCount;
         uint64_t         m_ConnectionTimeStart;
+        // Id of the deferred response the connection waits for, or zero
+        uint32_t         m_DeferredId;
+        uint16_t         m_CloseConnection : 1;
     };
 
     struct Server
@@ -43,6 +46,7 @@ namespace dmHttpServer
         {
             m_ServerSocket = dmSocket::INVALID_SOCKET_HANDLE;
             m_Reconnect = 0;
+            m_NextDeferredId = 1;
         }
         dmSocket::Address   m_Address;
         uint16_t            m_Port;
@@ -56,6 +60,7 @@ namespace dmHttpServer
         dmSocket::Socket    m_ServerSocket;
         // Receive and send buffer
         char                m_Buffer[BUFFER_SIZE];
+        uint32_t            m_NextDeferredId;
 
         uint32_t            m_Reconnect : 1;
     };
@@ -84,6 +89,9 @@ namespace dmHttpServer
         // Number of bytes in send buffer
         uint32_t m_SendBufferPos;
 
+        // Set by Defer()
+        uint32_t m_DeferredId;
+
         uint16_t m_CloseConnection : 1;
         uint16_t m_HeaderSent : 1;
         uint16_t m_AttributesSent : 1;
@@ -313,6 +321,27 @@ bail:
         return;
     }
 
+    static void SendResponseEnd(InternalRequest* internal_req)
+    {
+        dmSocket::Result r;
+
+        // Send headers and attributes even if no data is sent
+        if (!internal_req->m_HeaderSent)
+            SendHeader(internal_req);
+
+        if (!internal_req->m_AttributesSent)
+            SendAttributes(internal_req);
+
+        FlushSendBuffer(&internal_req->m_Request);
+
+        HTTP_SERVER_SENDALL_AND_BAIL("0\r\n\r\n")
+
+        return;
+bail:
+        internal_req->m_Result = RESULT_SOCKET_ERROR;
+        return;
+    }
+
     static void HandleReponse(void* user_data, int offset)
     {
         InternalRequest* internal_req = (InternalRequest*) user_data;
@@ -321,8 +350,6 @@ bail:
         Server* server = internal_req->m_Server;
         internal_req->m_ContentOffset = offset;
 
-        dmSocket::Result r;
-
         request->m_Method = internal_req->m_Method;
         request->m_Resource = internal_req->m_Resource;
         request->m_Internal = internal_req;
@@ -334,24 +361,14 @@ bail:
             dmLogWarning("Actual content differs from expected content-length (%d != %d)",
                     internal_req->m_TotalContentReceived,
                     internal_req->m_Request.m_ContentLength);
-            goto bail;
+            internal_req->m_Result = RESULT_SOCKET_ERROR;
+            return;
         }
 
-        // Send headers and attributes even if no data is sent
-        if (!internal_req->m_HeaderSent)
-            SendHeader(internal_req);
-
-        if (!internal_req->m_AttributesSent)
-            SendAttributes(internal_req);
-
-        FlushSendBuffer(request);
-
-        HTTP_SERVER_SENDALL_AND_BAIL("0\r\n\r\n")
-
-        return;
-bail:
-        internal_req->m_Result = RESULT_SOCKET_ERROR;
-        return;
+        if (internal_req->m_DeferredId == 0)
+        {
+            SendResponseEnd(internal_req);
+        }
     }
 
     Result SetStatusCode(const Request* request, int status_code)
@@ -367,6 +384,25 @@ bail:
         return RESULT_OK;
     }
 
+    Result Defer(const Request* request, uint32_t* id)
+    {
+        InternalRequest* internal_req = (InternalRequest*) request->m_Internal;
+        if (internal_req->m_HeaderSent)
+        {
+            dmLogError("Defer is only valid before any data is sent");
+            return RESULT_ERROR_INVAL;
+        }
+
+        Server* server = internal_req->m_Server;
+        internal_req->m_DeferredId = server->m_NextDeferredId++;
+        if (server->m_NextDeferredId == 0)
+        {
+            server->m_NextDeferredId = 1;
+        }
+        *id = internal_req->m_DeferredId;
+        return RESULT_OK;
+    }
+
     static void FlushSendBuffer(const Request* request)
     {
         InternalRequest* internal_req = (InternalRequest*) request->m_Internal;
@@ -571,7 +607,14 @@ bail:
                 break;
         }
 
-        if (internal_req.m_Result == RESULT_OK)
+        if (internal_req.m_Result == RESULT_OK && internal_req.m_DeferredId != 0)
+        {
+            // Keep the connection, and don't read the next request until the response is sent
+            connection->m_DeferredId = internal_req.m_DeferredId;
+            connection->m_CloseConnection = internal_req.m_CloseConnection;
+            return true;
+        }
+        else if (internal_req.m_Result == RESULT_OK)
         {
             return (bool) !internal_req.m_CloseConnection;
         }
@@ -581,7 +624,56 @@ bail:
         }
     }
 
+    static void CloseConnection(Server* server, uint32_t index)
+    {
+        Connection* connection = &server->m_Connections[index];
+        dmSocket::Shutdown(connection->m_Socket, dmSocket::SHUTDOWNTYPE_READWRITE);
+        dmSocket::Delete(connection->m_Socket);
+        connection->m_Socket = dmSocket::INVALID_SOCKET_HANDLE;
+        server->m_Connections.EraseSwap(index);
+    }
+
+    Result CompleteDeferred(HServer server, uint32_t id, HttpResponse response, void* user_data)
+    {
+        for (uint32_t i = 0; i < server->m_Connections.Size(); ++i)
+        {
+            Connection* connection = &server->m_Connections[i];
+            if (connection->m_DeferredId != id)
+            {
+                continue;
+            }
+            connection->m_DeferredId = 0;
+
+            InternalRequest internal_req;
+            internal_req.m_Result = RESULT_OK;
+            internal_req.m_Socket = connection->m_Socket;
+            internal_req.m_Server = server;
+            internal_req.m_CloseConnection = connection->m_CloseConnection;
+
+            Request* request = &internal_req.m_Request;
+            request->m_Method = internal_req.m_Method;
+            request->m_Resource = internal_req.m_Resource;
+            request->m_Internal = &internal_req;
+            response(user_data, request);
+
+            SendResponseEnd(&internal_req);
+
+            if (internal_req.m_Result != RESULT_OK || internal_req.m_CloseConnection)
+            {
+                CloseConnection(server, i);
+            }
+            return internal_req.m_Result;
+        }
+        // The connection was closed, or timed out
+        return RESULT_ERROR_INVAL;
+    }
+
     Result Update(HServer server)
+    {
+        return Update(server, 0);
+    }
+
+    Result Update(HServer server, int32_t timeout)
     {
         if (server->m_Reconnect)
         {
@@ -589,17 +681,55 @@ bail:
             Connect(server, server->m_Port);
             server->m_Reconnect = 0;
         }
+
+        uint64_t current_time = dmTime::GetTime();
+
+        // Iterate over persistent connections, timeout phase
+        for (uint32_t i = 0; i < server->m_Connections.Size(); ++i)
+        {
+            Connection* connection = &server->m_Connections[i];
+            uint64_t time_diff = current_time - connection->m_ConnectionTimeStart;
+            if (time_diff > server->m_ConnectionTimeout)
+            {
+                CloseConnection(server, i);
+                --i;
+            }
+        }
+
+        // Wait for new connections and requests on the persistent connections at the same time
         dmSocket::Selector selector;
         dmSocket::SelectorSet(&selector, dmSocket::SELECTOR_KIND_READ, server->m_ServerSocket);
+        for (uint32_t i = 0; i < server->m_Connections.Size(); ++i)
+        {
+            Connection* connection = &server->m_Connections[i];
+            if (connection->m_DeferredId == 0)
+            {
+                dmSocket::SelectorSet(&selector, dmSocket::SELECTOR_KIND_READ, connection->m_Socket);
+            }
+        }
 
-        dmSocket::Result r = dmSocket::Select(&selector, 0);
-
+        dmSocket::Result r = dmSocket::Select(&selector, timeout);
         if (r != dmSocket::RESULT_OK)
         {
             return RESULT_SOCKET_ERROR;
         }
 
-        // Check for new connections
+        // Iterate over persistent connections, handle phase
+        for (uint32_t i = 0; i < server->m_Connections.Size(); ++i)
+        {
+            Connection* connection = &server->m_Connections[i];
+            if (connection->m_DeferredId == 0 && dmSocket::SelectorIsSet(&selector, dmSocket::SELECTOR_KIND_READ, connection->m_Socket))
+            {
+                bool keep_connection =  HandleConnection(server, connection);
+                if (!keep_connection)
+                {
+                    CloseConnection(server, i);
+                    --i;
+                }
+            }
+        }
+
+        // Check for new connections. Their requests are served in the next update
         if (dmSocket::SelectorIsSet(&selector, dmSocket::SELECTOR_KIND_READ, server->m_ServerSocket))
         {
             dmSocket::Address address;
@@ -628,54 +758,6 @@ bail:
                 server->m_Reconnect = 1;
             }
         }
-
-        dmSocket::SelectorZero(&selector);
-
-        uint64_t current_time = dmTime::GetTime();
-
-        // Iterate over persistent connections, timeout phase
-        for (uint32_t i = 0; i < server->m_Connections.Size(); ++i)
-        {
-            Connection* connection = &server->m_Connections[i];
-            uint64_t time_diff = current_time - connection->m_ConnectionTimeStart;
-            if (time_diff > server->m_ConnectionTimeout)
-            {
-                dmSocket::Shutdown(connection->m_Socket, dmSocket::SHUTDOWNTYPE_READWRITE);
-                dmSocket::Delete(connection->m_Socket);
-                connection->m_Socket = dmSocket::INVALID_SOCKET_HANDLE;
-                server->m_Connections.EraseSwap(i);
-                --i;
-            }
-        }
-
-        // Iterate over persistent connections, select phase
-        for (uint32_t i = 0; i < server->m_Connections.Size(); ++i)
-        {
-            Connection* connection = &server->m_Connections[i];
-            dmSocket::SelectorSet(&selector, dmSocket::SELECTOR_KIND_READ, connection->m_Socket);
-        }
-
-        r = dmSocket::Select(&selector, 0);
-        if (r != dmSocket::RESULT_OK)
-            return RESULT_SOCKET_ERROR;
-
-        // Iterate over persistent connections, handle phase
-        for (uint32_t i = 0; i < server->m_Connections.Size(); ++i)
-        {
-            Connection* connection = &server->m_Connections[i];
-            if (dmSocket::SelectorIsSet(&selector, dmSocket::SELECTOR_KIND_READ, connection->m_Socket))
-            {
-                bool keep_connection =  HandleConnection(server, connection);
-                if (!keep_connection)
-                {
-                    dmSocket::Shutdown(connection->m_Socket, dmSocket::SHUTDOWNTYPE_READWRITE);
-                    dmSocket::Delete(connection->m_Socket);
-                    connection->m_Socket = dmSocket::INVALID_SOCKET_HANDLE;
-                    server->m_Connections.EraseSwap(i);
-                    --i;
-                }
-            }
-        }
         return RESULT_OK;
     }
 
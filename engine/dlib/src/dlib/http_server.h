@@ -158,6 +158,29 @@ namespace dmHttpServer
      */
     Result Receive(const Request* request, void* buffer, uint32_t buffer_size, uint32_t* received_bytes);
 
+    /**
+     * Defer the response to a request. The response is sent later, with #CompleteDeferred.
+     * The connection isn't read from until then, so responses are sent in order.
+     * @note Only valid to invoke from the #HttpResponse callback, after all content is received
+     * and before any data is sent
+     * @param request Request
+     * @param id Id of the deferred response [out]
+     * @return RESULT_OK on success
+     */
+    Result Defer(const Request* request, uint32_t* id);
+
+    /**
+     * Send a deferred response. The callback is invoked to send the response, in the same way
+     * as the #HttpResponse callback. The request in the callback has no method, resource or content.
+     * @note Must be invoked from the same thread as #Update
+     * @param server Http server instance
+     * @param id Id of the deferred response, see #Defer
+     * @param response Callback that sends the response
+     * @param user_data User data passed to the callback
+     * @return RESULT_OK on success. RESULT_ERROR_INVAL if the connection has been closed
+     */
+    Result CompleteDeferred(HServer server, uint32_t id, HttpResponse response, void* user_data);
+
     /**
      * Delete http server instance
      * @param server Http server instance handle
@@ -171,6 +194,14 @@ namespace dmHttpServer
      */
     Result Update(HServer server);
 
+    /**
+     * Update http server, and wait for new connections or requests if there are none
+     * @param server Http server instance
+     * @param timeout Max time to wait, in microseconds
+     * @return RESULT_OK on success
+     */
+    Result Update(HServer server, int32_t timeout);
+
     /**
      * Get name for socket, ie address and port
      * @param server Http server instance
@@ -63,6 +63,8 @@ struct JobContext
     dmArray<dmThread::Thread> m_Threads;
 #endif
     JobThreadContext    m_ThreadContext;
+    // The completed items, copied in Update(). Keeps its capacity between updates
+    dmArray<JobItem>    m_Items;
 };
 
 static void PutWork(JobThreadContext* ctx, const JobItem* item)
@@ -208,14 +210,16 @@ void Update(HContext context)
 
     // Lock for as little as possible, by copying the items to an array owned by this thread
     uint32_t size;
-    dmArray<JobItem> items;
+    dmArray<JobItem>& items = context->m_Items;
 
     {
 #if defined(DM_HAS_THREADS)
         DM_MUTEX_SCOPED_LOCK(context->m_ThreadContext.m_Mutex);
 #endif
         size = context->m_ThreadContext.m_Done.Size();
-        items.SetCapacity(size);
+        if (items.Capacity() < size)
+            items.SetCapacity(size);
+        items.SetSize(0);
 
         for(uint32_t i = 0; i < size; ++i)
             items.Push(context->m_ThreadContext.m_Done[i]);
@@ -24,8 +24,9 @@
 #include "profile/profile.h"
 #include "socket.h"
 #include "spinlock.h"
-#include "message.h"
+#include "mutex.h"
 #include "thread.h"
+#include "align.h"
 #include "math.h"
 #include "time.h"
 #include "path.h"
@@ -59,27 +60,74 @@ struct dmLogConnection
 };
 
 static const uint32_t DLIB_MAX_LOG_CONNECTIONS = 16;
+static const uint32_t LOG_BATCH_SIZE = 16 * 1024;
+static const uint32_t LOG_MIN_BUFFER_SIZE = 16 * 1024;
+static const uint32_t LOG_RECORD_ALIGNMENT = 8;
+
+// Header of a record in the ring buffer, followed by a LogMessage.
+// The state is set last by the producer, and the log thread clears
+// the memory of consumed records before handing it back to the producers.
+// NOTE: dmAtomicStore32 is only an acquire barrier, so the state and the
+// read cursor are published with dmAtomicAdd32 (full barrier) instead.
+struct LogRecord
+{
+    enum State
+    {
+        STATE_PENDING = 0,
+        STATE_MESSAGE = 1,
+        STATE_PADDING = 2,
+    };
+
+    int32_atomic_t m_State;
+    uint32_t       m_Size; // Including the header
+};
+
+// Multiple producer, single consumer ring buffer of log records.
+// The cursors are free running and wrap at 2^32
+struct LogRingBuffer
+{
+    char*          m_Buffer;
+    uint32_t       m_Size; // Power of two
+    int32_atomic_t m_Write;
+    int32_atomic_t m_Read;
+};
 
 struct dmLogServer
 {
-    dmLogServer(dmSocket::Socket server_socket, uint16_t port,
-                 dmMessage::HSocket message_socket)
+    dmLogServer(dmSocket::Socket server_socket, uint16_t port)
     {
         m_Connections.SetCapacity(DLIB_MAX_LOG_CONNECTIONS);
         m_ServerSocket = server_socket;
         m_Port = port;
-        m_MessageSocket = message_socket;
         m_Thread = 0;
+        m_FileMutex = dmMutex::New();
+        memset(&m_Ring, 0, sizeof(m_Ring));
+        m_BatchSize = 0;
+        m_DroppedReported = 0;
+        m_Run = 1;
+    }
+
+    ~dmLogServer()
+    {
+        delete[] m_Ring.m_Buffer;
+        dmMutex::Delete(m_FileMutex);
     }
 
     dmArray<dmLogConnection> m_Connections;
     dmSocket::Socket         m_ServerSocket;
     uint16_t                 m_Port;
-    dmMessage::HSocket       m_MessageSocket;
     dmThread::Thread         m_Thread;
+    dmMutex::HMutex          m_FileMutex; // Protects the log file while the log thread writes to it
+    LogRingBuffer            m_Ring;
+    char                     m_Batch[LOG_BATCH_SIZE];
+    uint32_t                 m_BatchSize;
+    uint32_t                 m_DroppedReported;
+    int32_atomic_t           m_Run;
 };
 
 static int32_atomic_t g_LogServerInitialized = 0;
+static int32_atomic_t g_LogWriters = 0;  // Number of threads currently pushing to the ring buffer
+static int32_atomic_t g_LogDropped = 0;
 static dmSpinlock::Spinlock g_LogServerLock;
 static dmLogServer* g_dmLogServer = 0;
 static LogSeverity g_LogLevel = LOG_SEVERITY_USER_DEBUG;
@@ -320,7 +368,10 @@ static void DoLogPlatform(LogSeverity severity, const char* output, int output_l
 #elif !defined(ANDROID)
         fwrite(output, 1, output_len, stderr);
 #endif
+}
 
+static void WriteLogFile(const char* output, int output_len)
+{
     if (dmLog::g_LogFile && dmLog::g_TotalBytesLogged < dmLog::MAX_LOG_FILE_SIZE) {
         dmLog::g_TotalBytesLogged += output_len;
         fwrite(output, 1, output_len, dmLog::g_LogFile);
@@ -328,6 +379,14 @@ static void DoLogPlatform(LogSeverity severity, const char* output, int output_l
     }
 }
 
+// Errors are written to the log file on the calling thread, so that they aren't lost if the
+// application crashes before the next log thread update. They may end up in the file ahead of
+// less severe messages that are still waiting in the ring buffer.
+static inline bool IsWrittenSynchronously(LogSeverity severity)
+{
+    return severity >= LOG_SEVERITY_ERROR;
+}
+
 // Here we put logging that needs to be thread safe
 // We either push it on the logger thread, or from the main thread if threads aren't supported (e.g. html5)
 static void DoLogSynchronized(LogSeverity severity, const char* domain, const char* output, int output_len)
@@ -343,96 +402,188 @@ static void DoLogSynchronized(LogSeverity severity, const char* domain, const ch
     dmProfile::LogText("%s", output);
 }
 
-static void dmLogDispatch(dmMessage::Message *message, void* user_ptr)
+static void InitRingBuffer(LogRingBuffer* ring, uint32_t size)
 {
-    dmLogServer* server = g_dmLogServer;
+    ring->m_Size = LOG_MIN_BUFFER_SIZE;
+    while (ring->m_Size < size)
+        ring->m_Size <<= 1;
+    ring->m_Buffer = new char[ring->m_Size];
+    memset(ring->m_Buffer, 0, ring->m_Size);
+    dmAtomicStore32(&ring->m_Write, 0);
+    dmAtomicStore32(&ring->m_Read, 0);
+}
 
-    bool* run = (bool*) user_ptr;
-    LogMessage* log_message = (LogMessage*) &message->m_Data[0];
-    if (log_message->m_Type == LogMessage::SHUTDOWN)
+// Returns 0 if the ring buffer is full
+static LogRecord* RingReserve(LogRingBuffer* ring, uint32_t size)
+{
+    const uint32_t mask = ring->m_Size - 1;
+    while (true)
     {
-        *run = false;
-        return;
-    }
+        uint32_t write = (uint32_t) dmAtomicGet32(&ring->m_Write);
+        uint32_t read = (uint32_t) dmAtomicGet32(&ring->m_Read);
+        uint32_t offset = write & mask;
 
-    int msg_len = (int) strlen(log_message->m_Message);
-    DoLogSynchronized((LogSeverity)log_message->m_Severity, log_message->m_Domain, log_message->m_Message, msg_len);
+        // A record is never split, so a too small tail is skipped with a padding record
+        uint32_t padding = (offset + size > ring->m_Size) ? ring->m_Size - offset : 0;
+        if (write + padding + size - read > ring->m_Size)
+            return 0;
 
-    // NOTE: Keep i as signed! See --i below after EraseSwap
-    int n = 0;
+        if ((uint32_t) dmAtomicCompareStore32(&ring->m_Write, (int32_t) (write + padding + size), (int32_t) write) != write)
+            continue; // Another thread reserved in between
+
+        if (padding)
+        {
+            LogRecord* pad = (LogRecord*) &ring->m_Buffer[offset];
+            pad->m_Size = padding;
+            dmAtomicAdd32(&pad->m_State, LogRecord::STATE_PADDING);
+        }
+        return (LogRecord*) &ring->m_Buffer[(write + padding) & mask];
+    }
+}
+
+static void PushMessage(dmLogServer* server, LogSeverity severity, const char* domain, const char* output, int output_len)
+{
+    uint32_t size = (uint32_t) DM_ALIGN(sizeof(LogRecord) + sizeof(LogMessage) + output_len + 1, LOG_RECORD_ALIGNMENT);
+    LogRecord* record = RingReserve(&server->m_Ring, size);
+    if (!record)
     {
-        DM_SPINLOCK_SCOPED_LOCK(dmLog::g_LogServerLock);
-        if (!dmLog::IsServerInitialized())
-            return; // The log system may have been shut down in between
-        n = (int) server->m_Connections.Size();
+        dmAtomicIncrement32(&g_LogDropped);
+        return;
     }
 
+    record->m_Size = size;
+    LogMessage* msg = (LogMessage*) (record + 1);
+    msg->m_Severity = (uint8_t) severity;
+    dmStrlCpy(msg->m_Domain, domain, sizeof(msg->m_Domain));
+    memcpy(msg->m_Message, output, output_len);
+    msg->m_Message[output_len] = '\0';
+    dmAtomicAdd32(&record->m_State, LogRecord::STATE_MESSAGE);
+}
+
+static void dmLogSend(dmLogServer* server, const char* buffer, int length)
+{
+    // The connections are only modified on the log thread
+    // NOTE: Keep i as signed! See --i below after EraseSwap
+    int n = (int) server->m_Connections.Size();
     for (int i = 0; i < n; ++i)
     {
-        dmLogConnection* c = 0;
-        dmSocket::Socket socket = dmSocket::INVALID_SOCKET_HANDLE;
+        dmSocket::Socket socket = server->m_Connections[i].m_Socket;
+        dmSocket::Result r = SendAll(socket, buffer, length);
+        if (r != dmSocket::RESULT_OK)
         {
-            DM_SPINLOCK_SCOPED_LOCK(dmLog::g_LogServerLock);
-            if (!dmLog::IsServerInitialized())
-                return; // The log system may have been shut down in between
-            c = &server->m_Connections[i];
-            socket = c->m_Socket;
-        }
+            dmSocket::Shutdown(socket, dmSocket::SHUTDOWNTYPE_READWRITE);
+            dmSocket::Delete(socket);
 
-        dmSocket::Result r;
-        int sent_bytes;
-        int total_sent = 0;
-        do
-        {
-            r = dmSocket::Send(socket, log_message->m_Message + total_sent, msg_len - total_sent, &sent_bytes);
-            if (r == dmSocket::RESULT_OK)
             {
-                total_sent += sent_bytes;
+                DM_SPINLOCK_SCOPED_LOCK(dmLog::g_LogServerLock);
+                server->m_Connections.EraseSwap(i);
             }
-            else if (r == dmSocket::RESULT_TRY_AGAIN)
-            {
-                // Ok
-            }
-            else
-            {
-                dmSocket::Shutdown(socket, dmSocket::SHUTDOWNTYPE_READWRITE);
-                dmSocket::Delete(socket);
 
-                {
-                    DM_SPINLOCK_SCOPED_LOCK(dmLog::g_LogServerLock);
-                    if (!dmLog::IsServerInitialized())
-                        return; // The log system may have been shut down in between
-                    c->m_Socket = dmSocket::INVALID_SOCKET_HANDLE;
-                    server->m_Connections.EraseSwap(i);
-                }
+            --n;
+            --i;
+        }
+    }
+}
 
-                --n;
-                --i;
-                break;
-            }
-        } while (total_sent < msg_len);
+static void dmLogFlush(dmLogServer* server)
+{
+    if (server->m_BatchSize == 0)
+        return;
+
+    if (dLib::IsDebugMode())
+    {
+        DM_MUTEX_SCOPED_LOCK(server->m_FileMutex);
+        WriteLogFile(server->m_Batch, server->m_BatchSize);
     }
+
+    dmLogSend(server, server->m_Batch, server->m_BatchSize);
+    server->m_BatchSize = 0;
+}
+
+static void dmLogDispatch(dmLogServer* server, LogSeverity severity, const char* domain, const char* output, int output_len, bool write_file)
+{
+    DoLogSynchronized(severity, domain, output, output_len);
+
+    if (!write_file)
+    {
+        // Already in the log file, keep the order of the messages sent to the connections
+        dmLogFlush(server);
+        dmLogSend(server, output, output_len);
+        return;
+    }
+
+    if (server->m_BatchSize + output_len > LOG_BATCH_SIZE)
+        dmLogFlush(server);
+    memcpy(&server->m_Batch[server->m_BatchSize], output, output_len);
+    server->m_BatchSize += output_len;
+}
+
+// Dispatches the messages in the ring buffer, and writes them to the log file
+// and the connections in batches
+static void dmLogDrain(dmLogServer* server)
+{
+    LogRingBuffer* ring = &server->m_Ring;
+    const uint32_t mask = ring->m_Size - 1;
+    uint32_t read = (uint32_t) dmAtomicGet32(&ring->m_Read);
+    uint32_t write = (uint32_t) dmAtomicGet32(&ring->m_Write);
+    while (read != write)
+    {
+        LogRecord* record = (LogRecord*) &ring->m_Buffer[read & mask];
+        int32_t state = dmAtomicGet32(&record->m_State);
+        if (state == LogRecord::STATE_PENDING)
+            break; // Still being written, we'll get it in the next update
+
+        uint32_t size = record->m_Size;
+        if (state == LogRecord::STATE_MESSAGE)
+        {
+            LogMessage* msg = (LogMessage*) (record + 1);
+            LogSeverity severity = (LogSeverity) msg->m_Severity;
+            dmLogDispatch(server, severity, msg->m_Domain, msg->m_Message, (int) strlen(msg->m_Message), !IsWrittenSynchronously(severity));
+        }
+
+        memset(record, 0, size);
+        read += size;
+        dmAtomicAdd32(&ring->m_Read, (int32_t) size);
+    }
+
+    uint32_t dropped = (uint32_t) dmAtomicGet32(&g_LogDropped);
+    if (dropped != server->m_DroppedReported)
+    {
+        char buf[128];
+        int n = dmSnPrintf(buf, sizeof(buf), "WARNING:DLIB: Log buffer full, %u messages dropped\n", dropped - server->m_DroppedReported);
+        server->m_DroppedReported = dropped;
+        if (dLib::IsDebugMode())
+        {
+            DoLogPlatform(LOG_SEVERITY_WARNING, buf, n);
+        }
+        dmLogDispatch(server, LOG_SEVERITY_WARNING, "DLIB", buf, n, true);
+    }
+
+    dmLogFlush(server);
 }
 
 static void dmLogThread(void* args)
 {
-    dmLogServer* server = g_dmLogServer;
+    dmLogServer* server = (dmLogServer*) args;
 
-    volatile bool run = true;
-    while (run)
+    while (dmAtomicGet32(&server->m_Run))
     {
-        // NOTE: We have support for blocking dispatch in dmMessage
-        // but we have to wait for both new messages and on sockets.
-        // Currently no support for that and hence the sleep here
+        // NOTE: The messages pile up in the ring buffer in between updates,
+        // so that the file and the connections are written to once per update.
+        // There is no way to wait for both new messages and on sockets, hence the sleep here
         dmTime::Sleep(1000 * 30);
         dmLogUpdateNetwork();
-        dmMessage::Dispatch(server->m_MessageSocket, dmLogDispatch, (void*) &run);
+        dmLogDrain(server);
     }
+
+    // The messages logged before the shutdown
+    dmLogDrain(server);
 }
 
 void LogInitialize(const LogParams* params)
 {
     g_TotalBytesLogged = 0;
+    dmAtomicStore32(&g_LogDropped, 0);
 
     if (dmAtomicGet32(&g_LogServerInitialized) != 0)
     {
@@ -455,33 +606,21 @@ void LogInitialize(const LogParams* params)
         }
     }
 
-    dmMessage::HSocket message_socket = 0;
-    dmMessage::Result mr;
-
-    mr = dmMessage::NewSocket("@log", &message_socket);
-    if (mr != dmMessage::RESULT_OK)
-    {
-        fprintf(stderr, "ERROR:DLIB: Unable to create @log message socket\n");
-        if (message_socket != 0)
-            dmMessage::DeleteSocket(message_socket);
-        if (server_socket != dmSocket::INVALID_SOCKET_HANDLE)
-            dmSocket::Delete(server_socket);
-        return;
-    }
+    dmAtomicStore32(&g_ListenersCount, 0);
+    dmSpinlock::Create(&g_ListenerLock);
 
-    dmLogServer* server = new dmLogServer(server_socket, port, message_socket);
+    dmLogServer* server = new dmLogServer(server_socket, port);
     g_dmLogServer = server;
 
     server->m_Thread = 0;
     if(dLib::FeaturesSupported(DM_FEATURE_BIT_SOCKET_SERVER_TCP)) // e.g. Emscripten doesn't support it
     {
-        server->m_Thread = dmThread::New(dmLogThread, 0x80000, 0, "log");
+        InitRingBuffer(&server->m_Ring, params->m_BufferSize);
+        server->m_Thread = dmThread::New(dmLogThread, 0x80000, server, "log");
     }
 
-    dmAtomicStore32(&g_LogServerInitialized, 1);
-
-    dmAtomicStore32(&g_ListenersCount, 0);
-    dmSpinlock::Create(&g_ListenerLock);
+    // Full barrier, as the server is read without a lock when logging
+    dmAtomicAdd32(&g_LogServerInitialized, 1);
 
     /*
      * This message is parsed by editor 2 - don't remove or change without
@@ -508,17 +647,15 @@ void LogFinalize()
 
     dmLogServer* self = g_dmLogServer;
 
-    LogMessage msg;
-    msg.m_Type = LogMessage::SHUTDOWN;
-    dmMessage::URL receiver;
-    receiver.m_Socket = self->m_MessageSocket;
-    receiver.m_Path = 0;
-    receiver.m_Fragment = 0;
-    dmMessage::Post(0, &receiver, 0, 0, 0, &msg, sizeof(msg), 0);
+    // Make sure we have control of the context. Full barrier, so that no new writer
+    // can miss the flag before g_LogWriters is read below
+    dmAtomicAdd32(&g_LogServerInitialized, -1);
 
-    // Make sure we have control of the context
-    dmAtomicStore32(&g_LogServerInitialized, 0);
+    // Wait for the messages currently being pushed, so that the log thread can write them before exiting
+    while (dmAtomicGet32(&g_LogWriters) != 0)
+        dmTime::Sleep(100);
 
+    dmAtomicStore32(&self->m_Run, 0);
     if (self->m_Thread)
         dmThread::Join(self->m_Thread);
 
@@ -540,11 +677,6 @@ void LogFinalize()
             self->m_ServerSocket = dmSocket::INVALID_SOCKET_HANDLE;
         }
 
-        if (self->m_MessageSocket != 0)
-        {
-            dmMessage::DeleteSocket(self->m_MessageSocket);
-        }
-
         delete self;
         g_dmLogServer = 0;
         CloseLogFile();
@@ -562,13 +694,25 @@ uint16_t GetPort()
     return g_dmLogServer->m_Port;
 }
 
+uint32_t GetDroppedCount()
+{
+    return (uint32_t) dmAtomicGet32(&g_LogDropped);
+}
+
 bool SetLogFile(const char* path)
 {
-    if (g_LogFile) {
-        fclose(g_LogFile);
-        g_LogFile = 0;
+    FILE* file = fopen(path, "wb");
+    {
+        // While the server is running, the log file is written to from the log thread
+        dmMutex::HMutex mutex = IsServerInitialized() ? g_dmLogServer->m_FileMutex : 0;
+        if (mutex)
+            dmMutex::Lock(mutex);
+        if (g_LogFile)
+            fclose(g_LogFile);
+        g_LogFile = file;
+        if (mutex)
+            dmMutex::Unlock(mutex);
     }
-    g_LogFile = fopen(path, "wb");
     if (g_LogFile) {
         dmLogInfo("Writing log to: %s", path);
     } else {
@@ -654,9 +798,7 @@ void LogInternal(LogSeverity severity, const char* domain, const char* format, .
             break;
     }
 
-    char tmp_buf[sizeof(dmLog::LogMessage) + dmLog::MAX_STRING_SIZE];
-    dmLog::LogMessage* msg = (dmLog::LogMessage*) &tmp_buf[0];
-    char* str_buf = &tmp_buf[sizeof(dmLog::LogMessage)];
+    char str_buf[dmLog::MAX_STRING_SIZE];
 
     int n = 0;
     n += dmSnPrintf(str_buf + n, dmLog::MAX_STRING_SIZE - n, "%s:%s: ", severity_str, domain);
@@ -687,39 +829,47 @@ void LogInternal(LogSeverity severity, const char* domain, const char* format, .
         dmLog::DoLogPlatform(severity, str_buf, actual_n);
     }
 
-    if (!dmLog::IsServerInitialized()) // in case the server lock isn't even created
-        return;
+    // Keeps the log system from shutting down until we're done
+    dmAtomicIncrement32(&dmLog::g_LogWriters);
 
-    // Make sure we have the lock, so that the log system cannot shut down in between
-    DM_SPINLOCK_SCOPED_LOCK(dmLog::g_LogServerLock);
     if (!dmLog::IsServerInitialized())
-        return; // The log system may have been shut down in between
-
-    dmLog::dmLogServer* server = dmLog::g_dmLogServer;
-    if (!server->m_Thread) // e.g. Emscripten
     {
-        dmLog::DoLogSynchronized(severity, domain, str_buf, actual_n);
+        if (is_debug_mode)
+        {
+            dmLog::WriteLogFile(str_buf, actual_n);
+        }
     }
-
-    if(!dLib::FeaturesSupported(DM_FEATURE_BIT_SOCKET_SERVER_TCP)) // e.g. Emscripten
-        return;
-
-    if (dmThread::GetCurrentThread() == server->m_Thread)
+    else
     {
-        // Due to the recursive nature, we're not allowed make new dmLogXxx calls from the dispatch thread
-        // However, we may call the print functions
-        return;
+        dmLog::dmLogServer* server = dmLog::g_dmLogServer;
+        if (!server->m_Thread) // e.g. Emscripten
+        {
+            dmLog::DoLogSynchronized(severity, domain, str_buf, actual_n);
+            if (is_debug_mode)
+            {
+                dmLog::WriteLogFile(str_buf, actual_n);
+            }
+        }
+        else if (dmThread::GetCurrentThread() == server->m_Thread)
+        {
+            // Due to the recursive nature, we're not allowed make new dmLogXxx calls from the log thread
+            // However, we may call the print functions
+            if (is_debug_mode)
+            {
+                DM_MUTEX_SCOPED_LOCK(server->m_FileMutex);
+                dmLog::WriteLogFile(str_buf, actual_n);
+            }
+        }
+        else
+        {
+            if (is_debug_mode && dmLog::IsWrittenSynchronously(severity))
+            {
+                DM_MUTEX_SCOPED_LOCK(server->m_FileMutex);
+                dmLog::WriteLogFile(str_buf, actual_n);
+            }
+            dmLog::PushMessage(server, severity, domain, str_buf, actual_n);
+        }
     }
 
-    if (server)
-    {
-        msg->m_Type = dmLog::LogMessage::MESSAGE;
-        msg->m_Severity = severity;
-        dmStrlCpy(msg->m_Domain, domain, sizeof(msg->m_Domain));
-        dmMessage::URL receiver;
-        receiver.m_Socket = server->m_MessageSocket;
-        receiver.m_Path = 0;
-        receiver.m_Fragment = 0;
-        dmMessage::Post(0, &receiver, 0, 0, 0, msg, dmMath::Min(sizeof(dmLog::LogMessage) + actual_n + 1, sizeof(tmp_buf)), 0);
-    }
+    dmAtomicDecrement32(&dmLog::g_LogWriters);
 }
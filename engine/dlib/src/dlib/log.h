@@ -39,24 +39,26 @@ namespace dmLog
 
 struct LogMessage
 {
-    enum Type
-    {
-        MESSAGE = 0,
-        SHUTDOWN = 1,
-    };
-
-    uint8_t m_Type:2;
-    uint8_t m_Severity:6;
+    uint8_t m_Severity;
     char    m_Domain[15];
     char    m_Message[0];
 };
 
 const uint32_t MAX_STRING_SIZE = dmMessage::DM_MESSAGE_MAX_DATA_SIZE - sizeof(LogMessage);
+
+/**
+ * Log parameters
+ * @member m_BufferSize Size in bytes of the ring buffer of pending log messages. Rounded up to a power of two.
+ *                      Messages logged while the buffer is full are dropped and counted.
+ */
 struct LogParams
 {
     LogParams()
     {
+        m_BufferSize = 256 * 1024;
     }
+
+    uint32_t m_BufferSize;
 };
 
 /**
@@ -78,9 +80,19 @@ void LogFinalize();
  */
 uint16_t GetPort();
 
+/**
+ * Get the number of log messages dropped since the log system was initialized,
+ * due to the log buffer being full
+ * @return number of dropped messages
+ */
+uint32_t GetDroppedCount();
+
 /**
  * Set log file. The file will be created and truncated.
  * Subsequent invocations to this function will close previous opened file.
+ * While the log server is running, messages are written to the file from the log thread
+ * in batches. Errors and fatal errors are written immediately, so they may appear ahead
+ * of less severe messages logged just before them.
  * If the file can't be created a message will be logged to the "console"
  * @param path log path
  * @return true if file successfully created.
@@ -14,11 +14,36 @@
 
 #include "memory.h"
 #include "dalloca.h"
+#include "align.h"
+#include "atomic.h"
+#include "math.h"
+#include "static_assert.h"
+#include <assert.h>
+#include <string.h>
 #include <stdlib.h>
 #include <errno.h>
 #if defined(__ANDROID__) || defined(_MSC_VER)
 #include <malloc.h>
 #endif
+#include <dlib/profile/profile.h>
+
+DM_PROPERTY_GROUP(rmtp_MemoryTags, "Memory per subsystem");
+DM_PROPERTY_U32(rmtp_MemoryGameObject, 0, FrameReset, "kb", &rmtp_MemoryTags);
+DM_PROPERTY_U32(rmtp_MemoryGameObjectCount, 0, FrameReset, "# allocations", &rmtp_MemoryTags);
+DM_PROPERTY_U32(rmtp_MemoryGameSys, 0, FrameReset, "kb", &rmtp_MemoryTags);
+DM_PROPERTY_U32(rmtp_MemoryGameSysCount, 0, FrameReset, "# allocations", &rmtp_MemoryTags);
+DM_PROPERTY_U32(rmtp_MemoryRender, 0, FrameReset, "kb", &rmtp_MemoryTags);
+DM_PROPERTY_U32(rmtp_MemoryRenderCount, 0, FrameReset, "# allocations", &rmtp_MemoryTags);
+DM_PROPERTY_U32(rmtp_MemoryResource, 0, FrameReset, "kb", &rmtp_MemoryTags);
+DM_PROPERTY_U32(rmtp_MemoryResourceCount, 0, FrameReset, "# allocations", &rmtp_MemoryTags);
+DM_PROPERTY_U32(rmtp_MemoryScript, 0, FrameReset, "kb", &rmtp_MemoryTags);
+DM_PROPERTY_U32(rmtp_MemoryScriptCount, 0, FrameReset, "# allocations", &rmtp_MemoryTags);
+DM_PROPERTY_U32(rmtp_MemorySound, 0, FrameReset, "kb", &rmtp_MemoryTags);
+DM_PROPERTY_U32(rmtp_MemorySoundCount, 0, FrameReset, "# allocations", &rmtp_MemoryTags);
+DM_PROPERTY_U32(rmtp_MemoryPhysics, 0, FrameReset, "kb", &rmtp_MemoryTags);
+DM_PROPERTY_U32(rmtp_MemoryPhysicsCount, 0, FrameReset, "# allocations", &rmtp_MemoryTags);
+DM_PROPERTY_U32(rmtp_MemoryFrame, 0, FrameReset, "kb", &rmtp_MemoryTags);
+DM_PROPERTY_U32(rmtp_MemoryFrameHighWater, 0, FrameReset, "kb", &rmtp_MemoryTags);
 
 namespace dmMemory
 {
@@ -66,4 +91,299 @@ namespace dmMemory
         #error "dmMemory::AlignedFree not implemented for this platform."
 #endif
     }
+
+    // Prepended to each tagged allocation. The size is a multiple of 16 in order
+    // to keep the alignment of the memory returned by malloc
+    struct AllocationHeader
+    {
+        uint32_t m_Size;
+        uint32_t m_Tag;
+        uint32_t m_Pad[2];
+    };
+
+    DM_STATIC_ASSERT(sizeof(AllocationHeader) == 16, Invalid_Struct_Size);
+
+    struct TagCounters
+    {
+        int32_atomic_t m_LiveBytes;
+        int32_atomic_t m_LiveCount;
+        int32_atomic_t m_TotalCount;
+    };
+
+    static TagCounters g_TagCounters[MAX_TAG_COUNT];
+
+    static const char* TAG_NAMES[MAX_TAG_COUNT] =
+    {
+        "gameobject",
+        "gamesys",
+        "render",
+        "resource",
+        "script",
+        "sound",
+        "physics",
+        "frame",
+    };
+
+    void* Malloc(Tag tag, uint32_t size)
+    {
+        assert(tag < MAX_TAG_COUNT);
+        AllocationHeader* header = (AllocationHeader*) malloc(sizeof(AllocationHeader) + size);
+        if (!header)
+        {
+            return 0;
+        }
+        header->m_Size = size;
+        header->m_Tag = (uint32_t) tag;
+
+        TagCounters* counters = &g_TagCounters[tag];
+        dmAtomicAdd32(&counters->m_LiveBytes, (int32_t) size);
+        dmAtomicIncrement32(&counters->m_LiveCount);
+        dmAtomicIncrement32(&counters->m_TotalCount);
+        return header + 1;
+    }
+
+    void* Realloc(Tag tag, void* memory, uint32_t size)
+    {
+        if (!memory)
+        {
+            return Malloc(tag, size);
+        }
+
+        AllocationHeader* header = ((AllocationHeader*) memory) - 1;
+        assert(header->m_Tag == (uint32_t) tag);
+        uint32_t old_size = header->m_Size;
+
+        header = (AllocationHeader*) realloc(header, sizeof(AllocationHeader) + size);
+        if (!header)
+        {
+            return 0;
+        }
+        header->m_Size = size;
+
+        TagCounters* counters = &g_TagCounters[tag];
+        dmAtomicAdd32(&counters->m_LiveBytes, (int32_t) (size - old_size));
+        dmAtomicIncrement32(&counters->m_TotalCount);
+        return header + 1;
+    }
+
+    void Free(Tag tag, void* memory)
+    {
+        if (!memory)
+        {
+            return;
+        }
+
+        AllocationHeader* header = ((AllocationHeader*) memory) - 1;
+        assert(header->m_Tag == (uint32_t) tag);
+
+        TagCounters* counters = &g_TagCounters[tag];
+        dmAtomicSub32(&counters->m_LiveBytes, (int32_t) header->m_Size);
+        dmAtomicDecrement32(&counters->m_LiveCount);
+        free(header);
+    }
+
+    void GetTagStats(Tag tag, TagStats* stats)
+    {
+        assert(tag < MAX_TAG_COUNT);
+        TagCounters* counters = &g_TagCounters[tag];
+        stats->m_LiveBytes  = (uint32_t) dmAtomicGet32(&counters->m_LiveBytes);
+        stats->m_LiveCount  = (uint32_t) dmAtomicGet32(&counters->m_LiveCount);
+        stats->m_TotalCount = (uint32_t) dmAtomicGet32(&counters->m_TotalCount);
+    }
+
+    const char* GetTagName(Tag tag)
+    {
+        assert(tag < MAX_TAG_COUNT);
+        return TAG_NAMES[tag];
+    }
+
+    void UpdateProfileProperties()
+    {
+        TagStats stats[MAX_TAG_COUNT];
+        for (uint32_t i = 0; i < MAX_TAG_COUNT; ++i)
+        {
+            GetTagStats((Tag) i, &stats[i]);
+        }
+
+        DM_PROPERTY_SET_U32(rmtp_MemoryGameObject, stats[TAG_GAMEOBJECT].m_LiveBytes / 1024);
+        DM_PROPERTY_SET_U32(rmtp_MemoryGameObjectCount, stats[TAG_GAMEOBJECT].m_LiveCount);
+        DM_PROPERTY_SET_U32(rmtp_MemoryGameSys, stats[TAG_GAMESYS].m_LiveBytes / 1024);
+        DM_PROPERTY_SET_U32(rmtp_MemoryGameSysCount, stats[TAG_GAMESYS].m_LiveCount);
+        DM_PROPERTY_SET_U32(rmtp_MemoryRender, stats[TAG_RENDER].m_LiveBytes / 1024);
+        DM_PROPERTY_SET_U32(rmtp_MemoryRenderCount, stats[TAG_RENDER].m_LiveCount);
+        DM_PROPERTY_SET_U32(rmtp_MemoryResource, stats[TAG_RESOURCE].m_LiveBytes / 1024);
+        DM_PROPERTY_SET_U32(rmtp_MemoryResourceCount, stats[TAG_RESOURCE].m_LiveCount);
+        DM_PROPERTY_SET_U32(rmtp_MemoryScript, stats[TAG_SCRIPT].m_LiveBytes / 1024);
+        DM_PROPERTY_SET_U32(rmtp_MemoryScriptCount, stats[TAG_SCRIPT].m_LiveCount);
+        DM_PROPERTY_SET_U32(rmtp_MemorySound, stats[TAG_SOUND].m_LiveBytes / 1024);
+        DM_PROPERTY_SET_U32(rmtp_MemorySoundCount, stats[TAG_SOUND].m_LiveCount);
+        DM_PROPERTY_SET_U32(rmtp_MemoryPhysics, stats[TAG_PHYSICS].m_LiveBytes / 1024);
+        DM_PROPERTY_SET_U32(rmtp_MemoryPhysicsCount, stats[TAG_PHYSICS].m_LiveCount);
+        DM_PROPERTY_SET_U32(rmtp_MemoryFrame, stats[TAG_FRAME].m_LiveBytes / 1024);
+        DM_PROPERTY_SET_U32(rmtp_MemoryFrameHighWater, GetFrameHighWaterMark() / 1024);
+    }
+
+    // The data of the block follows the header
+    struct ArenaBlock
+    {
+        ArenaBlock* m_Next; // Previously filled block
+        uint32_t    m_Size;
+        uint32_t    m_Used;
+    };
+
+    struct Arena
+    {
+        ArenaBlock* m_Block; // Current block
+        Tag         m_Tag;
+        uint32_t    m_Used;
+        uint32_t    m_Capacity;
+    };
+
+    static inline uint8_t* GetBlockData(ArenaBlock* block)
+    {
+        return (uint8_t*) (block + 1);
+    }
+
+    static ArenaBlock* NewArenaBlock(Arena* arena, uint32_t size)
+    {
+        ArenaBlock* block = (ArenaBlock*) Malloc(arena->m_Tag, sizeof(ArenaBlock) + size);
+        assert(block);
+        block->m_Next = 0;
+        block->m_Size = size;
+        block->m_Used = 0;
+        arena->m_Capacity += size;
+        return block;
+    }
+
+    static void DeleteArenaBlocks(Arena* arena)
+    {
+        ArenaBlock* block = arena->m_Block;
+        while (block)
+        {
+            ArenaBlock* next = block->m_Next;
+            Free(arena->m_Tag, block);
+            block = next;
+        }
+        arena->m_Block = 0;
+        arena->m_Capacity = 0;
+    }
+
+    HArena NewArena(Tag tag, uint32_t block_size)
+    {
+        Arena* arena = new Arena;
+        arena->m_Tag = tag;
+        arena->m_Used = 0;
+        arena->m_Capacity = 0;
+        arena->m_Block = NewArenaBlock(arena, block_size);
+        return arena;
+    }
+
+    void DeleteArena(HArena arena)
+    {
+        DeleteArenaBlocks(arena);
+        delete arena;
+    }
+
+    void* ArenaAlloc(HArena arena, uint32_t size, uint32_t alignment)
+    {
+        assert(alignment > 0 && (alignment & (alignment - 1)) == 0);
+
+        // NOTE: The alignment must be as wide as the pointer for DM_ALIGN to keep the upper bits
+        const uintptr_t align = alignment;
+        ArenaBlock* block = arena->m_Block;
+        uintptr_t data = (uintptr_t) GetBlockData(block);
+        uintptr_t ptr = DM_ALIGN(data + block->m_Used, align);
+        if (ptr + size > data + block->m_Size)
+        {
+            // Grow geometrically, so that a growing arena needs few blocks before the next reset merges them
+            uint32_t new_size = dmMath::Max(block->m_Size * 2, size + alignment);
+            ArenaBlock* new_block = NewArenaBlock(arena, new_size);
+            new_block->m_Next = block;
+            arena->m_Block = block = new_block;
+            data = (uintptr_t) GetBlockData(block);
+            ptr = DM_ALIGN(data, align);
+        }
+
+        block->m_Used = (uint32_t) (ptr + size - data);
+        arena->m_Used += size;
+        return (void*) ptr;
+    }
+
+    void ResetArena(HArena arena)
+    {
+        if (arena->m_Block->m_Next)
+        {
+            uint32_t capacity = arena->m_Capacity;
+            DeleteArenaBlocks(arena);
+            arena->m_Block = NewArenaBlock(arena, capacity);
+        }
+        arena->m_Block->m_Used = 0;
+        arena->m_Used = 0;
+    }
+
+    uint32_t GetArenaUsed(HArena arena)
+    {
+        return arena->m_Used;
+    }
+
+    uint32_t GetArenaCapacity(HArena arena)
+    {
+        return arena->m_Capacity;
+    }
+
+    // Initial size of each of the frame arenas
+    static const uint32_t FRAME_ARENA_BLOCK_SIZE = 64 * 1024;
+
+    struct FrameAllocator
+    {
+        HArena   m_Arenas[2];
+        uint32_t m_Current;
+        uint32_t m_HighWaterMark;
+    };
+
+    static FrameAllocator g_FrameAllocator;
+
+    void* FrameAlloc(uint32_t size, uint32_t alignment)
+    {
+        FrameAllocator* allocator = &g_FrameAllocator;
+        if (!allocator->m_Arenas[0])
+        {
+            allocator->m_Arenas[0] = NewArena(TAG_FRAME, FRAME_ARENA_BLOCK_SIZE);
+            allocator->m_Arenas[1] = NewArena(TAG_FRAME, FRAME_ARENA_BLOCK_SIZE);
+            allocator->m_Current = 0;
+        }
+        return ArenaAlloc(allocator->m_Arenas[allocator->m_Current], size, alignment);
+    }
+
+    void EndFrame()
+    {
+        FrameAllocator* allocator = &g_FrameAllocator;
+        if (!allocator->m_Arenas[0])
+        {
+            return;
+        }
+
+        uint32_t used = GetArenaUsed(allocator->m_Arenas[allocator->m_Current]);
+        allocator->m_HighWaterMark = dmMath::Max(allocator->m_HighWaterMark, used);
+
+        // The memory of the frame that just ended stays valid during the next frame
+        allocator->m_Current ^= 1;
+        ResetArena(allocator->m_Arenas[allocator->m_Current]);
+    }
+
+    uint32_t GetFrameHighWaterMark()
+    {
+        return g_FrameAllocator.m_HighWaterMark;
+    }
+
+    void DeleteFrameAllocator()
+    {
+        FrameAllocator* allocator = &g_FrameAllocator;
+        if (allocator->m_Arenas[0])
+        {
+            DeleteArena(allocator->m_Arenas[0]);
+            DeleteArena(allocator->m_Arenas[1]);
+        }
+        memset(allocator, 0, sizeof(*allocator));
+    }
 }
@@ -15,6 +15,169 @@
 #ifndef DM_MEMORY_H
 #define DM_MEMORY_H
 
+#include <stdint.h>
 #include <dmsdk/dlib/memory.h>
 
+namespace dmMemory
+{
+    /**
+     * Memory tags. Each engine subsystem allocates with its own tag,
+     * so that the live memory can be accounted for per subsystem.
+     */
+    enum Tag
+    {
+        TAG_GAMEOBJECT  = 0,
+        TAG_GAMESYS     = 1,
+        TAG_RENDER      = 2,
+        TAG_RESOURCE    = 3,
+        TAG_SCRIPT      = 4,
+        TAG_SOUND       = 5,
+        TAG_PHYSICS     = 6,
+        TAG_FRAME       = 7,
+        MAX_TAG_COUNT
+    };
+
+    /**
+     * Memory statistics of a tag
+     * @member m_LiveBytes Number of bytes currently allocated
+     * @member m_LiveCount Number of allocations currently alive
+     * @member m_TotalCount Total number of allocations made (wraps around)
+     */
+    struct TagStats
+    {
+        uint32_t m_LiveBytes;
+        uint32_t m_LiveCount;
+        uint32_t m_TotalCount;
+    };
+
+    /**
+     * Allocate memory accounted for by a tag. The memory has the same alignment as memory from malloc.
+     * Thread safe.
+     * @param tag the tag
+     * @param size size in bytes
+     * @return pointer to the memory, or 0 if out of memory
+     */
+    void* Malloc(Tag tag, uint32_t size);
+
+    /**
+     * Reallocate memory allocated with dmMemory::Malloc. Similar to realloc.
+     * Thread safe.
+     * @param tag the tag the memory was allocated with
+     * @param memory memory to reallocate, or 0
+     * @param size new size in bytes
+     * @return pointer to the memory, or 0 if out of memory
+     */
+    void* Realloc(Tag tag, void* memory, uint32_t size);
+
+    /**
+     * Free memory allocated with dmMemory::Malloc or dmMemory::Realloc.
+     * Thread safe.
+     * @param tag the tag the memory was allocated with
+     * @param memory memory to free, or 0
+     */
+    void Free(Tag tag, void* memory);
+
+    /**
+     * Get the memory statistics of a tag
+     * @param tag the tag
+     * @param stats [out] the statistics
+     */
+    void GetTagStats(Tag tag, TagStats* stats);
+
+    /**
+     * Get the name of a tag
+     * @param tag the tag
+     * @return the name, e.g. "gameobject"
+     */
+    const char* GetTagName(Tag tag);
+
+    /**
+     * Update the memory profile properties, i.e. the live bytes and allocation count of each tag.
+     * Should be called once per frame from the main thread.
+     */
+    void UpdateProfileProperties();
+
+    /**
+     * Arena handle. A linear (bump) allocator for short lived scratch memory, e.g. per frame.
+     * Individual allocations are not freeable, instead all memory is released at once with ResetArena().
+     * Not thread safe.
+     */
+    typedef struct Arena* HArena;
+
+    /**
+     * Create a new arena
+     * @param tag the tag the arena memory is accounted for with
+     * @param block_size initial size in bytes of the arena memory
+     * @return arena handle
+     */
+    HArena NewArena(Tag tag, uint32_t block_size);
+
+    /**
+     * Delete an arena and free all of its memory
+     * @param arena arena handle
+     */
+    void DeleteArena(HArena arena);
+
+    /**
+     * Allocate memory from an arena. If the current block is full, a new block is allocated.
+     * @param arena arena handle
+     * @param size size in bytes
+     * @param alignment alignment in bytes. Must be a power of two
+     * @return pointer to the memory
+     */
+    void* ArenaAlloc(HArena arena, uint32_t size, uint32_t alignment = 16);
+
+    /**
+     * Release all memory allocated from the arena. If the arena had to grow since the last reset,
+     * the blocks are merged into one block large enough for all of it, so that the arena
+     * stops allocating from the heap once the usage is stable.
+     * @param arena arena handle
+     */
+    void ResetArena(HArena arena);
+
+    /**
+     * Get the number of bytes allocated from the arena since the last reset
+     * @param arena arena handle
+     * @return number of bytes
+     */
+    uint32_t GetArenaUsed(HArena arena);
+
+    /**
+     * Get the number of bytes reserved by the arena
+     * @param arena arena handle
+     * @return number of bytes
+     */
+    uint32_t GetArenaCapacity(HArena arena);
+
+    /**
+     * Allocate per frame scratch memory. The memory is valid until the end of the next frame, i.e. until
+     * EndFrame() has been called twice, and is never freed individually.
+     * The frame allocator is double buffered arenas, created on first use.
+     * Not thread safe, only use it from the main thread.
+     * @note Only use it from code that runs in the engine frame loop. The memory is only released
+     * by EndFrame(), and without it the arenas grow without bound.
+     * @param size size in bytes
+     * @param alignment alignment in bytes. Must be a power of two
+     * @return pointer to the memory
+     */
+    void* FrameAlloc(uint32_t size, uint32_t alignment = 16);
+
+    /**
+     * End the frame. Updates the high-water mark and releases the memory allocated with FrameAlloc()
+     * during the previous frame. Called once per frame by the engine.
+     */
+    void EndFrame();
+
+    /**
+     * Get the largest number of bytes allocated with FrameAlloc() during a single frame
+     * @return number of bytes
+     */
+    uint32_t GetFrameHighWaterMark();
+
+    /**
+     * Free all memory held by the frame allocator. Any memory from FrameAlloc() is invalid afterwards.
+     */
+    void DeleteFrameAllocator();
+}
+
 #endif // DM_MEMORY_H
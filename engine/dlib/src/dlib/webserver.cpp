@@ -18,25 +18,56 @@
 #include "log.h"
 #include "hashtable.h"
 #include "array.h"
+#include "math.h"
 #include "dstrings.h"
+#include "mutex.h"
+#include "thread.h"
+#include "time.h"
 #include "webserver.h"
 #include "http_server.h"
 
 namespace dmWebServer
 {
+    const uint32_t THREAD_STACK_SIZE = 0x20000;
+    // Max time the server thread waits for new requests, in microseconds
+    const int32_t THREAD_SELECT_TIMEOUT = 50 * 1000;
+    // Max time to wait while there are responses from the main thread to send
+    const int32_t THREAD_DEFERRED_SELECT_TIMEOUT = 1000;
+
     struct HandlerData
     {
         void*   m_Userdata;
         Handler m_Handler;
         char    m_Prefix[64];
+        bool    m_ThreadSafe;
     };
 
     struct Server;
 
+    // A request for a handler that isn't thread safe, on a threaded server.
+    // The server thread records the request and queues it. The handler is invoked
+    // from Update(), and the response is recorded and sent by the server thread
+    struct PendingRequest
+    {
+        uint32_t                    m_DeferredId;
+        char                        m_Method[16];
+        char                        m_Resource[128];
+        dmHashTable32<const char*>  m_Headers;
+        char                        m_StringBuffer[1024];
+        dmArray<char>               m_Content;
+        uint32_t                    m_ContentOffset;
+
+        int                         m_StatusCode;
+        // Attributes as null-terminated key and value pairs
+        dmArray<char>               m_Attributes;
+        dmArray<char>               m_Data;
+    };
+
     struct InternalRequest
     {
         Server*                      m_Server;
         const dmHttpServer::Request* m_Request;
+        PendingRequest*              m_Pending;
     };
 
     struct Server
@@ -44,6 +75,10 @@ namespace dmWebServer
         Server()
         {
             m_StringBytesAllocated = 0;
+            m_Thread = 0;
+            m_Mutex = 0;
+            m_DeferredCount = 0;
+            m_Run = false;
         }
 
         dmHttpServer::HServer       m_HttpServer;
@@ -51,6 +86,20 @@ namespace dmWebServer
         dmHashTable32<const char*>  m_Headers;
         char                        m_StringBuffer[1024];
         uint32_t                    m_StringBytesAllocated;
+
+        // Guards the handlers, and the queues when the server is threaded
+        dmMutex::HMutex             m_Mutex;
+        dmThread::Thread            m_Thread;
+        // Requests waiting for Update()
+        dmArray<PendingRequest*>    m_Pending;
+        // Requests handled in Update(), waiting to be sent
+        dmArray<PendingRequest*>    m_Completed;
+        // Only used by Update() and the server thread respectively
+        dmArray<PendingRequest*>    m_Handling;
+        dmArray<PendingRequest*>    m_Sending;
+        // Number of queued requests, only used by the server thread
+        uint32_t                    m_DeferredCount;
+        volatile bool               m_Run;
     };
 
     static void ResetHeadersTable(Server* server)
@@ -87,6 +136,7 @@ namespace dmWebServer
         memset(params, 0, sizeof(*params));
         params->m_MaxConnections = 16;
         params->m_ConnectionTimeout = 60;
+        params->m_Threaded = false;
     }
 
     static Result TranslateResult(dmHttpServer::Result r)
@@ -115,37 +165,162 @@ namespace dmWebServer
         AddHeader(server, key, value);
     }
 
-    void HttpResponse(void* user_data, const dmHttpServer::Request* request)
+    static bool FindHandler(Server* server, const char* resource, HandlerData* handler_out)
     {
-        Server* server = (Server*) user_data;
-
+        DM_MUTEX_SCOPED_LOCK(server->m_Mutex);
         dmArray<HandlerData>& handlers = server->m_Handlers;
         uint32_t n = handlers.Size();
-        HandlerData* handler = 0;
         for (uint32_t i = 0; i < n; ++i)
         {
             HandlerData* h = &handlers[i];
 
-            if (strncmp(request->m_Resource, h->m_Prefix, strlen(h->m_Prefix)) == 0)
+            if (strncmp(resource, h->m_Prefix, strlen(h->m_Prefix)) == 0)
             {
-                handler = h;
-                break;
+                *handler_out = *h;
+                return true;
             }
         }
+        return false;
+    }
 
-        if (handler)
+    static void PushRequest(dmArray<PendingRequest*>& queue, PendingRequest* pending)
+    {
+        if (queue.Full())
         {
-            InternalRequest internal_request;
-            internal_request.m_Server = server;
-            internal_request.m_Request = request;
+            queue.OffsetCapacity(16);
+        }
+        queue.Push(pending);
+    }
 
-            Request web_request;
-            web_request.m_Method = request->m_Method;
-            web_request.m_Resource = request->m_Resource;
-            web_request.m_ContentLength = request->m_ContentLength;
-            web_request.m_Internal = &internal_request;
+    struct CopyHeadersContext
+    {
+        PendingRequest* m_Pending;
+        const char*     m_StringBuffer;
+    };
+
+    static void CopyHeader(CopyHeadersContext* context, const uint32_t* key, const char** value)
+    {
+        PendingRequest* pending = context->m_Pending;
+        pending->m_Headers.Put(*key, pending->m_StringBuffer + (*value - context->m_StringBuffer));
+    }
+
+    // Called on the server thread. Records the request and queues it for Update()
+    static void QueueRequest(Server* server, const dmHttpServer::Request* request)
+    {
+        PendingRequest* pending = new PendingRequest;
+        dmStrlCpy(pending->m_Method, request->m_Method, sizeof(pending->m_Method));
+        dmStrlCpy(pending->m_Resource, request->m_Resource, sizeof(pending->m_Resource));
+        pending->m_ContentOffset = 0;
+        pending->m_StatusCode = 0;
+
+        // The header values point into the string buffer, so they point into the copy of it
+        memcpy(pending->m_StringBuffer, server->m_StringBuffer, server->m_StringBytesAllocated);
+        pending->m_Headers.SetCapacity(63, dmMath::Max(1U, server->m_Headers.Size()));
+        CopyHeadersContext context;
+        context.m_Pending = pending;
+        context.m_StringBuffer = server->m_StringBuffer;
+        server->m_Headers.Iterate(CopyHeader, &context);
+
+        // The content is read here, since the connection is only read on the server thread
+        if (request->m_ContentLength > 0)
+        {
+            pending->m_Content.SetCapacity(request->m_ContentLength);
+            pending->m_Content.SetSize(request->m_ContentLength);
+            uint32_t received = 0;
+            dmHttpServer::Result r = dmHttpServer::Receive(request, pending->m_Content.Begin(), request->m_ContentLength, &received);
+            if (r != dmHttpServer::RESULT_OK)
+            {
+                delete pending;
+                return;
+            }
+        }
 
-            handler->m_Handler(handler->m_Userdata, &web_request);
+        if (dmHttpServer::Defer(request, &pending->m_DeferredId) != dmHttpServer::RESULT_OK)
+        {
+            delete pending;
+            dmHttpServer::SetStatusCode(request, 500);
+            return;
+        }
+
+        DM_MUTEX_SCOPED_LOCK(server->m_Mutex);
+        PushRequest(server->m_Pending, pending);
+        server->m_DeferredCount++;
+    }
+
+    // Sends the response recorded by a request handled on the main thread
+    static void SendRecordedResponse(void* user_data, const dmHttpServer::Request* request)
+    {
+        PendingRequest* pending = (PendingRequest*) user_data;
+
+        if (pending->m_StatusCode != 0)
+        {
+            dmHttpServer::SetStatusCode(request, pending->m_StatusCode);
+        }
+
+        const char* attribute = pending->m_Attributes.Begin();
+        const char* attributes_end = pending->m_Attributes.End();
+        while (attribute < attributes_end)
+        {
+            const char* value = attribute + strlen(attribute) + 1;
+            dmHttpServer::SendAttribute(request, attribute, value);
+            attribute = value + strlen(value) + 1;
+        }
+
+        dmHttpServer::Send(request, pending->m_Data.Begin(), pending->m_Data.Size());
+    }
+
+    static void SendCompleted(Server* server)
+    {
+        {
+            DM_MUTEX_SCOPED_LOCK(server->m_Mutex);
+            server->m_Sending.Swap(server->m_Completed);
+        }
+
+        for (uint32_t i = 0; i < server->m_Sending.Size(); ++i)
+        {
+            PendingRequest* pending = server->m_Sending[i];
+            dmHttpServer::CompleteDeferred(server->m_HttpServer, pending->m_DeferredId, SendRecordedResponse, pending);
+            delete pending;
+        }
+        server->m_DeferredCount -= server->m_Sending.Size();
+        server->m_Sending.SetSize(0);
+    }
+
+    static void DeleteRequests(dmArray<PendingRequest*>& queue)
+    {
+        for (uint32_t i = 0; i < queue.Size(); ++i)
+        {
+            delete queue[i];
+        }
+        queue.SetSize(0);
+    }
+
+    void HttpResponse(void* user_data, const dmHttpServer::Request* request)
+    {
+        Server* server = (Server*) user_data;
+
+        HandlerData handler;
+        if (FindHandler(server, request->m_Resource, &handler))
+        {
+            if (server->m_Thread && !handler.m_ThreadSafe)
+            {
+                QueueRequest(server, request);
+            }
+            else
+            {
+                InternalRequest internal_request;
+                internal_request.m_Server = server;
+                internal_request.m_Request = request;
+                internal_request.m_Pending = 0;
+
+                Request web_request;
+                web_request.m_Method = request->m_Method;
+                web_request.m_Resource = request->m_Resource;
+                web_request.m_ContentLength = request->m_ContentLength;
+                web_request.m_Internal = &internal_request;
+
+                handler.m_Handler(handler.m_Userdata, &web_request);
+            }
         }
         else
         {
@@ -158,6 +333,24 @@ namespace dmWebServer
         ResetHeadersTable(server);
     }
 
+    static void ServerThread(void* arg)
+    {
+        Server* server = (Server*) arg;
+        while (server->m_Run)
+        {
+            // Thread safe handlers are served while requests wait for the main thread,
+            // but wake up often enough to send their responses soon after Update()
+            int32_t timeout = server->m_DeferredCount > 0 ? THREAD_DEFERRED_SELECT_TIMEOUT : THREAD_SELECT_TIMEOUT;
+            dmHttpServer::Result r = dmHttpServer::Update(server->m_HttpServer, timeout);
+            if (r != dmHttpServer::RESULT_OK)
+            {
+                // Avoid spinning if the sockets are in a bad state
+                dmTime::Sleep(THREAD_SELECT_TIMEOUT);
+            }
+            SendCompleted(server);
+        }
+    }
+
     Result New(const NewParams* params, HServer* server_out)
     {
         *server_out = 0;
@@ -180,14 +373,30 @@ namespace dmWebServer
         }
 
         server->m_HttpServer = http_server;
+        server->m_Mutex = dmMutex::New();
         ResetHeadersTable(server);
+
+        if (params->m_Threaded && dmThread::PlatformHasThreadSupport())
+        {
+            server->m_Run = true;
+            server->m_Thread = dmThread::New(ServerThread, THREAD_STACK_SIZE, server, "webserver");
+        }
+
         *server_out = server;
         return RESULT_OK;
     }
 
     void Delete(HServer server)
     {
+        if (server->m_Thread)
+        {
+            server->m_Run = false;
+            dmThread::Join(server->m_Thread);
+            DeleteRequests(server->m_Pending);
+            DeleteRequests(server->m_Completed);
+        }
         dmHttpServer::Delete(server->m_HttpServer);
+        dmMutex::Delete(server->m_Mutex);
         delete server;
     }
 
@@ -207,10 +416,9 @@ namespace dmWebServer
         return 0;
     }
 
-    Result AddHandler(HServer server,
-                      const char* prefix,
-                      const HandlerParams* handler_params)
+    static Result AddHandler(HServer server, const char* prefix, const HandlerParams* handler_params, bool thread_safe)
     {
+        DM_MUTEX_SCOPED_LOCK(server->m_Mutex);
         if (GetHandler(server, prefix))
         {
             return RESULT_HANDLER_ALREADY_REGISTRED;
@@ -223,12 +431,26 @@ namespace dmWebServer
         handler.m_Userdata = handler_params->m_Userdata;
         handler.m_Handler = handler_params->m_Handler;
         dmStrlCpy(handler.m_Prefix, prefix, sizeof(handler.m_Prefix));
+        handler.m_ThreadSafe = thread_safe;
         server->m_Handlers.Push(handler);
         return RESULT_OK;
     }
 
+    Result AddHandler(HServer server,
+                      const char* prefix,
+                      const HandlerParams* handler_params)
+    {
+        return AddHandler(server, prefix, handler_params, false);
+    }
+
+    Result AddThreadSafeHandler(HServer server, const char* prefix, const HandlerParams* handler_params)
+    {
+        return AddHandler(server, prefix, handler_params, true);
+    }
+
     Result RemoveHandler(HServer server, const char* prefix)
     {
+        DM_MUTEX_SCOPED_LOCK(server->m_Mutex);
         dmArray<HandlerData>& handlers = server->m_Handlers;
         uint32_t n = handlers.Size();
         for (uint32_t i = 0; i < n; ++i)
@@ -247,6 +469,18 @@ namespace dmWebServer
     Result SetStatusCode(Request* request, int status_code)
     {
         InternalRequest* internal_request = (InternalRequest*) request->m_Internal;
+        PendingRequest* pending = internal_request->m_Pending;
+        if (pending)
+        {
+            if (pending->m_Attributes.Size() > 0 || pending->m_Data.Size() > 0)
+            {
+                dmLogError("Set status code is only valid before any data is sent");
+                return RESULT_ERROR_INVAL;
+            }
+            pending->m_StatusCode = status_code;
+            return RESULT_OK;
+        }
+
         dmHttpServer::Result r = dmHttpServer::SetStatusCode(internal_request->m_Request, status_code);
         return TranslateResult(r);
     }
@@ -255,7 +489,8 @@ namespace dmWebServer
     {
         uint32_t name_hash = dmHashBufferNoReverse32(name, strlen(name));
         InternalRequest* internal_request = (InternalRequest*) request->m_Internal;
-        const char** value = internal_request->m_Server->m_Headers.Get(name_hash);
+        PendingRequest* pending = internal_request->m_Pending;
+        const char** value = pending ? pending->m_Headers.Get(name_hash) : internal_request->m_Server->m_Headers.Get(name_hash);
         if (value)
         {
             return *value;
@@ -266,9 +501,25 @@ namespace dmWebServer
         }
     }
 
+    static void DeferredAppend(dmArray<char>& buffer, const void* data, uint32_t data_length)
+    {
+        uint32_t left = buffer.Capacity() - buffer.Size();
+        if (left < data_length)
+        {
+            buffer.OffsetCapacity((int32_t) dmMath::Max(data_length - left, dmMath::Max(buffer.Capacity(), 4U * 1024U)));
+        }
+        buffer.PushArray((const char*) data, data_length);
+    }
+
     Result Send(Request* request, const void* data, uint32_t data_length)
     {
         InternalRequest* internal_request = (InternalRequest*) request->m_Internal;
+        if (internal_request->m_Pending)
+        {
+            DeferredAppend(internal_request->m_Pending->m_Data, data, data_length);
+            return RESULT_OK;
+        }
+
         dmHttpServer::Result r = dmHttpServer::Send(internal_request->m_Request, data, data_length);
         return TranslateResult(r);
     }
@@ -276,14 +527,77 @@ namespace dmWebServer
     Result Receive(Request* request, void* buffer, uint32_t buffer_size, uint32_t* received_bytes)
     {
         InternalRequest* internal_request = (InternalRequest*) request->m_Internal;
+        PendingRequest* pending = internal_request->m_Pending;
+        if (pending)
+        {
+            // The content was received by the server thread
+            uint32_t to_copy = dmMath::Min(buffer_size, pending->m_Content.Size() - pending->m_ContentOffset);
+            memcpy(buffer, pending->m_Content.Begin() + pending->m_ContentOffset, to_copy);
+            pending->m_ContentOffset += to_copy;
+            *received_bytes = to_copy;
+            return RESULT_OK;
+        }
+
         dmHttpServer::Result r = dmHttpServer::Receive(internal_request->m_Request, buffer, buffer_size, received_bytes);
         return TranslateResult(r);
     }
 
     Result Update(HServer server)
     {
-        dmHttpServer::Result r = dmHttpServer::Update(server->m_HttpServer);
-        return TranslateResult(r);
+        if (!server->m_Thread)
+        {
+            dmHttpServer::Result r = dmHttpServer::Update(server->m_HttpServer);
+            return TranslateResult(r);
+        }
+
+        dmArray<PendingRequest*>& handling = server->m_Handling;
+        {
+            DM_MUTEX_SCOPED_LOCK(server->m_Mutex);
+            handling.Swap(server->m_Pending);
+        }
+
+        if (handling.Empty())
+        {
+            return RESULT_OK;
+        }
+
+        for (uint32_t i = 0; i < handling.Size(); ++i)
+        {
+            PendingRequest* pending = handling[i];
+
+            InternalRequest internal_request;
+            internal_request.m_Server = server;
+            internal_request.m_Request = 0;
+            internal_request.m_Pending = pending;
+
+            Request web_request;
+            web_request.m_Method = pending->m_Method;
+            web_request.m_Resource = pending->m_Resource;
+            web_request.m_ContentLength = pending->m_Content.Size();
+            web_request.m_Internal = &internal_request;
+
+            // The handler may have been removed since the request was queued
+            HandlerData handler;
+            if (FindHandler(server, pending->m_Resource, &handler))
+            {
+                handler.m_Handler(handler.m_Userdata, &web_request);
+            }
+            else
+            {
+                SetStatusCode(&web_request, 404);
+                char not_found[256];
+                dmSnPrintf(not_found, sizeof(not_found), "Resource '%s' not found", pending->m_Resource);
+                Send(&web_request, not_found, strlen(not_found));
+            }
+        }
+
+        DM_MUTEX_SCOPED_LOCK(server->m_Mutex);
+        for (uint32_t i = 0; i < handling.Size(); ++i)
+        {
+            PushRequest(server->m_Completed, handling[i]);
+        }
+        handling.SetSize(0);
+        return RESULT_OK;
     }
 
     void GetName(HServer server, dmSocket::Address* address, uint16_t* port)
@@ -294,6 +608,19 @@ namespace dmWebServer
     Result SendAttribute(Request* request, const char* key, const char* value)
     {
         InternalRequest* internal_request = (InternalRequest*) request->m_Internal;
+        PendingRequest* pending = internal_request->m_Pending;
+        if (pending)
+        {
+            if (pending->m_Data.Size() > 0)
+            {
+                dmLogError("SendAttribute is only valid before any data is sent: (%s : %s)", key, value);
+                return RESULT_ERROR_INVAL;
+            }
+            DeferredAppend(pending->m_Attributes, key, strlen(key) + 1);
+            DeferredAppend(pending->m_Attributes, value, strlen(value) + 1);
+            return RESULT_OK;
+        }
+
         dmHttpServer::Result r = dmHttpServer::SendAttribute(internal_request->m_Request, key, value);
         return TranslateResult(r);
     }
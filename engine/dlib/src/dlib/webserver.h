@@ -40,6 +40,11 @@ namespace dmWebServer
         /// Connection timeout in seconds
         uint16_t    m_ConnectionTimeout;
 
+        /// Serve connections on a separate thread. Handlers not added with #AddThreadSafeHandler
+        /// are still invoked from #Update. Their requests are queued, and their responses are
+        /// sent by the server thread, which keeps serving the thread safe handlers meanwhile
+        bool        m_Threaded;
+
         NewParams()
         {
             SetDefaultParams(this);
@@ -60,7 +65,18 @@ namespace dmWebServer
      */
     void Delete(HServer server);
     /**
-     * Update server
+     * Add a handler that may be invoked directly from the server thread, see NewParams#m_Threaded.
+     * On a server without a thread, this is the same as #AddHandler
+     * @param server Server handle
+     * @param prefix Location prefix for which locations this handler should handle
+     * @param handler_params Handler parameters
+     * @return RESULT_OK on success
+     */
+    Result AddThreadSafeHandler(HServer server, const char* prefix, const HandlerParams* handler_params);
+
+    /**
+     * Update server. For a threaded server, this invokes the handlers that aren't thread safe,
+     * for all queued requests
      * @param server Server handle
      * @return RESULT_OK on success
      */
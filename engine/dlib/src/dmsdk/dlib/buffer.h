@@ -392,7 +392,7 @@ namespace dmBuffer
     Result GetContentVersion(HBuffer hbuffer, uint32_t* version);
 
     /*# Update the internal frame counter.
-     * Used to know if a buffer has been updated.
+     * Used to know if a buffer has been updated. All streams are marked as changed.
      *
      * @name dmBuffer::UpdateContentVersion
      * @param type [type:dmBuffer::HBuffer] The value type
@@ -400,6 +400,48 @@ namespace dmBuffer
      */
     Result UpdateContentVersion(HBuffer hbuffer);
 
+    /*# Update the internal frame counter, for a change to a range of elements in a stream.
+     * Used to know if, and which part of, a buffer has been updated.
+     *
+     * @name dmBuffer::UpdateStreamContentVersion
+     * @param hbuffer [type:dmBuffer::HBuffer] buffer handle.
+     * @param stream_name [type:dmhash_t] Hash of stream name
+     * @param first_element [type:uint32_t] The first changed element
+     * @param element_count [type:uint32_t] The number of changed elements
+     * @return result [type:dmBuffer::Result] BUFFER_OK if all went ok
+     */
+    Result UpdateStreamContentVersion(HBuffer hbuffer, dmhash_t stream_name, uint32_t first_element, uint32_t element_count);
+
+    /*# Gets the range of elements in a stream changed since a content version
+     * Each user keeps the content version it last read the changes at. The changes are tracked for
+     * the last few reads, by any user. If the changes since the version are no longer tracked,
+     * the range covers all elements.
+     *
+     * @name dmBuffer::GetStreamDirtyRange
+     * @param hbuffer [type:dmBuffer::HBuffer] buffer handle.
+     * @param stream_name [type:dmhash_t] Hash of stream name
+     * @param since_version [type:uint32_t] A version previously returned by GetContentVersion
+     * @param first_element [type:uint32_t*] The first changed element
+     * @param element_count [type:uint32_t*] The number of changed elements. 0 if nothing changed.
+     * @return result [type:dmBuffer::Result] BUFFER_OK if all went ok
+     */
+    Result GetStreamDirtyRange(HBuffer hbuffer, dmhash_t stream_name, uint32_t since_version, uint32_t* first_element, uint32_t* element_count);
+
+    /*# Gets the byte range of the buffer changed since a content version
+     * The range is relative to the start of the data returned by GetBytes, and covers the changes in all streams.
+     * Each user keeps the content version it last read the changes at. The changes are tracked for
+     * the last few reads, by any user. If the changes since the version are no longer tracked,
+     * the range covers the whole buffer.
+     *
+     * @name dmBuffer::GetDirtyRange
+     * @param hbuffer [type:dmBuffer::HBuffer] buffer handle.
+     * @param since_version [type:uint32_t] A version previously returned by GetContentVersion
+     * @param offset [type:uint32_t*] The offset in bytes to the first changed byte
+     * @param size [type:uint32_t*] The size in bytes of the changed range. 0 if nothing changed.
+     * @return result [type:dmBuffer::Result] BUFFER_OK if all went ok
+     */
+    Result GetDirtyRange(HBuffer hbuffer, uint32_t since_version, uint32_t* offset, uint32_t* size);
+
     /*# set a metadata entry
      *
      * Create or update a new metadata entry with a number of values of a specific type.
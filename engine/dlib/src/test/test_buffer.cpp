@@ -653,6 +653,69 @@ TEST_F(GetDataTest, CheckOverwrite)
     }
 }
 
+TEST_F(GetDataTest, DirtyRanges)
+{
+    const dmhash_t position = dmHashString64("position");
+    const dmhash_t texcoord = dmHashString64("texcoord");
+
+    uint32_t version = 0;
+    ASSERT_EQ(dmBuffer::RESULT_OK, dmBuffer::GetContentVersion(buffer, &version));
+
+    // Nothing changed
+    uint32_t offset = 1, size = 1;
+    ASSERT_EQ(dmBuffer::RESULT_OK, dmBuffer::GetDirtyRange(buffer, version, &offset, &size));
+    ASSERT_EQ(0u, size);
+
+    // The texcoord of element 1, and the position of element 2
+    ASSERT_EQ(dmBuffer::RESULT_OK, dmBuffer::UpdateStreamContentVersion(buffer, texcoord, 1, 1));
+    ASSERT_EQ(dmBuffer::RESULT_OK, dmBuffer::UpdateStreamContentVersion(buffer, position, 2, 1));
+    ASSERT_EQ(dmBuffer::RESULT_OK, dmBuffer::GetDirtyRange(buffer, version, &offset, &size));
+    ASSERT_EQ(stride * 1 + sizeof(float)*3, offset);
+    ASSERT_EQ(stride * 2 + sizeof(float)*3 - offset, size);
+
+    uint32_t first = 0, element_count = 0;
+    ASSERT_EQ(dmBuffer::RESULT_OK, dmBuffer::GetStreamDirtyRange(buffer, texcoord, version, &first, &element_count));
+    ASSERT_EQ(1u, first);
+    ASSERT_EQ(1u, element_count);
+
+    ASSERT_EQ(dmBuffer::RESULT_BUFFER_SIZE_ERROR, dmBuffer::UpdateStreamContentVersion(buffer, position, 3, 2));
+    ASSERT_EQ(dmBuffer::RESULT_STREAM_MISSING, dmBuffer::UpdateStreamContentVersion(buffer, dmHashString64("missing"), 0, 1));
+
+    // Reading the changes starts a new period. A user that read them only gets the new changes,
+    // while a user at the old version still gets the changes since then
+    uint32_t read_version = 0;
+    ASSERT_EQ(dmBuffer::RESULT_OK, dmBuffer::GetContentVersion(buffer, &read_version));
+    ASSERT_EQ(dmBuffer::RESULT_OK, dmBuffer::UpdateStreamContentVersion(buffer, position, 3, 1));
+    ASSERT_EQ(dmBuffer::RESULT_OK, dmBuffer::GetDirtyRange(buffer, read_version, &offset, &size));
+    ASSERT_EQ(stride * 3, offset);
+    ASSERT_EQ(sizeof(float)*3, size);
+
+    ASSERT_EQ(dmBuffer::RESULT_OK, dmBuffer::GetDirtyRange(buffer, version, &offset, &size));
+    ASSERT_EQ(stride * 1 + sizeof(float)*3, offset);
+    ASSERT_EQ(stride * 3 + sizeof(float)*3 - offset, size);
+
+    // Only the last few periods are tracked
+    for (int i = 0; i < 8; ++i)
+    {
+        uint32_t period_version = 0;
+        ASSERT_EQ(dmBuffer::RESULT_OK, dmBuffer::GetContentVersion(buffer, &period_version));
+        ASSERT_EQ(dmBuffer::RESULT_OK, dmBuffer::UpdateStreamContentVersion(buffer, position, 0, 1));
+        ASSERT_EQ(dmBuffer::RESULT_OK, dmBuffer::GetDirtyRange(buffer, period_version, &offset, &size));
+        ASSERT_EQ(0u, offset);
+        ASSERT_EQ(sizeof(float)*3, size);
+    }
+    ASSERT_EQ(dmBuffer::RESULT_OK, dmBuffer::GetDirtyRange(buffer, read_version, &offset, &size));
+    ASSERT_EQ(0u, offset);
+    ASSERT_EQ(stride * count, size);
+
+    // A full update marks everything
+    ASSERT_EQ(dmBuffer::RESULT_OK, dmBuffer::GetContentVersion(buffer, &read_version));
+    ASSERT_EQ(dmBuffer::RESULT_OK, dmBuffer::UpdateContentVersion(buffer));
+    ASSERT_EQ(dmBuffer::RESULT_OK, dmBuffer::GetDirtyRange(buffer, read_version, &offset, &size));
+    ASSERT_EQ(0u, offset);
+    ASSERT_EQ(stride * count, size);
+}
+
 
 TEST_P(AlignmentTest, CheckAlignment)
 {
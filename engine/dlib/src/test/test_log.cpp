@@ -226,6 +226,47 @@ TEST(dmLog, LogFile)
     dmSys::Unlink(logpath);
 }
 
+static uint32_t CountInFile(const char* path, const char* text)
+{
+    char tmp[1024] = {0};
+    FILE* f = fopen(path, "rb");
+    if (!f)
+        return 0;
+    fread(tmp, 1, sizeof(tmp) - 1, f);
+    fclose(f);
+
+    uint32_t count = 0;
+    for (const char* p = strstr(tmp, text); p; p = strstr(p + 1, text))
+        ++count;
+    return count;
+}
+
+TEST(dmLog, LogFileError)
+{
+    if (!dLib::FeaturesSupported(DM_FEATURE_BIT_SOCKET_SERVER_TCP))
+    {
+        printf("Test disabled due to platform not supporting TCP");
+        return;
+    }
+
+    char logpath[DMPATH_MAX_PATH];
+    dmTestUtil::MakeHostPath(logpath, sizeof(logpath), "log_error.txt");
+
+    dmLog::LogParams params;
+    dmLog::LogInitialize(&params);
+    dmLog::SetLogFile(logpath);
+
+    // Errors are in the file before the log thread gets to them
+    dmLogError("TESTING_LOG_ERROR");
+    ASSERT_EQ(1u, CountInFile(logpath, "TESTING_LOG_ERROR"));
+
+    dmLog::LogFinalize();
+
+    // ... and aren't written a second time
+    ASSERT_EQ(1u, CountInFile(logpath, "TESTING_LOG_ERROR"));
+    dmSys::Unlink(logpath);
+}
+
 dmArray<char> g_LogListenerOutput;
 
 static void TestLogCaptureCallback(LogSeverity severity, const char* domain, const char* formatted_string)
@@ -310,6 +351,113 @@ TEST(dmLog, TestLogThreadWithLogCalls)
     dLib::SetDebugMode(true);
 }
 
+struct LogFloodContext
+{
+    int32_atomic_t* m_Start;
+    uint32_t        m_Count;
+};
+
+static void LogThreadFlood(void* arg)
+{
+    LogFloodContext* ctx = (LogFloodContext*)arg;
+    while (dmAtomicGet32(ctx->m_Start) == 0)
+        dmTime::Sleep(0);
+    for (uint32_t i = 0; i < ctx->m_Count; ++i)
+    {
+        dmLogWarning("flood %u", i);
+    }
+}
+
+int32_atomic_t g_LogFloodCount = 0;
+static void LogFloodListener(LogSeverity severity, const char* domain, const char* formatted_string)
+{
+    if (strstr(formatted_string, "flood") != 0)
+        dmAtomicAdd32(&g_LogFloodCount, 1);
+}
+
+TEST(dmLog, BufferFull)
+{
+    dLib::SetDebugMode(false); // avoid spam in the unit tests
+
+    dmLog::LogParams params;
+    params.m_BufferSize = 64 * 1024; // make sure we fill it up
+    dmLog::LogInitialize(&params);
+
+    g_LogFloodCount = 0;
+    dmLogRegisterListener(LogFloodListener);
+
+    const uint32_t loop_count = 10000;
+    const uint32_t num_threads = 4;
+    int32_atomic_t start = 0;
+    dmThread::Thread threads[num_threads];
+    LogFloodContext thread_ctx[num_threads];
+    for (uint32_t i = 0; i < num_threads; ++i)
+    {
+        thread_ctx[i].m_Start = &start;
+        thread_ctx[i].m_Count = loop_count;
+        threads[i] = dmThread::New(LogThreadFlood, 0x80000, &thread_ctx[i], "test");
+    }
+
+    dmAtomicStore32(&start, 1);
+    for (uint32_t i = 0; i < num_threads; ++i)
+    {
+        dmThread::Join(threads[i]);
+    }
+
+    uint32_t dropped = dmLog::GetDroppedCount();
+
+    // wait for thread to join, thus making sure we get all the pending log messages
+    dmLog::LogFinalize();
+
+    dLib::SetDebugMode(true);
+
+    // Every message is either delivered or counted as dropped
+    ASSERT_EQ(num_threads * loop_count, (uint32_t)g_LogFloodCount + dropped);
+}
+
+// Not a correctness test, but reports how many log calls per second several threads can make
+TEST(dmLog, Throughput)
+{
+    dLib::SetDebugMode(false); // avoid spam in the unit tests
+
+    dmLog::LogParams params;
+    dmLog::LogInitialize(&params);
+
+    g_LogFloodCount = 0;
+    dmLogRegisterListener(LogFloodListener);
+
+    const uint32_t loop_count = 100000;
+    const uint32_t num_threads = 4;
+    int32_atomic_t start = 0;
+    dmThread::Thread threads[num_threads];
+    LogFloodContext thread_ctx[num_threads];
+    for (uint32_t i = 0; i < num_threads; ++i)
+    {
+        thread_ctx[i].m_Start = &start;
+        thread_ctx[i].m_Count = loop_count;
+        threads[i] = dmThread::New(LogThreadFlood, 0x80000, &thread_ctx[i], "test");
+    }
+
+    uint64_t time_start = dmTime::GetTime();
+    dmAtomicStore32(&start, 1);
+    for (uint32_t i = 0; i < num_threads; ++i)
+    {
+        dmThread::Join(threads[i]);
+    }
+    uint64_t time_end = dmTime::GetTime();
+
+    uint32_t dropped = dmLog::GetDroppedCount();
+    dmLog::LogFinalize();
+
+    dLib::SetDebugMode(true);
+
+    uint32_t total = num_threads * loop_count;
+    double seconds = (time_end - time_start + 1) / 1000000.0;
+    printf("%u threads: %.0f log calls per second (%u dropped)\n", num_threads, total / seconds, dropped);
+
+    ASSERT_EQ(total, (uint32_t)g_LogFloodCount + dropped);
+}
+
 int main(int argc, char **argv)
 {
     TestMainPlatformInit();
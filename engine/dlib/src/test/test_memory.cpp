@@ -14,6 +14,7 @@
 
 #include <stdint.h>
 #include <stdio.h>
+#include <string.h>
 #define JC_TEST_IMPLEMENTATION
 #include <jc_test/jc_test.h>
 #include "../dlib/memory.h"
@@ -52,6 +53,120 @@ TEST(dmMemory, AlignedMalloc)
     dummy = 0;
 }
 
+TEST(dmMemory, TaggedMalloc)
+{
+    dmMemory::TagStats before;
+    dmMemory::GetTagStats(dmMemory::TAG_SOUND, &before);
+
+    void* a = dmMemory::Malloc(dmMemory::TAG_SOUND, 100);
+    void* b = dmMemory::Malloc(dmMemory::TAG_SOUND, 28);
+    ASSERT_TRUE(a != 0);
+    ASSERT_TRUE(b != 0);
+    ASSERT_EQ(0u, ((uintptr_t)a % sizeof(void*)));
+    memset(a, 1, 100);
+
+    dmMemory::TagStats stats;
+    dmMemory::GetTagStats(dmMemory::TAG_SOUND, &stats);
+    ASSERT_EQ(before.m_LiveBytes + 128, stats.m_LiveBytes);
+    ASSERT_EQ(before.m_LiveCount + 2, stats.m_LiveCount);
+    ASSERT_EQ(before.m_TotalCount + 2, stats.m_TotalCount);
+
+    a = dmMemory::Realloc(dmMemory::TAG_SOUND, a, 1000);
+    ASSERT_TRUE(a != 0);
+    ASSERT_EQ(1, ((uint8_t*)a)[99]);
+    dmMemory::GetTagStats(dmMemory::TAG_SOUND, &stats);
+    ASSERT_EQ(before.m_LiveBytes + 1028, stats.m_LiveBytes);
+    ASSERT_EQ(before.m_LiveCount + 2, stats.m_LiveCount);
+
+    dmMemory::Free(dmMemory::TAG_SOUND, a);
+    dmMemory::Free(dmMemory::TAG_SOUND, b);
+    dmMemory::Free(dmMemory::TAG_SOUND, 0);
+    dmMemory::GetTagStats(dmMemory::TAG_SOUND, &stats);
+    ASSERT_EQ(before.m_LiveBytes, stats.m_LiveBytes);
+    ASSERT_EQ(before.m_LiveCount, stats.m_LiveCount);
+
+    ASSERT_STREQ("sound", dmMemory::GetTagName(dmMemory::TAG_SOUND));
+}
+
+TEST(dmMemory, Arena)
+{
+    dmMemory::TagStats before;
+    dmMemory::GetTagStats(dmMemory::TAG_RENDER, &before);
+
+    dmMemory::HArena arena = dmMemory::NewArena(dmMemory::TAG_RENDER, 256);
+    ASSERT_EQ(256u, dmMemory::GetArenaCapacity(arena));
+
+    uint8_t* a = (uint8_t*) dmMemory::ArenaAlloc(arena, 3, 1);
+    uint8_t* b = (uint8_t*) dmMemory::ArenaAlloc(arena, 16, 16);
+    ASSERT_EQ(0u, ((uintptr_t)b % 16));
+    ASSERT_LT(a, b);
+    ASSERT_EQ(19u, dmMemory::GetArenaUsed(arena));
+
+    // Doesn't fit, grows the arena
+    uint8_t* c = (uint8_t*) dmMemory::ArenaAlloc(arena, 1000, 4);
+    memset(c, 0, 1000);
+    ASSERT_EQ(1019u, dmMemory::GetArenaUsed(arena));
+    uint32_t capacity = dmMemory::GetArenaCapacity(arena);
+    ASSERT_GT(capacity, 1019u);
+
+    dmMemory::TagStats stats;
+    dmMemory::GetTagStats(dmMemory::TAG_RENDER, &stats);
+    ASSERT_EQ(before.m_LiveCount + 2, stats.m_LiveCount);
+
+    // The blocks are merged into one
+    dmMemory::ResetArena(arena);
+    ASSERT_EQ(0u, dmMemory::GetArenaUsed(arena));
+    ASSERT_EQ(capacity, dmMemory::GetArenaCapacity(arena));
+    dmMemory::GetTagStats(dmMemory::TAG_RENDER, &stats);
+    ASSERT_EQ(before.m_LiveCount + 1, stats.m_LiveCount);
+
+    // Same usage, no new allocations
+    dmMemory::ArenaAlloc(arena, 3, 1);
+    dmMemory::ArenaAlloc(arena, 16, 16);
+    dmMemory::ArenaAlloc(arena, 1000, 4);
+    dmMemory::ResetArena(arena);
+    dmMemory::GetTagStats(dmMemory::TAG_RENDER, &stats);
+    ASSERT_EQ(before.m_LiveCount + 1, stats.m_LiveCount);
+    ASSERT_EQ(capacity, dmMemory::GetArenaCapacity(arena));
+
+    dmMemory::DeleteArena(arena);
+    dmMemory::GetTagStats(dmMemory::TAG_RENDER, &stats);
+    ASSERT_EQ(before.m_LiveBytes, stats.m_LiveBytes);
+    ASSERT_EQ(before.m_LiveCount, stats.m_LiveCount);
+}
+
+TEST(dmMemory, FrameAlloc)
+{
+    uint8_t* a = (uint8_t*) dmMemory::FrameAlloc(100);
+    memset(a, 1, 100);
+    dmMemory::EndFrame();
+    ASSERT_EQ(100u, dmMemory::GetFrameHighWaterMark());
+
+    // The memory from the previous frame is still valid
+    uint8_t* b = (uint8_t*) dmMemory::FrameAlloc(300);
+    memset(b, 2, 300);
+    ASSERT_EQ(1, a[99]);
+    dmMemory::EndFrame();
+    ASSERT_EQ(300u, dmMemory::GetFrameHighWaterMark());
+
+    // The memory from two frames ago is reused
+    uint8_t* c = (uint8_t*) dmMemory::FrameAlloc(50, 4);
+    ASSERT_EQ(a, c);
+    ASSERT_EQ(2, b[299]);
+    dmMemory::EndFrame();
+    ASSERT_EQ(300u, dmMemory::GetFrameHighWaterMark());
+
+    dmMemory::TagStats stats;
+    dmMemory::GetTagStats(dmMemory::TAG_FRAME, &stats);
+    ASSERT_EQ(2u, stats.m_LiveCount);
+
+    dmMemory::DeleteFrameAllocator();
+    dmMemory::GetTagStats(dmMemory::TAG_FRAME, &stats);
+    ASSERT_EQ(0u, stats.m_LiveBytes);
+    ASSERT_EQ(0u, stats.m_LiveCount);
+    ASSERT_EQ(0u, dmMemory::GetFrameHighWaterMark());
+}
+
 int main(int argc, char **argv)
 {
     jc_test_init(&argc, argv);
@@ -34,6 +34,23 @@ public:
     volatile bool m_Quit;
     volatile bool m_ServerStarted;
 
+    // The thread running the test, which calls Update()
+    dmThread::Thread m_MainThread;
+    // Number of handler calls on the main thread, and on other threads
+    volatile int32_t m_MainThreadCalls;
+    volatile int32_t m_OtherThreadCalls;
+    volatile int32_t m_MulMainThreadCalls;
+    volatile int32_t m_MulOtherThreadCalls;
+
+    void RecordThread(bool mul)
+    {
+        bool main_thread = dmThread::GetCurrentThread() == m_MainThread;
+        if (mul)
+            main_thread ? ++m_MulMainThreadCalls : ++m_MulOtherThreadCalls;
+        else
+            main_thread ? ++m_MainThreadCalls : ++m_OtherThreadCalls;
+    }
+
     static void ServerThread(void* user_data)
     {
         dmWebServerTest* self = (dmWebServerTest*) user_data;
@@ -50,7 +67,8 @@ public:
 
     static void MulHandler(void* user_data, dmWebServer::Request* request)
     {
-        //dmWebServerTest* self = (dmWebServerTest*) user_data;
+        dmWebServerTest* self = (dmWebServerTest*) user_data;
+        self->RecordThread(true);
 
         int a,b;
         sscanf(request->m_Resource, "/mul/%d/%d", &a,&b);
@@ -62,6 +80,8 @@ public:
 
     static void MulHeaderHandler(void* user_data, dmWebServer::Request* request)
     {
+        dmWebServerTest* self = (dmWebServerTest*) user_data;
+        self->RecordThread(false);
         int a, b;
 
         const char* as = dmWebServer::GetHeader(request, "X-a");
@@ -77,17 +97,29 @@ public:
     static void QuitHandler(void* user_data, dmWebServer::Request* request)
     {
         dmWebServerTest* self = (dmWebServerTest*) user_data;
+        self->RecordThread(false);
         dmWebServer::SetStatusCode(request, 200);
         self->m_Quit = true;
     }
 
+    virtual bool IsThreaded()
+    {
+        return false;
+    }
+
     virtual void SetUp()
     {
         m_Quit = false;
         m_ServerStarted = false;
+        m_MainThread = dmThread::GetCurrentThread();
+        m_MainThreadCalls = 0;
+        m_OtherThreadCalls = 0;
+        m_MulMainThreadCalls = 0;
+        m_MulOtherThreadCalls = 0;
         dmWebServer::NewParams params;
         params.m_ConnectionTimeout = 20;
         params.m_Port = 8501;
+        params.m_Threaded = IsThreaded();
         dmWebServer::Result r = dmWebServer::New(&params, &m_Server);
         ASSERT_EQ(dmWebServer::RESULT_OK, r);
         dmWebServer::HandlerParams handler_params;
@@ -96,8 +128,9 @@ public:
         handler_params.m_Handler = QuitHandler;
         dmWebServer::AddHandler(m_Server, "/quit", &handler_params);
 
+        // Invoked directly from the server thread when the server is threaded
         handler_params.m_Handler = MulHandler;
-        dmWebServer::AddHandler(m_Server, "/mul", &handler_params);
+        dmWebServer::AddThreadSafeHandler(m_Server, "/mul", &handler_params);
 
         handler_params.m_Handler = MulHeaderHandler;
         dmWebServer::AddHandler(m_Server, "/header_mul", &handler_params);
@@ -121,6 +154,15 @@ public:
     }
 };
 
+class dmWebServerThreadedTest: public dmWebServerTest
+{
+public:
+    virtual bool IsThreaded()
+    {
+        return true;
+    }
+};
+
 int g_PythonTestResult;
 void RunPythonThread(void*)
 {
@@ -146,6 +188,114 @@ TEST_F(dmWebServerTest, TestServer)
     ASSERT_LE(iter, 1000);
     dmThread::Join(thread);
     ASSERT_EQ(0, g_PythonTestResult);
+
+    ASSERT_LT(0, m_MainThreadCalls);
+    ASSERT_LT(0, m_MulMainThreadCalls);
+    ASSERT_EQ(0, m_OtherThreadCalls);
+    ASSERT_EQ(0, m_MulOtherThreadCalls);
+}
+
+// The quit and header handlers are invoked from Update(), the mul handler from the server thread
+TEST_F(dmWebServerThreadedTest, TestServer)
+{
+    dmThread::Thread thread = dmThread::New(RunPythonThread, 0x8000, 0, "test");
+    int iter = 0;
+    while (!m_Quit && iter < 1000)
+    {
+        dmWebServer::Update(m_Server);
+        dmTime::Sleep(1000 * 10);
+        ++iter;
+    }
+    ASSERT_LE(iter, 1000);
+    dmThread::Join(thread);
+    ASSERT_EQ(0, g_PythonTestResult);
+
+    ASSERT_LT(0, m_MainThreadCalls);
+    ASSERT_LT(0, m_MulOtherThreadCalls);
+    ASSERT_EQ(0, m_OtherThreadCalls);
+    ASSERT_EQ(0, m_MulMainThreadCalls);
+}
+
+static dmSocket::Socket SendRequest(const char* request)
+{
+    dmSocket::Address address;
+    dmSocket::Result r = dmSocket::GetHostByName("localhost", &address);
+    if (r != dmSocket::RESULT_OK)
+        return dmSocket::INVALID_SOCKET_HANDLE;
+
+    dmSocket::Socket socket;
+    r = dmSocket::New(address.m_family, dmSocket::TYPE_STREAM, dmSocket::PROTOCOL_TCP, &socket);
+    if (r != dmSocket::RESULT_OK)
+        return dmSocket::INVALID_SOCKET_HANDLE;
+
+    int sent = 0;
+    if (dmSocket::Connect(socket, address, 8501) != dmSocket::RESULT_OK ||
+        dmSocket::Send(socket, request, strlen(request), &sent) != dmSocket::RESULT_OK)
+    {
+        dmSocket::Delete(socket);
+        return dmSocket::INVALID_SOCKET_HANDLE;
+    }
+    return socket;
+}
+
+// Returns true when the whole chunked response is received
+static bool ReceiveResponse(dmSocket::Socket socket, char* buffer, uint32_t buffer_size, uint32_t* size)
+{
+    dmSocket::Selector selector;
+    dmSocket::SelectorSet(&selector, dmSocket::SELECTOR_KIND_READ, socket);
+    if (dmSocket::Select(&selector, 0) != dmSocket::RESULT_OK || !dmSocket::SelectorIsSet(&selector, dmSocket::SELECTOR_KIND_READ, socket))
+        return false;
+
+    int received = 0;
+    if (dmSocket::Receive(socket, buffer + *size, buffer_size - *size - 1, &received) == dmSocket::RESULT_OK)
+    {
+        *size += received;
+        buffer[*size] = 0;
+    }
+    return strstr(buffer, "\r\n0\r\n\r\n") != 0;
+}
+
+// A request to a thread safe handler is served while another request waits for Update()
+TEST_F(dmWebServerThreadedTest, ServeWhilePending)
+{
+    dmSocket::Socket header_socket = SendRequest("GET /header_mul HTTP/1.1\r\nX-a: 1\r\nX-b: 2\r\n\r\n");
+    ASSERT_NE(dmSocket::INVALID_SOCKET_HANDLE, header_socket);
+    dmSocket::Socket mul_socket = SendRequest("GET /mul/3/4 HTTP/1.1\r\n\r\n");
+    ASSERT_NE(dmSocket::INVALID_SOCKET_HANDLE, mul_socket);
+
+    char mul_response[1024] = {0};
+    uint32_t mul_size = 0;
+    int iter = 0;
+    while (!ReceiveResponse(mul_socket, mul_response, sizeof(mul_response), &mul_size) && iter < 1000)
+    {
+        dmTime::Sleep(1000 * 10);
+        ++iter;
+    }
+    ASSERT_LT(iter, 1000);
+    ASSERT_NE((char*)0, strstr(mul_response, "HTTP/1.1 200"));
+    ASSERT_NE((char*)0, strstr(mul_response, "\r\n7\r\n"));
+    ASSERT_EQ(1, m_MulOtherThreadCalls);
+
+    // The header handler isn't thread safe, and waits for Update()
+    ASSERT_EQ(0, m_MainThreadCalls);
+
+    char header_response[1024] = {0};
+    uint32_t header_size = 0;
+    iter = 0;
+    while (!ReceiveResponse(header_socket, header_response, sizeof(header_response), &header_size) && iter < 1000)
+    {
+        dmWebServer::Update(m_Server);
+        dmTime::Sleep(1000 * 10);
+        ++iter;
+    }
+    ASSERT_LT(iter, 1000);
+    ASSERT_NE((char*)0, strstr(header_response, "HTTP/1.1 200"));
+    ASSERT_NE((char*)0, strstr(header_response, "\r\n3\r\n"));
+    ASSERT_EQ(1, m_MainThreadCalls);
+    ASSERT_EQ(0, m_OtherThreadCalls);
+
+    dmSocket::Delete(header_socket);
+    dmSocket::Delete(mul_socket);
 }
 
 #endif
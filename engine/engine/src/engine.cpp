@@ -32,6 +32,7 @@
 #include <dlib/log.h>
 #include <dlib/math.h>
 #include <dlib/memprofile.h>
+#include <dlib/memory.h>
 #include <dlib/path.h>
 #include <dlib/profile.h>
 #include <dlib/socket.h>
@@ -402,6 +403,7 @@ namespace dmEngine
         dmExtension::AppFinalize((dmExtension::AppParams*)&app_params);
 
         dmBuffer::DeleteContext();
+        dmMemory::DeleteFrameAllocator();
 
         if (engine->m_Config)
         {
@@ -987,6 +989,15 @@ namespace dmEngine
             params.m_Flags |= RESOURCE_FACTORY_FLAGS_LIVE_UPDATE_MOUNTS_ON_START;
         }
 
+        // Record the load order during a development session, and prefetch the resources in that order on the next start
+        const char* load_order_record_path = dmConfigFile::GetString(engine->m_Config, "resource.record_load_order", 0);
+        if (load_order_record_path && load_order_record_path[0])
+            params.m_LoadOrderRecordPath = load_order_record_path;
+        const char* prefetch_path = dmConfigFile::GetString(engine->m_Config, "resource.prefetch_load_order", 0);
+        if (prefetch_path && prefetch_path[0])
+            params.m_PrefetchPath = prefetch_path;
+        params.m_PrefetchMaxMemory = dmConfigFile::GetInt(engine->m_Config, "resource.prefetch_max_memory", params.m_PrefetchMaxMemory);
+
 #if !defined(DM_RELEASE)
         params.m_ArchiveIndex.m_Data = (const void*) BUILTINS_ARCI;
         params.m_ArchiveIndex.m_Size = BUILTINS_ARCI_SIZE;
@@ -1161,6 +1172,7 @@ namespace dmEngine
         }
         physics_params.m_ContactImpulseLimit = dmConfigFile::GetFloat(engine->m_Config, "physics.contact_impulse_limit", 0.0f);
         physics_params.m_AllowDynamicTransforms = dmConfigFile::GetInt(engine->m_Config, "physics.allow_dynamic_transforms", 1) ? 1 : 0;
+        physics_params.m_WorkerThreadCount3D = dmConfigFile::GetInt(engine->m_Config, "physics.worker_thread_count_3d", 0);
         if (dmStrCaseCmp(physics_type, "3D") == 0)
         {
             engine->m_PhysicsContext.m_3D = true;
@@ -1182,6 +1194,7 @@ namespace dmEngine
         engine->m_PhysicsContext.m_MaxContactPointCount = dmConfigFile::GetInt(engine->m_Config, dmGameSystem::PHYSICS_MAX_CONTACTS_KEY, 128);
         engine->m_PhysicsContext.m_UseFixedTimestep = dmConfigFile::GetInt(engine->m_Config, dmGameSystem::PHYSICS_USE_FIXED_TIMESTEP, 1) ? 1 : 0;
         engine->m_PhysicsContext.m_MaxFixedTimesteps = dmConfigFile::GetInt(engine->m_Config, dmGameSystem::PHYSICS_MAX_FIXED_TIMESTEPS, 2);
+        engine->m_PhysicsContext.m_Interpolate = dmConfigFile::GetInt(engine->m_Config, dmGameSystem::PHYSICS_INTERPOLATE, 0) ? 1 : 0;
         // TODO: Should move inside the ifdef release? Is this usable without the debug callbacks?
         engine->m_PhysicsContext.m_Debug = (bool) dmConfigFile::GetInt(engine->m_Config, "physics.debug", 0);
 
@@ -1774,6 +1787,7 @@ bail:
 
             DM_PROPERTY_SET_U32(rmtp_LuaRefs, dmScript::GetLuaRefCount());
             DM_PROPERTY_SET_U32(rmtp_LuaMem, GetLuaMemCount(engine));
+            dmMemory::UpdateProfileProperties();
 
             if (dLib::IsDebugMode())
             {
@@ -1852,6 +1866,7 @@ bail:
             }
         }
         dmProfile::EndFrame(profile);
+        dmMemory::EndFrame();
 
         ++engine->m_Stats.m_FrameCount;
         engine->m_Stats.m_TotalTime += dt;
@@ -350,8 +350,11 @@ namespace dmEngineService
             dmStrlCat(m_Name, " - ", sizeof(m_Name));
             dmStrlCat(m_Name, info.m_SystemName, sizeof(m_Name));
 
+            // Connections are served on a separate thread, so that large responses don't stall the frame.
+            // Handlers that access engine state are still invoked on the main thread from Update()
             dmWebServer::NewParams params;
             params.m_Port = port;
+            params.m_Threaded = true;
             dmWebServer::HServer web_server;
             dmWebServer::Result r = dmWebServer::New(&params, &web_server);
             if (r != dmWebServer::RESULT_OK)
@@ -433,17 +436,18 @@ namespace dmEngineService
             dmWebServer::HandlerParams post_params;
             post_params.m_Handler = PostHandler;
             post_params.m_Userdata = this;
-            dmWebServer::AddHandler(web_server, "/post", &post_params);
+            // Posting messages is thread safe
+            dmWebServer::AddThreadSafeHandler(web_server, "/post", &post_params);
 
             dmWebServer::HandlerParams ping_params;
             ping_params.m_Handler = PingHandler;
             ping_params.m_Userdata = this;
-            dmWebServer::AddHandler(web_server, "/ping", &ping_params);
+            dmWebServer::AddThreadSafeHandler(web_server, "/ping", &ping_params);
 
             dmWebServer::HandlerParams info_params;
             info_params.m_Handler = InfoHandler;
             info_params.m_Userdata = this;
-            dmWebServer::AddHandler(web_server, "/info", &info_params);
+            dmWebServer::AddThreadSafeHandler(web_server, "/info", &info_params);
 
             // The purpose of this handler is both for debugging but also for Editor2,
             // where the user can manually specify an IP (and optionally port) to connect to.
@@ -451,7 +455,7 @@ namespace dmEngineService
             dmWebServer::HandlerParams upnp_params;
             upnp_params.m_Handler = UpnpHandler;
             upnp_params.m_Userdata = this;
-            dmWebServer::AddHandler(web_server, "/upnp", &upnp_params);
+            dmWebServer::AddThreadSafeHandler(web_server, "/upnp", &upnp_params);
 
             // Redirects from old profiler to the new
             if (web_server_redirect)
@@ -459,7 +463,7 @@ namespace dmEngineService
                 dmWebServer::HandlerParams redirect_params;
                 redirect_params.m_Handler = RedirectHandler;
                 redirect_params.m_Userdata = this;
-                dmWebServer::AddHandler(web_server_redirect, "/", &redirect_params);
+                dmWebServer::AddThreadSafeHandler(web_server_redirect, "/", &redirect_params);
             }
 
             m_WebServer = web_server;
@@ -915,7 +919,7 @@ namespace dmEngineService
         dmWebServer::HandlerParams profile_params;
         profile_params.m_Handler = ProfileHandler;
         profile_params.m_Userdata = 0;
-        dmWebServer::AddHandler(engine_service->m_WebServer, "/", &profile_params);
+        dmWebServer::AddThreadSafeHandler(engine_service->m_WebServer, "/", &profile_params);
     }
 }
 
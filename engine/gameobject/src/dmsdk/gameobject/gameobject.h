@@ -519,6 +519,25 @@ namespace dmGameObject
     HInstance Spawn(HCollection collection, HPrototype prototype, const char* prototype_name, dmhash_t id,
                       HPropertyContainer properties, const dmVMath::Point3& position, const dmVMath::Quat& rotation, const dmVMath::Vector3& scale);
 
+    /*# spawn a batch of new game objects
+     * Spawns several gameobject instances of the same prototype. All instances are created
+     * before any of them is initialized.
+     * @name SpawnBatch
+     * @param collection [type: HCollection] Gameobject collection
+     * @param prototype [type: HPrototype] Prototype
+     * @param prototype_name [type: const char*] Prototype file name (.goc)
+     * @param count [type: uint32_t] Number of instances to spawn
+     * @param ids [type: const dmhash_t*] Ids of the spawned instances
+     * @param properties [type: HPropertyContainer] Container with override properties, used for all instances
+     * @param positions [type: const dmVMath::Point3*] Positions of the spawned objects
+     * @param rotations [type: const dmVMath::Quat*] Rotations of the spawned objects
+     * @param scales [type: const dmVMath::Vector3*] Scales of the spawned objects
+     * @param out_instances [type: HInstance*] The spawned instances, 0 for the ones that failed
+     * return count [type: uint32_t] the number of spawned instances
+     */
+    uint32_t SpawnBatch(HCollection collection, HPrototype prototype, const char* prototype_name, uint32_t count, const dmhash_t* ids, HPropertyContainer properties,
+                        const dmVMath::Point3* positions, const dmVMath::Quat* rotations, const dmVMath::Vector3* scales, HInstance* out_instances);
+
     /*#
      * Retrieve a collection from the specified instance
      * @name GetCollection
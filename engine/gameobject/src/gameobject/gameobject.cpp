@@ -24,6 +24,7 @@
 #include <dlib/index_pool.h>
 #include <dlib/profile.h>
 #include <dlib/math.h>
+#include <dlib/memory.h>
 #include <dlib/vmath.h>
 #include <dlib/mutex.h>
 #include <ddf/ddf.h>
@@ -93,6 +94,10 @@ namespace dmGameObject
     Prototype::~Prototype()
     {
         free(m_Components);
+        for (uint32_t i = 0; i < m_InstancePool.Size(); ++i)
+        {
+            dmMemory::Free(dmMemory::TAG_GAMEOBJECT, m_InstancePool[i]);
+        }
     }
 
     InputAction::InputAction()
@@ -729,6 +734,11 @@ namespace dmGameObject
         instance->m_LevelIndex = level_index;
     }
 
+    static uint32_t GetInstanceMemorySize(uint32_t component_instance_userdata_count) {
+        uint32_t component_userdata_size = sizeof(((Instance*)0)->m_ComponentInstanceUserData[0]);
+        return sizeof(Instance) + component_instance_userdata_count * component_userdata_size;
+    }
+
     static HInstance AllocInstance(Prototype* proto, const char* prototype_name) {
         // Count number of component userdata fields required
         uint32_t component_instance_userdata_count = 0;
@@ -745,15 +755,27 @@ namespace dmGameObject
                 component_instance_userdata_count++;
         }
 
-        uint32_t component_userdata_size = sizeof(((Instance*)0)->m_ComponentInstanceUserData[0]);
         // NOTE: Allocate actual Instance with *all* component instance user-data accounted
-        void* instance_memory = ::operator new (sizeof(Instance) + component_instance_userdata_count * component_userdata_size);
+        uint32_t instance_memory_size = GetInstanceMemorySize(component_instance_userdata_count);
+        void* instance_memory;
+        // The size only changes if the prototype is reloaded with other components
+        if (!proto->m_InstancePool.Empty() && proto->m_InstanceMemorySize == instance_memory_size)
+        {
+            instance_memory = proto->m_InstancePool.Back();
+            proto->m_InstancePool.Pop();
+        }
+        else
+        {
+            instance_memory = dmMemory::Malloc(dmMemory::TAG_GAMEOBJECT, instance_memory_size);
+        }
         Instance* instance = new(instance_memory) Instance(proto);
         instance->m_ComponentInstanceUserDataCount = component_instance_userdata_count;
         return instance;
     }
 
     static void DeallocInstance(HInstance instance) {
+        Prototype* proto = instance->m_Prototype;
+        uint32_t instance_memory_size = GetInstanceMemorySize(instance->m_ComponentInstanceUserDataCount);
         instance->~Instance();
         void* instance_memory = (void*) instance;
 
@@ -761,7 +783,37 @@ namespace dmGameObject
         // TODO: #ifdef on something...?
         // Clear all memory excluding ComponentInstanceUserData
         memset(instance_memory, 0xcc, sizeof(Instance));
-        operator delete (instance_memory);
+
+        if (!proto->m_InstancePool.Full() && proto->m_InstanceMemorySize == instance_memory_size)
+        {
+            proto->m_InstancePool.Push(instance_memory);
+        }
+        else
+        {
+            dmMemory::Free(dmMemory::TAG_GAMEOBJECT, instance_memory);
+        }
+    }
+
+    void SetInstancePoolSize(HPrototype proto, uint32_t pool_size)
+    {
+        if (proto == &EMPTY_PROTOTYPE || proto->m_InstancePool.Capacity() >= pool_size)
+        {
+            return;
+        }
+
+        uint32_t component_instance_userdata_count = 0;
+        for (uint32_t i = 0; i < proto->m_ComponentCount; ++i)
+        {
+            if (proto->m_Components[i].m_Type->m_InstanceHasUserData)
+                component_instance_userdata_count++;
+        }
+        proto->m_InstanceMemorySize = GetInstanceMemorySize(component_instance_userdata_count);
+
+        proto->m_InstancePool.SetCapacity(pool_size);
+        while (!proto->m_InstancePool.Full())
+        {
+            proto->m_InstancePool.Push(dmMemory::Malloc(dmMemory::TAG_GAMEOBJECT, proto->m_InstanceMemorySize));
+        }
     }
 
     HInstance NewInstance(Collection* collection, Prototype* proto, const char* prototype_name) {
@@ -799,7 +851,7 @@ namespace dmGameObject
         }
 
         uint16_t instance_index = instance->m_Index;
-        operator delete ((void*)instance);
+        dmMemory::Free(dmMemory::TAG_GAMEOBJECT, (void*)instance);
         collection->m_Instances[instance_index] = 0x0;
         collection->m_InstanceIndices.Push(instance_index);
         assert(collection->m_IDToInstance.Size() <= collection->m_InstanceIndices.Size());
@@ -1160,13 +1212,9 @@ namespace dmGameObject
     }
 
     // Supplied 'proto' will be released after this function is done.
-    static HInstance SpawnInternal(Collection* collection, Prototype *proto, const char *prototype_name, dmhash_t id, HPropertyContainer property_container, const Point3& position, const Quat& rotation, const Vector3& scale)
+    // Creates the instance and its components, without initializing it
+    static HInstance CreateSpawnInstance(Collection* collection, Prototype *proto, const char *prototype_name, dmhash_t id, HPropertyContainer property_container, const Point3& position, const Quat& rotation, const Vector3& scale)
     {
-        if (collection->m_ToBeDeleted) {
-            dmLogWarning("Spawning is not allowed when the collection is being deleted.");
-            return 0;
-        }
-
         HInstance instance = dmGameObject::NewInstance(collection, proto, prototype_name);
         if (instance == 0) {
             return 0;
@@ -1198,20 +1246,34 @@ namespace dmGameObject
         }
 
         success = SetScriptPropertiesFromBuffer(instance, prototype_name, property_container);
+        if (!success) {
+            Delete(collection, instance, false);
+            return 0;
+        }
 
-        if (success && !InitInstance(collection, instance))
-        {
-            dmLogError("Could not initialize when spawning %s.", prototype_name);
-            success = false;
+        return instance;
+    }
+
+    static HInstance SpawnInternal(Collection* collection, Prototype *proto, const char *prototype_name, dmhash_t id, HPropertyContainer property_container, const Point3& position, const Quat& rotation, const Vector3& scale)
+    {
+        if (collection->m_ToBeDeleted) {
+            dmLogWarning("Spawning is not allowed when the collection is being deleted.");
+            return 0;
         }
 
-        if (success) {
-            AddToUpdate(collection, instance);
-        } else {
+        HInstance instance = CreateSpawnInstance(collection, proto, prototype_name, id, property_container, position, rotation, scale);
+        if (instance == 0) {
+            return 0;
+        }
+
+        if (!InitInstance(collection, instance))
+        {
+            dmLogError("Could not initialize when spawning %s.", prototype_name);
             Delete(collection, instance, false);
             return 0;
         }
 
+        AddToUpdate(collection, instance);
         return instance;
     }
 
@@ -1653,6 +1715,64 @@ namespace dmGameObject
         return instance;
     }
 
+    uint32_t SpawnBatch(HCollection hcollection, HPrototype proto, const char* prototype_name, uint32_t count, const dmhash_t* ids, HPropertyContainer property_container,
+                        const Point3* positions, const Quat* rotations, const Vector3* scales, HInstance* out_instances)
+    {
+        DM_PROFILE("SpawnBatch");
+
+        memset(out_instances, 0, sizeof(HInstance) * count);
+
+        if (proto == 0x0) {
+            dmLogError("No prototype to spawn from.");
+            return 0;
+        }
+
+        Collection* collection = hcollection->m_Collection;
+        if (collection->m_ToBeDeleted) {
+            dmLogWarning("Spawning is not allowed when the collection is being deleted.");
+            return 0;
+        }
+
+        uint32_t remaining = collection->m_InstanceIndices.Remaining();
+        if (count > remaining)
+        {
+            dmLogError("Only %u of %u instances of prototype %s could be spawned since the buffer is full (%d). Increase the capacity with collection.max_instances",
+                        remaining, count, prototype_name, collection->m_InstanceIndices.Capacity());
+            count = remaining;
+        }
+
+        // Create all instances before initializing any of them, like when spawning a collection
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            out_instances[i] = CreateSpawnInstance(collection, proto, prototype_name, ids[i], property_container, positions[i], rotations[i], scales[i]);
+            if (out_instances[i] == 0) {
+                dmLogError("Could not spawn an instance of prototype %s.", prototype_name);
+            }
+        }
+
+        uint32_t spawned = 0;
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            HInstance instance = out_instances[i];
+            // The init function of a previous instance might have deleted it
+            if (instance == 0 || instance->m_ToBeDeleted)
+                continue;
+
+            if (!InitInstance(collection, instance))
+            {
+                dmLogError("Could not initialize when spawning %s.", prototype_name);
+                Delete(collection, instance, false);
+                out_instances[i] = 0;
+                continue;
+            }
+
+            AddToUpdate(collection, instance);
+            ++spawned;
+        }
+
+        return spawned;
+    }
+
     static void MoveDown(Collection* collection, Instance* instance)
     {
         /*
@@ -1981,8 +2101,6 @@ namespace dmGameObject
         EraseSwapLevelIndex(collection, instance);
         MoveAllUp(collection, instance);
 
-        if (prototype != &EMPTY_PROTOTYPE)
-            dmResource::Release(factory, prototype);
         collection->m_InstanceIndices.Push(instance->m_Index);
         collection->m_Instances[instance->m_Index] = 0;
 
@@ -2009,6 +2127,10 @@ namespace dmGameObject
 
         DeallocInstance(instance);
 
+        // Released after the instance memory has been returned to the pool of the prototype
+        if (prototype != &EMPTY_PROTOTYPE)
+            dmResource::Release(factory, prototype);
+
         assert(collection->m_IDToInstance.Size() <= collection->m_InstanceIndices.Size());
     }
 
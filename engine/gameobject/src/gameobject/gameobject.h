@@ -149,6 +149,16 @@ namespace dmGameObject
                              const Point3& position, const Quat& rotation, const Vector3& scale,
                              InstanceIdMap *instances);
 
+    /**
+     * Keep up to pool_size instance memory blocks of the prototype around, so that spawning
+     * new instances reuses the memory of deleted ones instead of allocating. Only the memory
+     * is pooled, the components are still created and destroyed with each instance.
+     * The pool is filled up front, never shrinks, and is freed with the prototype.
+     * @param prototype Prototype
+     * @param pool_size Max number of pooled memory blocks
+     */
+    void SetInstancePoolSize(HPrototype prototype, uint32_t pool_size);
+
     /**
      * Delete all gameobject instances in the collection
      * @param collection Gameobject collection
@@ -43,6 +43,7 @@ namespace dmGameObject
         Prototype()
             : m_Components(0)
             , m_ComponentCount(0)
+            , m_InstanceMemorySize(0)
         {
         }
         ~Prototype();
@@ -83,6 +84,9 @@ namespace dmGameObject
         uint32_t       m_ComponentCount;
         // Resources referenced through property overrides inside the prototype
         dmArray<void*> m_PropertyResources;
+        // Memory of deleted instances, reused when spawning new instances. See SetInstancePoolSize()
+        dmArray<void*> m_InstancePool;
+        uint32_t       m_InstanceMemorySize;
     };
 
     // Invalid instance index. Implies that maximum number of instances is 32766 (ie 0x7fff - 1)
@@ -648,6 +648,109 @@ TEST_F(SpawnDeleteTest, CollectionUpdate_SpawnDeleteMulti2)
     PostUpdate();
 }
 
+TEST_F(SpawnDeleteTest, InstancePool)
+{
+    dmGameObject::HPrototype prototype = 0x0;
+    ASSERT_EQ(dmResource::RESULT_OK, dmResource::Get(m_Factory, "/a.goc", (void**)&prototype));
+
+    dmGameObject::SetInstancePoolSize(prototype, 4);
+    ASSERT_EQ(4u, prototype->m_InstancePool.Size());
+
+    dmGameObject::HInstance go = dmGameObject::Spawn(m_Collection, prototype, "/a.goc", 2, 0, Point3(0.0f, 0.0f, 0.0f), Quat(0.0f, 0.0f, 0.0f, 1.0f), Vector3(1, 1, 1));
+    NotNull(go);
+    ASSERT_EQ(3u, prototype->m_InstancePool.Size());
+
+    Delete(go);
+    PostUpdate();
+    ASSERT_EQ(4u, prototype->m_InstancePool.Size());
+
+    // The memory of the deleted instance is reused
+    dmGameObject::HInstance go2 = dmGameObject::Spawn(m_Collection, prototype, "/a.goc", 3, 0, Point3(1.0f, 0.0f, 0.0f), Quat(0.0f, 0.0f, 0.0f, 1.0f), Vector3(1, 1, 1));
+    ASSERT_EQ(go, go2);
+    ASSERT_EQ((dmhash_t)3, dmGameObject::GetIdentifier(go2));
+    ASSERT_EQ(1.0f, dmGameObject::GetPosition(go2).getX());
+
+    Delete(go2);
+    PostUpdate();
+
+    dmResource::Release(m_Factory, prototype);
+}
+
+// Repeated spawn/delete of a batch that fits in the pool never allocates new instance memory
+TEST_F(SpawnDeleteTest, InstancePoolSpawnDeleteBatches)
+{
+    const uint32_t batch_size = 8;
+    const uint32_t iterations = 100;
+
+    dmGameObject::HPrototype prototype = 0x0;
+    ASSERT_EQ(dmResource::RESULT_OK, dmResource::Get(m_Factory, "/a.goc", (void**)&prototype));
+    dmGameObject::SetInstancePoolSize(prototype, batch_size);
+    ASSERT_EQ(batch_size, prototype->m_InstancePool.Size());
+
+    void* pool[batch_size];
+    memcpy(pool, prototype->m_InstancePool.Begin(), sizeof(pool));
+
+    dmGameObject::HInstance instances[batch_size];
+    for (uint32_t i = 0; i < iterations; ++i)
+    {
+        for (uint32_t j = 0; j < batch_size; ++j)
+        {
+            instances[j] = dmGameObject::Spawn(m_Collection, prototype, "/a.goc", 100 + j, 0, Point3(0.0f, 0.0f, 0.0f), Quat(0.0f, 0.0f, 0.0f, 1.0f), Vector3(1, 1, 1));
+            ASSERT_NE((dmGameObject::HInstance)0, instances[j]);
+
+            bool pooled = false;
+            for (uint32_t k = 0; k < batch_size; ++k)
+                pooled |= (void*)instances[j] == pool[k];
+            ASSERT_TRUE(pooled);
+        }
+        ASSERT_EQ(0u, prototype->m_InstancePool.Size());
+
+        for (uint32_t j = 0; j < batch_size; ++j)
+        {
+            Delete(instances[j]);
+        }
+        PostUpdate();
+        ASSERT_EQ(batch_size, prototype->m_InstancePool.Size());
+        ASSERT_EQ(batch_size, prototype->m_InstancePool.Capacity());
+    }
+
+    dmResource::Release(m_Factory, prototype);
+}
+
+// Not a correctness test, but reports the spawn/delete throughput with and without the instance pool
+TEST_F(SpawnDeleteTest, InstancePoolThroughput)
+{
+    const uint32_t batch_size = 8;
+    const uint32_t iterations = 2000;
+
+    for (uint32_t pool_size = 0; pool_size <= batch_size; pool_size += batch_size)
+    {
+        dmGameObject::HPrototype prototype = 0x0;
+        ASSERT_EQ(dmResource::RESULT_OK, dmResource::Get(m_Factory, "/a.goc", (void**)&prototype));
+        dmGameObject::SetInstancePoolSize(prototype, pool_size);
+
+        dmGameObject::HInstance instances[batch_size];
+        uint64_t start = dmTime::GetTime();
+        for (uint32_t i = 0; i < iterations; ++i)
+        {
+            for (uint32_t j = 0; j < batch_size; ++j)
+            {
+                instances[j] = dmGameObject::Spawn(m_Collection, prototype, "/a.goc", 100 + j, 0, Point3(0.0f, 0.0f, 0.0f), Quat(0.0f, 0.0f, 0.0f, 1.0f), Vector3(1, 1, 1));
+                ASSERT_NE((dmGameObject::HInstance)0, instances[j]);
+            }
+            for (uint32_t j = 0; j < batch_size; ++j)
+            {
+                Delete(instances[j]);
+            }
+            PostUpdate();
+        }
+        uint64_t elapsed = dmTime::GetTime() - start;
+        printf("Spawn/delete of %u instances, pool size %u: %.2f ms (%.0f instances/s)\n", iterations * batch_size, pool_size,
+                elapsed / 1000.0, (iterations * batch_size) / (elapsed / 1000000.0));
+
+        dmResource::Release(m_Factory, prototype);
+    }
+}
 
 #undef ASSERT_INIT
 #undef ASSERT_ADD_TO_UPDATE
@@ -51,6 +51,12 @@ namespace dmGameSystem
                                                 uint32_t index, dmhash_t id,
                                                 const dmVMath::Point3& position, const dmVMath::Quat& rotation, const dmVMath::Vector3& scale,
                                                 dmGameObject::HPropertyContainer properties);
+
+    // Spawns count instances, and returns the number of spawned instances. Failed instances are 0 in out_instances.
+    uint32_t CompFactorySpawnBatch(HFactoryWorld world, HFactoryComponent component, dmGameObject::HCollection collection,
+                                                uint32_t count, const uint32_t* indices, const dmhash_t* ids,
+                                                const dmVMath::Point3* positions, const dmVMath::Quat* rotations, const dmVMath::Vector3* scales,
+                                                dmGameObject::HPropertyContainer properties, dmGameObject::HInstance* out_instances);
 }
 
 #endif // DMSDK_GAMESYS_FACTORY_H
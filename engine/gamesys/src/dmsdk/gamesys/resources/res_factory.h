@@ -30,6 +30,8 @@ namespace dmGameSystem
         uint8_t                  m_LoadDynamically : 1;
         uint8_t                  m_DynamicPrototype : 1;
         uint8_t                  : 6;
+
+        uint32_t                 m_PoolSize;                // number of pooled instance memory blocks of the prototype
     };
 
     // scripting
@@ -56,6 +56,8 @@ namespace dmGameSystem
     const char* PHYSICS_USE_FIXED_TIMESTEP          = "physics.use_fixed_timestep";
     /// Config key for using max updates during a single step
     const char* PHYSICS_MAX_FIXED_TIMESTEPS         = "physics.max_fixed_timesteps";
+    /// Config key for interpolating the physics transforms between the fixed time steps
+    const char* PHYSICS_INTERPOLATE                 = "physics.interpolate";
 
     static const dmhash_t PROP_LINEAR_DAMPING = dmHashString64("linear_damping");
     static const dmhash_t PROP_ANGULAR_DAMPING = dmHashString64("angular_damping");
@@ -110,6 +112,15 @@ namespace dmGameSystem
 
         dmPhysics::HCollisionShape3D* m_ShapeBuffer;
 
+        // Physics interpolation. The body transforms of the last two fixed steps,
+        // and the blended transform that was last written to the game object.
+        dmVMath::Point3 m_PrevPosition;
+        dmVMath::Point3 m_CurrPosition;
+        dmVMath::Point3 m_RenderPosition;
+        dmVMath::Quat   m_PrevRotation;
+        dmVMath::Quat   m_CurrRotation;
+        dmVMath::Quat   m_RenderRotation;
+
         uint16_t m_Mask;
         uint16_t m_ComponentIndex;
         // True if the physics is 3D
@@ -125,6 +136,12 @@ namespace dmGameSystem
         uint8_t m_StartAsEnabled : 1;
         uint8_t m_FlippedX : 1; // set if it's been flipped
         uint8_t m_FlippedY : 1;
+
+        uint8_t m_Interpolate : 1;      // The body transform is blended into the game object, see UpdateInterpolatedTransforms()
+        uint8_t m_HasPhysicsState : 1;  // m_PrevPosition/m_CurrPosition are valid
+        uint8_t m_PhysicsMoved : 1;     // The body was moved during the last fixed step
+        uint8_t m_WritePending : 1;     // The body moved in an earlier step, and the game object hasn't been updated since
+        uint8_t m_Teleported : 1;       // The game object was moved by someone else, and the body should follow at the next step
     };
 
     struct CollisionWorld
@@ -143,13 +160,38 @@ namespace dmGameSystem
         uint8_t     m_ComponentTypeIndex;
         uint8_t     m_3D : 1;
         uint8_t     m_FirstUpdate : 1;
+        uint8_t     m_Interpolate : 1;
+        uint8_t     m_BatchEvents : 1;  // Collect the events instead of sending messages, see physics.get_events()
+        uint8_t     m_ClearEvents : 1;  // Clear the events before the next step
         dmArray<CollisionComponent*> m_Components;
+
+        // Batched events
+        dmArray<dmPhysicsDDF::CollisionEvent>       m_CollisionEvents;
+        dmArray<dmPhysicsDDF::ContactPointEvent>    m_ContactPointEvents;
+        dmArray<dmPhysicsDDF::TriggerEvent>         m_TriggerEvents;
     };
 
     // Forward declarations
     static void DeleteJoint(CollisionWorld* world, dmPhysics::HJoint joint);
     static void DeleteJoint(CollisionWorld* world, JointEntry* joint_entry);
 
+    // Changes of the game object transform below these are considered noise, rather than the game object having been moved
+    static const float INTERPOLATION_POS_EPSILON = 0.0001f;
+    static const float INTERPOLATION_ROT_EPSILON = 0.0001f;
+
+    // Checks if the game object has been moved since the blended transform was written to it
+    static bool IsMovedByUser(CollisionComponent* component, const dmVMath::Point3& position, const dmVMath::Quat& rotation)
+    {
+        dmVMath::Vector3 dp = position - component->m_RenderPosition;
+        if (!component->m_3D)
+        {
+            dp.setZ(0.0f);
+        }
+        float dr = dmVMath::LengthSqr(rotation - component->m_RenderRotation);
+        return dmVMath::LengthSqr(dp) > INTERPOLATION_POS_EPSILON * INTERPOLATION_POS_EPSILON
+            || dr > INTERPOLATION_ROT_EPSILON * INTERPOLATION_ROT_EPSILON;
+    }
+
     static void GetWorldTransform(void* user_data, dmTransform::Transform& world_transform)
     {
         if (!user_data)
@@ -157,6 +199,30 @@ namespace dmGameSystem
         CollisionComponent* component = (CollisionComponent*)user_data;
         dmGameObject::HInstance instance = component->m_Instance;
         world_transform = dmGameObject::GetWorldTransform(instance);
+
+        if (component->m_Interpolate && component->m_HasPhysicsState)
+        {
+            // The game object holds a blended transform that lags behind the body.
+            // Unless it's been moved by someone else, the body should stay where it is.
+            dmVMath::Point3 position = dmGameObject::GetPosition(instance);
+            dmVMath::Quat rotation = dmGameObject::GetRotation(instance);
+            if (component->m_Teleported || IsMovedByUser(component, position, rotation))
+            {
+                // Teleported, skip the blend
+                component->m_PrevPosition = component->m_CurrPosition = component->m_RenderPosition = position;
+                component->m_PrevRotation = component->m_CurrRotation = component->m_RenderRotation = rotation;
+                component->m_Teleported = 0;
+                return;
+            }
+
+            dmVMath::Vector3 translation = dmVMath::Vector3(component->m_CurrPosition);
+            if (!component->m_3D)
+            {
+                translation.setZ(world_transform.GetTranslation().getZ());
+            }
+            world_transform.SetTranslation(translation);
+            world_transform.SetRotation(component->m_CurrRotation);
+        }
     }
 
     // TODO: Allow the SetWorldTransform to have a physics context which we can check instead!!
@@ -167,6 +233,31 @@ namespace dmGameSystem
         if (!user_data)
             return;
         CollisionComponent* component = (CollisionComponent*)user_data;
+        if (component->m_Interpolate)
+        {
+            // The game object is updated once per frame, in UpdateInterpolatedTransforms()
+            component->m_CurrPosition = position;
+            component->m_CurrRotation = rotation;
+            if (!component->m_HasPhysicsState)
+            {
+                component->m_PrevPosition = position;
+                component->m_PrevRotation = rotation;
+                component->m_RenderPosition = dmGameObject::GetPosition(component->m_Instance);
+                component->m_RenderRotation = dmGameObject::GetRotation(component->m_Instance);
+                component->m_HasPhysicsState = 1;
+            }
+            if (component->m_Teleported)
+            {
+                // The body didn't pick up the new transform (dynamic transforms are disabled),
+                // so the physics wins, as it does without interpolation
+                component->m_RenderPosition = dmGameObject::GetPosition(component->m_Instance);
+                component->m_RenderRotation = dmGameObject::GetRotation(component->m_Instance);
+                component->m_Teleported = 0;
+            }
+            component->m_PhysicsMoved = 1;
+            return;
+        }
+
         dmGameObject::HInstance instance = component->m_Instance;
         if (component->m_3D)
         {
@@ -234,6 +325,7 @@ namespace dmGameSystem
         world->m_ComponentTypeIndex = params.m_ComponentIndex;
         world->m_3D = physics_context->m_3D;
         world->m_FirstUpdate = 1;
+        world->m_Interpolate = physics_context->m_UseFixedTimestep && physics_context->m_Interpolate;
         world->m_Components.SetCapacity(comp_count);
         *params.m_World = world;
         return dmGameObject::CREATE_RESULT_OK;
@@ -468,8 +560,13 @@ namespace dmGameSystem
         component->m_FlippedX = 0;
         component->m_FlippedY = 0;
         component->m_ShapeBuffer = 0;
+        component->m_HasPhysicsState = 0;
+        component->m_PhysicsMoved = 0;
+        component->m_WritePending = 0;
+        component->m_Teleported = 0;
 
         CollisionWorld* world = (CollisionWorld*)params.m_World;
+        component->m_Interpolate = world->m_Interpolate;
         if (!CreateCollisionObject(physics_context, world, params.m_Instance, component, false))
         {
             delete component;
@@ -599,6 +696,16 @@ namespace dmGameSystem
         RunCollisionWorldCallback(world->m_CallbackInfo, desc, data);
     }
 
+    template <typename T>
+    static void PushEvent(dmArray<T>& events, const T& event)
+    {
+        if (events.Full())
+        {
+            events.OffsetCapacity(dmMath::Max(16U, events.Capacity()));
+        }
+        events.Push(event);
+    }
+
     bool CollisionCallback(void* user_data_a, uint16_t group_a, void* user_data_b, uint16_t group_b, void* user_data)
     {
         CollisionUserData* cud = (CollisionUserData*)user_data;
@@ -616,7 +723,7 @@ namespace dmGameSystem
             uint64_t group_hash_a = GetLSBGroupHash(world, group_a);
             uint64_t group_hash_b = GetLSBGroupHash(world, group_b);
 
-            if (world->m_CallbackInfo != 0x0)
+            if (world->m_BatchEvents || world->m_CallbackInfo != 0x0)
             {
                 dmPhysicsDDF::CollisionEvent ddf;
 
@@ -630,7 +737,10 @@ namespace dmGameSystem
                 b.m_Id =        instance_b_id;
                 b.m_Position =  dmGameObject::GetWorldPosition(instance_b);
 
-                RunPhysicsCallback(world, dmPhysicsDDF::CollisionEvent::m_DDFDescriptor, (const char*)&ddf);
+                if (world->m_BatchEvents)
+                    PushEvent(world->m_CollisionEvents, ddf);
+                else
+                    RunPhysicsCallback(world, dmPhysicsDDF::CollisionEvent::m_DDFDescriptor, (const char*)&ddf);
                 return true;
             }
 
@@ -679,7 +789,7 @@ namespace dmGameSystem
             uint64_t group_hash_a = GetLSBGroupHash(world, contact_point.m_GroupA);
             uint64_t group_hash_b = GetLSBGroupHash(world, contact_point.m_GroupB);
 
-            if (world->m_CallbackInfo != 0x0)
+            if (world->m_BatchEvents || world->m_CallbackInfo != 0x0)
             {
                 dmPhysicsDDF::ContactPointEvent ddf;
                 ddf.m_AppliedImpulse = contact_point.m_AppliedImpulse;
@@ -701,7 +811,10 @@ namespace dmGameSystem
                 b.m_RelativeVelocity    = contact_point.m_RelativeVelocity;
                 b.m_Normal              = contact_point.m_Normal;
 
-                RunPhysicsCallback(world, dmPhysicsDDF::ContactPointEvent::m_DDFDescriptor, (const char*)&ddf);
+                if (world->m_BatchEvents)
+                    PushEvent(world->m_ContactPointEvents, ddf);
+                else
+                    RunPhysicsCallback(world, dmPhysicsDDF::ContactPointEvent::m_DDFDescriptor, (const char*)&ddf);
                 return true;
             }
 
@@ -763,7 +876,7 @@ namespace dmGameSystem
         uint64_t group_hash_a = GetLSBGroupHash(world, trigger_enter.m_GroupA);
         uint64_t group_hash_b = GetLSBGroupHash(world, trigger_enter.m_GroupB);
 
-        if (world->m_CallbackInfo != 0x0)
+        if (world->m_BatchEvents || world->m_CallbackInfo != 0x0)
         {
 
             dmPhysicsDDF::TriggerEvent ddf;
@@ -777,7 +890,10 @@ namespace dmGameSystem
             b.m_Group       = group_hash_b;
             b.m_Id          = instance_b_id;
 
-            RunPhysicsCallback(world, dmPhysicsDDF::TriggerEvent::m_DDFDescriptor, (const char*)&ddf);
+            if (world->m_BatchEvents)
+                PushEvent(world->m_TriggerEvents, ddf);
+            else
+                RunPhysicsCallback(world, dmPhysicsDDF::TriggerEvent::m_DDFDescriptor, (const char*)&ddf);
             return;
         }
 
@@ -812,7 +928,7 @@ namespace dmGameSystem
         uint64_t group_hash_a = GetLSBGroupHash(world, trigger_exit.m_GroupA);
         uint64_t group_hash_b = GetLSBGroupHash(world, trigger_exit.m_GroupB);
 
-        if (world->m_CallbackInfo != 0x0)
+        if (world->m_BatchEvents || world->m_CallbackInfo != 0x0)
         {
             dmPhysicsDDF::TriggerEvent ddf;
             ddf.m_Enter = 0;
@@ -825,7 +941,10 @@ namespace dmGameSystem
             b.m_Group       = group_hash_b;
             b.m_Id          = instance_b_id;
 
-            RunPhysicsCallback(world, dmPhysicsDDF::TriggerEvent::m_DDFDescriptor, (const char*)&ddf);
+            if (world->m_BatchEvents)
+                PushEvent(world->m_TriggerEvents, ddf);
+            else
+                RunPhysicsCallback(world, dmPhysicsDDF::TriggerEvent::m_DDFDescriptor, (const char*)&ddf);
             return;
         }
 
@@ -1006,6 +1125,63 @@ namespace dmGameSystem
         return dispatch_context.m_Success;
     }
 
+    // Called before each fixed step, to keep the body transforms of the last two steps
+    static void BeginInterpolationStep(CollisionWorld* world)
+    {
+        DM_PROFILE("BeginInterpolationStep");
+        uint32_t num_components = world->m_Components.Size();
+        for (uint32_t i = 0; i < num_components; ++i)
+        {
+            CollisionComponent* c = world->m_Components[i];
+            if (!c->m_PhysicsMoved)
+                continue; // Sleeping, or not simulated (static, kinematic, triggers)
+            c->m_PrevPosition = c->m_CurrPosition;
+            c->m_PrevRotation = c->m_CurrRotation;
+            c->m_PhysicsMoved = 0;
+            // The game object still needs to reach the current transform, even if the body doesn't move again
+            c->m_WritePending = 1;
+        }
+    }
+
+    // Blends the body transforms of the last two fixed steps into the game objects.
+    // The blend factor is how far into the next fixed step the frame is, which means
+    // that the game objects lag at most one fixed step behind the bodies.
+    static bool UpdateInterpolatedTransforms(CollisionWorld* world, float alpha)
+    {
+        DM_PROFILE("UpdateInterpolatedTransforms");
+        alpha = dmMath::Clamp(alpha, 0.0f, 1.0f);
+        bool updated = false;
+        uint32_t num_components = world->m_Components.Size();
+        for (uint32_t i = 0; i < num_components; ++i)
+        {
+            CollisionComponent* c = world->m_Components[i];
+            if (!c->m_PhysicsMoved && !c->m_WritePending)
+                continue;
+
+            dmGameObject::HInstance instance = c->m_Instance;
+            if (c->m_Teleported || IsMovedByUser(c, dmGameObject::GetPosition(instance), dmGameObject::GetRotation(instance)))
+            {
+                // Keep the new transform, the body is moved there at the next step
+                c->m_Teleported = 1;
+                continue;
+            }
+            dmVMath::Point3 position = dmVMath::Point3(dmVMath::Lerp(alpha, dmVMath::Vector3(c->m_PrevPosition), dmVMath::Vector3(c->m_CurrPosition)));
+            if (!c->m_3D)
+            {
+                // Preserve z for 2D physics
+                position.setZ(dmGameObject::GetPosition(instance).getZ());
+            }
+            dmVMath::Quat rotation = dmVMath::Slerp(alpha, c->m_PrevRotation, c->m_CurrRotation);
+            dmGameObject::SetPosition(instance, position);
+            dmGameObject::SetRotation(instance, rotation);
+            c->m_RenderPosition = dmGameObject::GetPosition(instance);
+            c->m_RenderRotation = dmGameObject::GetRotation(instance);
+            c->m_WritePending = 0;
+            updated = true;
+        }
+        return updated;
+    }
+
     static void Step(CollisionWorld* world, PhysicsContext* physics_context, dmGameObject::HCollection collection, const dmPhysics::StepWorldContext* step_ctx)
     {
         CollisionUserData* collision_user_data = (CollisionUserData*)step_ctx->m_CollisionUserData;
@@ -1015,6 +1191,20 @@ namespace dmGameSystem
 
         world->m_CurrentDT = step_ctx->m_DT;
 
+        if (world->m_Interpolate)
+        {
+            BeginInterpolationStep(world);
+        }
+
+        if (world->m_ClearEvents)
+        {
+            // Keep the events of all the steps in a frame, until they're read or the next frame is stepped
+            world->m_CollisionEvents.SetSize(0);
+            world->m_ContactPointEvents.SetSize(0);
+            world->m_TriggerEvents.SetSize(0);
+            world->m_ClearEvents = 0;
+        }
+
         if (!CompCollisionObjectDispatchPhysicsMessages(physics_context, world, collection))
         {
             dmLogWarning("Failed to dispatch physics messages");
@@ -1141,8 +1331,26 @@ namespace dmGameSystem
     {
 
         PhysicsContext* physics_context = (PhysicsContext*)params.m_Context;
+        CollisionWorld* world = (CollisionWorld*)params.m_World;
+        if (world != 0x0)
+        {
+            world->m_ClearEvents = 1;
+        }
+
         if (physics_context->m_UseFixedTimestep)
+        {
+            if (world != 0x0 && world->m_Interpolate)
+            {
+                // The fixed steps for this frame are taken after the regular update, so we present the
+                // result of the previous frame's steps. The accumulated time is what remained after those.
+                const dmGameObject::UpdateContext* update_context = params.m_UpdateContext;
+                float alpha = 1.0f;
+                if (update_context->m_FixedUpdateFrequency != 0)
+                    alpha = update_context->m_AccumFrameTime * update_context->m_FixedUpdateFrequency;
+                update_result.m_TransformsUpdated = UpdateInterpolatedTransforms(world, alpha);
+            }
             return dmGameObject::UPDATE_RESULT_OK; // Let the fixed update handle this
+        }
 
         return CompCollisionObjectUpdateInternal(params, update_result);
     }
@@ -1313,6 +1521,10 @@ namespace dmGameSystem
         component->m_Resource = (CollisionObjectResource*)params.m_Resource;
         component->m_AddedToUpdate = false;
         component->m_StartAsEnabled = true;
+        component->m_HasPhysicsState = 0;
+        component->m_PhysicsMoved = 0;
+        component->m_WritePending = 0;
+        component->m_Teleported = 0;
         if (!CreateCollisionObject(physics_context, world, params.m_Instance, component, true))
         {
             dmLogError("%s", "Could not recreate collision object component, not reloaded.");
@@ -2006,6 +2218,41 @@ namespace dmGameSystem
         world->m_CallbackInfo = callback_info;
     }
 
+    bool IsCollisionWorldEventBatching(void* _world)
+    {
+        CollisionWorld* world = (CollisionWorld*)_world;
+        return world->m_BatchEvents;
+    }
+
+    void SetCollisionWorldEventBatching(void* _world, bool enable)
+    {
+        CollisionWorld* world = (CollisionWorld*)_world;
+        world->m_BatchEvents = enable;
+        if (!enable)
+        {
+            ClearCollisionWorldEvents(world);
+        }
+    }
+
+    void GetCollisionWorldEvents(void* _world, CollisionWorldEvents* events)
+    {
+        CollisionWorld* world = (CollisionWorld*)_world;
+        events->m_CollisionEvents           = world->m_CollisionEvents.Begin();
+        events->m_CollisionEventCount       = world->m_CollisionEvents.Size();
+        events->m_ContactPointEvents        = world->m_ContactPointEvents.Begin();
+        events->m_ContactPointEventCount    = world->m_ContactPointEvents.Size();
+        events->m_TriggerEvents             = world->m_TriggerEvents.Begin();
+        events->m_TriggerEventCount         = world->m_TriggerEvents.Size();
+    }
+
+    void ClearCollisionWorldEvents(void* _world)
+    {
+        CollisionWorld* world = (CollisionWorld*)_world;
+        world->m_CollisionEvents.SetSize(0);
+        world->m_ContactPointEvents.SetSize(0);
+        world->m_TriggerEvents.SetSize(0);
+    }
+
     dmhash_t GetCollisionGroup(void* _world, void* _component)
     {
         CollisionWorld* world = (CollisionWorld*)_world;
@@ -93,6 +93,24 @@ namespace dmGameSystem
     void SetCollisionWorldCallback(void* _world, void* callback_info);
     void RunCollisionWorldCallback(void* callback_data, const dmDDF::Descriptor* desc, const char* data);
 
+    // Batched events. When enabled, the collision, contact point and trigger events of a frame
+    // are collected in the world, instead of being sent as messages or to the world listener.
+    struct CollisionWorldEvents
+    {
+        const dmPhysicsDDF::CollisionEvent*     m_CollisionEvents;
+        const dmPhysicsDDF::ContactPointEvent*  m_ContactPointEvents;
+        const dmPhysicsDDF::TriggerEvent*       m_TriggerEvents;
+        uint32_t                                m_CollisionEventCount;
+        uint32_t                                m_ContactPointEventCount;
+        uint32_t                                m_TriggerEventCount;
+    };
+
+    bool IsCollisionWorldEventBatching(void* _world);
+    void SetCollisionWorldEventBatching(void* _world, bool enable);
+    // The events are valid until the next physics step, or until they're cleared
+    void GetCollisionWorldEvents(void* _world, CollisionWorldEvents* events);
+    void ClearCollisionWorldEvents(void* _world);
+
     struct ShapeInfo
     {
         union
@@ -269,6 +269,10 @@ namespace dmGameSystem
                 dmLogError("Failed to get factory prototype resource: %s", resource->m_PrototypePath);
                 return 0;
             }
+            if(resource->m_PoolSize)
+            {
+                dmGameObject::SetInstancePoolSize(resource->m_Prototype, resource->m_PoolSize);
+            }
         }
         return resource->m_Prototype;
     }
@@ -484,5 +488,28 @@ namespace dmGameSystem
         return instance;
     }
 
+    uint32_t CompFactorySpawnBatch(HFactoryWorld world, HFactoryComponent component, dmGameObject::HCollection collection,
+                                                uint32_t count, const uint32_t* indices, const dmhash_t* ids,
+                                                const dmVMath::Point3* positions, const dmVMath::Quat* rotations, const dmVMath::Vector3* scales,
+                                                dmGameObject::HPropertyContainer properties, dmGameObject::HInstance* out_instances)
+    {
+        dmGameObject::HPrototype prototype = CompFactoryGetPrototype(world, component);
+        const char* path = CompFactoryGetPrototypePath(world, component);
+
+        uint32_t spawned = dmGameObject::SpawnBatch(collection, prototype, path, count, ids, properties, positions, rotations, scales, out_instances);
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            if (out_instances[i] != 0x0)
+            {
+                dmGameObject::AssignInstanceIndex(indices[i], out_instances[i]);
+            }
+            else
+            {
+                dmGameObject::ReleaseInstanceIndex(indices[i], collection);
+            }
+        }
+        return spawned;
+    }
+
 
 }
@@ -22,6 +22,7 @@
 #include <dlib/hash.h>
 #include <dlib/log.h>
 #include <dlib/math.h>
+#include <dlib/memory.h>
 #include <dlib/message.h>
 #include <dlib/object_pool.h>
 #include <dlib/profile.h>
@@ -85,6 +86,10 @@ namespace dmGameSystem
         dmGraphics::HVertexBuffer m_VertexBuffer;
         uint32_t m_RefCount;
         uint32_t m_Version;
+        // What was last uploaded to the vertex buffer, so that only the changed range needs to be uploaded
+        dmBuffer::HBuffer m_Buffer;
+        uint32_t m_ContentVersion;
+        uint32_t m_Size;
     };
 
     struct MeshWorld
@@ -140,17 +145,21 @@ namespace dmGameSystem
         return info->m_VertexBuffer;
     }
 
-    static void AddVertexBufferInfo(MeshWorld* world, dmhash_t path, dmGraphics::HVertexBuffer vertex_buffer, uint32_t version)
+    static VertexBufferInfo* AddVertexBufferInfo(MeshWorld* world, dmhash_t path, dmGraphics::HVertexBuffer vertex_buffer, uint32_t version)
     {
         VertexBufferInfo info;
         info.m_RefCount = 1;
         info.m_VertexBuffer = vertex_buffer;
         info.m_Version = version;
+        info.m_Buffer = 0;
+        info.m_ContentVersion = 0;
+        info.m_Size = 0;
         if (world->m_ResourceToVertexBuffer.Full()) {
             uint32_t capacity = world->m_ResourceToVertexBuffer.Capacity() + 8;
             world->m_ResourceToVertexBuffer.SetCapacity(capacity/3, capacity);
         }
         world->m_ResourceToVertexBuffer.Put(path, info);
+        return world->m_ResourceToVertexBuffer.Get(path);
     }
 
     static void DecRefVertexBuffer(MeshWorld* world, dmhash_t path)
@@ -185,14 +194,39 @@ namespace dmGameSystem
         return dmHashFinal32(&state);
     }
 
-    static void CopyBufferToVertexBuffer(dmBuffer::HBuffer buffer, dmGraphics::HVertexBuffer vertex_buffer, uint32_t vert_size, uint32_t elem_count, dmGraphics::BufferUsage buffer_usage)
+    static void CopyBufferToVertexBuffer(VertexBufferInfo* info, BufferResource* br, dmGraphics::BufferUsage buffer_usage)
     {
         uint8_t* bytes = 0x0;
-        uint32_t size = 0;
-        dmBuffer::Result r = dmBuffer::GetBytes(buffer, (void**)&bytes, &size);
+        uint32_t bytes_size = 0;
+        dmBuffer::Result r = dmBuffer::GetBytes(br->m_Buffer, (void**)&bytes, &bytes_size);
         assert(r == dmBuffer::RESULT_OK);
 
-        dmGraphics::SetVertexBufferData(vertex_buffer, vert_size * elem_count, bytes, buffer_usage);
+        uint32_t content_version = 0;
+        dmBuffer::GetContentVersion(br->m_Buffer, &content_version);
+        uint32_t size = br->m_Stride * br->m_ElementCount;
+
+        // If it's the same buffer as last time, only the range changed since then needs to be uploaded
+        uint32_t dirty_offset = 0;
+        uint32_t dirty_size = size;
+        if (info->m_Buffer == br->m_Buffer && info->m_Size == size)
+        {
+            dmBuffer::GetDirtyRange(br->m_Buffer, info->m_ContentVersion, &dirty_offset, &dirty_size);
+            dirty_offset = dmMath::Min(dirty_offset, size);
+            dirty_size = dmMath::Min(dirty_size, size - dirty_offset);
+        }
+
+        if (dirty_size == size)
+        {
+            dmGraphics::SetVertexBufferData(info->m_VertexBuffer, size, bytes, buffer_usage);
+        }
+        else if (dirty_size > 0)
+        {
+            dmGraphics::SetVertexBufferSubData(info->m_VertexBuffer, dirty_offset, dirty_size, bytes + dirty_offset);
+        }
+
+        info->m_Buffer = br->m_Buffer;
+        info->m_ContentVersion = content_version;
+        info->m_Size = size;
     }
 
     static void CreateVertexBuffer(MeshWorld* world, dmGameSystem::BufferResource* br, uint32_t version)
@@ -201,9 +235,9 @@ namespace dmGameSystem
         if (!vertex_buffer)
         {
             vertex_buffer = AllocVertexBuffer(world, world->m_GraphicsContext);
-            AddVertexBufferInfo(world, br->m_NameHash, vertex_buffer, version); // ref count == 1
+            VertexBufferInfo* info = AddVertexBufferInfo(world, br->m_NameHash, vertex_buffer, version); // ref count == 1
 
-            CopyBufferToVertexBuffer(br->m_Buffer, vertex_buffer, br->m_Stride, br->m_ElementCount, dmGraphics::BUFFER_USAGE_STREAM_DRAW);
+            CopyBufferToVertexBuffer(info, br, dmGraphics::BUFFER_USAGE_STREAM_DRAW);
         }
         else
         {
@@ -258,7 +292,7 @@ namespace dmGameSystem
 
         if (world->m_WorldVertexData)
         {
-            free(world->m_WorldVertexData);
+            dmMemory::Free(dmMemory::TAG_GAMESYS, world->m_WorldVertexData);
         }
 
         dmResource::UnregisterResourceReloadedCallback(((MeshContext*)params.m_Context)->m_Factory, ResourceReloadedCallback, world);
@@ -501,7 +535,7 @@ namespace dmGameSystem
                 {
                     info->m_Version = component.m_BufferVersion;
 
-                    CopyBufferToVertexBuffer(br->m_Buffer, info->m_VertexBuffer, br->m_Stride, br->m_ElementCount, dmGraphics::BUFFER_USAGE_DYNAMIC_DRAW);
+                    CopyBufferToVertexBuffer(info, br, dmGraphics::BUFFER_USAGE_DYNAMIC_DRAW);
                 }
             }
 
@@ -693,7 +727,7 @@ namespace dmGameSystem
         if (world->m_WorldVertexDataSize < vert_size * element_count)
         {
             world->m_WorldVertexDataSize = vert_size * element_count;
-            world->m_WorldVertexData = realloc(world->m_WorldVertexData, world->m_WorldVertexDataSize);
+            world->m_WorldVertexData = dmMemory::Realloc(dmMemory::TAG_GAMESYS, world->m_WorldVertexData, world->m_WorldVertexDataSize);
         }
 
         // Fill scratch buffer with data
@@ -16,6 +16,7 @@
 
 #include <string.h>
 #include <float.h>
+#include <algorithm>
 
 #include <dlib/array.h>
 #include <dlib/hash.h>
@@ -25,6 +26,7 @@
 #include <dlib/dstrings.h>
 #include <dlib/object_pool.h>
 #include <dlib/math.h>
+#include <dlib/memory.h>
 #include <dmsdk/dlib/vmath.h>
 #include <dmsdk/dlib/intersection.h>
 #include <graphics/graphics.h>
@@ -53,6 +55,7 @@ DM_PROPERTY_U32(rmtp_Model, 0, FrameReset, "# components", &rmtp_Components);
 DM_PROPERTY_U32(rmtp_ModelIndexCount, 0, FrameReset, "# indices", &rmtp_Model);
 DM_PROPERTY_U32(rmtp_ModelVertexCount, 0, FrameReset, "# vertices", &rmtp_Model);
 DM_PROPERTY_U32(rmtp_ModelVertexSize, 0, FrameReset, "size of vertices in bytes", &rmtp_Model);
+DM_PROPERTY_U32(rmtp_ModelInstanced, 0, FrameReset, "# meshes drawn with instancing", &rmtp_Model);
 
 namespace dmGameSystem
 {
@@ -65,6 +68,12 @@ namespace dmGameSystem
     {
         dmGraphics::HVertexBuffer      m_VertexBuffer;
         dmGraphics::HVertexDeclaration m_VertexDeclaration;
+        // Only set when the world matrix is written per vertex, since it has to be rewritten when the mesh moves
+        uint8_t*                       m_VertexData;
+        uint32_t                       m_VertexCount;
+        uint32_t                       m_VertexStride;
+        uint32_t                       m_WorldMatrixOffset;
+        dmVMath::Matrix4               m_WorldMatrix;
     };
 
     struct MeshRenderItem
@@ -83,6 +92,13 @@ namespace dmGameSystem
         uint32_t                    : 15;
     };
 
+    // A render item waiting to be drawn instanced, and the group (mesh and material slot) it belongs to
+    struct InstanceItem
+    {
+        MeshRenderItem* m_Item;
+        uint32_t        m_Group;
+    };
+
     struct ModelComponent
     {
         dmGameObject::HInstance     m_Instance;
@@ -121,6 +137,14 @@ namespace dmGameSystem
         // Temporary scratch array for instances, only used during the creation phase of components
         dmArray<dmGameObject::HInstance> m_ScratchInstances;
         dmRig::HRigContext               m_RigContext;
+        // Per instance world matrices for local space materials. The declaration is 0 if instancing isn't supported,
+        // and the world matrices are then written per vertex instead (see SetupMeshAttributeRenderData)
+        dmGraphics::HVertexDeclaration           m_InstanceVertexDeclaration;
+        dmArray<dmRender::HBufferedRenderBuffer> m_InstanceBuffers; // One per instanced draw call during the frame
+        dmArray<InstanceItem>                    m_InstanceItems;   // Scratch, only used while rendering a batch
+        dmArray<MeshRenderItem*>                 m_InstanceGroups;  // Scratch, the first item of each group in the batch
+        dmArray<Matrix4>                         m_InstanceData;    // Scratch, only used while rendering a batch
+        uint32_t                         m_InstanceBufferCount;
         uint32_t                         m_MaxElementsVertices;
         uint32_t                         m_MaxBatchIndex;
     };
@@ -183,6 +207,17 @@ namespace dmGameSystem
 
         dmGraphics::DeleteVertexStreamDeclaration(stream_declaration);
 
+        world->m_InstanceVertexDeclaration = 0;
+        world->m_InstanceBufferCount = 0;
+        if (dmGraphics::IsContextFeatureSupported(graphics_context, dmGraphics::CONTEXT_FEATURE_INSTANCING))
+        {
+            stream_declaration = dmGraphics::NewVertexStreamDeclaration(graphics_context);
+            dmGraphics::AddVertexStream(stream_declaration, dmRender::VERTEX_STREAM_WORLD_MATRIX, 16, dmGraphics::TYPE_FLOAT, false);
+            world->m_InstanceVertexDeclaration = dmGraphics::NewVertexDeclaration(graphics_context, stream_declaration);
+            dmGraphics::SetVertexDeclarationStepFunction(world->m_InstanceVertexDeclaration, dmGraphics::VERTEX_STEP_FUNCTION_INSTANCE);
+            dmGraphics::DeleteVertexStreamDeclaration(stream_declaration);
+        }
+
         *params.m_World = world;
 
         dmResource::RegisterResourceReloadedCallback(context->m_Factory, ResourceReloadedCallback, world);
@@ -199,6 +234,14 @@ namespace dmGameSystem
         {
             dmRender::DeleteBufferedRenderBuffer(context->m_RenderContext, world->m_VertexBuffers[i]);
         }
+        for(uint32_t i = 0; i < world->m_InstanceBuffers.Size(); ++i)
+        {
+            dmRender::DeleteBufferedRenderBuffer(context->m_RenderContext, world->m_InstanceBuffers[i]);
+        }
+        if (world->m_InstanceVertexDeclaration)
+        {
+            dmGraphics::DeleteVertexDeclaration(world->m_InstanceVertexDeclaration);
+        }
 
         dmResource::UnregisterResourceReloadedCallback(((ModelContext*)params.m_Context)->m_Factory, ResourceReloadedCallback, world);
 
@@ -280,15 +323,13 @@ namespace dmGameSystem
 
         if (!pose.Empty()) {
             uint32_t bone_count = pose.Size();
-            dmArray<dmTransform::Transform> transforms;
-            transforms.SetCapacity(bone_count);
-            transforms.SetSize(bone_count);
+            dmTransform::Transform* transforms = (dmTransform::Transform*)dmMemory::FrameAlloc(bone_count * sizeof(dmTransform::Transform));
             for (uint32_t i = 0; i < bone_count; ++i)
             {
                 transforms[i] = pose[i].m_Local;
             }
 
-            dmGameObject::SetBoneTransforms(component->m_NodeInstances[0], component->m_Transform, transforms.Begin(), transforms.Size());
+            dmGameObject::SetBoneTransforms(component->m_NodeInstances[0], component->m_Transform, transforms, bone_count);
         }
     }
 
@@ -302,6 +343,11 @@ namespace dmGameSystem
                (name_hash == dmRender::VERTEX_STREAM_TEXCOORD1 && semantic_type == dmGraphics::VertexAttribute::SEMANTIC_TYPE_TEXCOORD);
     }
 
+    static inline bool HasWorldMatrixAttribute(dmRender::HMaterial material)
+    {
+        return dmRender::GetMaterialAttributeIndex(material, dmRender::VERTEX_STREAM_WORLD_MATRIX) != dmRender::INVALID_MATERIAL_ATTRIBUTE_INDEX;
+    }
+
     static inline MaterialResource* GetMaterialResource(const ModelComponent* component, const ModelResource* resource, uint32_t index) {
         // TODO: Add support for setting material on different indices
         return component->m_Material ? component->m_Material : resource->m_Materials[index].m_Material;
@@ -504,7 +550,8 @@ namespace dmGameSystem
         for (int i = 0; i < attribute_count; ++i)
         {
             const dmGraphics::VertexAttribute& attr = attributes[i];
-            if (!IsDefaultStream(attr.m_NameHash, attr.m_SemanticType))
+            // The world matrix is either drawn instanced, or added to the attribute render data when it's needed
+            if (!IsDefaultStream(attr.m_NameHash, attr.m_SemanticType) && attr.m_NameHash != dmRender::VERTEX_STREAM_WORLD_MATRIX)
             {
                 return true;
             }
@@ -512,6 +559,17 @@ namespace dmGameSystem
         return false;
     }
 
+    static void WriteVertexWorldMatrix(MeshAttributeRenderData* rd, const Matrix4& world)
+    {
+        rd->m_WorldMatrix = world;
+        uint8_t* write_ptr = rd->m_VertexData + rd->m_WorldMatrixOffset;
+        for (uint32_t i = 0; i < rd->m_VertexCount; ++i)
+        {
+            memcpy(write_ptr, &world, sizeof(Matrix4));
+            write_ptr += rd->m_VertexStride;
+        }
+    }
+
     static void SetupMeshAttributeRenderData(dmRender::HRenderContext render_context, dmRender::HMaterial material, const MeshRenderItem* render_item, dmGraphics::VertexAttribute* model_attributes, uint32_t model_attribute_count, MeshAttributeRenderData* rd)
     {
         assert(!rd->m_VertexBuffer);
@@ -537,6 +595,9 @@ namespace dmGameSystem
         non_default_attribute.m_VertexStride = 0;
         non_default_attribute.m_NumInfos     = 0;
 
+        const uint32_t no_world_matrix = 0xffffffff;
+        uint32_t world_matrix_offset   = no_world_matrix;
+
         for (int i = 0; i < material_infos.m_NumInfos; ++i)
         {
             const dmGraphics::VertexAttributeInfo& attr_material = material_infos.m_Infos[i];
@@ -545,6 +606,11 @@ namespace dmGameSystem
             if (!IsDefaultStream(attr_model.m_NameHash, attr_material.m_SemanticType))
             {
                 assert(attr_model.m_NameHash == attr_material.m_NameHash);
+                if (attr_model.m_NameHash == dmRender::VERTEX_STREAM_WORLD_MATRIX && attr_model.m_ValueByteSize == sizeof(Matrix4))
+                {
+                    world_matrix_offset = non_default_attribute.m_VertexStride;
+                }
+
                 dmGraphics::AddVertexStream(stream_declaration,
                     attr_model.m_NameHash,
                     attr_material.m_ElementCount, // Need the material attribute here to get the _actual_ element count
@@ -578,17 +644,50 @@ namespace dmGameSystem
                 positions, normals, tangents, uv0, uv1, colors);
         }
 
+        if (world_matrix_offset != no_world_matrix)
+        {
+            // The vertex data is kept, so that the world matrix can be updated (see AddLocalRenderObject)
+            rd->m_VertexData        = (uint8_t*) attribute_data;
+            rd->m_VertexCount       = vertex_count;
+            rd->m_VertexStride      = non_default_attribute.m_VertexStride;
+            rd->m_WorldMatrixOffset = world_matrix_offset;
+            WriteVertexWorldMatrix(rd, render_item->m_World);
+        }
+
         rd->m_VertexBuffer      = dmGraphics::NewVertexBuffer(graphics_context, vertex_data_size, attribute_data, dmGraphics::BUFFER_USAGE_DYNAMIC_DRAW);
         rd->m_VertexDeclaration = dmGraphics::NewVertexDeclaration(graphics_context, stream_declaration);
 
         dmGraphics::DeleteVertexStreamDeclaration(stream_declaration);
 
-        free(attribute_data);
+        if (!rd->m_VertexData)
+        {
+            free(attribute_data);
+        }
         free(scratch_attribute_vertex);
     }
 
+    static void DestroyMeshAttributeRenderDatas(ModelComponent* component)
+    {
+        for (uint32_t i = 0; i < component->m_MeshAttributeRenderDatas.Size(); ++i)
+        {
+            MeshAttributeRenderData& rd = component->m_MeshAttributeRenderDatas[i];
+            if (rd.m_VertexBuffer)
+            {
+                dmGraphics::DeleteVertexBuffer(rd.m_VertexBuffer);
+            }
+            if (rd.m_VertexDeclaration)
+            {
+                dmGraphics::DeleteVertexDeclaration(rd.m_VertexDeclaration);
+            }
+            free(rd.m_VertexData);
+        }
+        component->m_MeshAttributeRenderDatas.SetCapacity(0);
+    }
+
     static void SetupRenderItems(ModelComponent* component, ModelResource* resource)
     {
+        DestroyMeshAttributeRenderDatas(component);
+
         component->m_RenderItems.SetCapacity(resource->m_Meshes.Size());
         component->m_RenderItems.SetSize(0);
 
@@ -743,6 +842,7 @@ namespace dmGameSystem
         dmGameObject::DeleteBones(component->m_Instance);
         // If we're going to use memset, then we should explicitly clear pose and instance arrays.
         component->m_NodeInstances.SetCapacity(0);
+        DestroyMeshAttributeRenderDatas(component);
 
         if (component->m_RigInstance)
         {
@@ -775,81 +875,227 @@ namespace dmGameSystem
         return dmGameObject::CREATE_RESULT_OK;
     }
 
-    static inline void RenderBatchLocalVS(ModelWorld* world, dmRender::HRenderContext render_context, dmRender::HMaterial render_context_material, dmRender::RenderListEntry *buf, uint32_t* begin, uint32_t* end)
+    static void AddLocalRenderObject(ModelWorld* world, dmRender::HRenderContext render_context, dmRender::HMaterial render_context_material, bool render_context_material_custom_attributes,
+                                     MeshRenderItem* render_item, uint32_t instance_count)
     {
-        DM_PROFILE("RenderBatchLocal");
+        const ModelResourceBuffers* buffers = render_item->m_Buffers;
+        ModelComponent* component = render_item->m_Component;
+        uint32_t material_index = render_item->m_MaterialIndex;
 
-        bool render_context_material_custom_attributes = false;
-        if (render_context_material)
+        // Without the instance buffer, the world matrix is written per vertex to the attribute render data
+        bool vertex_world_matrix = instance_count == 0 && HasWorldMatrixAttribute(GetRenderMaterial(render_context_material, component, component->m_Resource, material_index));
+
+        world->m_RenderObjects.SetSize(world->m_RenderObjects.Size()+1);
+        dmRender::RenderObject& ro = world->m_RenderObjects.Back();
+
+        ro.Init();
+        ro.m_Material              = GetComponentMaterial(component, component->m_Resource, material_index);
+        ro.m_PrimitiveType         = dmGraphics::PRIMITIVE_TRIANGLES;
+        ro.m_VertexDeclarations[0] = world->m_VertexDeclaration;
+        ro.m_VertexBuffers[0]      = buffers->m_VertexBuffer;
+
+        if (instance_count > 0)
         {
-            render_context_material_custom_attributes = HasCustomVertexAttributes(render_context_material);
+            // The world matrices of the instances have been written to the last instance buffer
+            ro.m_VertexDeclarations[1] = world->m_InstanceVertexDeclaration;
+            ro.m_VertexBuffers[1]      = (dmGraphics::HVertexBuffer) dmRender::GetBuffer(render_context, world->m_InstanceBuffers[world->m_InstanceBufferCount - 1]);
+            ro.m_InstanceCount         = instance_count;
+        }
+        else if (render_context_material_custom_attributes || vertex_world_matrix || render_item->m_AttributeRenderDataIndex != ATTRIBUTE_RENDER_DATA_INDEX_UNUSED)
+        {
+            // The overridden material from the render script might be setup with custom vertex attributes,
+            // while the component material might not. In this case, we need to setup the attribute render data
+            // specifically for the render material.
+            if (render_item->m_AttributeRenderDataIndex == ATTRIBUTE_RENDER_DATA_INDEX_UNUSED)
+            {
+                render_item->m_AttributeRenderDataIndex = component->m_MeshAttributeRenderDatas.Size();
+                component->m_MeshAttributeRenderDatas.OffsetCapacity(1);
+                component->m_MeshAttributeRenderDatas.SetSize(component->m_MeshAttributeRenderDatas.Capacity());
+                memset(&component->m_MeshAttributeRenderDatas.Back(), 0, sizeof(MeshAttributeRenderData));
+            }
+
+            MeshAttributeRenderData* attribute_rd = &component->m_MeshAttributeRenderDatas[render_item->m_AttributeRenderDataIndex];
+
+            if (!attribute_rd->m_VertexDeclaration)
+            {
+                SetupMeshAttributeRenderData(render_context,
+                    GetRenderMaterial(render_context_material, component, component->m_Resource, material_index),
+                    render_item,
+                    component->m_Resource->m_Materials[material_index].m_Attributes,
+                    component->m_Resource->m_Materials[material_index].m_AttributeCount,
+                    attribute_rd);
+            }
+            else if (attribute_rd->m_VertexData && memcmp(&attribute_rd->m_WorldMatrix, &render_item->m_World, sizeof(Matrix4)) != 0)
+            {
+                WriteVertexWorldMatrix(attribute_rd, render_item->m_World);
+                dmGraphics::SetVertexBufferData(attribute_rd->m_VertexBuffer, attribute_rd->m_VertexCount * attribute_rd->m_VertexStride, attribute_rd->m_VertexData, dmGraphics::BUFFER_USAGE_DYNAMIC_DRAW);
+            }
+
+            ro.m_VertexDeclarations[1] = attribute_rd->m_VertexDeclaration;
+            ro.m_VertexBuffers[1]      = attribute_rd->m_VertexBuffer;
         }
 
-        for (uint32_t *i=begin;i!=end;i++)
+        // These should be named "element" or "index" (as opposed to vertex)
+        ro.m_VertexStart    = 0;
+        ro.m_VertexCount    = buffers->m_IndexCount;
+        ro.m_WorldTransform = render_item->m_World;
+        ro.m_IndexBuffer    = buffers->m_IndexBuffer;              // May be 0
+        ro.m_IndexType      = buffers->m_IndexBufferElementType;
+
+        uint32_t mesh_count = dmMath::Max(instance_count, 1u);
+        DM_PROPERTY_ADD_U32(rmtp_ModelIndexCount, buffers->m_IndexCount * mesh_count);
+        DM_PROPERTY_ADD_U32(rmtp_ModelVertexCount, buffers->m_VertexCount * mesh_count);
+        DM_PROPERTY_ADD_U32(rmtp_ModelVertexSize, buffers->m_VertexCount * sizeof(dmRig::RigModelVertex));
+
+        FillTextures(&ro, component, material_index);
+
+        if (component->m_RenderConstants)
         {
-            MeshRenderItem* render_item = (MeshRenderItem*) buf[*i].m_UserData;
-            const ModelResourceBuffers* buffers = render_item->m_Buffers;
-            ModelComponent* component = render_item->m_Component;
-            uint32_t material_index = render_item->m_MaterialIndex;
-            dmRender::HMaterial render_material = GetRenderMaterial(render_context_material, component, component->m_Resource, material_index);
+            dmGameSystem::EnableRenderObjectConstants(&ro, component->m_RenderConstants);
+        }
+
+        dmRender::AddToRender(render_context, &ro);
+    }
+
+    // A mesh can be instanced when the material reads the world matrix from a vertex attribute,
+    // and doesn't need any other per mesh vertex data
+    static inline bool CanInstanceRenderItem(ModelWorld* world, dmRender::HMaterial render_material, bool render_context_material_custom_attributes, const MeshRenderItem* render_item)
+    {
+        return world->m_InstanceVertexDeclaration &&
+               !render_context_material_custom_attributes &&
+               render_item->m_AttributeRenderDataIndex == ATTRIBUTE_RENDER_DATA_INDEX_UNUSED &&
+               HasWorldMatrixAttribute(render_material);
+    }
+
+    static inline bool InstanceItemLess(const InstanceItem& a, const InstanceItem& b)
+    {
+        return a.m_Group < b.m_Group;
+    }
+
+    // Groups are numbered in the order they first appear in the batch
+    static void AddInstanceItem(ModelWorld* world, MeshRenderItem* render_item)
+    {
+        dmArray<MeshRenderItem*>& groups = world->m_InstanceGroups;
+        uint32_t group_count = groups.Size();
+        uint32_t group = 0;
+        for (; group < group_count; ++group)
+        {
+            if (groups[group]->m_Buffers == render_item->m_Buffers && groups[group]->m_MaterialIndex == render_item->m_MaterialIndex)
+                break;
+        }
 
-            // We currently have no support for instancing, so we generate a separate draw call for each render item
-            world->m_RenderObjects.SetSize(world->m_RenderObjects.Size()+1);
-            dmRender::RenderObject& ro = world->m_RenderObjects.Back();
+        if (group == group_count)
+        {
+            if (groups.Full())
+            {
+                groups.OffsetCapacity(8);
+            }
+            groups.Push(render_item);
+        }
 
-            ro.Init();
-            ro.m_Material              = GetComponentMaterial(component, component->m_Resource, material_index);
-            ro.m_PrimitiveType         = dmGraphics::PRIMITIVE_TRIANGLES;
-            ro.m_VertexDeclarations[0] = world->m_VertexDeclaration;
-            ro.m_VertexBuffers[0]      = buffers->m_VertexBuffer;
+        InstanceItem item;
+        item.m_Item = render_item;
+        item.m_Group = group;
+        world->m_InstanceItems.Push(item);
+    }
 
-            if (render_context_material_custom_attributes || render_item->m_AttributeRenderDataIndex != ATTRIBUTE_RENDER_DATA_INDEX_UNUSED)
+    static void RenderInstancedLocalVS(ModelWorld* world, dmRender::HRenderContext render_context, dmRender::HMaterial render_context_material)
+    {
+        DM_PROFILE("RenderInstancedLocal");
+
+        // All items in the batch share material, textures and constants (see ReHash), so the items
+        // that use the same mesh and material slot can be drawn with a single instanced draw call.
+        // The sort is stable, so the groups are drawn in the order they appear in the batch, and
+        // the instances keep their order within each group
+        dmArray<InstanceItem>& items = world->m_InstanceItems;
+        std::stable_sort(items.Begin(), items.End(), InstanceItemLess);
+
+        uint32_t item_count = items.Size();
+        uint32_t group_begin = 0;
+        while (group_begin < item_count)
+        {
+            MeshRenderItem* first = items[group_begin].m_Item;
+            uint32_t group_end = group_begin + 1;
+            while (group_end < item_count && items[group_end].m_Group == items[group_begin].m_Group)
             {
-                // The overridden material from the render script might be setup with custom vertex attributes,
-                // while the component material might not. In this case, we need to setup the attribute render data
-                // specifically for the render material.
-                if (render_item->m_AttributeRenderDataIndex == ATTRIBUTE_RENDER_DATA_INDEX_UNUSED)
-                {
-                    render_item->m_AttributeRenderDataIndex = component->m_MeshAttributeRenderDatas.Size();
-                    component->m_MeshAttributeRenderDatas.OffsetCapacity(1);
-                    component->m_MeshAttributeRenderDatas.SetSize(component->m_MeshAttributeRenderDatas.Capacity());
-                }
+                ++group_end;
+            }
 
-                MeshAttributeRenderData* attribute_rd = &component->m_MeshAttributeRenderDatas[render_item->m_AttributeRenderDataIndex];
+            // Single meshes are drawn with one instance too, since the material reads the world matrix from the instance buffer
+            uint32_t instance_count = group_end - group_begin;
+            world->m_InstanceData.SetSize(0);
+            if (world->m_InstanceData.Capacity() < instance_count)
+            {
+                world->m_InstanceData.SetCapacity(instance_count);
+            }
+            for (uint32_t i = group_begin; i < group_end; ++i)
+            {
+                world->m_InstanceData.Push(items[i].m_Item->m_World);
+            }
 
-                if (!attribute_rd->m_VertexDeclaration)
+            // Each instanced draw call gets its own buffer, since the instances always start at the beginning of the buffer
+            if (world->m_InstanceBufferCount == world->m_InstanceBuffers.Size())
+            {
+                if (world->m_InstanceBuffers.Full())
                 {
-                    SetupMeshAttributeRenderData(render_context,
-                        render_material,
-                        render_item,
-                        component->m_Resource->m_Materials[material_index].m_Attributes,
-                        component->m_Resource->m_Materials[material_index].m_AttributeCount,
-                        attribute_rd);
+                    world->m_InstanceBuffers.OffsetCapacity(8);
                 }
-
-                ro.m_VertexDeclarations[1] = attribute_rd->m_VertexDeclaration;
-                ro.m_VertexBuffers[1]      = attribute_rd->m_VertexBuffer;
+                world->m_InstanceBuffers.Push(dmRender::NewBufferedRenderBuffer(render_context, dmRender::RENDER_BUFFER_TYPE_VERTEX_BUFFER));
             }
+            dmRender::HBufferedRenderBuffer instance_buffer = world->m_InstanceBuffers[world->m_InstanceBufferCount++];
+            dmRender::SetBufferData(render_context, instance_buffer, instance_count * sizeof(Matrix4), world->m_InstanceData.Begin(), dmGraphics::BUFFER_USAGE_DYNAMIC_DRAW);
+
+            AddLocalRenderObject(world, render_context, render_context_material, false, first, instance_count);
+            DM_PROPERTY_ADD_U32(rmtp_ModelInstanced, instance_count);
+
+            group_begin = group_end;
+        }
+
+        items.SetSize(0);
+        world->m_InstanceGroups.SetSize(0);
+    }
+
+    static inline void RenderBatchLocalVS(ModelWorld* world, dmRender::HRenderContext render_context, dmRender::HMaterial render_context_material, dmRender::RenderListEntry *buf, uint32_t* begin, uint32_t* end)
+    {
+        DM_PROFILE("RenderBatchLocal");
+
+        bool render_context_material_custom_attributes = false;
+        if (render_context_material)
+        {
+            render_context_material_custom_attributes = HasCustomVertexAttributes(render_context_material);
+        }
 
-            // These should be named "element" or "index" (as opposed to vertex)
-            ro.m_VertexStart    = 0;
-            ro.m_VertexCount    = buffers->m_IndexCount;
-            ro.m_WorldTransform = render_item->m_World;
-            ro.m_IndexBuffer    = buffers->m_IndexBuffer;              // May be 0
-            ro.m_IndexType      = buffers->m_IndexBufferElementType;
+        uint32_t count = end - begin;
+        if (world->m_InstanceVertexDeclaration && world->m_InstanceItems.Capacity() < count)
+        {
+            world->m_InstanceItems.SetCapacity(count);
+        }
 
-            DM_PROPERTY_ADD_U32(rmtp_ModelIndexCount, buffers->m_IndexCount);
-            DM_PROPERTY_ADD_U32(rmtp_ModelVertexCount, buffers->m_VertexCount);
-            DM_PROPERTY_ADD_U32(rmtp_ModelVertexSize, buffers->m_VertexCount * sizeof(dmRig::RigModelVertex));
+        for (uint32_t *i=begin;i!=end;i++)
+        {
+            MeshRenderItem* render_item = (MeshRenderItem*) buf[*i].m_UserData;
+            ModelComponent* component = render_item->m_Component;
+            dmRender::HMaterial render_material = GetRenderMaterial(render_context_material, component, component->m_Resource, render_item->m_MaterialIndex);
 
-            FillTextures(&ro, component, material_index);
+            if (CanInstanceRenderItem(world, render_material, render_context_material_custom_attributes, render_item))
+            {
+                AddInstanceItem(world, render_item);
+                continue;
+            }
 
-            if (component->m_RenderConstants)
+            // Draw the pending instances first, to keep the draw order of the batch
+            if (!world->m_InstanceItems.Empty())
             {
-                dmGameSystem::EnableRenderObjectConstants(&ro, component->m_RenderConstants);
+                RenderInstancedLocalVS(world, render_context, render_context_material);
             }
 
-            dmRender::AddToRender(render_context, &ro);
+            // Without instancing, we generate a separate draw call for each render item
+            AddLocalRenderObject(world, render_context, render_context_material, render_context_material_custom_attributes, render_item, 0);
+        }
+
+        if (!world->m_InstanceItems.Empty())
+        {
+            RenderInstancedLocalVS(world, render_context, render_context_material);
         }
     }
 
@@ -1156,7 +1402,14 @@ namespace dmGameSystem
             world->m_VertexBufferDispatchCounts[i] = 0;
         }
 
+        for (uint32_t i = 0; i < world->m_InstanceBufferCount; ++i)
+        {
+            dmRender::TrimBuffer(context->m_RenderContext, world->m_InstanceBuffers[i]);
+            dmRender::RewindBuffer(context->m_RenderContext, world->m_InstanceBuffers[i]);
+        }
+
         world->m_MaxBatchIndex = 0;
+        world->m_InstanceBufferCount = 0;
 
         update_result.m_TransformsUpdated = rig_res == dmRig::RESULT_UPDATED_POSE;
         return dmGameObject::UPDATE_RESULT_OK;
@@ -26,6 +26,7 @@
 #include <dlib/dstrings.h>
 #include <dlib/object_pool.h>
 #include <dlib/math.h>
+#include <dlib/memory.h>
 #include <dmsdk/dlib/vmath.h>
 #include <dmsdk/dlib/intersection.h>
 #include <graphics/graphics.h>
@@ -182,12 +183,12 @@ namespace dmGameSystem
 
         sprite_world->m_VertexBuffer     = dmRender::NewBufferedRenderBuffer(render_context, dmRender::RENDER_BUFFER_TYPE_VERTEX_BUFFER);
         uint32_t vertex_memsize          = sprite_world->m_VertexMemorySize;
-        sprite_world->m_VertexBufferData = (uint8_t*) realloc(sprite_world->m_VertexBufferData, vertex_memsize);
+        sprite_world->m_VertexBufferData = (uint8_t*) dmMemory::Realloc(dmMemory::TAG_GAMESYS, sprite_world->m_VertexBufferData, vertex_memsize);
 
         uint32_t index_data_type_size   = sprite_world->m_VertexCount <= 65536 ? sizeof(uint16_t) : sizeof(uint32_t);
         size_t indices_memsize          = sprite_world->m_IndexCount * index_data_type_size;
         sprite_world->m_Is16BitIndex    = index_data_type_size == sizeof(uint16_t) ? 1 : 0;
-        sprite_world->m_IndexBufferData = (uint8_t*)realloc(sprite_world->m_IndexBufferData, indices_memsize);
+        sprite_world->m_IndexBufferData = (uint8_t*) dmMemory::Realloc(dmMemory::TAG_GAMESYS, sprite_world->m_IndexBufferData, indices_memsize);
 
         if (sprite_world->m_IndexBuffer)
         {
@@ -233,9 +234,9 @@ namespace dmGameSystem
 
         SpriteContext* sprite_context = (SpriteContext*)params.m_Context;
         dmRender::DeleteBufferedRenderBuffer(sprite_context->m_RenderContext, sprite_world->m_VertexBuffer);
-        free(sprite_world->m_VertexBufferData);
+        dmMemory::Free(dmMemory::TAG_GAMESYS, sprite_world->m_VertexBufferData);
         dmRender::DeleteBufferedRenderBuffer(sprite_context->m_RenderContext, sprite_world->m_IndexBuffer);
-        free(sprite_world->m_IndexBufferData);
+        dmMemory::Free(dmMemory::TAG_GAMESYS, sprite_world->m_IndexBufferData);
 
         delete sprite_world;
         return dmGameObject::CREATE_RESULT_OK;
@@ -655,10 +656,16 @@ namespace dmGameSystem
         return dmGameObject::CREATE_RESULT_OK;
     }
 
+    // The scratch arrays are backed by per frame memory, which is released by the frame allocator
     static void EnsureSize(dmArray<float>& array, uint32_t size)
     {
         if (array.Capacity() < size) {
-            array.OffsetCapacity(size - array.Capacity());
+            uint32_t capacity = dmMath::Max(size, array.Capacity() * 2);
+            float* data = (float*)dmMemory::FrameAlloc(capacity * sizeof(float));
+            if (!array.Empty()) {
+                memcpy(data, array.Begin(), array.Size() * sizeof(float));
+            }
+            array.Set(data, array.Size(), capacity, true);
         }
         array.SetSize(size);
     }
@@ -26,6 +26,7 @@
 #include <dlib/time.h>
 #include <graphics/graphics.h>
 #include <render/render.h>
+#include <resource/resource.h>
 #include <gameobject/gameobject.h>
 #include <gameobject/gameobject_ddf.h>
 #include <dmsdk/dlib/vmath.h>
@@ -67,6 +68,23 @@ namespace dmGameSystem
         uint8_t :7;
     };
 
+    struct TileGridVertex
+    {
+        float x, y, z, u, v;
+    };
+
+    // The world space vertices of one layer in a region. They are rebuilt when a tile in the region
+    // changes, or when the world transform of the component changes.
+    struct TileGridRegionVertices
+    {
+        TileGridVertex* m_Vertices;
+        uint32_t        m_VertexCount;
+        uint32_t        m_VertexCapacity;
+        uint32_t        m_WorldVersion; // The TileGridComponent::m_WorldVersion the vertices were built with
+        uint8_t         m_Dirty : 1;
+        uint8_t         : 7;
+    };
+
     struct TileGridComponent
     {
         struct Flags
@@ -83,6 +101,9 @@ namespace dmGameSystem
         , m_Material(0)
         , m_TextureSet(0)
         , m_Resource(0)
+        , m_VerticesTextureSet(0)
+        , m_WorldVersion(1)
+        , m_VerticesTextureSetVersion(0)
         {
         }
 
@@ -94,24 +115,23 @@ namespace dmGameSystem
         Flags*                      m_CellFlags;
         dmArray<TileGridRegion>     m_Regions;
         dmArray<TileGridLayer>      m_Layers;
+        dmArray<TileGridRegionVertices> m_RegionVertices; // layer_index * region_count + region_index
         uint32_t                    m_MixedHash;
         HComponentRenderConstants   m_RenderConstants;
         MaterialResource*           m_Material;
         TextureSetResource*         m_TextureSet;
         TileGridResource*           m_Resource;
+        TextureSetResource*         m_VerticesTextureSet; // The texture set the region vertices were built from
+        uint32_t                    m_WorldVersion; // Incremented each time m_World changes
         uint16_t                    m_RegionsX; // number of regions in the x dimension
         uint16_t                    m_RegionsY; // number of regions in the y dimension
         uint16_t                    m_Occupied; // Number of occupied regions (regions with visible tiles)
+        uint16_t                    m_VerticesTextureSetVersion; // The resource version of m_VerticesTextureSet, which changes when it's reloaded
         uint8_t                     m_Enabled : 1;
         uint8_t                     m_AddedToUpdate : 1;
         uint8_t                     : 6;
     };
 
-    struct TileGridVertex
-    {
-        float x, y, z, u, v;
-    };
-
     struct TileGridWorld
     {
         TileGridWorld()
@@ -237,13 +257,16 @@ namespace dmGameSystem
         layer->m_IsVisible = visible;
     }
 
-    static void SetRegionDirty(TileGridComponent* component, int32_t cell_x, int32_t cell_y)
+    static void SetRegionDirty(TileGridComponent* component, uint32_t layer, int32_t cell_x, int32_t cell_y)
     {
         uint32_t region_x = cell_x / TILEGRID_REGION_SIZE;
         uint32_t region_y = cell_y / TILEGRID_REGION_SIZE;
         uint32_t region_index = region_y * component->m_RegionsX + region_x;
         TileGridRegion* region = &component->m_Regions[region_index];
         region->m_Dirty = 1;
+
+        uint32_t region_count = component->m_Regions.Size();
+        component->m_RegionVertices[layer * region_count + region_index].m_Dirty = 1;
     }
 
     void SetTileGridTile(TileGridComponent* component, uint32_t layer, int32_t cell_x, int32_t cell_y, uint32_t tile, uint8_t transform_mask)
@@ -255,7 +278,7 @@ namespace dmGameSystem
         TileGridComponent::Flags* flags = &component->m_CellFlags[cell_index];
         flags->m_TransformMask = transform_mask;
 
-        SetRegionDirty(component, cell_x, cell_y);
+        SetRegionDirty(component, layer, cell_x, cell_y);
     }
 
     uint16_t GetTileCount(const TileGridComponent* component) {
@@ -280,6 +303,26 @@ namespace dmGameSystem
         component->m_MixedHash = dmHashFinal32(&state);
     }
 
+    static void FreeRegionVertices(TileGridComponent* component)
+    {
+        uint32_t count = component->m_RegionVertices.Size();
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            TileGridRegionVertices* vertices = &component->m_RegionVertices[i];
+            free(vertices->m_Vertices);
+        }
+        component->m_RegionVertices.SetSize(0);
+    }
+
+    static void InvalidateRegionVertices(TileGridComponent* component)
+    {
+        uint32_t count = component->m_RegionVertices.Size();
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            component->m_RegionVertices[i].m_Dirty = 1;
+        }
+    }
+
     static void CreateRegions(TileGridComponent* component, TileGridResource* resource)
     {
         // Round up to closest multiple
@@ -290,6 +333,13 @@ namespace dmGameSystem
         component->m_Regions.SetCapacity(region_count);
         component->m_Regions.SetSize(region_count);
         memset(&component->m_Regions[0], 0xFF, region_count * sizeof(TileGridRegion)); // mark them all dirty
+
+        uint32_t vertices_count = resource->m_TileGrid->m_Layers.m_Count * region_count;
+        FreeRegionVertices(component);
+        component->m_RegionVertices.SetCapacity(vertices_count);
+        component->m_RegionVertices.SetSize(vertices_count);
+        memset(component->m_RegionVertices.Begin(), 0, vertices_count * sizeof(TileGridRegionVertices));
+        InvalidateRegionVertices(component);
     }
 
     static uint32_t UpdateRegion(TileGridComponent* component, uint32_t region_x, uint32_t region_y)
@@ -467,6 +517,7 @@ namespace dmGameSystem
 
                 delete [] tile_grid->m_Cells;
                 delete [] tile_grid->m_CellFlags;
+                FreeRegionVertices(tile_grid);
 
                 if (tile_grid->m_RenderConstants)
                 {
@@ -516,13 +567,20 @@ namespace dmGameSystem
 
             Matrix4 local(component->m_Rotation, component->m_Translation);
             const Matrix4& go_world = dmGameObject::GetWorldMatrix(component->m_Instance);
+            Matrix4 world_matrix;
             if (dmGameObject::ScaleAlongZ(component->m_Instance))
             {
-                component->m_World = go_world * local;
+                world_matrix = go_world * local;
             }
             else
             {
-                component->m_World = dmTransform::MulNoScaleZ(go_world, local);
+                world_matrix = dmTransform::MulNoScaleZ(go_world, local);
+            }
+
+            if (memcmp(&world_matrix, &component->m_World, sizeof(Matrix4)) != 0)
+            {
+                component->m_World = world_matrix;
+                ++component->m_WorldVersion;
             }
         }
         DM_PROPERTY_ADD_U32(rmtp_Tilemap, world->m_Components.Size());
@@ -548,100 +606,143 @@ namespace dmGameSystem
         region_y = (ptr >> 48) & 0xFFFF;
     }
 
-    TileGridVertex* CreateVertexData(TileGridWorld* world, TileGridVertex* where, TextureSetResource* texture_set, dmRender::RenderListEntry* buf, uint32_t* begin, uint32_t* end)
+    /*
+     *   0----3
+     *   | \  |
+     *   |  \ |
+     *   1____2
+    */
+    static const int TEX_COORD_ORDER[] = {
+        0,1,2,2,3,0,
+        3,2,1,1,0,3,    //h
+        1,0,3,3,2,1,    //v
+        2,3,0,0,1,2,    //hv
+        // rotate 90 degrees:
+        3,0,1,1,2,3,
+        0,3,2,2,1,0,    //h
+        2,1,0,0,3,2,    //v
+        1,2,3,3,0,1     //hv
+    };
+
+    static void BuildRegionVertices(const TileGridComponent* component, uint32_t layer, uint32_t region_x, uint32_t region_y, TileGridRegionVertices* vertices)
     {
-        DM_PROFILE("CreateVertexData");
-        /*
-         *   0----3
-         *   | \  |
-         *   |  \ |
-         *   1____2
-        */
-        static int tex_coord_order[] = {
-            0,1,2,2,3,0,
-            3,2,1,1,0,3,    //h
-            1,0,3,3,2,1,    //v
-            2,3,0,0,1,2,    //hv
-            // rotate 90 degrees:
-            3,0,1,1,2,3,
-            0,3,2,2,1,0,    //h
-            2,1,0,0,3,2,    //v
-            1,2,3,3,0,1     //hv
-        };
+        DM_PROFILE("BuildRegionVertices");
 
-        dmGameSystemDDF::TextureSet* texture_set_ddf = texture_set->m_TextureSet;
+        const dmGameSystemDDF::TextureSet* texture_set_ddf = GetTextureSet(component)->m_TextureSet;
         const float* tex_coords = (const float*) texture_set_ddf->m_TexCoords.m_Data;
-
         uint32_t tile_width = texture_set_ddf->m_TileWidth;
         uint32_t tile_height = texture_set_ddf->m_TileHeight;
 
-        for (uint32_t* i = begin; i != end; ++i)
-        {
-            uint32_t index, layer, region_x, region_y;
-            DecodeGridAndLayer(buf[*i].m_UserData, index, layer, region_x, region_y);
+        const TileGridResource* resource = component->m_Resource;
+        dmGameSystemDDF::TileLayer* layer_ddf = &resource->m_TileGrid->m_Layers[layer];
+        const Matrix4& w = component->m_World;
+        const float z = layer_ddf->m_Z;
 
-            const TileGridComponent* component = world->m_Components[index];
-            const TileGridResource* resource = component->m_Resource;
-            dmGameSystemDDF::TileGrid* tile_grid_ddf = resource->m_TileGrid;
-            dmGameSystemDDF::TileLayer* layer_ddf = &tile_grid_ddf->m_Layers[layer];
+        uint32_t column_count = resource->m_ColumnCount;
+        uint32_t row_count = resource->m_RowCount;
 
-            const Matrix4& w = component->m_World;
-            const float z = layer_ddf->m_Z;
+        int32_t min_x = resource->m_MinCellX + region_x * TILEGRID_REGION_SIZE;
+        int32_t min_y = resource->m_MinCellY + region_y * TILEGRID_REGION_SIZE;
+        int32_t max_x = dmMath::Min(min_x + (int32_t)TILEGRID_REGION_SIZE, resource->m_MinCellX + (int32_t)column_count);
+        int32_t max_y = dmMath::Min(min_y + (int32_t)TILEGRID_REGION_SIZE, resource->m_MinCellY + (int32_t)row_count);
 
-            uint32_t column_count = resource->m_ColumnCount;
-            uint32_t row_count = resource->m_RowCount;
+        uint32_t tile_count = 0;
+        for (int32_t y = min_y; y < max_y; ++y)
+        {
+            for (int32_t x = min_x; x < max_x; ++x)
+            {
+                uint32_t cell = CalculateCellIndex(layer, x - resource->m_MinCellX, y - resource->m_MinCellY, column_count, row_count);
+                tile_count += component->m_Cells[cell] != 0xffff;
+            }
+        }
 
-            int32_t min_x = resource->m_MinCellX + region_x * TILEGRID_REGION_SIZE;
-            int32_t min_y = resource->m_MinCellY + region_y * TILEGRID_REGION_SIZE;
-            int32_t max_x = dmMath::Min(min_x + (int32_t)TILEGRID_REGION_SIZE, resource->m_MinCellX + (int32_t)column_count);
-            int32_t max_y = dmMath::Min(min_y + (int32_t)TILEGRID_REGION_SIZE, resource->m_MinCellY + (int32_t)row_count);
+        uint32_t vertex_count = tile_count * 6;
+        if (vertex_count > vertices->m_VertexCapacity)
+        {
+            vertices->m_Vertices = (TileGridVertex*) realloc(vertices->m_Vertices, sizeof(TileGridVertex) * vertex_count);
+            vertices->m_VertexCapacity = vertex_count;
+        }
 
-            for (int32_t y = min_y; y < max_y; ++y)
+        TileGridVertex* where = vertices->m_Vertices;
+        for (int32_t y = min_y; y < max_y; ++y)
+        {
+            for (int32_t x = min_x; x < max_x; ++x)
             {
-                for (int32_t x = min_x; x < max_x; ++x)
+                uint32_t cell = CalculateCellIndex(layer, x - resource->m_MinCellX, y - resource->m_MinCellY, column_count, row_count);
+                uint16_t tile = component->m_Cells[cell];
+                if (tile == 0xffff)
                 {
-                    uint32_t cell = CalculateCellIndex(layer, x - resource->m_MinCellX, y - resource->m_MinCellY, column_count, row_count);
-                    uint16_t tile = component->m_Cells[cell];
-                    if (tile == 0xffff)
-                    {
-                        continue;
-                    }
+                    continue;
+                }
 
-                    if( where >= world->m_VertexBufferDataEnd )
-                    {
-                        dmLogError("Out of tiles to render (%zu). You can change this with the game.project setting tilemap.max_tile_count", (size_t)((world->m_VertexBufferDataEnd - world->m_VertexBufferData) / 6));
-                        return world->m_VertexBufferDataEnd;
+                float p[4];
+                CalculateCellBounds(x, y, 1, 1, p);
+                const float* puv = &tex_coords[tile * 8];
+
+                TileGridComponent::Flags flags = component->m_CellFlags[cell];
+                const int* tex_lookup = &TEX_COORD_ORDER[flags.m_TransformMask * 6];
+
+                #define SET_VERTEX(_I, _X, _Y, _Z, _U, _V) \
+                    { \
+                        const Vector4 v = w * Point3(_X * tile_width, _Y * tile_height, _Z); \
+                        where[_I].x = v.getX(); \
+                        where[_I].y = v.getY(); \
+                        where[_I].z = v.getZ(); \
+                        where[_I].u = _U; \
+                        where[_I].v = _V; \
                     }
 
-                    float p[4];
-                    CalculateCellBounds(x, y, 1, 1, p);
-                    const float* puv = &tex_coords[tile * 8];
-
-                    TileGridComponent::Flags flags = component->m_CellFlags[cell];
-                    const int* tex_lookup = &tex_coord_order[flags.m_TransformMask * 6];
-
-                    #define SET_VERTEX(_I, _X, _Y, _Z, _U, _V) \
-                        { \
-                            const Vector4 v = w * Point3(_X * tile_width, _Y * tile_height, _Z); \
-                            where[_I].x = v.getX(); \
-                            where[_I].y = v.getY(); \
-                            where[_I].z = v.getZ(); \
-                            where[_I].u = _U; \
-                            where[_I].v = _V; \
-                        }
+                SET_VERTEX(0, p[0], p[1], z, puv[tex_lookup[0] * 2], puv[tex_lookup[0] * 2 + 1]);
+                SET_VERTEX(1, p[0], p[3], z, puv[tex_lookup[1] * 2], puv[tex_lookup[1] * 2 + 1]);
+                SET_VERTEX(2, p[2], p[3], z, puv[tex_lookup[2] * 2], puv[tex_lookup[2] * 2 + 1]);
+                SET_VERTEX(3, p[2], p[3], z, puv[tex_lookup[3] * 2], puv[tex_lookup[3] * 2 + 1]);
+                SET_VERTEX(4, p[2], p[1], z, puv[tex_lookup[4] * 2], puv[tex_lookup[4] * 2 + 1]);
+                SET_VERTEX(5, p[0], p[1], z, puv[tex_lookup[5] * 2], puv[tex_lookup[5] * 2 + 1]);
 
-                    SET_VERTEX(0, p[0], p[1], z, puv[tex_lookup[0] * 2], puv[tex_lookup[0] * 2 + 1]);
-                    SET_VERTEX(1, p[0], p[3], z, puv[tex_lookup[1] * 2], puv[tex_lookup[1] * 2 + 1]);
-                    SET_VERTEX(2, p[2], p[3], z, puv[tex_lookup[2] * 2], puv[tex_lookup[2] * 2 + 1]);
-                    SET_VERTEX(3, p[2], p[3], z, puv[tex_lookup[3] * 2], puv[tex_lookup[3] * 2 + 1]);
-                    SET_VERTEX(4, p[2], p[1], z, puv[tex_lookup[4] * 2], puv[tex_lookup[4] * 2 + 1]);
-                    SET_VERTEX(5, p[0], p[1], z, puv[tex_lookup[5] * 2], puv[tex_lookup[5] * 2 + 1]);
+                where += 6;
 
-                    where += 6;
+                #undef SET_VERTEX
+            }
+        }
 
-                    #undef SET_VERTEX
-                }
+        vertices->m_VertexCount = vertex_count;
+        vertices->m_WorldVersion = component->m_WorldVersion;
+        vertices->m_Dirty = 0;
+    }
+
+    TileGridVertex* CreateVertexData(TileGridWorld* world, TileGridVertex* where, dmRender::RenderListEntry* buf, uint32_t* begin, uint32_t* end)
+    {
+        DM_PROFILE("CreateVertexData");
+
+        for (uint32_t* i = begin; i != end; ++i)
+        {
+            uint32_t index, layer, region_x, region_y;
+            DecodeGridAndLayer(buf[*i].m_UserData, index, layer, region_x, region_y);
+
+            TileGridComponent* component = world->m_Components[index];
+            uint32_t region_index = region_y * component->m_RegionsX + region_x;
+            TileGridRegionVertices* vertices = &component->m_RegionVertices[layer * component->m_Regions.Size() + region_index];
+            if (vertices->m_Dirty || vertices->m_WorldVersion != component->m_WorldVersion)
+            {
+                BuildRegionVertices(component, layer, region_x, region_y, vertices);
+            }
+
+            uint32_t vertex_count = vertices->m_VertexCount;
+            if (vertex_count == 0)
+            {
+                continue;
+            }
+
+            uint32_t vertices_left = (uint32_t)(world->m_VertexBufferDataEnd - where);
+            if (vertex_count > vertices_left)
+            {
+                memcpy(where, vertices->m_Vertices, sizeof(TileGridVertex) * vertices_left);
+                dmLogError("Out of tiles to render (%zu). You can change this with the game.project setting tilemap.max_tile_count", (size_t)((world->m_VertexBufferDataEnd - world->m_VertexBufferData) / 6));
+                return world->m_VertexBufferDataEnd;
             }
+
+            memcpy(where, vertices->m_Vertices, sizeof(TileGridVertex) * vertex_count);
+            where += vertex_count;
         }
         return where;
     }
@@ -701,7 +802,7 @@ namespace dmGameSystem
 
         // Fill in vertex buffer
         TileGridVertex* vb_begin = world->m_VertexBufferWritePtr;
-        world->m_VertexBufferWritePtr = CreateVertexData(world, vb_begin, texture_set, buf, begin, end);
+        world->m_VertexBufferWritePtr = CreateVertexData(world, vb_begin, buf, begin, end);
 
         if (dmRender::GetBufferIndex(render_context, world->m_VertexBuffer) < world->m_DispatchCount)
         {
@@ -847,8 +948,18 @@ namespace dmGameSystem
                 ReHash(component);
             }
 
+            // The texture set was changed or reloaded since the vertices were built
+            TextureSetResource* texture_set = GetTextureSet(component);
+            uint16_t texture_set_version = dmResource::GetVersion(dmGameObject::GetFactory(component->m_Instance), texture_set);
+            if (component->m_VerticesTextureSet != texture_set || component->m_VerticesTextureSetVersion != texture_set_version)
+            {
+                InvalidateRegionVertices(component);
+                component->m_VerticesTextureSet = texture_set;
+                component->m_VerticesTextureSetVersion = texture_set_version;
+            }
+
             TileGridResource* resource = component->m_Resource;
-            dmGameSystemDDF::TextureSet* texture_set_ddf = GetTextureSet(component)->m_TextureSet;
+            dmGameSystemDDF::TextureSet* texture_set_ddf = texture_set->m_TextureSet;
             dmGameSystemDDF::TileGrid* tile_grid_ddf = resource->m_TileGrid;
 
             uint32_t tile_width = texture_set_ddf->m_TileWidth;
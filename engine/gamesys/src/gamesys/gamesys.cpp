@@ -135,6 +135,15 @@ namespace dmGameSystem
 
 #undef REGISTER_RESOURCE_TYPE
 
+        // These types only read their data while being created, so they may read it directly from a memory mapped archive.
+        // That saves the copy into the factory load buffer: the sound data is still copied by the sound system, and the
+        // DDF types are parsed into messages of their own. Textures are not included, as their data may be uploaded later
+        const char* zero_copy_types[] = {"wavc", "oggc", "camerac", "lightc", "input_bindingc"};
+        for (uint32_t i = 0; i < DM_ARRAY_SIZE(zero_copy_types); ++i)
+        {
+            dmResource::SetTypeZeroCopy(factory, zero_copy_types[i], true);
+        }
+
         return e;
     }
 
@@ -46,6 +46,8 @@ namespace dmGameSystem
     extern const char* PHYSICS_USE_FIXED_TIMESTEP;
     /// Config key for using max updates during a single step
     extern const char* PHYSICS_MAX_FIXED_TIMESTEPS;
+    /// Config key for interpolating the physics transforms between the fixed time steps
+    extern const char* PHYSICS_INTERPOLATE;
     /// Config key to use for tweaking maximum number of collection proxies
     extern const char* COLLECTION_PROXY_MAX_COUNT_KEY;
     /// Config key to use for tweaking maximum number of factories
@@ -88,6 +90,7 @@ namespace dmGameSystem
         bool        m_Debug;
         bool        m_3D;
         bool        m_UseFixedTimestep;
+        bool        m_Interpolate;          // Only used together with m_UseFixedTimestep
         uint32_t    m_MaxFixedTimesteps;
     };
 
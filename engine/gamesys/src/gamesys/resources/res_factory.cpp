@@ -24,12 +24,18 @@ namespace dmGameSystem
     {
         factory_res->m_LoadDynamically = factory_desc->m_LoadDynamically;
         factory_res->m_DynamicPrototype = factory_desc->m_DynamicPrototype;
+        factory_res->m_PoolSize = factory_desc->m_PoolSize;
         factory_res->m_PrototypePath = strdup(factory_desc->m_Prototype);
         if(factory_res->m_LoadDynamically)
         {
             return dmResource::RESULT_OK;
         }
-        return dmResource::Get(factory, factory_res->m_PrototypePath, (void **)&factory_res->m_Prototype);
+        dmResource::Result res = dmResource::Get(factory, factory_res->m_PrototypePath, (void **)&factory_res->m_Prototype);
+        if(res == dmResource::RESULT_OK && factory_res->m_PoolSize)
+        {
+            dmGameObject::SetInstancePoolSize(factory_res->m_Prototype, factory_res->m_PoolSize);
+        }
+        return res;
     }
 
     static void ReleaseResources(dmResource::HFactory factory, FactoryResource* factory_res)
@@ -497,6 +497,18 @@ namespace dmGameSystem
     #undef DM_COPY_STREAM
     }
 
+    // Offset and count is in "value type"
+    static void UpdateStreamVersion(BufferStream* stream, uint32_t offset, uint32_t count)
+    {
+        if (count == 0)
+        {
+            return;
+        }
+        uint32_t first = offset / stream->m_TypeCount;
+        uint32_t last = (offset + count - 1) / stream->m_TypeCount;
+        dmBuffer::UpdateStreamContentVersion(stream->m_Buffer, stream->m_Name, first, last - first + 1);
+    }
+
     /*# copies data from one stream to another
      *
      * Copy a specified amount of data from one stream to another.
@@ -566,6 +578,359 @@ namespace dmGameSystem
             {
                 return DM_LUA_ERROR("Unknown stream value type: %d", dststream->m_Type);
             }
+            UpdateStreamVersion(dststream, dstoffset, count);
+        }
+        return 0;
+    }
+
+    // Reads the optional offset and count of a stream range (measured in value type)
+    static void CheckStreamRange(lua_State* L, int index, const BufferStream* stream, uint32_t* offset, uint32_t* count)
+    {
+        int size = (int)(stream->m_Count * stream->m_TypeCount);
+        int o = luaL_optint(L, index, 0);
+        int c = luaL_optint(L, index + 1, size - o);
+        if (o < 0 || c < 0 || o + c > size)
+        {
+            luaL_error(L, "The range is outside the stream: Stream length: %d, Offset: %d, Count: %d", size, o, c);
+        }
+        *offset = (uint32_t)o;
+        *count = (uint32_t)c;
+    }
+
+    // Reads one value per component, from a number, a vector or a table of numbers
+    static void CheckComponentValues(lua_State* L, int index, uint32_t components, lua_Number* out)
+    {
+        if (lua_type(L, index) == LUA_TNUMBER)
+        {
+            lua_Number v = lua_tonumber(L, index);
+            for (uint32_t c = 0; c < components; ++c)
+                out[c] = v;
+            return;
+        }
+
+        dmVMath::Vector3* v3 = dmScript::ToVector3(L, index);
+        dmVMath::Vector4* v4 = v3 ? 0 : dmScript::ToVector4(L, index);
+        if (v3 || v4)
+        {
+            uint32_t vector_size = v3 ? 3 : 4;
+            if (components > vector_size)
+            {
+                luaL_error(L, "Expected %u values, got a vector with %u", components, vector_size);
+            }
+            for (uint32_t c = 0; c < components; ++c)
+                out[c] = v3 ? v3->getElem(c) : v4->getElem(c);
+            return;
+        }
+
+        if (lua_istable(L, index))
+        {
+            if (lua_objlen(L, index) < components)
+            {
+                luaL_error(L, "Expected %u values, got a table with %u", components, (uint32_t)lua_objlen(L, index));
+            }
+            for (uint32_t c = 0; c < components; ++c)
+            {
+                lua_rawgeti(L, index, c + 1);
+                out[c] = luaL_checknumber(L, -1);
+                lua_pop(L, 1);
+            }
+            return;
+        }
+
+        luaL_typerror(L, index, "number, vector or table");
+    }
+
+    enum StreamOp
+    {
+        STREAM_OP_SET,
+        STREAM_OP_ADD,
+        STREAM_OP_MUL,
+    };
+
+    template<typename T, StreamOp OP>
+    static inline void ApplyStreamOp(T* dst, lua_Number v)
+    {
+        switch (OP)
+        {
+        case STREAM_OP_SET: *dst = (T)v; break;
+        case STREAM_OP_ADD: *dst = (T)(*dst + v); break;
+        case STREAM_OP_MUL: *dst = (T)(*dst * v); break;
+        }
+    }
+
+    // Offset and count is in "value type". There is one value per component.
+    template<typename T, StreamOp OP>
+    static void StreamOpT(T* data, uint32_t stride, uint32_t components, uint32_t offset, uint32_t count, const lua_Number* values)
+    {
+        data += (offset / components) * stride;
+        uint32_t c = offset % components;
+
+        // The values before the first whole element
+        for (; c != 0 && c < components && count > 0; ++c, --count)
+            ApplyStreamOp<T, OP>(&data[c], values[c]);
+        if (c == components)
+            data += stride;
+
+        // Whole elements
+        uint32_t element_count = count / components;
+        for (uint32_t e = 0; e < element_count; ++e, data += stride)
+        {
+            for (uint32_t i = 0; i < components; ++i)
+                ApplyStreamOp<T, OP>(&data[i], values[i]);
+        }
+
+        // The values after the last whole element
+        count -= element_count * components;
+        for (uint32_t i = 0; i < count; ++i)
+            ApplyStreamOp<T, OP>(&data[i], values[i]);
+    }
+
+    template<StreamOp OP>
+    static bool StreamOpInternal(BufferStream* stream, uint32_t offset, uint32_t count, const lua_Number* values)
+    {
+        #define DM_STREAM_OP(_T_) StreamOpT<_T_, OP>((_T_*)stream->m_Data, stream->m_Stride, stream->m_TypeCount, offset, count, values)
+            switch(stream->m_Type)
+            {
+            case dmBuffer::VALUE_TYPE_UINT8:      DM_STREAM_OP(uint8_t); break;
+            case dmBuffer::VALUE_TYPE_UINT16:     DM_STREAM_OP(uint16_t); break;
+            case dmBuffer::VALUE_TYPE_UINT32:     DM_STREAM_OP(uint32_t); break;
+            case dmBuffer::VALUE_TYPE_UINT64:     DM_STREAM_OP(uint64_t); break;
+            case dmBuffer::VALUE_TYPE_INT8:       DM_STREAM_OP(int8_t); break;
+            case dmBuffer::VALUE_TYPE_INT16:      DM_STREAM_OP(int16_t); break;
+            case dmBuffer::VALUE_TYPE_INT32:      DM_STREAM_OP(int32_t); break;
+            case dmBuffer::VALUE_TYPE_INT64:      DM_STREAM_OP(int64_t); break;
+            case dmBuffer::VALUE_TYPE_FLOAT32:    DM_STREAM_OP(float); break;
+            default:
+                return false;
+            }
+            return true;
+    #undef DM_STREAM_OP
+    }
+
+    template<StreamOp OP>
+    static int DoStreamOp(lua_State* L)
+    {
+        DM_LUA_STACK_CHECK(L, 0);
+        BufferStream* stream = CheckStream(L, 1);
+
+        lua_Number* values = (lua_Number*)alloca(stream->m_TypeCount * sizeof(lua_Number));
+        CheckComponentValues(L, 2, stream->m_TypeCount, values);
+
+        uint32_t offset, count;
+        CheckStreamRange(L, 3, stream, &offset, &count);
+
+        if (!StreamOpInternal<OP>(stream, offset, count, values))
+        {
+            return DM_LUA_ERROR("Unknown stream value type: %d", stream->m_Type);
+        }
+        UpdateStreamVersion(stream, offset, count);
+        return 0;
+    }
+
+    /*# fills a stream with a value
+     *
+     * Set all values in a range of a stream.
+     *
+     * @name buffer.fill_stream
+     * @param stream [type:bufferstream] the stream
+     * @param value [type:number|vector3|vector4|table] the value. A vector or a table sets one value per component.
+     * @param [offset] [type:number] the offset to start at (measured in value type). Defaults to 0.
+     * @param [count] [type:number] the number of values (measured in value type). Defaults to the rest of the stream.
+     *
+     * @examples
+     *
+     * ```lua
+     * local colors = buffer.get_stream(buf, hash("color"))
+     * buffer.fill_stream(colors, vmath.vector4(1, 1, 1, 1))
+     * ```
+    */
+    static int FillStream(lua_State* L)
+    {
+        return DoStreamOp<STREAM_OP_SET>(L);
+    }
+
+    /*# adds a value to a stream
+     *
+     * Add a value to all values in a range of a stream.
+     *
+     * @name buffer.add_stream
+     * @param stream [type:bufferstream] the stream
+     * @param value [type:number|vector3|vector4|table] the value to add. A vector or a table adds one value per component.
+     * @param [offset] [type:number] the offset to start at (measured in value type). Defaults to 0.
+     * @param [count] [type:number] the number of values (measured in value type). Defaults to the rest of the stream.
+     *
+     * @examples
+     *
+     * ```lua
+     * local positions = buffer.get_stream(buf, hash("position"))
+     * buffer.add_stream(positions, vmath.vector3(0, 10, 0))
+     * ```
+    */
+    static int AddStream(lua_State* L)
+    {
+        return DoStreamOp<STREAM_OP_ADD>(L);
+    }
+
+    /*# multiplies a stream by a value
+     *
+     * Multiply all values in a range of a stream by a value.
+     *
+     * @name buffer.mul_stream
+     * @param stream [type:bufferstream] the stream
+     * @param value [type:number|vector3|vector4|table] the value to multiply by. A vector or a table multiplies each component by its own value.
+     * @param [offset] [type:number] the offset to start at (measured in value type). Defaults to 0.
+     * @param [count] [type:number] the number of values (measured in value type). Defaults to the rest of the stream.
+     *
+     * @examples
+     *
+     * ```lua
+     * local positions = buffer.get_stream(buf, hash("position"))
+     * buffer.mul_stream(positions, vmath.vector3(2, 1, 1))
+     * ```
+    */
+    static int MulStream(lua_State* L)
+    {
+        return DoStreamOp<STREAM_OP_MUL>(L);
+    }
+
+    // Offset and count is in "value type". Reads the values from the table at the given stack index
+    template<typename T>
+    static void SetStreamT(lua_State* L, int index, T* data, uint32_t stride, uint32_t components, uint32_t offset, uint32_t count)
+    {
+        data += (offset / components) * stride;
+        uint32_t c = offset % components;
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            lua_rawgeti(L, index, i + 1);
+            data[c] = (T)luaL_checknumber(L, -1);
+            lua_pop(L, 1);
+
+            if (++c == components)
+            {
+                c = 0;
+                data += stride;
+            }
+        }
+    }
+
+    static bool SetStreamInternal(lua_State* L, int index, BufferStream* stream, uint32_t offset, uint32_t count)
+    {
+        #define DM_SET_STREAM(_T_) SetStreamT<_T_>(L, index, (_T_*)stream->m_Data, stream->m_Stride, stream->m_TypeCount, offset, count)
+            switch(stream->m_Type)
+            {
+            case dmBuffer::VALUE_TYPE_UINT8:      DM_SET_STREAM(uint8_t); break;
+            case dmBuffer::VALUE_TYPE_UINT16:     DM_SET_STREAM(uint16_t); break;
+            case dmBuffer::VALUE_TYPE_UINT32:     DM_SET_STREAM(uint32_t); break;
+            case dmBuffer::VALUE_TYPE_UINT64:     DM_SET_STREAM(uint64_t); break;
+            case dmBuffer::VALUE_TYPE_INT8:       DM_SET_STREAM(int8_t); break;
+            case dmBuffer::VALUE_TYPE_INT16:      DM_SET_STREAM(int16_t); break;
+            case dmBuffer::VALUE_TYPE_INT32:      DM_SET_STREAM(int32_t); break;
+            case dmBuffer::VALUE_TYPE_INT64:      DM_SET_STREAM(int64_t); break;
+            case dmBuffer::VALUE_TYPE_FLOAT32:    DM_SET_STREAM(float); break;
+            default:
+                return false;
+            }
+            return true;
+    #undef DM_SET_STREAM
+    }
+
+    /*# sets stream values from a table
+     *
+     * Set a range of values in a stream from a table of numbers.
+     *
+     * @name buffer.set_stream
+     * @param stream [type:bufferstream] the stream
+     * @param offset [type:number] the offset to start writing at (measured in value type)
+     * @param values [type:table] the values to write
+     *
+     * @examples
+     *
+     * ```lua
+     * local positions = buffer.get_stream(buf, hash("position"))
+     * buffer.set_stream(positions, 0, { 0,0,0, 1,0,0, 1,1,0 })
+     * ```
+    */
+    static int SetStream(lua_State* L)
+    {
+        DM_LUA_STACK_CHECK(L, 0);
+        BufferStream* stream = CheckStream(L, 1);
+        int offset = luaL_checkint(L, 2);
+        luaL_checktype(L, 3, LUA_TTABLE);
+
+        int count = (int)lua_objlen(L, 3);
+        int size = (int)(stream->m_Count * stream->m_TypeCount);
+        if (offset < 0 || offset + count > size)
+        {
+            return DM_LUA_ERROR("Trying to write too many values: Stream length: %d, Offset: %d, Values to write: %d", size, offset, count);
+        }
+
+        if (!SetStreamInternal(L, 3, stream, (uint32_t)offset, (uint32_t)count))
+        {
+            return DM_LUA_ERROR("Unknown stream value type: %d", stream->m_Type);
+        }
+
+        UpdateStreamVersion(stream, (uint32_t)offset, (uint32_t)count);
+        return 0;
+    }
+
+    static void TransformStreamInternal(float* data, uint32_t stride, uint32_t components, uint32_t count, const dmVMath::Matrix4& m, bool is_point)
+    {
+        const float w = is_point ? 1.0f : 0.0f;
+        for (uint32_t i = 0; i < count; ++i, data += stride)
+        {
+            dmVMath::Vector4 v = m * dmVMath::Vector4(data[0], data[1], data[2], components == 4 ? data[3] : w);
+            data[0] = v.getX();
+            data[1] = v.getY();
+            data[2] = v.getZ();
+            if (components == 4)
+                data[3] = v.getW();
+        }
+    }
+
+    /*# transforms a stream by a matrix
+     *
+     * Transform the elements of a float32 stream with 3 or 4 components by a matrix.
+     *
+     * @name buffer.transform_stream
+     * @param stream [type:bufferstream] the stream
+     * @param matrix [type:matrix4] the transform
+     * @param [is_point] [type:boolean] if true, 3 component elements are treated as points (w = 1), otherwise as directions (w = 0). Defaults to true. 4 component elements use their own w.
+     * @param [offset] [type:number] the first element to transform (measured in elements). Defaults to 0.
+     * @param [count] [type:number] the number of elements to transform. Defaults to the rest of the stream.
+     *
+     * @examples
+     *
+     * ```lua
+     * local positions = buffer.get_stream(buf, hash("position"))
+     * buffer.transform_stream(positions, vmath.matrix4_rotation_z(math.pi / 2))
+     * ```
+    */
+    static int TransformStream(lua_State* L)
+    {
+        DM_LUA_STACK_CHECK(L, 0);
+        BufferStream* stream = CheckStream(L, 1);
+        dmVMath::Matrix4* m = dmScript::CheckMatrix4(L, 2);
+        bool is_point = lua_isnoneornil(L, 3) ? true : lua_toboolean(L, 3);
+
+        if (stream->m_Type != dmBuffer::VALUE_TYPE_FLOAT32 || (stream->m_TypeCount != 3 && stream->m_TypeCount != 4))
+        {
+            return DM_LUA_ERROR("Expected a stream of 'buffer.%s' with 3 or 4 components, got %u 'buffer.%s'",
+                                    dmBuffer::GetValueTypeString(dmBuffer::VALUE_TYPE_FLOAT32), stream->m_TypeCount, dmBuffer::GetValueTypeString(stream->m_Type));
+        }
+
+        int offset = luaL_optint(L, 4, 0);
+        int count = luaL_optint(L, 5, (int)stream->m_Count - offset);
+        if (offset < 0 || count < 0 || offset + count > (int)stream->m_Count)
+        {
+            return DM_LUA_ERROR("The range is outside the stream: Stream length: %u, Offset: %d, Count: %d", stream->m_Count, offset, count);
+        }
+
+        float* data = (float*)stream->m_Data + offset * stream->m_Stride;
+        TransformStreamInternal(data, stream->m_Stride, stream->m_TypeCount, (uint32_t)count, *m, is_point);
+
+        if (count > 0)
+        {
+            dmBuffer::UpdateStreamContentVersion(stream->m_Buffer, stream->m_Name, (uint32_t)offset, (uint32_t)count);
         }
         return 0;
     }
@@ -890,7 +1255,7 @@ namespace dmGameSystem
         uint32_t count = index / stream->m_TypeCount;
         uint32_t component = index % stream->m_TypeCount;
         stream->m_Set(stream->m_Data, count * stream->m_Stride + component, luaL_checknumber(L, 3));
-        dmBuffer::UpdateContentVersion(stream->m_Buffer);
+        dmBuffer::UpdateStreamContentVersion(stream->m_Buffer, stream->m_Name, count, 1);
         return 0;
     }
 
@@ -1147,6 +1512,11 @@ namespace dmGameSystem
         {"get_stream", GetStream},
         {"get_bytes", GetBytes},
         {"copy_stream", CopyStream},
+        {"set_stream", SetStream},
+        {"fill_stream", FillStream},
+        {"add_stream", AddStream},
+        {"mul_stream", MulStream},
+        {"transform_stream", TransformStream},
         {"copy_buffer", CopyBuffer},
         {"set_metadata",SetMetadata},
         {"get_metadata",GetMetadata},
@@ -16,6 +16,7 @@
 #include <stdio.h>
 #include <assert.h>
 
+#include <dlib/array.h>
 #include <dlib/hash.h>
 #include <dlib/log.h>
 #include <dlib/math.h>
@@ -380,6 +381,211 @@ namespace dmGameSystem
         return 1;
     }
 
+    /*# make a factory create several new game objects
+     *
+     * Creates a number of new game objects from the same factory in one call. The properties are
+     * only parsed once, and all game objects are created before any of them is initialized.
+     *
+     * If the collection doesn't have room for all of the game objects, as many as possible are created.
+     *
+     * @name factory.create_many
+     * @param url [type:string|hash|url] the factory that should create the game objects.
+     * @param count [type:number] the number of game objects to create.
+     * @param [positions] [type:table] a table with the position of each game object, the position of the game object calling `factory.create_many()` is used by default, or if the value is `nil`.
+     * @param [rotations] [type:table] a table with the rotation of each game object, the rotation of the game object calling `factory.create_many()` is used by default, or if the value is `nil`.
+     * @param [properties] [type:table] the properties defined in a script attached to the new game objects. The same properties are used for all game objects.
+     * @param [scale] [type:number|vector3] the scale of the new game objects (must be greater than 0), the scale of the game object containing the factory is used by default, or if the value is `nil`
+     * @return ids [type:table] the global ids of the spawned game objects
+     * @examples
+     *
+     * How to create a row of enemies:
+     *
+     * ```lua
+     * function init(self)
+     *     local positions = {}
+     *     for i = 1, 100 do
+     *         positions[i] = vmath.vector3(i * 10, 100, 0)
+     *     end
+     *     self.enemies = factory.create_many("#factory", #positions, positions, nil, {speed = 10})
+     * end
+     * ```
+     */
+    static int FactoryComp_CreateMany(lua_State* L)
+    {
+        int top = lua_gettop(L);
+
+        dmGameObject::HInstance sender_instance = dmScript::CheckGOInstance(L);
+        dmGameObject::HCollection collection = dmGameObject::GetCollection(sender_instance);
+
+        HFactoryWorld world;
+        HFactoryComponent component;
+        dmMessage::URL receiver;
+        dmScript::GetComponentFromLua(L, 1, FACTORY_EXT, (dmGameObject::HComponentWorld*)&world, (dmGameObject::HComponent*)&component, &receiver);
+
+        int count = luaL_checkinteger(L, 2);
+        if (count < 0)
+        {
+            return luaL_error(L, "The number of game objects to create must be positive: %d", count);
+        }
+
+        bool has_positions = top >= 3 && !lua_isnil(L, 3);
+        bool has_rotations = top >= 4 && !lua_isnil(L, 4);
+        if (has_positions)
+        {
+            luaL_checktype(L, 3, LUA_TTABLE);
+        }
+        if (has_rotations)
+        {
+            luaL_checktype(L, 4, LUA_TTABLE);
+        }
+
+        dmVMath::Vector3 scale;
+        if (top >= 6 && !lua_isnil(L, 6))
+        {
+            // We check for zero in the ToTransform/ResetScale in transform.h
+            dmVMath::Vector3* v = dmScript::ToVector3(L, 6);
+            if (v != 0)
+            {
+                scale = *v;
+            }
+            else
+            {
+                float val = luaL_checknumber(L, 6);
+                scale = dmVMath::Vector3(val, val, val);
+            }
+        }
+        else
+        {
+            scale = dmGameObject::GetWorldScale(sender_instance);
+        }
+
+        // Check all arguments before anything is allocated, since a Lua error won't free it
+        for (int i = 0; i < count; ++i)
+        {
+            if (has_positions)
+            {
+                lua_rawgeti(L, 3, i + 1);
+                if (!lua_isnil(L, -1))
+                    dmScript::CheckVector3(L, -1);
+                lua_pop(L, 1);
+            }
+            if (has_rotations)
+            {
+                lua_rawgeti(L, 4, i + 1);
+                if (!lua_isnil(L, -1))
+                    dmScript::CheckQuat(L, -1);
+                lua_pop(L, 1);
+            }
+        }
+
+        dmGameObject::HPropertyContainer properties = 0;
+        if (top >= 5 && !lua_isnil(L, 5))
+        {
+            luaL_checktype(L, 5, LUA_TTABLE);
+            properties = dmGameObject::PropertyContainerCreateFromLua(L, 5);
+        }
+
+        dmArray<uint32_t> indices;
+        dmArray<dmhash_t> ids;
+        dmArray<dmVMath::Point3> positions;
+        dmArray<dmVMath::Quat> rotations;
+        dmArray<dmVMath::Vector3> scales;
+        indices.SetCapacity(count);
+        ids.SetCapacity(count);
+        positions.SetCapacity(count);
+        rotations.SetCapacity(count);
+        scales.SetCapacity(count);
+
+        dmVMath::Point3 default_position = dmGameObject::GetWorldPosition(sender_instance);
+        dmVMath::Quat default_rotation = dmGameObject::GetWorldRotation(sender_instance);
+        for (int i = 0; i < count; ++i)
+        {
+            dmVMath::Point3 position = default_position;
+            if (has_positions)
+            {
+                lua_rawgeti(L, 3, i + 1);
+                if (!lua_isnil(L, -1))
+                {
+                    position = dmVMath::Point3(*dmScript::ToVector3(L, -1));
+                }
+                lua_pop(L, 1);
+            }
+            dmVMath::Quat rotation = default_rotation;
+            if (has_rotations)
+            {
+                lua_rawgeti(L, 4, i + 1);
+                if (!lua_isnil(L, -1))
+                {
+                    rotation = *dmScript::ToQuat(L, -1);
+                }
+                lua_pop(L, 1);
+            }
+            positions.Push(position);
+            rotations.Push(rotation);
+            scales.Push(scale);
+        }
+
+        for (int i = 0; i < count; ++i)
+        {
+            uint32_t index = dmGameObject::AcquireInstanceIndex(collection);
+            if (index == dmGameObject::INVALID_INSTANCE_POOL_INDEX)
+            {
+                dmLogError("factory.create_many could only create %d of %d gameobjects since the buffer is full. See `collection.max_instances` in game.project", i, count);
+                break;
+            }
+            indices.Push(index);
+            ids.Push(dmGameObject::ConstructInstanceId(index));
+        }
+
+        uint32_t spawn_count = indices.Size();
+        lua_createtable(L, spawn_count, 0);
+
+        bool msg_passing = dmGameObject::GetInstanceFromLua(L) == 0x0;
+        if (msg_passing)
+        {
+            for (uint32_t i = 0; i < spawn_count; ++i)
+            {
+                FactoryComp_CreateWithMessage(L, collection, &receiver, indices[i], ids[i], properties, positions[i], rotations[i], scales[i]);
+                // We currently don't know if the creation succeeds
+                dmScript::PushHash(L, ids[i]);
+                lua_rawseti(L, -2, i + 1);
+            }
+        }
+        else if (spawn_count > 0)
+        {
+            dmArray<dmGameObject::HInstance> instances;
+            instances.SetCapacity(spawn_count);
+            instances.SetSize(spawn_count);
+
+            // Since the spawning will invoke any scripts on the new instances,
+            // we need a way to restore the state
+            dmScript::GetInstance(L);
+            int ref = dmScript::Ref(L, LUA_REGISTRYINDEX);
+
+            CompFactorySpawnBatch(world, component, collection, spawn_count, indices.Begin(), ids.Begin(),
+                                  positions.Begin(), rotations.Begin(), scales.Begin(), properties, instances.Begin());
+
+            lua_rawgeti(L, LUA_REGISTRYINDEX, ref);
+            dmScript::SetInstance(L);
+            dmScript::Unref(L, LUA_REGISTRYINDEX, ref);
+
+            int n = 0;
+            for (uint32_t i = 0; i < spawn_count; ++i)
+            {
+                if (instances[i] != 0)
+                {
+                    dmScript::PushHash(L, ids[i]);
+                    lua_rawseti(L, -2, ++n);
+                }
+            }
+        }
+
+        dmGameObject::PropertyContainerDestroy(properties);
+
+        assert(top + 1 == lua_gettop(L));
+        return 1;
+    }
+
     /*# changes the prototype for the factory
      *
      * Changes the prototype for the factory.
@@ -465,6 +671,7 @@ namespace dmGameSystem
             {
                 return luaL_error(L, "Failed to load collection factory prototype %s", path);
             }
+            new_resource->m_PoolSize = default_resource->m_PoolSize;
         }
 
         CompFactorySetResource(world, component, new_resource);
@@ -481,6 +688,7 @@ namespace dmGameSystem
     static const luaL_reg FACTORY_COMP_FUNCTIONS[] =
     {
         {"create",            FactoryComp_Create},
+        {"create_many",       FactoryComp_CreateMany},
         {"load",              FactoryComp_Load},
         {"unload",            FactoryComp_Unload},
         {"get_status",        FactoryComp_GetStatus},
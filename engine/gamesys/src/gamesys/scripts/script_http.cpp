@@ -25,6 +25,7 @@
 #include <dlib/hash.h>
 #include <dlib/log.h>
 #include <dlib/math.h>
+#include <dlib/path.h>
 #include <dlib/uri.h>
 
 #include <script/script.h>
@@ -95,7 +96,7 @@ namespace dmGameSystem
      * @param [options] [type:table] optional table with request parameters. Supported entries:
      *
      * - [type:number] `timeout`: timeout in seconds
-     * - [type:string] `path`: path on disc where to download the file. Only overwrites the path if status is 200. [icon:attention] Path should be absolute
+     * - [type:string] `path`: path on disc where to download the file. Only overwrites the path if status is 200. The response is streamed to disc while it is downloaded, and is not kept in memory. [icon:attention] Path should be absolute
      * - [type:boolean] `ignore_cache`: don't return cached data if we get a 304. [icon:attention] Not available in HTML5 build
      * - [type:boolean] `chunked_transfer`: use chunked transfer encoding for https requests larger than 16kb. Defaults to true. [icon:attention] Not available in HTML5 build
      * - [type:boolean] `report_progress`: when it is true, the amount of bytes sent and/or received for a request will be passed into the callback function
@@ -200,6 +201,7 @@ namespace dmGameSystem
 
             uint64_t timeout = g_Timeout;
             const char* path = 0;
+            uint32_t path_len = 0;
             bool ignore_cache = false;
             bool chunked_transfer = true;
             bool report_progress = false;
@@ -216,6 +218,13 @@ namespace dmGameSystem
                     else if (strcmp(attr, "path") == 0)
                     {
                         path = luaL_checkstring(L, -1);
+                        path_len = (uint32_t)strlen(path);
+                        if (path_len >= DMPATH_MAX_PATH)
+                        {
+                            free(headers);
+                            free(request_data);
+                            return luaL_error(L, "http.request does not support paths longer than %d characters.", DMPATH_MAX_PATH - 1);
+                        }
                     }
                     else if (strcmp(attr, "ignore_cache") == 0)
                     {
@@ -235,11 +244,16 @@ namespace dmGameSystem
                 lua_pop(L, 1);
             }
 
-            // ddf + max method and url string lengths incl. null character
-            char buf[sizeof(dmHttpDDF::HttpRequest) + max_method_len + 1 + max_url_len + 1];
+            // ddf + max method, url and path string lengths incl. null character
+            // NOTE: The path is copied as the lua string might be collected before the response arrives
+            char buf[sizeof(dmHttpDDF::HttpRequest) + max_method_len + 1 + max_url_len + 1 + DMPATH_MAX_PATH];
             char* string_buf = buf + sizeof(dmHttpDDF::HttpRequest);
             dmStrlCpy(string_buf, method, method_len + 1);
             dmStrlCpy(string_buf + method_len + 1, url, url_len + 1);
+            if (path)
+            {
+                dmStrlCpy(string_buf + method_len + 1 + url_len + 1, path, path_len + 1);
+            }
 
             dmHttpDDF::HttpRequest* request = (dmHttpDDF::HttpRequest*) buf;
             request->m_Method = (const char*) (sizeof(*request));
@@ -249,12 +263,12 @@ namespace dmGameSystem
             request->m_Request = (uint64_t) request_data;
             request->m_RequestLength = request_data_length;
             request->m_Timeout = timeout;
-            request->m_Path = path;
+            request->m_Path = path ? (const char*) (sizeof(*request) + method_len + 1 + url_len + 1) : 0;
             request->m_IgnoreCache = ignore_cache;
             request->m_ChunkedTransfer = chunked_transfer;
             request->m_ReportProgress = report_progress;
 
-            uint32_t post_len = sizeof(dmHttpDDF::HttpRequest) + method_len + 1 + url_len + 1;
+            uint32_t post_len = sizeof(dmHttpDDF::HttpRequest) + method_len + 1 + url_len + 1 + (path ? path_len + 1 : 0);
             dmMessage::URL receiver;
             dmMessage::ResetURL(&receiver);
             receiver.m_Socket = dmHttpService::GetSocket(g_Service);
@@ -104,6 +104,8 @@ namespace dmGameSystem
         resp.m_Response = (uint64_t) response;
         resp.m_ResponseLength = response_length;
         resp.m_Path = ctx->m_Path;
+        resp.m_PathStreamed = 0;
+        resp.m_PathError = 0;
 
         resp.m_Headers = (uint64_t) malloc(headers_length);
         memcpy((void*) resp.m_Headers, headers, headers_length);
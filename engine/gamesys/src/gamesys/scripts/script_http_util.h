@@ -64,7 +64,14 @@ namespace dmGameSystem
 
         if (resp->m_Path)
         {
-            if (resp->m_Status == 200) {
+            if (resp->m_PathStreamed) {
+                // The http service has already written the response to the file
+                if (resp->m_PathError)
+                {
+                    lua_pushstring(L, "Failed to write to temp file");
+                    lua_setfield(L, -2, "error");
+                }
+            } else if (resp->m_Status == 200) {
                 if (!WriteResponseToFile(resp->m_Path, response, resp->m_ResponseLength))
                 {
                     lua_pushstring(L, "Failed to write to temp file");
@@ -1675,6 +1675,117 @@ namespace dmGameSystem
         return 0;
     }
 
+    /*# enables or disables batched physics events
+     *
+     * When enabled, the collision, contact point and trigger events of the physics world are
+     * collected each frame, instead of being sent as messages or to the [ref:physics.set_listener] callback.
+     * Use [ref:physics.get_events] to read them. Ray cast responses are not affected.
+     *
+     * @name physics.set_event_batching
+     *
+     * @param enable [type:boolean] true to collect the events, false to send them as messages again
+     *
+     * @examples
+     *
+     * ```lua
+     * function init(self)
+     *     physics.set_event_batching(true)
+     * end
+     * ```
+     */
+    static int Physics_SetEventBatching(lua_State* L)
+    {
+        DM_LUA_STACK_CHECK(L, 0);
+
+        dmScript::GetGlobal(L, PHYSICS_CONTEXT_HASH);
+        PhysicsScriptContext* context = (PhysicsScriptContext*)lua_touserdata(L, -1);
+        lua_pop(L, 1);
+
+        dmGameObject::HInstance sender_instance = CheckGoInstance(L);
+        dmGameObject::HCollection collection = dmGameObject::GetCollection(sender_instance);
+
+        void* world = dmGameObject::GetWorld(collection, context->m_ComponentIndex);
+        if (world == 0x0)
+        {
+            return DM_LUA_ERROR("Physics world doesn't exist. Make sure you have at least one physics component in collection.");
+        }
+
+        SetCollisionWorldEventBatching(world, dmScript::CheckBoolean(L, 1));
+        return 0;
+    }
+
+    static void PushEventList(lua_State* L, const char* name, const dmDDF::Descriptor* desc, const char* events, uint32_t event_size, uint32_t count)
+    {
+        lua_createtable(L, count, 0);
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            dmScript::PushDDF(L, desc, events + i * event_size, false);
+            lua_rawseti(L, -2, i + 1);
+        }
+        lua_setfield(L, -2, name);
+    }
+
+    /*# gets the batched physics events
+     *
+     * Returns the collision, contact point and trigger events collected since the last call, and clears them.
+     * Requires [ref:physics.set_event_batching] to be enabled. Events that aren't read are dropped
+     * when the physics world is stepped the next frame.
+     *
+     * @name physics.get_events
+     *
+     * @return events [type:table] A table with the lists `collision_events`, `contact_point_events` and `trigger_events`.
+     * Each event has the same fields as the `data` table of the corresponding [ref:physics.set_listener] event.
+     *
+     * @examples
+     *
+     * ```lua
+     * function update(self, dt)
+     *     local events = physics.get_events()
+     *     for _, event in ipairs(events.collision_events) do
+     *         print(event.a.id, event.b.id)
+     *     end
+     *     for _, event in ipairs(events.trigger_events) do
+     *         print(event.enter, event.a.id, event.b.id)
+     *     end
+     * end
+     * ```
+     */
+    static int Physics_GetEvents(lua_State* L)
+    {
+        DM_LUA_STACK_CHECK(L, 1);
+
+        dmScript::GetGlobal(L, PHYSICS_CONTEXT_HASH);
+        PhysicsScriptContext* context = (PhysicsScriptContext*)lua_touserdata(L, -1);
+        lua_pop(L, 1);
+
+        dmGameObject::HInstance sender_instance = CheckGoInstance(L);
+        dmGameObject::HCollection collection = dmGameObject::GetCollection(sender_instance);
+
+        void* world = dmGameObject::GetWorld(collection, context->m_ComponentIndex);
+        if (world == 0x0)
+        {
+            return DM_LUA_ERROR("Physics world doesn't exist. Make sure you have at least one physics component in collection.");
+        }
+        if (!IsCollisionWorldEventBatching(world))
+        {
+            return DM_LUA_ERROR("Event batching isn't enabled. Call physics.set_event_batching(true) first.");
+        }
+
+        CollisionWorldEvents events;
+        GetCollisionWorldEvents(world, &events);
+
+        lua_createtable(L, 0, 3);
+        PushEventList(L, "collision_events", dmPhysicsDDF::CollisionEvent::m_DDFDescriptor,
+                        (const char*)events.m_CollisionEvents, sizeof(dmPhysicsDDF::CollisionEvent), events.m_CollisionEventCount);
+        PushEventList(L, "contact_point_events", dmPhysicsDDF::ContactPointEvent::m_DDFDescriptor,
+                        (const char*)events.m_ContactPointEvents, sizeof(dmPhysicsDDF::ContactPointEvent), events.m_ContactPointEventCount);
+        PushEventList(L, "trigger_events", dmPhysicsDDF::TriggerEvent::m_DDFDescriptor,
+                        (const char*)events.m_TriggerEvents, sizeof(dmPhysicsDDF::TriggerEvent), events.m_TriggerEventCount);
+
+        ClearCollisionWorldEvents(world);
+        return 1;
+    }
+
      /*# updates the mass of a dynamic 2D collision object in the physics world.
      *
      * The function recalculates the density of each shape based on the total area of all shapes and the specified mass, then updates the mass of the body accordingly.
@@ -1764,6 +1875,8 @@ namespace dmGameSystem
         {"get_maskbit",     Physics_GetMaskBit},
         {"set_maskbit",     Physics_SetMaskBit},
         {"set_listener",    Physics_SetListener},
+        {"set_event_batching", Physics_SetEventBatching},
+        {"get_events",      Physics_GetEvents},
         {"update_mass",     Physics_UpdateMass},
 
         // Shapes
@@ -0,0 +1,8 @@
+components {
+  id: "mesh"
+  component: "/mesh/triangle.meshc"
+}
+components {
+  id: "script"
+  component: "/mesh/partial_upload.script"
+}
@@ -0,0 +1,36 @@
+components {
+  id: "quad0"
+  component: "/model/instancing_quad.model"
+  position {
+    x: 0.0
+    y: 0.0
+    z: 0.0
+  }
+}
+components {
+  id: "cube"
+  component: "/model/instancing_cube.model"
+  position {
+    x: 2.0
+    y: 0.0
+    z: 0.0
+  }
+}
+components {
+  id: "quad1"
+  component: "/model/instancing_quad.model"
+  position {
+    x: 4.0
+    y: 0.0
+    z: 0.0
+  }
+}
+components {
+  id: "quad2"
+  component: "/model/instancing_quad.model"
+  position {
+    x: 6.0
+    y: 0.0
+    z: 0.0
+  }
+}
@@ -1932,6 +1932,35 @@ TEST_P(FactoryTest, Test)
 
 /* Collection factory dynamic and static loading */
 
+/* Create several game objects with factory.create_many */
+TEST_F(ComponentTest, FactoryCreateManyTest)
+{
+    dmHashEnableReverseHash(true);
+    lua_State* L = dmScript::GetLuaState(m_ScriptContext);
+
+    dmGameSystem::ScriptLibContext scriptlibcontext;
+    scriptlibcontext.m_Factory         = m_Factory;
+    scriptlibcontext.m_Register        = m_Register;
+    scriptlibcontext.m_LuaState        = L;
+    scriptlibcontext.m_GraphicsContext = m_GraphicsContext;
+    scriptlibcontext.m_ScriptContext   = m_ScriptContext;
+    dmGameSystem::InitializeScriptLibs(scriptlibcontext);
+
+    ASSERT_TRUE(dmGameObject::Init(m_Collection));
+    dmGameObject::HInstance go = Spawn(m_Factory, m_Collection, "/factory/create_many_test.goc", dmHashString64("/go"), 0, Point3(0, 0, 0), Quat(0, 0, 0, 1), Vector3(1, 1, 1));
+    ASSERT_NE((void*)0, go);
+
+    lua_getglobal(L, "tests_done");
+    ASSERT_TRUE(lua_toboolean(L, -1));
+    lua_pop(L, 1);
+
+    ASSERT_TRUE(dmGameObject::Update(m_Collection, &m_UpdateContext));
+    ASSERT_TRUE(dmGameObject::PostUpdate(m_Collection));
+
+    dmGameSystem::FinalizeScriptLibs(scriptlibcontext);
+    ASSERT_TRUE(dmGameObject::Final(m_Collection));
+}
+
 TEST_P(CollectionFactoryTest, Test)
 {
     const char* resource_path[] = {
@@ -2497,6 +2526,82 @@ TEST_F(CollisionObject2DTest, PropertiesTest)
     ASSERT_TRUE(dmGameObject::Final(m_Collection));
 }
 
+// Height of a body falling from y0, after n fixed steps (semi-implicit Euler, as in Box2D)
+static float FallHeight(float y0, uint32_t n, float dt)
+{
+    return y0 - 10.0f * dt * dt * (n * (n + 1)) * 0.5f;
+}
+
+// The fixed update frequency and frame time are picked so that the steps per frame alternate 1, 2, 1, 2...
+// and the blend factors 0.5, 0.0, 0.5, 0.0... without float rounding.
+static const uint32_t INTERPOLATION_TEST_FREQUENCY = 64;
+static const float    INTERPOLATION_TEST_FIXED_DT = 1.0f / 64.0f;
+
+TEST_F(CollisionObjectInterpolation2DTest, Blend)
+{
+    m_UpdateContext.m_FixedUpdateFrequency = INTERPOLATION_TEST_FREQUENCY;
+    m_UpdateContext.m_DT = 1.5f * INTERPOLATION_TEST_FIXED_DT;
+    const float dt = INTERPOLATION_TEST_FIXED_DT;
+
+    dmGameObject::HInstance go = Spawn(m_Factory, m_Collection, "/collision_object/body.goc", dmHashString64("/body"), 0, Point3(10, 10, 0), Quat(0, 0, 0, 1), Vector3(1, 1, 1));
+    ASSERT_NE((void*)0, go);
+
+    // Frame 1: step 1. The game object isn't touched until the next frame
+    ASSERT_TRUE(dmGameObject::Update(m_Collection, &m_UpdateContext));
+    ASSERT_TRUE(dmGameObject::PostUpdate(m_Collection));
+    ASSERT_NEAR(10.0f, dmGameObject::GetPosition(go).getY(), 0.0001f);
+
+    // Frame 2: blends step 1 with itself, then steps 2 and 3
+    ASSERT_TRUE(dmGameObject::Update(m_Collection, &m_UpdateContext));
+    ASSERT_TRUE(dmGameObject::PostUpdate(m_Collection));
+    ASSERT_NEAR(FallHeight(10.0f, 1, dt), dmGameObject::GetPosition(go).getY(), 0.0001f);
+
+    // Frame 3: alpha 0 presents step 2, one step behind the body, then step 4
+    ASSERT_TRUE(dmGameObject::Update(m_Collection, &m_UpdateContext));
+    ASSERT_TRUE(dmGameObject::PostUpdate(m_Collection));
+    ASSERT_NEAR(FallHeight(10.0f, 2, dt), dmGameObject::GetPosition(go).getY(), 0.0001f);
+
+    // Frame 4: alpha 0.5 presents the midpoint of step 3 and 4
+    ASSERT_TRUE(dmGameObject::Update(m_Collection, &m_UpdateContext));
+    ASSERT_TRUE(dmGameObject::PostUpdate(m_Collection));
+    float expected = 0.5f * (FallHeight(10.0f, 3, dt) + FallHeight(10.0f, 4, dt));
+    ASSERT_NEAR(expected, dmGameObject::GetPosition(go).getY(), 0.0001f);
+    ASSERT_NEAR(10.0f, dmGameObject::GetPosition(go).getX(), 0.0001f);
+
+    ASSERT_TRUE(dmGameObject::Final(m_Collection));
+}
+
+TEST_F(CollisionObjectInterpolation2DTest, Teleport)
+{
+    m_UpdateContext.m_FixedUpdateFrequency = INTERPOLATION_TEST_FREQUENCY;
+    m_UpdateContext.m_DT = 1.5f * INTERPOLATION_TEST_FIXED_DT;
+
+    dmGameObject::HInstance go = Spawn(m_Factory, m_Collection, "/collision_object/body.goc", dmHashString64("/body"), 0, Point3(10, 10, 0), Quat(0, 0, 0, 1), Vector3(1, 1, 1));
+    ASSERT_NE((void*)0, go);
+
+    for (int i = 0; i < 3; ++i)
+    {
+        ASSERT_TRUE(dmGameObject::Update(m_Collection, &m_UpdateContext));
+        ASSERT_TRUE(dmGameObject::PostUpdate(m_Collection));
+    }
+
+    // Moved before the regular update, as a script would. The blend must not overwrite it
+    dmGameObject::SetPosition(go, Point3(100, 50, 0));
+    ASSERT_TRUE(dmGameObject::Update(m_Collection, &m_UpdateContext));
+    ASSERT_TRUE(dmGameObject::PostUpdate(m_Collection));
+    ASSERT_NEAR(100.0f, dmGameObject::GetPosition(go).getX(), 0.0001f);
+    ASSERT_NEAR(50.0f, dmGameObject::GetPosition(go).getY(), 0.0001f);
+
+    // The body followed, so the blend continues from the new position instead of the old one
+    ASSERT_TRUE(dmGameObject::Update(m_Collection, &m_UpdateContext));
+    ASSERT_TRUE(dmGameObject::PostUpdate(m_Collection));
+    ASSERT_NEAR(100.0f, dmGameObject::GetPosition(go).getX(), 0.0001f);
+    ASSERT_GT(50.0f, dmGameObject::GetPosition(go).getY());
+    ASSERT_LT(49.0f, dmGameObject::GetPosition(go).getY());
+
+    ASSERT_TRUE(dmGameObject::Final(m_Collection));
+}
+
 TEST_P(GroupAndMask2DTest, GroupAndMaskTest )
 {
     const GroupAndMaskParams& params = GetParam();
@@ -2786,6 +2891,55 @@ TEST_F(ComponentTest, PhysicsListenerTest)
 
 }
 
+/* Physics event batching */
+TEST_F(ComponentTest, PhysicsEventBatchingTest)
+{
+    /* Setup:
+    ** event_batching
+    ** - [collisionobject] collision_object/callback_object.collisionobject
+    ** - [script] collision_object/event_batching.script
+    ** callback_trigger
+    ** - [collisionobject] collision_object/callback_trigger.collisionobject
+    */
+
+    dmHashEnableReverseHash(true);
+    lua_State* L = dmScript::GetLuaState(m_ScriptContext);
+
+    dmGameSystem::ScriptLibContext scriptlibcontext;
+    scriptlibcontext.m_Factory         = m_Factory;
+    scriptlibcontext.m_Register        = m_Register;
+    scriptlibcontext.m_LuaState        = L;
+    scriptlibcontext.m_GraphicsContext = m_GraphicsContext;
+    scriptlibcontext.m_ScriptContext   = m_ScriptContext;
+    dmGameSystem::InitializeScriptLibs(scriptlibcontext);
+
+    const char* path_test_object = "/collision_object/event_batching.goc";
+    const char* path_test_trigger = "/collision_object/callback_trigger.goc";
+
+    dmhash_t hash_go_object = dmHashString64("/test_object");
+    dmhash_t hash_go_trigger = dmHashString64("/test_trigger");
+
+    dmGameObject::HInstance go_b = Spawn(m_Factory, m_Collection, path_test_object, hash_go_object, 0, Point3(0, 0, 0), Quat(0, 0, 0, 1), Vector3(1, 1, 1));
+    ASSERT_NE((void*)0, go_b);
+
+    dmGameObject::HInstance go_a = Spawn(m_Factory, m_Collection, path_test_trigger, hash_go_trigger, 0, Point3(0, 0, 0), Quat(0, 0, 0, 1), Vector3(1, 1, 1));
+    ASSERT_NE((void*)0, go_a);
+
+    bool tests_done = false;
+    while (!tests_done)
+    {
+        ASSERT_TRUE(dmGameObject::Update(m_Collection, &m_UpdateContext));
+        ASSERT_TRUE(dmGameObject::PostUpdate(m_Collection));
+
+        // check if tests are done
+        lua_getglobal(L, "tests_done");
+        tests_done = lua_toboolean(L, -1);
+        lua_pop(L, 1);
+    }
+
+    ASSERT_TRUE(dmGameObject::Final(m_Collection));
+}
+
 /* Update mass for physics collision object */
 TEST_F(ComponentTest, PhysicsUpdateMassTest)
 {
@@ -3146,6 +3300,202 @@ TEST_F(ComponentTest, DispatchBuffersTest)
     ASSERT_TRUE(dmGameObject::Final(m_Collection));
 }
 
+// Renders a frame and returns the vertices written by the tilegrid world, as x, y, z, u, v
+static const float* RenderTileGridVertices(dmGameObject::HCollection collection, dmGameObject::UpdateContext* update_context, dmRender::HRenderContext render_context, void* tilegrid_world)
+{
+    if (!dmGameObject::Update(collection, update_context))
+        return 0;
+    dmRender::RenderListBegin(render_context);
+    dmGameObject::Render(collection);
+    dmRender::RenderListEnd(render_context);
+    dmRender::DrawRenderList(render_context, 0x0, 0x0, 0x0);
+
+    dmRender::BufferedRenderBuffer* vx_buffer;
+    dmGameSystem::GetTileGridWorldRenderBuffers(tilegrid_world, &vx_buffer);
+    dmGraphics::VertexBuffer* gfx_vx_buffer = (dmGraphics::VertexBuffer*) vx_buffer->m_Buffers[0];
+    return (const float*) gfx_vx_buffer->m_Buffer;
+}
+
+TEST_F(ComponentTest, TileGridVertexCache)
+{
+    void* tilegrid_world = dmGameObject::GetWorld(m_Collection, dmGameObject::GetComponentTypeIndex(m_Collection, dmHashString64("tilemapc")));
+    ASSERT_NE((void*) 0, tilegrid_world);
+
+    ASSERT_TRUE(dmGameObject::Init(m_Collection));
+    dmGameObject::HInstance go = Spawn(m_Factory, m_Collection, "/tile/valid_tilegrid.goc", dmHashString64("/go"), 0, Point3(0, 0, 0), Quat(0, 0, 0, 1), Vector3(1, 1, 1));
+    ASSERT_NE((void*)0, go);
+
+    // The first vertex of each tile is its lower left corner. The second tile is at cell (1, 0)
+    const uint32_t second_tile = 6 * 5;
+
+    const float* vertices = RenderTileGridVertices(m_Collection, &m_UpdateContext, m_RenderContext, tilegrid_world);
+    ASSERT_NE((void*)0, vertices);
+    ASSERT_EQ(16.0f, vertices[second_tile + 0]);
+    ASSERT_EQ(0.0f, vertices[second_tile + 1]);
+    float u = vertices[second_tile + 3];
+    float v = vertices[second_tile + 4];
+
+    // Moving the game object rebuilds the cached vertices
+    dmGameObject::SetPosition(go, Point3(100, 50, 0));
+    vertices = RenderTileGridVertices(m_Collection, &m_UpdateContext, m_RenderContext, tilegrid_world);
+    ASSERT_NE((void*)0, vertices);
+    ASSERT_EQ(116.0f, vertices[second_tile + 0]);
+    ASSERT_EQ(50.0f, vertices[second_tile + 1]);
+    ASSERT_EQ(u, vertices[second_tile + 3]);
+    ASSERT_EQ(v, vertices[second_tile + 4]);
+
+    // Reloading the tile source rebuilds the cached vertices, even if the new data ends up at the same address
+    const char* texture_set_path     = "/tile/valid.t.texturesetc";
+    const char* texture_set_path_32  = "/tile/valid2.t.texturesetc"; // 32x32 tiles
+    const char* texture_set_path_tmp = "/tile/tmp.t.texturesetc";
+    ASSERT_TRUE(CopyResource(texture_set_path, texture_set_path_tmp));
+    ASSERT_TRUE(CopyResource(texture_set_path_32, texture_set_path));
+    ASSERT_EQ(dmResource::RESULT_OK, dmResource::ReloadResource(m_Factory, texture_set_path, 0));
+
+    vertices = RenderTileGridVertices(m_Collection, &m_UpdateContext, m_RenderContext, tilegrid_world);
+    ASSERT_NE((void*)0, vertices);
+    ASSERT_EQ(132.0f, vertices[second_tile + 0]);
+
+    ASSERT_TRUE(CopyResource(texture_set_path_tmp, texture_set_path));
+    ASSERT_EQ(dmResource::RESULT_OK, dmResource::ReloadResource(m_Factory, texture_set_path, 0));
+
+    vertices = RenderTileGridVertices(m_Collection, &m_UpdateContext, m_RenderContext, tilegrid_world);
+    ASSERT_NE((void*)0, vertices);
+    ASSERT_EQ(116.0f, vertices[second_tile + 0]);
+    UnlinkResource(texture_set_path_tmp);
+
+    ASSERT_TRUE(dmGameObject::Final(m_Collection));
+}
+
+// Renders a frame with a game object with three quad models and one cube model, and returns the draw call counters
+static const dmGraphics::NullCallCounters* RenderModelInstancing(dmGameObject::HCollection collection, dmGameObject::UpdateContext* update_context, dmRender::HRenderContext render_context, dmGraphics::HContext graphics_context)
+{
+    if (!dmGameObject::Update(collection, update_context))
+        return 0;
+    dmRender::RenderListBegin(render_context);
+    dmGameObject::Render(collection);
+    dmRender::RenderListEnd(render_context);
+
+    dmGraphics::NullContext* null_context = (dmGraphics::NullContext*) graphics_context;
+    memset(&null_context->m_CallCounters, 0, sizeof(null_context->m_CallCounters));
+    dmRender::DrawRenderList(render_context, 0x0, 0x0, 0x0);
+    return &null_context->m_CallCounters;
+}
+
+TEST_F(ComponentTest, ModelInstancing)
+{
+    ASSERT_TRUE(dmGameObject::Init(m_Collection));
+
+    // The material reads the world matrix from the mtx_world attribute, so the quads are drawn with
+    // one instanced draw call, even though the cube is between them in the batch, and the cube with another
+    dmGameObject::HInstance go = Spawn(m_Factory, m_Collection, "/model/instancing.goc", dmHashString64("/go"), 0, Point3(0, 0, 0), Quat(0, 0, 0, 1), Vector3(1, 1, 1));
+    ASSERT_NE((void*)0, go);
+
+    const dmGraphics::NullCallCounters* counters = RenderModelInstancing(m_Collection, &m_UpdateContext, m_RenderContext, m_GraphicsContext);
+    ASSERT_NE((void*)0, counters);
+    ASSERT_EQ(2u, counters->m_Draw);
+    ASSERT_EQ(2u, counters->m_DrawInstanced);
+    ASSERT_EQ(4u, counters->m_DrawInstances);
+
+    // The cube is drawn last, as a single instance, with its world matrix in the instance buffer
+    dmGraphics::NullContext* null_context = (dmGraphics::NullContext*) m_GraphicsContext;
+    dmGraphics::HVertexDeclaration instance_declaration = null_context->m_DrawVertexDeclarations[1];
+    ASSERT_NE((void*)0, instance_declaration);
+    ASSERT_EQ(dmGraphics::VERTEX_STEP_FUNCTION_INSTANCE, instance_declaration->m_StepFunction);
+    ASSERT_EQ(0u, dmGraphics::GetVertexStreamOffset(instance_declaration, dmRender::VERTEX_STREAM_WORLD_MATRIX));
+
+    dmGraphics::VertexBuffer* instance_buffer = (dmGraphics::VertexBuffer*) null_context->m_DrawVertexBuffers[1];
+    ASSERT_NE((void*)0, instance_buffer);
+    ASSERT_EQ(sizeof(dmVMath::Matrix4), instance_buffer->m_Size);
+    dmVMath::Matrix4 cube_world = *(dmVMath::Matrix4*) instance_buffer->m_Buffer;
+    ASSERT_NEAR(2.0f, cube_world.getCol3().getX(), EPSILON);
+    DeleteInstance(m_Collection, go);
+
+    // Without instancing, the world matrix is written per vertex to the attribute buffer
+    null_context->m_ContextFeatures &= ~(1 << dmGraphics::CONTEXT_FEATURE_INSTANCING);
+    dmGameObject::HCollection collection = dmGameObject::NewCollection("collection_no_instancing", m_Factory, m_Register, 1024, 0x0);
+    ASSERT_NE((void*)0, collection);
+    ASSERT_TRUE(dmGameObject::Init(collection));
+
+    go = Spawn(m_Factory, collection, "/model/instancing.goc", dmHashString64("/go"), 0, Point3(0, 0, 0), Quat(0, 0, 0, 1), Vector3(1, 1, 1));
+    ASSERT_NE((void*)0, go);
+
+    counters = RenderModelInstancing(collection, &m_UpdateContext, m_RenderContext, m_GraphicsContext);
+    ASSERT_NE((void*)0, counters);
+    ASSERT_EQ(4u, counters->m_Draw);
+    ASSERT_EQ(0u, counters->m_DrawInstanced);
+
+    // The last quad is drawn last
+    dmGraphics::HVertexDeclaration attribute_declaration = null_context->m_DrawVertexDeclarations[1];
+    ASSERT_NE((void*)0, attribute_declaration);
+    ASSERT_EQ(dmGraphics::VERTEX_STEP_FUNCTION_VERTEX, attribute_declaration->m_StepFunction);
+    uint32_t world_offset = dmGraphics::GetVertexStreamOffset(attribute_declaration, dmRender::VERTEX_STREAM_WORLD_MATRIX);
+    ASSERT_NE(dmGraphics::INVALID_STREAM_OFFSET, world_offset);
+
+    dmGraphics::VertexBuffer* attribute_buffer = (dmGraphics::VertexBuffer*) null_context->m_DrawVertexBuffers[1];
+    ASSERT_NE((void*)0, attribute_buffer);
+    uint32_t stride = dmGraphics::GetVertexDeclarationStride(attribute_declaration);
+    ASSERT_LT(0u, attribute_buffer->m_Size / stride);
+    for (uint32_t i = 0; i < attribute_buffer->m_Size / stride; ++i)
+    {
+        dmVMath::Matrix4 quad_world = *(dmVMath::Matrix4*) (attribute_buffer->m_Buffer + i * stride + world_offset);
+        ASSERT_NEAR(6.0f, quad_world.getCol3().getX(), EPSILON);
+    }
+
+    DeleteInstance(collection, go);
+    ASSERT_TRUE(dmGameObject::Final(collection));
+    dmGameObject::DeleteCollection(collection);
+    null_context->m_ContextFeatures |= 1 << dmGraphics::CONTEXT_FEATURE_INSTANCING;
+
+    // Without the attribute, each model gets its own draw call
+    go = Spawn(m_Factory, m_Collection, "/model/instancing_off.goc", dmHashString64("/go_off"), 0, Point3(0, 0, 0), Quat(0, 0, 0, 1), Vector3(1, 1, 1));
+    ASSERT_NE((void*)0, go);
+
+    counters = RenderModelInstancing(m_Collection, &m_UpdateContext, m_RenderContext, m_GraphicsContext);
+    ASSERT_NE((void*)0, counters);
+    ASSERT_EQ(4u, counters->m_Draw);
+    ASSERT_EQ(0u, counters->m_DrawInstanced);
+    DeleteInstance(m_Collection, go);
+
+    ASSERT_TRUE(dmGameObject::Final(m_Collection));
+}
+
+TEST_F(ComponentTest, MeshPartialUpload)
+{
+    dmGameSystem::ScriptLibContext scriptlibcontext;
+    scriptlibcontext.m_Factory         = m_Factory;
+    scriptlibcontext.m_Register        = m_Register;
+    scriptlibcontext.m_LuaState        = dmScript::GetLuaState(m_ScriptContext);
+    scriptlibcontext.m_GraphicsContext = m_GraphicsContext;
+    scriptlibcontext.m_ScriptContext   = m_ScriptContext;
+    dmGameSystem::InitializeScriptLibs(scriptlibcontext);
+
+    ASSERT_TRUE(dmGameObject::Init(m_Collection));
+
+    dmGameObject::HInstance go = Spawn(m_Factory, m_Collection, "/mesh/partial_upload.goc", dmHashString64("/go"), 0, Point3(0, 0, 0), Quat(0, 0, 0, 1), Vector3(1, 1, 1));
+    ASSERT_NE((void*)0, go);
+
+    // Nothing is changed in the first frame
+    ASSERT_TRUE(dmGameObject::Update(m_Collection, &m_UpdateContext));
+
+    dmGraphics::NullContext* null_context = (dmGraphics::NullContext*) m_GraphicsContext;
+    memset(&null_context->m_CallCounters, 0, sizeof(null_context->m_CallCounters));
+
+    // The script changes one position in the second frame, which is uploaded in the second or third
+    ASSERT_TRUE(dmGameObject::Update(m_Collection, &m_UpdateContext));
+    ASSERT_TRUE(dmGameObject::Update(m_Collection, &m_UpdateContext));
+
+    const dmGraphics::NullCallCounters& counters = null_context->m_CallCounters;
+    ASSERT_EQ(0u, counters.m_SetVertexBufferData);
+    ASSERT_EQ(1u, counters.m_SetVertexBufferSubData);
+    ASSERT_EQ(sizeof(float) * 3, counters.m_VertexBufferUploadSize);
+
+    DeleteInstance(m_Collection, go);
+
+    dmGameSystem::FinalizeScriptLibs(scriptlibcontext);
+    ASSERT_TRUE(dmGameObject::Final(m_Collection));
+}
+
 /* Camera */
 
 const char* valid_camera_resources[] = {"/camera/valid.camerac"};
@@ -4435,6 +4785,116 @@ TEST_F(ScriptBufferTest, CopyStream)
     ASSERT_EQ(top, lua_gettop(L));
 }
 
+TEST_F(ScriptBufferTest, StreamOps)
+{
+    int top = lua_gettop(L);
+
+    uint16_t* stream_rgb = 0;
+    uint32_t count_rgb = 0;
+    uint32_t components_rgb = 0;
+    uint32_t stride_rgb = 0;
+    ASSERT_EQ(dmBuffer::RESULT_OK, dmBuffer::GetStream(m_Buffer, dmHashString64("rgb"), (void**)&stream_rgb, &count_rgb, &components_rgb, &stride_rgb));
+
+    float* stream_a = 0;
+    uint32_t count_a = 0;
+    uint32_t components_a = 0;
+    uint32_t stride_a = 0;
+    ASSERT_EQ(dmBuffer::RESULT_OK, dmBuffer::GetStream(m_Buffer, dmHashString64("a"), (void**)&stream_a, &count_a, &components_a, &stride_a));
+
+    dmScript::LuaHBuffer luabuf(m_Buffer, dmScript::OWNER_C);
+    dmScript::PushBuffer(L, luabuf);
+    lua_setglobal(L, "test_buffer");
+
+    uint32_t version = 0;
+    dmBuffer::GetContentVersion(m_Buffer, &version);
+
+    // Fill with one value per component, then add and multiply part of the stream
+    ASSERT_TRUE(RunString(L, "local stream = buffer.get_stream(test_buffer, hash(\"rgb\")) \
+                              buffer.fill_stream(stream, {1, 2, 3}) \
+                              buffer.add_stream(stream, 10, 3, 3) \
+                              buffer.mul_stream(stream, vmath.vector3(2, 3, 4), 4, 4) \
+                             "));
+    ASSERT_EQ(dmBuffer::RESULT_OK, dmBuffer::ValidateBuffer(m_Buffer));
+
+    uint16_t* rgb = stream_rgb;
+    ASSERT_EQ(1, rgb[0]); ASSERT_EQ(2, rgb[1]); ASSERT_EQ(3, rgb[2]);
+    rgb += stride_rgb;
+    ASSERT_EQ(11, rgb[0]); ASSERT_EQ(12*3, rgb[1]); ASSERT_EQ(13*4, rgb[2]);
+    rgb += stride_rgb;
+    ASSERT_EQ(1*2, rgb[0]); ASSERT_EQ(2*3, rgb[1]); ASSERT_EQ(3, rgb[2]);
+    rgb += stride_rgb;
+    for (uint32_t i = 3; i < count_rgb; ++i, rgb += stride_rgb)
+    {
+        ASSERT_EQ(1, rgb[0]); ASSERT_EQ(2, rgb[1]); ASSERT_EQ(3, rgb[2]);
+    }
+
+    // Set a range from a table, and copy it to another buffer
+    ASSERT_TRUE(RunString(L, "local a = buffer.get_stream(test_buffer, hash(\"a\")) \
+                              buffer.fill_stream(a, 0) \
+                              buffer.set_stream(a, 2, {1.5, 2.5, 3.5}) \
+                              local tmp = buffer.create(3, { {name=hash(\"temp\"), type=buffer.VALUE_TYPE_FLOAT32, count=1 } }) \
+                              local temp = buffer.get_stream(tmp, hash(\"temp\")) \
+                              buffer.set_stream(temp, 0, {1, 2, 3}) \
+                              buffer.copy_stream(a, 10, temp, 0, 3) \
+                             "));
+    ASSERT_EQ(dmBuffer::RESULT_OK, dmBuffer::ValidateBuffer(m_Buffer));
+    ASSERT_EQ(0.0f, stream_a[stride_a * 1]);
+    ASSERT_EQ(1.5f, stream_a[stride_a * 2]);
+    ASSERT_EQ(2.5f, stream_a[stride_a * 3]);
+    ASSERT_EQ(3.5f, stream_a[stride_a * 4]);
+    ASSERT_EQ(0.0f, stream_a[stride_a * 5]);
+    ASSERT_EQ(1.0f, stream_a[stride_a * 10]);
+    ASSERT_EQ(2.0f, stream_a[stride_a * 11]);
+    ASSERT_EQ(3.0f, stream_a[stride_a * 12]);
+
+    uint32_t new_version = 0;
+    dmBuffer::GetContentVersion(m_Buffer, &new_version);
+    ASSERT_NE(version, new_version);
+
+    // Transform points and directions
+    ASSERT_TRUE(RunString(L, "local buf = buffer.create(4, { {name=hash(\"position\"), type=buffer.VALUE_TYPE_FLOAT32, count=3 } }) \
+                              local positions = buffer.get_stream(buf, hash(\"position\")) \
+                              buffer.fill_stream(positions, vmath.vector3(1, 0, 0)) \
+                              local m = vmath.matrix4_translation(vmath.vector3(0, 0, 5)) * vmath.matrix4_rotation_z(math.pi / 2) \
+                              buffer.transform_stream(positions, m, true, 1, 2) \
+                              buffer.transform_stream(positions, m, false, 3) \
+                              local function near(i, x, y, z) \
+                                  return math.abs(positions[i*3+1] - x) < 0.0001 and math.abs(positions[i*3+2] - y) < 0.0001 and math.abs(positions[i*3+3] - z) < 0.0001 \
+                              end \
+                              assert(near(0, 1, 0, 0)) \
+                              assert(near(1, 0, 1, 5)) \
+                              assert(near(2, 0, 1, 5)) \
+                              assert(near(3, 0, 1, 0)) \
+                             "));
+
+    dmLogWarning("Expected error outputs ->");
+
+    ASSERT_FALSE(RunString(L, "local stream = buffer.get_stream(test_buffer, hash(\"rgb\")) \
+                               buffer.fill_stream(stream, 1, 0, #stream + 1) \
+                              "));
+    lua_pop(L, 1);
+
+    ASSERT_FALSE(RunString(L, "local stream = buffer.get_stream(test_buffer, hash(\"rgb\")) \
+                               buffer.set_stream(stream, #stream - 1, {1, 2}) \
+                              "));
+    lua_pop(L, 1);
+
+    ASSERT_FALSE(RunString(L, "local stream = buffer.get_stream(test_buffer, hash(\"rgb\")) \
+                               buffer.transform_stream(stream, vmath.matrix4()) \
+                              "));
+    lua_pop(L, 1);
+
+    // The value types must match
+    ASSERT_FALSE(RunString(L, "local a = buffer.get_stream(test_buffer, hash(\"a\")) \
+                               local tmp = buffer.create(3, { {name=hash(\"temp\"), type=buffer.VALUE_TYPE_UINT8, count=1 } }) \
+                               buffer.copy_stream(a, 0, buffer.get_stream(tmp, hash(\"temp\")), 0, 3) \
+                              "));
+    lua_pop(L, 1);
+
+    dmLogWarning("<- Expected error outputs end.");
+
+    ASSERT_EQ(top, lua_gettop(L));
+}
 
 TEST_P(ScriptBufferCopyTest, CopyBuffer)
 {
@@ -18,6 +18,7 @@
 #include <resource/resource.h>
 
 #include <dlib/buffer.h>
+#include <dlib/memory.h>
 #include <dlib/testutil.h>
 #include <hid/hid.h>
 
@@ -71,6 +72,9 @@ struct ProjectOptions {
   bool m_3D;
   float m_Scale;
   float m_VelocityThreshold;
+  bool m_UseFixedTimestep;
+  bool m_Interpolate;
+  bool m_AllowDynamicTransforms;
 };
 
 template<typename T>
@@ -102,6 +106,9 @@ public:
         this->m_projectOptions.m_3D = false;
         this->m_projectOptions.m_Scale = 1.0f;
         this->m_projectOptions.m_VelocityThreshold = 1.0f;
+        this->m_projectOptions.m_UseFixedTimestep = false;
+        this->m_projectOptions.m_Interpolate = false;
+        this->m_projectOptions.m_AllowDynamicTransforms = false;
     }
 protected:
     virtual void SetUp();
@@ -208,6 +215,16 @@ public:
 	}
 };
 
+class CollisionObjectInterpolation2DTest : public CollisionObject2DTest
+{
+public:
+    CollisionObjectInterpolation2DTest() {
+        m_projectOptions.m_UseFixedTimestep = true;
+        m_projectOptions.m_Interpolate = true;
+        m_projectOptions.m_AllowDynamicTransforms = true;
+    }
+};
+
 class ResourceTest : public GamesysTest<const char*>
 {
 public:
@@ -544,12 +561,15 @@ void GamesysTest<T>::SetUp()
     m_PhysicsContext.m_MaxContactPointCount = this->m_projectOptions.m_MaxContactPointCount;
     m_PhysicsContext.m_MaxCollisionObjectCount = this->m_projectOptions.m_MaxCollisionObjectCount;
     m_PhysicsContext.m_3D = this->m_projectOptions.m_3D;
+    m_PhysicsContext.m_UseFixedTimestep = this->m_projectOptions.m_UseFixedTimestep;
+    m_PhysicsContext.m_Interpolate = this->m_projectOptions.m_Interpolate;
     if (m_PhysicsContext.m_3D) {
         m_PhysicsContext.m_Context3D = dmPhysics::NewContext3D(dmPhysics::NewContextParams());
     } else {
         dmPhysics::NewContextParams context2DParams = dmPhysics::NewContextParams();
         context2DParams.m_Scale = this->m_projectOptions.m_Scale;
         context2DParams.m_VelocityThreshold = this->m_projectOptions.m_VelocityThreshold;
+        context2DParams.m_AllowDynamicTransforms = this->m_projectOptions.m_AllowDynamicTransforms;
         m_PhysicsContext.m_Context2D = dmPhysics::NewContext2D(context2DParams);
     }
 
@@ -649,6 +669,8 @@ void GamesysTest<T>::TearDown()
     }
     dmBuffer::DeleteContext();
     dmConfigFile::Delete(m_Config);
+    // The sprite and model components render with frame memory
+    dmMemory::DeleteFrameAllocator();
 }
 
 template<typename T>
@@ -672,6 +694,7 @@ void GamesysTest<T>::WaitForTestsDone(int update_count, bool render, bool* resul
 
             dmRender::RenderListEnd(m_RenderContext);
             dmRender::DrawRenderList(m_RenderContext, 0x0, 0x0, 0x0);
+            dmMemory::EndFrame();
         }
 
         // check if tests are done
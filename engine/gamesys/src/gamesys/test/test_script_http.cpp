@@ -318,6 +318,107 @@ TEST_F(ScriptHttpTest, TestTimeout)
     ASSERT_EQ(top, lua_gettop(L));
 }
 
+TEST_F(ScriptHttpTest, TestConcurrent)
+{
+    int top = lua_gettop(L);
+
+    ASSERT_TRUE(dmScriptTest::RunFile(L, "test_http_concurrent.lua.rawc", "build/src/gamesys/test/http"));
+    SetHttpAddress(L);
+
+    lua_getglobal(L, "functions");
+    ASSERT_EQ(LUA_TTABLE, lua_type(L, -1));
+    lua_getfield(L, -1, "test_http_concurrent");
+    ASSERT_EQ(LUA_TFUNCTION, lua_type(L, -1));
+    int result = dmScript::PCall(L, 0, LUA_MULTRET);
+    ASSERT_EQ(0, result);
+    lua_pop(L, 1);
+
+    uint64_t start = dmTime::GetTime();
+    while (1) {
+        dmSys::PumpMessageQueue();
+        dmMessage::Dispatch(m_DefaultURL.m_Socket, DispatchCallbackDDF, this);
+
+        lua_getglobal(L, "requests_left");
+        int requests_left = lua_tointeger(L, -1);
+        lua_pop(L, 1);
+
+        if (requests_left == 0) {
+            break;
+        }
+
+        if( m_NumberOfFails )
+        {
+            break;
+        }
+
+        dmTime::Sleep(10 * 1000);
+
+        uint64_t now = dmTime::GetTime();
+        uint64_t elapsed = now - start;
+        if (elapsed / 1000000 > 8) {
+            dmLogError("The test timed out\n");
+            ASSERT_TRUE(0);
+        }
+    }
+
+    ASSERT_EQ(0, m_NumberOfFails);
+    ASSERT_EQ(80, m_HttpResponseCount);
+    ASSERT_EQ(top, lua_gettop(L));
+}
+
+TEST_F(ScriptHttpTest, TestStalled)
+{
+    int top = lua_gettop(L);
+
+    ASSERT_TRUE(dmScriptTest::RunFile(L, "test_http_stalled.lua.rawc", "build/src/gamesys/test/http"));
+    SetHttpAddress(L);
+
+    lua_getglobal(L, "functions");
+    ASSERT_EQ(LUA_TTABLE, lua_type(L, -1));
+    lua_getfield(L, -1, "test_http_stalled");
+    ASSERT_EQ(LUA_TFUNCTION, lua_type(L, -1));
+    int result = dmScript::PCall(L, 0, LUA_MULTRET);
+    ASSERT_EQ(0, result);
+    lua_pop(L, 1);
+
+    uint64_t start = dmTime::GetTime();
+    while (1) {
+        dmSys::PumpMessageQueue();
+        dmMessage::Dispatch(m_DefaultURL.m_Socket, DispatchCallbackDDF, this);
+
+        lua_getglobal(L, "requests_left");
+        int requests_left = lua_tointeger(L, -1);
+        lua_pop(L, 1);
+
+        if (requests_left == 0) {
+            break;
+        }
+
+        if( m_NumberOfFails )
+        {
+            break;
+        }
+
+        dmTime::Sleep(10 * 1000);
+
+        uint64_t now = dmTime::GetTime();
+        uint64_t elapsed = now - start;
+        if (elapsed / 1000000 > 10) {
+            dmLogError("The test timed out\n");
+            ASSERT_TRUE(0);
+        }
+    }
+
+    ASSERT_EQ(0, m_NumberOfFails);
+    ASSERT_EQ(17, m_HttpResponseCount);
+
+    // All the other requests finished while the slow one was still in flight
+    lua_getglobal(L, "fast_done_before_stalled");
+    ASSERT_EQ(16, lua_tointeger(L, -1));
+    lua_pop(L, 1);
+    ASSERT_EQ(top, lua_gettop(L));
+}
+
 TEST_F(ScriptHttpTest, TestDeletedSocket)
 {
     SHttpRequestTimeoutGuard timeoutguard(300 * 1000);
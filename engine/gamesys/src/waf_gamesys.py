@@ -166,8 +166,10 @@ def compile_model(task):
 
         msg_out = rig.rig_ddf_pb2.RigScene()
         msg_out.mesh_set = "/" + _replace_model_ext(msg.mesh, ".meshsetc")
-        msg_out.skeleton = "/" + _replace_model_ext(msg.mesh, ".skeletonc")
-        msg_out.animation_set = "/" + _replace_model_ext(msg.animations, ".animationsetc")
+        # Models without animations are static, and may use local vertex space materials
+        if msg.animations:
+            msg_out.skeleton = "/" + _replace_model_ext(msg.mesh, ".skeletonc")
+            msg_out.animation_set = "/" + _replace_model_ext(msg.animations, ".animationsetc")
         with open(task.outputs[1].abspath(), 'wb') as out_f:
             out_f.write(msg_out.SerializeToString())
 
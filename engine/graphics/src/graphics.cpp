@@ -602,6 +602,11 @@ namespace dmGraphics
         return vertex_declaration->m_Stride;
     }
 
+    void SetVertexDeclarationStepFunction(HVertexDeclaration vertex_declaration, VertexStepFunction step_function)
+    {
+        vertex_declaration->m_StepFunction = step_function;
+    }
+
     #define DM_TEXTURE_FORMAT_TO_STR_CASE(x) case TEXTURE_FORMAT_##x: return #x;
     const char* TextureFormatToString(TextureFormat format)
     {
@@ -1327,6 +1332,14 @@ namespace dmGraphics
     {
         g_functions.m_Draw(context, prim_type, first, count);
     }
+    void DrawElementsInstanced(HContext context, PrimitiveType prim_type, uint32_t first, uint32_t count, uint32_t instance_count, Type type, HIndexBuffer index_buffer)
+    {
+        g_functions.m_DrawElementsInstanced(context, prim_type, first, count, instance_count, type, index_buffer);
+    }
+    void DrawInstanced(HContext context, PrimitiveType prim_type, uint32_t first, uint32_t count, uint32_t instance_count)
+    {
+        g_functions.m_DrawInstanced(context, prim_type, first, count, instance_count);
+    }
     void DispatchCompute(HContext context, uint32_t group_count_x, uint32_t group_count_y, uint32_t group_count_z)
     {
         g_functions.m_DispatchCompute(context, group_count_x, group_count_y, group_count_z);
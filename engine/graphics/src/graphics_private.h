@@ -242,6 +242,17 @@ namespace dmGraphics
         return (T*) container.Get(opaque_handle);
     }
 
+    // Matrix streams (e.g a per instance world matrix) are bound as one attribute per column
+    static inline uint32_t GetVertexStreamColumnCount(uint32_t stream_size)
+    {
+        switch(stream_size)
+        {
+            case 9:  return 3; // mat3
+            case 16: return 4; // mat4
+        }
+        return 1;
+    }
+
     // Test only functions:
     void     ResetDrawCount();
     uint64_t GetDrawCount();
@@ -188,6 +188,7 @@ namespace dmGraphics
         context->m_ContextFeatures |= 1 << CONTEXT_FEATURE_MULTI_TARGET_RENDERING;
         context->m_ContextFeatures |= 1 << CONTEXT_FEATURE_TEXTURE_ARRAY;
         context->m_ContextFeatures |= 1 << CONTEXT_FEATURE_COMPUTE_SHADER;
+        context->m_ContextFeatures |= 1 << CONTEXT_FEATURE_INSTANCING;
 
         if (context->m_AsyncProcessingSupport)
         {
@@ -430,11 +431,16 @@ namespace dmGraphics
         vb->m_Size = size;
         if (data != 0x0)
             memcpy(vb->m_Buffer, data, size);
+
+        g_NullContext->m_CallCounters.m_SetVertexBufferData++;
+        g_NullContext->m_CallCounters.m_VertexBufferUploadSize += size;
     }
 
     static void NullSetVertexBufferSubData(HVertexBuffer buffer, uint32_t offset, uint32_t size, const void* data)
     {
         VertexBuffer* vb = (VertexBuffer*)buffer;
+        g_NullContext->m_CallCounters.m_SetVertexBufferSubData++;
+        g_NullContext->m_CallCounters.m_VertexBufferUploadSize += size;
         if (offset + size <= vb->m_Size && data != 0x0)
             memcpy(&(vb->m_Buffer)[offset], data, size);
     }
@@ -549,12 +555,21 @@ namespace dmGraphics
     {
         NullContext* context = (NullContext*) _context;
         context->m_VertexBuffer = vertex_buffer;
+        if (binding_index < MAX_VERTEX_BUFFER_BINDING_COUNT)
+            context->m_VertexBufferBindings[binding_index] = vertex_buffer;
+        context->m_CallCounters.m_EnableVertexBuffer++;
     }
 
     static void NullDisableVertexBuffer(HContext _context, HVertexBuffer vertex_buffer)
     {
         NullContext* context = (NullContext*) _context;
         context->m_VertexBuffer = 0;
+        for (uint32_t i = 0; i < MAX_VERTEX_BUFFER_BINDING_COUNT; ++i)
+        {
+            if (context->m_VertexBufferBindings[i] == vertex_buffer)
+                context->m_VertexBufferBindings[i] = 0;
+        }
+        context->m_CallCounters.m_DisableVertexBuffer++;
     }
 
     void EnableVertexDeclaration(HContext _context, HVertexDeclaration vertex_declaration, uint32_t binding_index)
@@ -574,14 +589,26 @@ namespace dmGraphics
             stride += vertex_declaration->m_Streams[i].m_Size * TYPE_SIZE[vertex_declaration->m_Streams[i].m_Type - dmGraphics::TYPE_BYTE];
         }
 
+        if (binding_index < MAX_VERTEX_BUFFER_BINDING_COUNT)
+            context->m_VertexDeclarationBindings[binding_index] = vertex_declaration;
+
+        // The draw calls only emulate the per vertex fetch, so the per instance streams are left out
+        if (vertex_declaration->m_StepFunction == VERTEX_STEP_FUNCTION_INSTANCE)
+            return;
+
+        // Streams from several bindings are enabled at the same time, so each stream takes the first free slot
         uint32_t offset = 0;
+        uint16_t location = 0;
         for (uint16_t i = 0; i < vertex_declaration->m_StreamCount; ++i)
         {
             VertexDeclaration::Stream& stream = vertex_declaration->m_Streams[i];
             if (stream.m_Size > 0)
             {
-                stream.m_Location = i;
-                EnableVertexStream(context, i, stream.m_Size, stream.m_Type, stride, &vb->m_Buffer[offset]);
+                while (location < MAX_VERTEX_STREAM_COUNT && context->m_VertexStreams[location].m_Source != 0x0)
+                    ++location;
+                assert(location < MAX_VERTEX_STREAM_COUNT);
+                stream.m_Location = location;
+                EnableVertexStream(context, location, stream.m_Size, stream.m_Type, stride, &vb->m_Buffer[offset]);
                 offset += stream.m_Size * TYPE_SIZE[stream.m_Type - dmGraphics::TYPE_BYTE];
             }
         }
@@ -590,15 +617,32 @@ namespace dmGraphics
     static void NullEnableVertexDeclaration(HContext context, HVertexDeclaration vertex_declaration, uint32_t binding_index, HProgram program)
     {
         EnableVertexDeclaration(context, vertex_declaration, binding_index);
+        ((NullContext*) context)->m_CallCounters.m_EnableVertexDeclaration++;
     }
 
     static void NullDisableVertexDeclaration(HContext context, HVertexDeclaration vertex_declaration)
     {
         assert(context);
         assert(vertex_declaration);
-        for (uint32_t i = 0; i < vertex_declaration->m_StreamCount; ++i)
-            if (vertex_declaration->m_Streams[i].m_Size > 0)
-                DisableVertexStream(context, i);
+        NullContext* null_context = (NullContext*) context;
+        for (uint32_t i = 0; i < MAX_VERTEX_BUFFER_BINDING_COUNT; ++i)
+        {
+            if (null_context->m_VertexDeclarationBindings[i] == vertex_declaration)
+                null_context->m_VertexDeclarationBindings[i] = 0;
+        }
+        if (vertex_declaration->m_StepFunction != VERTEX_STEP_FUNCTION_INSTANCE)
+        {
+            for (uint32_t i = 0; i < vertex_declaration->m_StreamCount; ++i)
+                if (vertex_declaration->m_Streams[i].m_Size > 0)
+                    DisableVertexStream(context, vertex_declaration->m_Streams[i].m_Location);
+        }
+        null_context->m_CallCounters.m_DisableVertexDeclaration++;
+    }
+
+    static void SaveDrawBindings(NullContext* context)
+    {
+        memcpy(context->m_DrawVertexBuffers, context->m_VertexBufferBindings, sizeof(context->m_DrawVertexBuffers));
+        memcpy(context->m_DrawVertexDeclarations, context->m_VertexDeclarationBindings, sizeof(context->m_DrawVertexDeclarations));
     }
 
     static uint32_t GetIndex(Type type, HIndexBuffer ib, uint32_t index)
@@ -642,6 +686,9 @@ namespace dmGraphics
             }
         }
 
+        context->m_CallCounters.m_Draw++;
+        SaveDrawBindings(context);
+
         if (g_Flipped)
         {
             g_Flipped = 0;
@@ -653,6 +700,8 @@ namespace dmGraphics
     static void NullDraw(HContext context, PrimitiveType prim_type, uint32_t first, uint32_t count)
     {
         assert(context);
+        ((NullContext*) context)->m_CallCounters.m_Draw++;
+        SaveDrawBindings((NullContext*) context);
 
         if (g_Flipped)
         {
@@ -662,6 +711,20 @@ namespace dmGraphics
         g_DrawCount++;
     }
 
+    static void NullDrawElementsInstanced(HContext context, PrimitiveType prim_type, uint32_t first, uint32_t count, uint32_t instance_count, Type type, HIndexBuffer index_buffer)
+    {
+        NullDrawElements(context, prim_type, first, count, type, index_buffer);
+        ((NullContext*) context)->m_CallCounters.m_DrawInstanced++;
+        ((NullContext*) context)->m_CallCounters.m_DrawInstances += instance_count;
+    }
+
+    static void NullDrawInstanced(HContext context, PrimitiveType prim_type, uint32_t first, uint32_t count, uint32_t instance_count)
+    {
+        NullDraw(context, prim_type, first, count);
+        ((NullContext*) context)->m_CallCounters.m_DrawInstanced++;
+        ((NullContext*) context)->m_CallCounters.m_DrawInstances += instance_count;
+    }
+
     static void NullDispatchCompute(HContext _context, uint32_t group_count_x, uint32_t group_count_y, uint32_t group_count_z)
     {
         // Not supported
@@ -982,6 +1045,7 @@ namespace dmGraphics
     {
         assert(context);
         ((NullContext*) context)->m_Program = (void*)program;
+        ((NullContext*) context)->m_CallCounters.m_EnableProgram++;
     }
 
     static void NullDisableProgram(HContext context)
@@ -1107,6 +1171,7 @@ namespace dmGraphics
         NullContext* context = (NullContext*) _context;
         assert(context->m_Program != 0x0);
         memcpy(&context->m_ProgramRegisters[base_location], data, sizeof(Vector4) * count);
+        context->m_CallCounters.m_SetConstant++;
     }
 
     static void NullSetConstantM4(HContext _context, const Vector4* data, int count, HUniformLocation base_location)
@@ -1115,6 +1180,7 @@ namespace dmGraphics
         NullContext* context = (NullContext*) _context;
         assert(context->m_Program != 0x0);
         memcpy(&context->m_ProgramRegisters[base_location], data, sizeof(Vector4) * 4 * count);
+        context->m_CallCounters.m_SetConstant++;
     }
 
     static void NullSetSampler(HContext context, HUniformLocation location, int32_t unit)
@@ -1639,6 +1705,7 @@ namespace dmGraphics
         NullSetTextureParams(texture, tex->m_Sampler.m_MinFilter, tex->m_Sampler.m_MagFilter, tex->m_Sampler.m_UWrap, tex->m_Sampler.m_VWrap, tex->m_Sampler.m_Anisotropy);
 
         tex->m_LastBoundUnit[id_index] = unit;
+        context->m_CallCounters.m_EnableTexture++;
     }
 
     static void NullDisableTexture(HContext context, uint32_t unit, HTexture texture)
@@ -1646,6 +1713,7 @@ namespace dmGraphics
         assert(context);
         assert(unit < MAX_TEXTURE_COUNT);
         ((NullContext*) context)->m_Textures[unit] = 0;
+        ((NullContext*) context)->m_CallCounters.m_DisableTexture++;
     }
 
     static void NullReadPixels(HContext context, void* buffer, uint32_t buffer_size)
@@ -25,6 +25,7 @@ namespace dmGraphics
 {
     const static uint32_t MAX_REGISTER_COUNT = 16;
     const static uint32_t MAX_TEXTURE_COUNT  = 32;
+    const static uint32_t MAX_VERTEX_BUFFER_BINDING_COUNT = 4;
 
     struct TextureSampler
     {
@@ -101,6 +102,25 @@ namespace dmGraphics
         FrameBuffer     m_FrameBuffer;
     };
 
+    // Number of calls to the state changing functions. Only used for testing
+    struct NullCallCounters
+    {
+        uint32_t m_EnableProgram;
+        uint32_t m_SetConstant;
+        uint32_t m_EnableTexture;
+        uint32_t m_DisableTexture;
+        uint32_t m_EnableVertexBuffer;
+        uint32_t m_DisableVertexBuffer;
+        uint32_t m_EnableVertexDeclaration;
+        uint32_t m_DisableVertexDeclaration;
+        uint32_t m_Draw;
+        uint32_t m_DrawInstanced;   // Instanced draw calls, also counted in m_Draw
+        uint32_t m_DrawInstances;   // Instances drawn by the instanced draw calls
+        uint32_t m_SetVertexBufferData;
+        uint32_t m_SetVertexBufferSubData;
+        uint32_t m_VertexBufferUploadSize; // Bytes uploaded by the two calls above
+    };
+
     struct NullContext
     {
         NullContext(const ContextParams& params);
@@ -116,10 +136,16 @@ namespace dmGraphics
         TextureSampler                     m_Samplers[MAX_TEXTURE_COUNT];
         HTexture                           m_Textures[MAX_TEXTURE_COUNT];
         HVertexBuffer                      m_VertexBuffer;
+        // The vertex buffers and declarations per binding index, as bound now, and at the last draw call. Only used for testing
+        HVertexBuffer                      m_VertexBufferBindings[MAX_VERTEX_BUFFER_BINDING_COUNT];
+        HVertexDeclaration                 m_VertexDeclarationBindings[MAX_VERTEX_BUFFER_BINDING_COUNT];
+        HVertexBuffer                      m_DrawVertexBuffers[MAX_VERTEX_BUFFER_BINDING_COUNT];
+        HVertexDeclaration                 m_DrawVertexDeclarations[MAX_VERTEX_BUFFER_BINDING_COUNT];
         FrameBuffer                        m_MainFrameBuffer;
         FrameBuffer*                       m_CurrentFrameBuffer;
         void*                              m_Program;
         PipelineState                      m_PipelineState;
+        NullCallCounters                   m_CallCounters;
         TextureFilter                      m_DefaultTextureMinFilter;
         TextureFilter                      m_DefaultTextureMagFilter;
 
@@ -133,7 +159,7 @@ namespace dmGraphics
         uint32_t                           m_UseAsyncTextureLoad    : 1;
         uint32_t                           m_RequestWindowClose     : 1;
         uint32_t                           m_PrintDeviceInfo        : 1;
-        uint32_t                           m_ContextFeatures        : 3;
+        uint32_t                           m_ContextFeatures        : 8;
     };
 }
 
@@ -415,6 +415,15 @@ static void LogFrameBufferError(GLenum status)
     typedef void (* DM_PFNGLDRAWBUFFERSPROC) (GLsizei n, const GLenum *bufs);
     DM_PFNGLDRAWBUFFERSPROC PFN_glDrawBuffers = NULL;
 
+    typedef void (* DM_PFNGLVERTEXATTRIBDIVISORPROC) (GLuint index, GLuint divisor);
+    DM_PFNGLVERTEXATTRIBDIVISORPROC PFN_glVertexAttribDivisor = NULL;
+
+    typedef void (* DM_PFNGLDRAWARRAYSINSTANCEDPROC) (GLenum mode, GLint first, GLsizei count, GLsizei instancecount);
+    DM_PFNGLDRAWARRAYSINSTANCEDPROC PFN_glDrawArraysInstanced = NULL;
+
+    typedef void (* DM_PFNGLDRAWELEMENTSINSTANCEDPROC) (GLenum mode, GLsizei count, GLenum type, const void *indices, GLsizei instancecount);
+    DM_PFNGLDRAWELEMENTSINSTANCEDPROC PFN_glDrawElementsInstanced = NULL;
+
     // Note: This is necessary for webgl and android to work since we don't load core functions with emsc,
     //       however we might want to do this the other way around perhaps? i.e special case for webgl
     //       and load functions like this for all other platforms.
@@ -725,6 +734,7 @@ static void LogFrameBufferError(GLenum status)
             case CONTEXT_FEATURE_TEXTURE_ARRAY:          return context->m_TextureArraySupport;
             case CONTEXT_FEATURE_COMPUTE_SHADER:         return context->m_ComputeSupport;
             case CONTEXT_FEATURE_STORAGE_BUFFER:         return context->m_StorageBufferSupport;
+            case CONTEXT_FEATURE_INSTANCING:             return context->m_InstancingSupport;
         }
         return false;
     }
@@ -863,6 +873,7 @@ static void LogFrameBufferError(GLenum status)
         PRINT_FEATURE_IF_SUPPORTED(CONTEXT_FEATURE_MULTI_TARGET_RENDERING);
         PRINT_FEATURE_IF_SUPPORTED(CONTEXT_FEATURE_TEXTURE_ARRAY);
         PRINT_FEATURE_IF_SUPPORTED(CONTEXT_FEATURE_COMPUTE_SHADER);
+        PRINT_FEATURE_IF_SUPPORTED(CONTEXT_FEATURE_INSTANCING);
     #undef PRINT_FEATURE_IF_SUPPORTED
     }
 
@@ -1098,6 +1109,9 @@ static void LogFrameBufferError(GLenum status)
 
         DMGRAPHICS_GET_PROC_ADDRESS_EXT(PFN_glInvalidateFramebuffer,   "glDiscardFramebuffer", "discard_framebuffer", "glInvalidateFramebuffer", DM_PFNGLINVALIDATEFRAMEBUFFERPROC, context);
         DMGRAPHICS_GET_PROC_ADDRESS_EXT(PFN_glDrawBuffers,             "glDrawBuffers",        "draw_buffers",        "glDrawBuffers",           DM_PFNGLDRAWBUFFERSPROC, context);
+        DMGRAPHICS_GET_PROC_ADDRESS_EXT(PFN_glVertexAttribDivisor,     "glVertexAttribDivisor",   "instanced_arrays", "glVertexAttribDivisor",   DM_PFNGLVERTEXATTRIBDIVISORPROC, context);
+        DMGRAPHICS_GET_PROC_ADDRESS_EXT(PFN_glDrawArraysInstanced,     "glDrawArraysInstanced",   "draw_instanced",   "glDrawArraysInstanced",   DM_PFNGLDRAWARRAYSINSTANCEDPROC, context);
+        DMGRAPHICS_GET_PROC_ADDRESS_EXT(PFN_glDrawElementsInstanced,   "glDrawElementsInstanced", "draw_instanced",   "glDrawElementsInstanced", DM_PFNGLDRAWELEMENTSINSTANCEDPROC, context);
     #ifdef ANDROID
         DMGRAPHICS_GET_PROC_ADDRESS_EXT(PFN_glTexSubImage3D,           "glTexSubImage3D",           "texture_array", "glTexSubImage3D",           DM_PFNGLTEXSUBIMAGE3DPROC, context);
         DMGRAPHICS_GET_PROC_ADDRESS_EXT(PFN_glTexImage3D,              "glTexImage3D",              "texture_array", "glTexImage3D",              DM_PFNGLTEXIMAGE3DPROC, context);
@@ -1365,6 +1379,8 @@ static void LogFrameBufferError(GLenum status)
         #undef COMPUTE_VERSION_NEEDED
     #endif
 
+        context->m_InstancingSupport = PFN_glVertexAttribDivisor != 0 && PFN_glDrawArraysInstanced != 0 && PFN_glDrawElementsInstanced != 0;
+
         if (context->m_PrintDeviceInfo)
         {
             OpenGLPrintDeviceInfo(context);
@@ -1744,21 +1760,35 @@ static void LogFrameBufferError(GLenum status)
 
         #define BUFFER_OFFSET(i) ((char*)0x0 + (i))
 
+        const GLuint divisor = vertex_declaration->m_StepFunction == VERTEX_STEP_FUNCTION_INSTANCE ? 1 : 0;
+
         for (uint32_t i=0; i<vertex_declaration->m_StreamCount; i++)
         {
-            if (vertex_declaration->m_Streams[i].m_Location != -1)
+            const VertexDeclaration::Stream& stream = vertex_declaration->m_Streams[i];
+            if (stream.m_Location != -1)
             {
-                glEnableVertexAttribArray(vertex_declaration->m_Streams[i].m_Location);
-                CHECK_GL_ERROR;
-                glVertexAttribPointer(
-                        vertex_declaration->m_Streams[i].m_Location,
-                        vertex_declaration->m_Streams[i].m_Size,
-                        GetOpenGLType(vertex_declaration->m_Streams[i].m_Type),
-                        vertex_declaration->m_Streams[i].m_Normalize,
-                        vertex_declaration->m_Stride,
-                BUFFER_OFFSET(vertex_declaration->m_Streams[i].m_Offset) );   //The starting point of the VBO, for the vertices
+                const uint32_t column_count = GetVertexStreamColumnCount(stream.m_Size);
+                const uint32_t column_size  = stream.m_Size / column_count;
 
-                CHECK_GL_ERROR;
+                for (uint32_t c = 0; c < column_count; ++c)
+                {
+                    glEnableVertexAttribArray(stream.m_Location + c);
+                    CHECK_GL_ERROR;
+                    glVertexAttribPointer(
+                            stream.m_Location + c,
+                            column_size,
+                            GetOpenGLType(stream.m_Type),
+                            stream.m_Normalize,
+                            vertex_declaration->m_Stride,
+                    BUFFER_OFFSET(stream.m_Offset + c * column_size * GetTypeSize(stream.m_Type)) );   //The starting point of the VBO, for the vertices
+                    CHECK_GL_ERROR;
+
+                    if (divisor)
+                    {
+                        PFN_glVertexAttribDivisor(stream.m_Location + c, divisor);
+                        CHECK_GL_ERROR;
+                    }
+                }
             }
         }
 
@@ -1770,12 +1800,25 @@ static void LogFrameBufferError(GLenum status)
         assert(context);
         assert(vertex_declaration);
 
+        const bool reset_divisor = vertex_declaration->m_StepFunction == VERTEX_STEP_FUNCTION_INSTANCE;
+
         for (uint32_t i=0; i<vertex_declaration->m_StreamCount; i++)
         {
-            if (vertex_declaration->m_Streams[i].m_Location != -1)
+            const VertexDeclaration::Stream& stream = vertex_declaration->m_Streams[i];
+            if (stream.m_Location != -1)
             {
-                glDisableVertexAttribArray(vertex_declaration->m_Streams[i].m_Location);
-                CHECK_GL_ERROR;
+                const uint32_t column_count = GetVertexStreamColumnCount(stream.m_Size);
+                for (uint32_t c = 0; c < column_count; ++c)
+                {
+                    // The divisor is part of the attribute state, so it would otherwise leak into the next draw using this location
+                    if (reset_divisor)
+                    {
+                        PFN_glVertexAttribDivisor(stream.m_Location + c, 0);
+                        CHECK_GL_ERROR;
+                    }
+                    glDisableVertexAttribArray(stream.m_Location + c);
+                    CHECK_GL_ERROR;
+                }
             }
         }
 
@@ -1841,6 +1884,35 @@ static void LogFrameBufferError(GLenum status)
         CHECK_GL_ERROR
     }
 
+    static void OpenGLDrawElementsInstanced(HContext context, PrimitiveType prim_type, uint32_t first, uint32_t count, uint32_t instance_count, Type type, HIndexBuffer index_buffer)
+    {
+        DM_PROFILE(__FUNCTION__);
+        DM_PROPERTY_ADD_U32(rmtp_DrawCalls, 1);
+        assert(context);
+        assert(index_buffer);
+        assert(((OpenGLContext*) context)->m_InstancingSupport);
+
+        DrawSetup((OpenGLContext*) context);
+
+        glBindBufferARB(GL_ELEMENT_ARRAY_BUFFER, index_buffer);
+        CHECK_GL_ERROR;
+
+        PFN_glDrawElementsInstanced(GetOpenGLPrimitiveType(prim_type), count, GetOpenGLType(type), (GLvoid*)(uintptr_t) first, instance_count);
+        CHECK_GL_ERROR
+    }
+
+    static void OpenGLDrawInstanced(HContext context, PrimitiveType prim_type, uint32_t first, uint32_t count, uint32_t instance_count)
+    {
+        DM_PROFILE(__FUNCTION__);
+        DM_PROPERTY_ADD_U32(rmtp_DrawCalls, 1);
+        assert(context);
+        assert(((OpenGLContext*) context)->m_InstancingSupport);
+
+        DrawSetup((OpenGLContext*) context);
+        PFN_glDrawArraysInstanced(GetOpenGLPrimitiveType(prim_type), first, count, instance_count);
+        CHECK_GL_ERROR
+    }
+
     static void OpenGLDispatchCompute(HContext _context, uint32_t group_count_x, uint32_t group_count_y, uint32_t group_count_z)
     {
     #ifdef DM_HAVE_PLATFORM_COMPUTE_SUPPORT
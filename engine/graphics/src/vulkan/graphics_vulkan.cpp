@@ -2330,6 +2330,16 @@ bail:
         vkCmdDraw(vk_command_buffer, count, 1, first, 0);
     }
 
+    static void VulkanDrawElementsInstanced(HContext context, PrimitiveType prim_type, uint32_t first, uint32_t count, uint32_t instance_count, Type type, HIndexBuffer index_buffer)
+    {
+        VulkanDrawElementsInstanced(context, prim_type, first, count, instance_count, 0, type, index_buffer);
+    }
+
+    static void VulkanDrawInstanced(HContext context, PrimitiveType prim_type, uint32_t first, uint32_t count, uint32_t instance_count)
+    {
+        VulkanDrawBaseInstance(context, prim_type, first, count, instance_count, 0);
+    }
+
     static void VulkanDispatchCompute(HContext _context, uint32_t group_count_x, uint32_t group_count_y, uint32_t group_count_z)
     {
         DM_PROFILE(__FUNCTION__);
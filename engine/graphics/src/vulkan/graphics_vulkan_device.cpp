@@ -157,13 +157,19 @@ namespace dmGraphics
                 continue;
             }
 
-            VertexDeclaration::Stream& stream              = vertexDeclaration->m_Streams[i];
-            vk_vertex_input_descs[num_attributes].binding  = binding;
-            vk_vertex_input_descs[num_attributes].location = stream.m_Location;
-            vk_vertex_input_descs[num_attributes].format   = GetVertexAttributeFormat(stream.m_Type, stream.m_Size, stream.m_Normalize);
-            vk_vertex_input_descs[num_attributes].offset   = stream.m_Offset;
+            VertexDeclaration::Stream& stream = vertexDeclaration->m_Streams[i];
+            const uint32_t column_count       = GetVertexStreamColumnCount(stream.m_Size);
+            const uint32_t column_size        = stream.m_Size / column_count;
 
-            num_attributes++;
+            for (uint32_t c = 0; c < column_count; ++c)
+            {
+                vk_vertex_input_descs[num_attributes].binding  = binding;
+                vk_vertex_input_descs[num_attributes].location = stream.m_Location + c;
+                vk_vertex_input_descs[num_attributes].format   = GetVertexAttributeFormat(stream.m_Type, column_size, stream.m_Normalize);
+                vk_vertex_input_descs[num_attributes].offset   = stream.m_Offset + c * column_size * GetTypeSize(stream.m_Type);
+
+                num_attributes++;
+            }
         }
 
         return num_attributes;
@@ -1173,7 +1179,7 @@ bail:
         assert(pipelineOut && *pipelineOut == VK_NULL_HANDLE);
 
         uint16_t active_attributes = 0;
-        VkVertexInputAttributeDescription vk_vertex_input_descs[MAX_VERTEX_STREAM_COUNT] = {};
+        VkVertexInputAttributeDescription vk_vertex_input_descs[MAX_VERTEX_STREAM_COUNT * MAX_VERTEX_BUFFERS] = {};
         VkVertexInputBindingDescription vk_vx_input_descriptions[MAX_VERTEX_BUFFERS] = {};
 
         for (int i = 0; i < vertexDeclarationCount; ++i)
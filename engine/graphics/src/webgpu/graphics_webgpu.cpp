@@ -507,7 +507,7 @@ static WGPURenderPipeline WebGPUGetOrCreateRenderPipeline(WebGPUContext* context
     //vertex
     desc.vertex.entryPoint = "main";
     desc.vertex.module = context->m_CurrentProgram->m_VertexModule->m_Module;
-    WGPUVertexAttribute vertexAttributes[MAX_VERTEX_STREAM_COUNT];
+    WGPUVertexAttribute vertexAttributes[MAX_VERTEX_STREAM_COUNT * MAX_VERTEX_BUFFERS];
     WGPUVertexBufferLayout vertexBuffers[MAX_VERTEX_BUFFERS];
     for (int i = 0, attributes = 0; i < MAX_VERTEX_BUFFERS; ++i)
     {
@@ -522,17 +522,21 @@ static WGPURenderPipeline WebGPUGetOrCreateRenderPipeline(WebGPUContext* context
                 vertexBuffers[desc.vertex.bufferCount].stepMode = WGPUVertexStepMode_Instance;
             if (declaration->m_StreamCount)
             {
-                vertexBuffers[desc.vertex.bufferCount].attributeCount = declaration->m_StreamCount;
                 vertexBuffers[desc.vertex.bufferCount].attributes = vertexAttributes + attributes;
                 for (uint16_t s = 0; s < declaration->m_StreamCount; ++s)
                 {
-                    vertexAttributes[attributes] = {};
-                    vertexAttributes[attributes].offset = declaration->m_Streams[s].m_Offset;
-                    vertexAttributes[attributes].shaderLocation = declaration->m_Streams[s].m_Location;
-                    vertexAttributes[attributes].format = WebGPUDeduceVertexAttributeFormat(declaration->m_Streams[s].m_Type,
-                                                                                            declaration->m_Streams[s].m_Size,
-                                                                                            declaration->m_Streams[s].m_Normalize);
-                    ++attributes;
+                    const VertexDeclaration::Stream& stream = declaration->m_Streams[s];
+                    const uint32_t column_count = GetVertexStreamColumnCount(stream.m_Size);
+                    const uint32_t column_size  = stream.m_Size / column_count;
+                    for (uint32_t c = 0; c < column_count; ++c)
+                    {
+                        vertexAttributes[attributes] = {};
+                        vertexAttributes[attributes].offset = stream.m_Offset + c * column_size * GetTypeSize(stream.m_Type);
+                        vertexAttributes[attributes].shaderLocation = stream.m_Location + c;
+                        vertexAttributes[attributes].format = WebGPUDeduceVertexAttributeFormat(stream.m_Type, column_size, stream.m_Normalize);
+                        ++attributes;
+                        ++vertexBuffers[desc.vertex.bufferCount].attributeCount;
+                    }
                 }
                 ++desc.vertex.bufferCount;
             }
@@ -809,6 +813,7 @@ bool WebGPUContext::initialize(const ContextParams& params)
     m_ContextFeatures |= 1 << CONTEXT_FEATURE_MULTI_TARGET_RENDERING;
     m_ContextFeatures |= 1 << CONTEXT_FEATURE_TEXTURE_ARRAY;
     m_ContextFeatures |= 1 << CONTEXT_FEATURE_COMPUTE_SHADER;
+    m_ContextFeatures |= 1 << CONTEXT_FEATURE_INSTANCING;
 
     if (m_PrintDeviceInfo)
     {
@@ -1716,6 +1721,28 @@ static void WebGPUDraw(HContext _context, PrimitiveType prim_type, uint32_t firs
     wgpuRenderPassEncoderDraw(context->m_CurrentRenderPass.m_Encoder, count, 1, first, 0);
 }
 
+static void WebGPUDrawElementsInstanced(HContext _context, PrimitiveType prim_type, uint32_t first, uint32_t count, uint32_t instance_count, Type type, HIndexBuffer index_buffer)
+{
+    TRACE_CALL;
+    assert(_context);
+    assert(index_buffer);
+    WebGPUContext* context = (WebGPUContext*) _context;
+    context->m_CurrentPipelineState.m_PrimtiveType = prim_type;
+    WebGPUSetupRenderPipeline(context, (WebGPUBuffer*)index_buffer, type);
+    wgpuRenderPassEncoderDrawIndexed(context->m_CurrentRenderPass.m_Encoder, count, instance_count,
+                                     first / (type == TYPE_UNSIGNED_SHORT ? 2 : 4), 0, 0);
+}
+
+static void WebGPUDrawInstanced(HContext _context, PrimitiveType prim_type, uint32_t first, uint32_t count, uint32_t instance_count)
+{
+    TRACE_CALL;
+    assert(_context);
+    WebGPUContext* context = (WebGPUContext*) _context;
+    context->m_CurrentPipelineState.m_PrimtiveType = prim_type;
+    WebGPUSetupRenderPipeline(context, NULL, TYPE_BYTE);
+    wgpuRenderPassEncoderDraw(context->m_CurrentRenderPass.m_Encoder, count, instance_count, first, 0);
+}
+
 static void WebGPUDispatchCompute(HContext _context, uint32_t group_count_x, uint32_t group_count_y, uint32_t group_count_z)
 {
     TRACE_CALL;
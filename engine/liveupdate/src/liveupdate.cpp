@@ -59,6 +59,8 @@ namespace dmLiveUpdate
     const char* LIVEUPDATE_ZIP_ARCHIVE_TMP_FILENAME = "liveupdate.ref.tmp";
     const char* LIVEUPDATE_BUNDLE_VER_FILENAME      = "bundle.ver";
 
+    const uint32_t LIVEUPDATE_VERIFY_THREAD_COUNT   = 4;
+
     Result ResourceResultToLiveupdateResult(dmResource::Result r)
     {
         switch (r)
@@ -113,6 +115,7 @@ namespace dmLiveUpdate
         dmResourceProvider::HArchive    m_ResourceBaseArchive;  // The "game.arcd" archive
 
         dmJobThread::HContext           m_JobThread;
+        dmJobThread::HContext           m_VerifyJobThread;      // Verifies the archive entries in parallel, see VerifyZipArchive(). Created on first use
 
         // Legacy functionality
         dmResource::HFactory            m_ResourceFactory;      // Resource system factory
@@ -476,6 +479,10 @@ namespace dmLiveUpdate
         dmResourceProvider::Result result = dmResourceProvider::WriteFile(jobctx->m_LiveupdateArchive, url_hash, job->m_ExpectedResourceDigest,
                                                         (uint8_t*)job->m_Resource, job->m_ResourceLength);
 
+        // The resource may previously have been resolved from a mount with lower priority
+        if (dmResourceProvider::RESULT_OK == result && jobctx->m_ResourceMounts)
+            dmResourceMounts::InvalidateResource(jobctx->m_ResourceMounts, url_hash);
+
         return dmResourceProvider::RESULT_OK == result;
     }
     // Called on the main thread (see dmJobThread::Update below)
@@ -636,13 +643,37 @@ namespace dmLiveUpdate
         uint8_t                         m_Verify:1;
     };
 
+    static void StoreArchiveVerifyProgress(void* ctx, uint32_t num_verified, uint32_t num_entries)
+    {
+        StoreArchiveInfo* job = (StoreArchiveInfo*)ctx;
+        dmLogDebug("Verifying archive '%s': %u / %u entries", job->m_Path, num_verified, num_entries);
+    }
+
+    // Called on the worker thread
+    static dmJobThread::HContext GetVerifyJobThread()
+    {
+        // Most games never verify an archive, so the threads are only started when needed.
+        // Only the single liveupdate worker thread gets here, so no locking is needed
+        if (!g_LiveUpdate.m_VerifyJobThread)
+        {
+            dmJobThread::JobThreadCreationParams job_thread_create_param;
+            job_thread_create_param.m_ThreadCount = LIVEUPDATE_VERIFY_THREAD_COUNT;
+            for (uint32_t i = 0; i < LIVEUPDATE_VERIFY_THREAD_COUNT; ++i)
+            {
+                job_thread_create_param.m_ThreadNames[i] = "liveupdate_verify";
+            }
+            g_LiveUpdate.m_VerifyJobThread = dmJobThread::Create(job_thread_create_param);
+        }
+        return g_LiveUpdate.m_VerifyJobThread;
+    }
+
     // Called on the worker thread
     static int StoreArchiveProcess(LiveUpdateCtx* jobctx, StoreArchiveInfo* job)
     {
         if (job->m_Verify)
         {
             const char* public_key_path = dmResource::GetPublicKeyPath(g_LiveUpdate.m_ResourceFactory);
-            dmResource::Result result = dmLiveUpdate::VerifyZipArchive(job->m_Path, public_key_path);
+            dmResource::Result result = dmLiveUpdate::VerifyZipArchive(job->m_Path, public_key_path, GetVerifyJobThread(), StoreArchiveVerifyProgress, job);
             if (dmResource::RESULT_OK != result)
             {
                 dmLogError("Zip archive verification failed. Archive was not stored. %d %s", result, dmResource::ResultToString(result));
@@ -952,6 +983,7 @@ namespace dmLiveUpdate
         job_thread_create_param.m_ThreadCount    = 1;
 
         g_LiveUpdate.m_JobThread = dmJobThread::Create(job_thread_create_param);
+        g_LiveUpdate.m_VerifyJobThread = 0;
 
         if (g_LiveUpdate.m_JobThread) // Make the liveupdate module `nil` if it isn't available
         {
@@ -973,6 +1005,10 @@ namespace dmLiveUpdate
         if (g_LiveUpdate.m_JobThread)
             dmJobThread::Destroy(g_LiveUpdate.m_JobThread);
         g_LiveUpdate.m_JobThread = 0;
+        // Destroyed after the job thread, which creates it and may be waiting for the verification jobs
+        if (g_LiveUpdate.m_VerifyJobThread)
+            dmJobThread::Destroy(g_LiveUpdate.m_VerifyJobThread);
+        g_LiveUpdate.m_VerifyJobThread = 0;
         g_LiveUpdate.m_ResourceFactory = 0;
         return dmExtension::RESULT_OK;
     }
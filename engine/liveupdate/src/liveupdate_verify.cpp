@@ -17,14 +17,21 @@
 #include <resource/resource_manifest.h>
 #include <resource/resource_verify.h>
 
+#include <dlib/atomic.h>
+#include <dlib/condition_variable.h>
 #include <dlib/log.h>
+#include <dlib/math.h>
 #include <dlib/memory.h>
+#include <dlib/mutex.h>
+#include <dlib/thread.h>
 #include <dlib/zip.h>
 
 namespace dmLiveUpdate
 {
     const char* LIVEUPDATE_ARCHIVE_MANIFEST_FILENAME = "liveupdate.game.dmanifest";
 
+    const uint32_t LIVEUPDATE_VERIFY_MIN_ENTRIES_PER_JOB = 16;
+
     static uint8_t* GetZipResource(dmZip::HZip zip, const char* path, uint32_t* size)
     {
         uint32_t data_len = 0;
@@ -59,62 +66,188 @@ namespace dmLiveUpdate
         return data;
     }
 
-    static dmResource::Result VerifyZipEntries(dmResource::Manifest* manifest, dmZip::HZip zip)
+    struct VerifyContext
     {
+        const char*             m_Path;
+        dmResource::Manifest*   m_Manifest;
+        uint32_t                m_NumEntries;
+        int32_atomic_t          m_NextEntry;    // The next zip entry to verify
+        int32_atomic_t          m_Failed;       // Set when an entry can't be read, making all jobs stop
+
+        // Protected by m_Mutex, and signalled with m_Cond when changed
+        dmMutex::HMutex                         m_Mutex;
+        dmConditionVariable::HConditionVariable m_Cond;
+        uint32_t                                m_NumVerified;  // The number of entries processed
+        uint32_t                                m_NumFinished;  // The number of jobs that are done
+    };
+
+    static dmResource::Result VerifyZipEntry(VerifyContext* ctx, dmZip::HZip zip, uint32_t index, uint8_t** entry_data, uint32_t* entry_data_capacity)
+    {
+        dmZip::Result zr = dmZip::OpenEntry(zip, index);
+        if (dmZip::RESULT_OK != zr)
+        {
+            dmLogError("Could not open entry %u", index);
+            return dmResource::RESULT_INVALID_DATA;
+        }
+
         dmResource::Result result = dmResource::RESULT_OK;
-        uint32_t num_entries = dmZip::GetNumEntries(zip);
-        uint32_t entry_data_capacity = 0;
-        uint8_t* entry_data = 0;
-        for( uint32_t i = 0; i < num_entries && dmResource::RESULT_OK == result; ++i)
+        const char* entry_name = dmZip::GetEntryName(zip);
+        if (!dmZip::IsEntryDir(zip) && !(strcmp(LIVEUPDATE_ARCHIVE_MANIFEST_FILENAME, entry_name) == 0))
         {
-            dmZip::Result zr = dmZip::OpenEntry(zip, i);
+            // verify resource
+            uint32_t entry_size;
+            zr = dmZip::GetEntrySize(zip, &entry_size);
+            if (dmZip::RESULT_OK != zr)
+            {
+                dmLogError("Could not get entry size '%s'", entry_name);
+                dmZip::CloseEntry(zip);
+                return dmResource::RESULT_INVALID_DATA;
+            }
 
-            const char* entry_name = dmZip::GetEntryName(zip);
-            if (!dmZip::IsEntryDir(zip) && !(strcmp(LIVEUPDATE_ARCHIVE_MANIFEST_FILENAME, entry_name) == 0))
+            if (*entry_data_capacity < entry_size)
             {
-                // verify resource
-                uint32_t entry_size;
-                zr = dmZip::GetEntrySize(zip, &entry_size);
-                if (dmZip::RESULT_OK != zr)
-                {
-                    dmLogError("Could not get entry size '%s'", entry_name);
-                    dmZip::Close(zip);
-                    free((void*)entry_data);
-                    return dmResource::RESULT_INVALID_DATA;
-                }
+                *entry_data = (uint8_t*)realloc(*entry_data, entry_size);
+                *entry_data_capacity = entry_size;
+            }
 
-                if (entry_data_capacity < entry_size)
-                {
-                    entry_data = (uint8_t*)realloc(entry_data, entry_size);
-                    entry_data_capacity = entry_size;
-                }
+            zr = dmZip::GetEntryData(zip, *entry_data, entry_size);
+            if (dmZip::RESULT_OK != zr)
+            {
+                dmLogError("Could not read entry '%s'", entry_name);
+                dmZip::CloseEntry(zip);
+                return dmResource::RESULT_INVALID_DATA;
+            }
 
-                zr = dmZip::GetEntryData(zip, entry_data, entry_size);
+            dmResourceArchive::LiveUpdateResource resource(*entry_data, entry_size);
+            if (entry_size >= sizeof(dmResourceArchive::LiveUpdateResourceHeader))
+            {
+                // NOTE: The entry "name" is the actual checksum of the contents of that file. It is not a url.
+                // NOTE: We probably need to handle custom files existing in the .zip file that _aren't_ part of the manifest,
+                //       so an entry that doesn't verify is logged, but doesn't fail the archive
+                dmResource::Result verify_result = dmResource::VerifyResource(ctx->m_Manifest, (const uint8_t*)entry_name, strlen(entry_name), resource.m_Data, resource.m_Count);
 
-                dmResourceArchive::LiveUpdateResource resource(entry_data, entry_size);
-                if (entry_size >= sizeof(dmResourceArchive::LiveUpdateResourceHeader))
+                if (dmResource::RESULT_OK != verify_result)
                 {
-                    // NOTE: The entry "name" is the actual checksum of the contents of that file. It is not a url.
-                    // NOTE: We probably need to handle custom files existing in the .zip file that _aren't_ part of the manifest
-                    result = dmResource::VerifyResource(manifest, (const uint8_t*)entry_name, strlen(entry_name), resource.m_Data, resource.m_Count);
-
-                    if (dmResource::RESULT_OK != result)
-                    {
-                        dmLogError("Failed to verify resource '%s' in archive", entry_name);
-                    }
-                }
-                else {
-                    dmLogError("Skipping resource %s from archive", entry_name);
+                    dmLogError("Failed to verify resource '%s' in archive", entry_name);
                 }
             }
+            else {
+                dmLogError("Skipping resource %s from archive", entry_name);
+            }
+        }
 
-            dmZip::CloseEntry(zip);
+        dmZip::CloseEntry(zip);
+        return result;
+    }
+
+    static void SignalProgress(VerifyContext* ctx, uint32_t num_verified, uint32_t num_finished)
+    {
+        if (!ctx->m_Mutex)
+        {
+            ctx->m_NumVerified += num_verified;
+            ctx->m_NumFinished += num_finished;
+            return;
+        }
+        DM_MUTEX_SCOPED_LOCK(ctx->m_Mutex);
+        ctx->m_NumVerified += num_verified;
+        ctx->m_NumFinished += num_finished;
+        dmConditionVariable::Signal(ctx->m_Cond);
+    }
+
+    // Each job has its own zip handle, so that both decompression and hashing is done in parallel
+    static int VerifyZipEntriesJob(void* _ctx, void* _data)
+    {
+        VerifyContext* ctx = (VerifyContext*)_ctx;
+
+        dmZip::HZip zip;
+        if (dmZip::RESULT_OK != dmZip::Open(ctx->m_Path, &zip))
+        {
+            dmLogError("Could not open zip file '%s'", ctx->m_Path);
+            dmAtomicStore32(&ctx->m_Failed, 1);
+            SignalProgress(ctx, 0, 1);
+            return 0;
+        }
+
+        uint32_t entry_data_capacity = 0;
+        uint8_t* entry_data = 0;
+        while (!dmAtomicGet32(&ctx->m_Failed))
+        {
+            uint32_t index = (uint32_t)dmAtomicIncrement32(&ctx->m_NextEntry);
+            if (index >= ctx->m_NumEntries)
+                break;
+
+            dmResource::Result result = VerifyZipEntry(ctx, zip, index, &entry_data, &entry_data_capacity);
+            if (dmResource::RESULT_OK != result)
+            {
+                dmAtomicStore32(&ctx->m_Failed, 1);
+                break;
+            }
+            SignalProgress(ctx, 1, 0);
         }
+
         free((void*)entry_data);
-        return dmResource::RESULT_OK;
+        dmZip::Close(zip);
+        SignalProgress(ctx, 0, 1);
+        return 0;
+    }
+
+    static dmResource::Result VerifyZipEntries(dmResource::Manifest* manifest, const char* path, uint32_t num_entries, dmJobThread::HContext job_thread, FVerifyProgress progress_cbk, void* progress_ctx)
+    {
+        VerifyContext ctx;
+        memset(&ctx, 0, sizeof(ctx));
+        ctx.m_Path = path;
+        ctx.m_Manifest = manifest;
+        ctx.m_NumEntries = num_entries;
+
+        uint32_t num_jobs = 0;
+        if (job_thread && dmThread::PlatformHasThreadSupport())
+        {
+            num_jobs = dmMath::Min(dmJobThread::GetWorkerCount(job_thread), dmMath::Max(num_entries / LIVEUPDATE_VERIFY_MIN_ENTRIES_PER_JOB, 1U));
+        }
+
+        if (num_jobs == 0)
+        {
+            VerifyZipEntriesJob(&ctx, 0);
+            if (progress_cbk)
+                progress_cbk(progress_ctx, ctx.m_NumVerified, num_entries);
+            return ctx.m_Failed ? dmResource::RESULT_INVALID_DATA : dmResource::RESULT_OK;
+        }
+
+        ctx.m_Mutex = dmMutex::New();
+        ctx.m_Cond = dmConditionVariable::New();
+
+        for (uint32_t i = 0; i < num_jobs; ++i)
+        {
+            dmJobThread::PushJob(job_thread, VerifyZipEntriesJob, 0, &ctx, 0);
+        }
+
+        uint32_t prev_num_verified = 0;
+        dmMutex::Lock(ctx.m_Mutex);
+        while (ctx.m_NumFinished < num_jobs)
+        {
+            dmConditionVariable::Wait(ctx.m_Cond, ctx.m_Mutex);
+
+            uint32_t num_verified = ctx.m_NumVerified;
+            if (progress_cbk && num_verified != prev_num_verified)
+            {
+                dmMutex::Unlock(ctx.m_Mutex);
+                progress_cbk(progress_ctx, num_verified, num_entries);
+                dmMutex::Lock(ctx.m_Mutex);
+            }
+            prev_num_verified = num_verified;
+        }
+        dmMutex::Unlock(ctx.m_Mutex);
+
+        // The jobs have no callbacks, but the finished items are still queued until the next update
+        dmJobThread::Update(job_thread);
+
+        dmConditionVariable::Delete(ctx.m_Cond);
+        dmMutex::Delete(ctx.m_Mutex);
+
+        return dmAtomicGet32(&ctx.m_Failed) ? dmResource::RESULT_INVALID_DATA : dmResource::RESULT_OK;
     }
 
-    dmResource::Result VerifyZipArchive(const char* path, const char* public_key_path)
+    dmResource::Result VerifyZipArchive(const char* path, const char* public_key_path, dmJobThread::HContext job_thread, FVerifyProgress progress_cbk, void* progress_ctx)
     {
         dmLogInfo("Verifying archive '%s'", path);
 
@@ -161,7 +294,7 @@ namespace dmLiveUpdate
 
         // TODO: What to do here. It is now ok for a liveupdate manifest/archive to not contain all the resources
         //      * We can require the manifest to only contain entries for the files in the archive
-        result = VerifyZipEntries(manifest, zip);
+        result = VerifyZipEntries(manifest, path, dmZip::GetNumEntries(zip), job_thread, progress_cbk, progress_ctx);
         if (dmResource::RESULT_OK != result)
         {
             dmLogError("Manifest references non existing resources");
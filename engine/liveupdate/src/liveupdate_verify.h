@@ -16,11 +16,18 @@
 #define DM_LIVEUPDATE_VERIFY_H
 
 #include "liveupdate.h"
+#include <dlib/job_thread.h>
 #include <resource/resource.h>
 
 namespace dmLiveUpdate
 {
-    dmResource::Result VerifyZipArchive(const char* path, const char* public_key_path);
+    // Called with the number of verified entries so far
+    typedef void (*FVerifyProgress)(void* ctx, uint32_t num_verified, uint32_t num_entries);
+
+    // Verifies the manifest, and each entry of the archive. The entries are verified in parallel on the workers of the job thread,
+    // and the call blocks until they're done. If the job thread is null, the entries are verified on the calling thread.
+    // An entry that doesn't match the manifest is logged, but an entry that can't be read fails the archive.
+    dmResource::Result VerifyZipArchive(const char* path, const char* public_key_path, dmJobThread::HContext job_thread, FVerifyProgress progress_cbk, void* progress_ctx);
 }
 
 #endif // DM_LIVEUPDATE_VERIFY_H
@@ -391,6 +391,10 @@ public:
 
     void SynchronizeFixtures();
 
+    /// Get/set an index into a list owned by the user. Not used by Box2D. Defaults to -1
+    int32 GetUserIndex() const;
+    void SetUserIndex(int32 index);
+
 private:
 
 	friend class b2World;
@@ -473,6 +477,9 @@ private:
 	float32 m_sleepTime;
 
 	void* m_userData;
+
+    // Defold mod
+    int32 m_userIndex;
 };
 
 inline b2BodyType b2Body::GetType() const
@@ -865,4 +872,14 @@ inline const b2Vec2& b2Body::GetForce() const
     return m_force;
 }
 
+inline int32 b2Body::GetUserIndex() const
+{
+    return m_userIndex;
+}
+
+inline void b2Body::SetUserIndex(int32 index)
+{
+    m_userIndex = index;
+}
+
 #endif
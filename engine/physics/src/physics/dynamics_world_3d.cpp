@@ -0,0 +1,576 @@
+// Copyright 2020-2024 The Defold Foundation
+// Copyright 2014-2020 King
+// Copyright 2009-2014 Ragnar Svensson, Christian Murray
+// Licensed under the Defold License version 1.0 (the "License"); you may not use
+// this file except in compliance with the License.
+//
+// You may obtain a copy of the License, together with FAQs at
+// https://www.defold.com/license
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include <float.h>
+#include <string.h>
+
+#include <dlib/array.h>
+#include <dlib/atomic.h>
+#include <dlib/dstrings.h>
+#include <dlib/log.h>
+#include <dlib/math.h>
+#include <dlib/profile.h>
+#include <dlib/thread.h>
+
+#if defined(DM_HAS_THREADS)
+    #include <dlib/condition_variable.h>
+    #include <dlib/mutex.h>
+#endif
+
+#include <BulletCollision/CollisionDispatch/btSimulationIslandManager.h>
+
+#include "dynamics_world_3d.h"
+
+namespace dmPhysics
+{
+    static const uint32_t MAX_WORKER_COUNT = 8;
+
+    struct WorkerPool3D;
+
+    struct WorkerThreadArgs
+    {
+        WorkerPool3D*   m_Pool;
+        uint32_t        m_ThreadIndex;
+    };
+
+    struct WorkerPool3D
+    {
+#if defined(DM_HAS_THREADS)
+        dmArray<dmThread::Thread>               m_Threads;
+        WorkerThreadArgs                        m_ThreadArgs[MAX_WORKER_COUNT];
+        dmMutex::HMutex                         m_Mutex;
+        dmConditionVariable::HConditionVariable m_WorkCond;
+        dmConditionVariable::HConditionVariable m_DoneCond;
+#endif
+        FWorkerJob3D                            m_Job;
+        void*                                   m_JobContext;
+        uint32_t                                m_ItemCount;
+        int32_atomic_t                          m_NextItem;
+        // Bumped for each job. Every worker takes part in every job, which keeps the job state
+        // stable until all workers have reported back
+        uint32_t                                m_Generation;
+        uint32_t                                m_FinishedCount;
+        bool                                    m_Run;
+    };
+
+    static void ProcessItems(WorkerPool3D* pool, uint32_t thread_index)
+    {
+        while (true)
+        {
+            uint32_t item = (uint32_t)dmAtomicIncrement32(&pool->m_NextItem);
+            if (item >= pool->m_ItemCount)
+                break;
+            pool->m_Job(pool->m_JobContext, thread_index, item);
+        }
+    }
+
+#if defined(DM_HAS_THREADS)
+    static void WorkerThread(void* _args)
+    {
+        WorkerThreadArgs* args = (WorkerThreadArgs*)_args;
+        WorkerPool3D* pool = args->m_Pool;
+        uint32_t generation = 0;
+        while (true)
+        {
+            {
+                DM_MUTEX_SCOPED_LOCK(pool->m_Mutex);
+                while (pool->m_Run && pool->m_Generation == generation)
+                    dmConditionVariable::Wait(pool->m_WorkCond, pool->m_Mutex);
+                if (!pool->m_Run)
+                    return;
+                generation = pool->m_Generation;
+            }
+
+            {
+                DM_PROFILE("PhysicsWorker");
+                ProcessItems(pool, args->m_ThreadIndex);
+            }
+
+            {
+                DM_MUTEX_SCOPED_LOCK(pool->m_Mutex);
+                ++pool->m_FinishedCount;
+                dmConditionVariable::Signal(pool->m_DoneCond);
+            }
+        }
+    }
+#endif
+
+    HWorkerPool3D NewWorkerPool3D(uint32_t thread_count)
+    {
+#if defined(DM_HAS_THREADS)
+        if (thread_count == 0)
+            return 0x0;
+        if (thread_count > MAX_WORKER_COUNT)
+        {
+            dmLogWarning("Physics worker thread count %u clamped to %u.", thread_count, MAX_WORKER_COUNT);
+            thread_count = MAX_WORKER_COUNT;
+        }
+
+        WorkerPool3D* pool = new WorkerPool3D;
+        pool->m_Mutex = dmMutex::New();
+        pool->m_WorkCond = dmConditionVariable::New();
+        pool->m_DoneCond = dmConditionVariable::New();
+        pool->m_Job = 0x0;
+        pool->m_JobContext = 0x0;
+        pool->m_ItemCount = 0;
+        pool->m_NextItem = 0;
+        pool->m_Generation = 0;
+        pool->m_FinishedCount = 0;
+        pool->m_Run = true;
+
+        pool->m_Threads.SetCapacity(thread_count);
+        for (uint32_t i = 0; i < thread_count; ++i)
+        {
+            WorkerThreadArgs* args = &pool->m_ThreadArgs[i];
+            args->m_Pool = pool;
+            args->m_ThreadIndex = i + 1;
+            char name[32];
+            dmSnPrintf(name, sizeof(name), "physics_%u", i + 1);
+            pool->m_Threads.Push(dmThread::New(WorkerThread, 0x80000, args, name));
+        }
+        return pool;
+#else
+        (void)thread_count;
+        return 0x0;
+#endif
+    }
+
+    void DeleteWorkerPool3D(HWorkerPool3D pool)
+    {
+        if (!pool)
+            return;
+#if defined(DM_HAS_THREADS)
+        {
+            DM_MUTEX_SCOPED_LOCK(pool->m_Mutex);
+            pool->m_Run = false;
+            dmConditionVariable::Broadcast(pool->m_WorkCond);
+        }
+        for (uint32_t i = 0; i < pool->m_Threads.Size(); ++i)
+        {
+            dmThread::Join(pool->m_Threads[i]);
+        }
+        dmConditionVariable::Delete(pool->m_DoneCond);
+        dmConditionVariable::Delete(pool->m_WorkCond);
+        dmMutex::Delete(pool->m_Mutex);
+#endif
+        delete pool;
+    }
+
+    uint32_t GetWorkerCount3D(HWorkerPool3D pool)
+    {
+#if defined(DM_HAS_THREADS)
+        return pool ? pool->m_Threads.Size() : 0;
+#else
+        return 0;
+#endif
+    }
+
+    void RunJob3D(HWorkerPool3D pool, FWorkerJob3D job, void* context, uint32_t item_count)
+    {
+        if (pool == 0x0 || item_count <= 1)
+        {
+            for (uint32_t i = 0; i < item_count; ++i)
+                job(context, 0, i);
+            return;
+        }
+
+#if defined(DM_HAS_THREADS)
+        {
+            DM_MUTEX_SCOPED_LOCK(pool->m_Mutex);
+            pool->m_Job = job;
+            pool->m_JobContext = context;
+            pool->m_ItemCount = item_count;
+            dmAtomicStore32(&pool->m_NextItem, 0);
+            pool->m_FinishedCount = 0;
+            ++pool->m_Generation;
+            dmConditionVariable::Broadcast(pool->m_WorkCond);
+        }
+
+        ProcessItems(pool, 0);
+
+        DM_MUTEX_SCOPED_LOCK(pool->m_Mutex);
+        while (pool->m_FinishedCount < pool->m_Threads.Size())
+            dmConditionVariable::Wait(pool->m_DoneCond, pool->m_Mutex);
+#endif
+    }
+
+    // Same as in btDiscreteDynamicsWorld.cpp
+    static inline int GetConstraintIslandId(const btTypedConstraint* constraint)
+    {
+        const btCollisionObject& co0 = constraint->getRigidBodyA();
+        const btCollisionObject& co1 = constraint->getRigidBodyB();
+        return co0.getIslandTag() >= 0 ? co0.getIslandTag() : co1.getIslandTag();
+    }
+
+    struct SortConstraintOnIslandPredicate
+    {
+        bool operator() (const btTypedConstraint* lhs, const btTypedConstraint* rhs) const
+        {
+            return GetConstraintIslandId(lhs) < GetConstraintIslandId(rhs);
+        }
+    };
+
+    // Collects the awake islands into batches, the same way btDiscreteDynamicsWorld batches them before solving
+    struct IslandGatherCallback3D : public btSimulationIslandManager::IslandCallback
+    {
+        IslandGatherCallback3D(DynamicsWorld3D* world, int min_batch_size)
+        : m_World(world)
+        , m_MinBatchSize(min_batch_size)
+        {
+            BeginBatch();
+        }
+
+        virtual void ProcessIsland(btCollisionObject** bodies, int num_bodies, btPersistentManifold** manifolds, int num_manifolds, int island_id)
+        {
+            btAlignedObjectArray<btTypedConstraint*>& sorted = m_World->m_SortedConstraints;
+            int constraint_count = sorted.size();
+            int first_constraint = 0;
+            while (first_constraint < constraint_count && GetConstraintIslandId(sorted[first_constraint]) != island_id)
+                ++first_constraint;
+            int num_constraints = 0;
+            for (int i = first_constraint; i < constraint_count; ++i)
+            {
+                if (GetConstraintIslandId(sorted[i]) == island_id)
+                    ++num_constraints;
+            }
+
+            // Only solve if there is some work
+            if (m_MinBatchSize <= 1 && num_manifolds + num_constraints == 0)
+                return;
+
+            for (int i = 0; i < num_bodies; ++i)
+                m_World->m_IslandBodies.push_back(bodies[i]);
+            for (int i = 0; i < num_manifolds; ++i)
+                m_World->m_IslandManifolds.push_back(manifolds[i]);
+            for (int i = 0; i < num_constraints; ++i)
+                m_World->m_IslandConstraints.push_back(sorted[first_constraint + i]);
+
+            int batch_size = (m_World->m_IslandManifolds.size() - m_Batch.m_FirstManifold) + (m_World->m_IslandConstraints.size() - m_Batch.m_FirstConstraint);
+            if (m_MinBatchSize <= 1 || batch_size > m_MinBatchSize)
+            {
+                EndBatch();
+            }
+        }
+
+        void BeginBatch()
+        {
+            m_Batch.m_FirstBody = m_World->m_IslandBodies.size();
+            m_Batch.m_FirstManifold = m_World->m_IslandManifolds.size();
+            m_Batch.m_FirstConstraint = m_World->m_IslandConstraints.size();
+        }
+
+        void EndBatch()
+        {
+            m_Batch.m_BodyCount = m_World->m_IslandBodies.size() - m_Batch.m_FirstBody;
+            m_Batch.m_ManifoldCount = m_World->m_IslandManifolds.size() - m_Batch.m_FirstManifold;
+            m_Batch.m_ConstraintCount = m_World->m_IslandConstraints.size() - m_Batch.m_FirstConstraint;
+            if (m_Batch.m_ManifoldCount + m_Batch.m_ConstraintCount > 0)
+            {
+                m_World->m_IslandBatches.push_back(m_Batch);
+            }
+            BeginBatch();
+        }
+
+        DynamicsWorld3D*                m_World;
+        DynamicsWorld3D::IslandBatch    m_Batch;
+        int                             m_MinBatchSize;
+    };
+
+    /*
+     * Solver used for the islands when they are solved in parallel.
+     * The profiler in Bullet (BT_PROFILE) keeps a single global sample tree and isn't thread safe,
+     * and the prebuilt Bullet library has it enabled. The base class enters it in solveGroup,
+     * solveGroupCacheFriendlySetup and solveGroupCacheFriendlyIterations, so those are reimplemented
+     * here, following btSequentialImpulseConstraintSolver (Bullet 2.77) step by step.
+     * The remaining functions it calls don't use the profiler or any other global state, except the
+     * gNumSplitImpulseRecoveries counter, which is only touched when split impulse is enabled (it isn't by default),
+     * and the allocation counters, see Reserve().
+     */
+    class WorkerSolver3D : public btSequentialImpulseConstraintSolver
+    {
+    public:
+        virtual btScalar solveGroup(btCollisionObject** bodies, int num_bodies, btPersistentManifold** manifolds, int num_manifolds,
+                                    btTypedConstraint** constraints, int num_constraints, const btContactSolverInfo& info,
+                                    btIDebugDraw* debug_draw, btStackAlloc* stack_alloc, btDispatcher* dispatcher)
+        {
+            (void)dispatcher;
+            solveGroupCacheFriendlySetup(bodies, num_bodies, manifolds, num_manifolds, constraints, num_constraints, info, debug_draw, stack_alloc);
+            solveGroupCacheFriendlyIterations(bodies, num_bodies, manifolds, num_manifolds, constraints, num_constraints, info, debug_draw, stack_alloc);
+            solveGroupCacheFriendlyFinish(bodies, num_bodies, manifolds, num_manifolds, constraints, num_constraints, info, debug_draw, stack_alloc);
+            return 0.0f;
+        }
+
+        // Grows the pools up front, on the calling thread, since the allocation counters in Bullet aren't thread safe either
+        void Reserve(int contact_count, int constraint_count)
+        {
+            // At most two friction constraints per contact
+            m_tmpSolverContactConstraintPool.reserve(contact_count);
+            m_tmpSolverContactFrictionConstraintPool.reserve(contact_count * 2);
+            m_orderTmpConstraintPool.reserve(contact_count);
+            m_orderFrictionConstraintPool.reserve(contact_count * 2);
+            // At most one row per degree of freedom
+            m_tmpConstraintSizesPool.reserve(constraint_count);
+            m_tmpSolverNonContactConstraintPool.reserve(constraint_count * 6);
+        }
+
+    protected:
+        virtual btScalar solveGroupCacheFriendlySetup(btCollisionObject** bodies, int num_bodies, btPersistentManifold** manifolds, int num_manifolds,
+                                                      btTypedConstraint** constraints, int num_constraints, const btContactSolverInfo& info,
+                                                      btIDebugDraw* debug_draw, btStackAlloc* stack_alloc)
+        {
+            (void)debug_draw;
+            (void)stack_alloc;
+
+            if (num_constraints + num_manifolds == 0)
+                return 0.0f;
+
+            for (int i = 0; i < num_bodies; ++i)
+            {
+                btRigidBody* body = btRigidBody::upcast(bodies[i]);
+                if (!body)
+                    continue;
+                body->internalGetDeltaLinearVelocity().setZero();
+                body->internalGetDeltaAngularVelocity().setZero();
+                if (info.m_splitImpulse)
+                {
+                    body->internalGetPushVelocity().setZero();
+                    body->internalGetTurnVelocity().setZero();
+                }
+            }
+
+            for (int i = 0; i < num_constraints; ++i)
+            {
+                constraints[i]->buildJacobian();
+            }
+
+            int total_row_count = 0;
+            m_tmpConstraintSizesPool.resize(num_constraints);
+            for (int i = 0; i < num_constraints; ++i)
+            {
+                btTypedConstraint::btConstraintInfo1& info1 = m_tmpConstraintSizesPool[i];
+                constraints[i]->getInfo1(&info1);
+                total_row_count += info1.m_numConstraintRows;
+            }
+            m_tmpSolverNonContactConstraintPool.resize(total_row_count);
+
+            int current_row = 0;
+            for (int i = 0; i < num_constraints; ++i)
+            {
+                const btTypedConstraint::btConstraintInfo1& info1 = m_tmpConstraintSizesPool[i];
+                if (info1.m_numConstraintRows)
+                {
+                    SetupConstraintRows(&m_tmpSolverNonContactConstraintPool[current_row], info1.m_numConstraintRows, constraints[i], info);
+                }
+                current_row += info1.m_numConstraintRows;
+            }
+
+            for (int i = 0; i < num_manifolds; ++i)
+            {
+                convertContact(manifolds[i], info);
+            }
+
+            int contact_count = m_tmpSolverContactConstraintPool.size();
+            int friction_count = m_tmpSolverContactFrictionConstraintPool.size();
+            m_orderTmpConstraintPool.resize(contact_count);
+            m_orderFrictionConstraintPool.resize(friction_count);
+            for (int i = 0; i < contact_count; ++i)
+            {
+                m_orderTmpConstraintPool[i] = i;
+            }
+            for (int i = 0; i < friction_count; ++i)
+            {
+                m_orderFrictionConstraintPool[i] = i;
+            }
+            return 0.0f;
+        }
+
+        virtual btScalar solveGroupCacheFriendlyIterations(btCollisionObject** bodies, int num_bodies, btPersistentManifold** manifolds, int num_manifolds,
+                                                           btTypedConstraint** constraints, int num_constraints, const btContactSolverInfo& info,
+                                                           btIDebugDraw* debug_draw, btStackAlloc* stack_alloc)
+        {
+            for (int iteration = 0; iteration < info.m_numIterations; ++iteration)
+            {
+                solveSingleIteration(iteration, bodies, num_bodies, manifolds, num_manifolds, constraints, num_constraints, info, debug_draw, stack_alloc);
+            }
+            solveGroupCacheFriendlySplitImpulseIterations(bodies, num_bodies, manifolds, num_manifolds, constraints, num_constraints, info, debug_draw, stack_alloc);
+            return 0.0f;
+        }
+
+    private:
+        static void SetupConstraintRows(btSolverConstraint* rows, int row_count, btTypedConstraint* constraint, const btContactSolverInfo& info)
+        {
+            btRigidBody& rb_a = constraint->getRigidBodyA();
+            btRigidBody& rb_b = constraint->getRigidBodyB();
+
+            for (int j = 0; j < row_count; ++j)
+            {
+                memset((void*)&rows[j], 0, sizeof(btSolverConstraint));
+                rows[j].m_lowerLimit = -FLT_MAX;
+                rows[j].m_upperLimit = FLT_MAX;
+                rows[j].m_appliedImpulse = 0.0f;
+                rows[j].m_appliedPushImpulse = 0.0f;
+                rows[j].m_solverBodyA = &rb_a;
+                rows[j].m_solverBodyB = &rb_b;
+            }
+
+            // Static bodies (and the shared fixed body) may be attached to constraints in several islands.
+            // Their deltas are never changed by the solver, so only reset the deltas of the dynamic ones
+            if (rb_a.getInvMass() != 0.0f)
+            {
+                rb_a.internalGetDeltaLinearVelocity().setZero();
+                rb_a.internalGetDeltaAngularVelocity().setZero();
+            }
+            if (rb_b.getInvMass() != 0.0f)
+            {
+                rb_b.internalGetDeltaLinearVelocity().setZero();
+                rb_b.internalGetDeltaAngularVelocity().setZero();
+            }
+
+            btTypedConstraint::btConstraintInfo2 info2;
+            info2.fps = 1.0f / info.m_timeStep;
+            info2.erp = info.m_erp;
+            info2.m_J1linearAxis = rows->m_contactNormal;
+            info2.m_J1angularAxis = rows->m_relpos1CrossNormal;
+            info2.m_J2linearAxis = 0;
+            info2.m_J2angularAxis = rows->m_relpos2CrossNormal;
+            info2.rowskip = sizeof(btSolverConstraint) / sizeof(btScalar);
+            info2.m_constraintError = &rows->m_rhs;
+            rows->m_cfm = info.m_globalCfm;
+            info2.cfm = &rows->m_cfm;
+            info2.m_lowerLimit = &rows->m_lowerLimit;
+            info2.m_upperLimit = &rows->m_upperLimit;
+            info2.m_numIterations = info.m_numIterations;
+            constraint->getInfo2(&info2);
+
+            for (int j = 0; j < row_count; ++j)
+            {
+                btSolverConstraint& row = rows[j];
+                row.m_originalContactPoint = constraint;
+                row.m_angularComponentA = rb_a.getInvInertiaTensorWorld() * row.m_relpos1CrossNormal * rb_a.getAngularFactor();
+                row.m_angularComponentB = rb_b.getInvInertiaTensorWorld() * row.m_relpos2CrossNormal * rb_b.getAngularFactor();
+
+                btVector3 imj_la = row.m_contactNormal * rb_a.getInvMass();
+                btVector3 imj_aa = rb_a.getInvInertiaTensorWorld() * row.m_relpos1CrossNormal;
+                btVector3 imj_lb = row.m_contactNormal * rb_b.getInvMass();
+                btVector3 imj_ab = rb_b.getInvInertiaTensorWorld() * row.m_relpos2CrossNormal;
+                btScalar sum = imj_la.dot(row.m_contactNormal);
+                sum += imj_aa.dot(row.m_relpos1CrossNormal);
+                sum += imj_lb.dot(row.m_contactNormal);
+                sum += imj_ab.dot(row.m_relpos2CrossNormal);
+                row.m_jacDiagABInv = btScalar(1.0f) / sum;
+
+                btScalar vel1_dot_n = row.m_contactNormal.dot(rb_a.getLinearVelocity()) + row.m_relpos1CrossNormal.dot(rb_a.getAngularVelocity());
+                btScalar vel2_dot_n = -row.m_contactNormal.dot(rb_b.getLinearVelocity()) + row.m_relpos2CrossNormal.dot(rb_b.getAngularVelocity());
+                btScalar velocity_error = -(vel1_dot_n + vel2_dot_n);
+                // m_rhs holds the positional error, filled in by getInfo2
+                btScalar penetration_impulse = row.m_rhs * row.m_jacDiagABInv;
+                btScalar velocity_impulse = velocity_error * row.m_jacDiagABInv;
+                row.m_rhs = penetration_impulse + velocity_impulse;
+                row.m_appliedImpulse = 0.0f;
+            }
+        }
+    };
+
+    DynamicsWorld3D::DynamicsWorld3D(btDispatcher* dispatcher, btBroadphaseInterface* pair_cache, btConstraintSolver* solver,
+                                     btCollisionConfiguration* collision_configuration, HWorkerPool3D pool)
+    : btDiscreteDynamicsWorld(dispatcher, pair_cache, solver, collision_configuration)
+    , m_WorkerPool(pool)
+    , m_SolverInfo(0x0)
+    {
+        // One for the calling thread, and one per worker thread
+        uint32_t solver_count = pool ? GetWorkerCount3D(pool) + 1 : 0;
+        for (uint32_t i = 0; i < solver_count; ++i)
+        {
+            m_WorkerSolvers.push_back(new WorkerSolver3D);
+        }
+    }
+
+    DynamicsWorld3D::~DynamicsWorld3D()
+    {
+        for (int i = 0; i < m_WorkerSolvers.size(); ++i)
+        {
+            delete m_WorkerSolvers[i];
+        }
+    }
+
+    void DynamicsWorld3D::SolveIslandBatch(void* context, uint32_t thread_index, uint32_t item)
+    {
+        DynamicsWorld3D* world = (DynamicsWorld3D*)context;
+        const IslandBatch& batch = world->m_IslandBatches[item];
+        // The stack allocator of the world isn't thread safe, and the sequential impulse solver doesn't use it
+        btConstraintSolver* solver = world->m_WorkerSolvers[thread_index];
+        solver->solveGroup(batch.m_BodyCount ? &world->m_IslandBodies[batch.m_FirstBody] : 0x0, batch.m_BodyCount,
+                           batch.m_ManifoldCount ? &world->m_IslandManifolds[batch.m_FirstManifold] : 0x0, batch.m_ManifoldCount,
+                           batch.m_ConstraintCount ? &world->m_IslandConstraints[batch.m_FirstConstraint] : 0x0, batch.m_ConstraintCount,
+                           *world->m_SolverInfo, 0x0, 0x0, world->m_dispatcher1);
+    }
+
+    void DynamicsWorld3D::solveConstraints(btContactSolverInfo& solver_info)
+    {
+        // Without split islands, everything is solved as one group
+        if (m_WorkerPool == 0x0 || !m_islandManager->getSplitIslands())
+        {
+            btDiscreteDynamicsWorld::solveConstraints(solver_info);
+            return;
+        }
+
+        DM_PROFILE("SolveConstraints");
+
+        m_SortedConstraints.resize(m_constraints.size());
+        for (int i = 0; i < m_constraints.size(); ++i)
+        {
+            m_SortedConstraints[i] = m_constraints[i];
+        }
+        m_SortedConstraints.quickSort(SortConstraintOnIslandPredicate());
+
+        m_IslandBodies.resize(0);
+        m_IslandManifolds.resize(0);
+        m_IslandConstraints.resize(0);
+        m_IslandBatches.resize(0);
+
+        m_constraintSolver->prepareSolve(getCollisionWorld()->getNumCollisionObjects(), getCollisionWorld()->getDispatcher()->getNumManifolds());
+
+        {
+            DM_PROFILE("BuildIslands");
+            IslandGatherCallback3D callback(this, solver_info.m_minimumSolverBatchSize);
+            m_islandManager->buildAndProcessIslands(getCollisionWorld()->getDispatcher(), getCollisionWorld(), &callback);
+            callback.EndBatch();
+        }
+
+        // Any solver may pick any batch
+        int max_contact_count = 0;
+        int max_constraint_count = 0;
+        for (int i = 0; i < m_IslandBatches.size(); ++i)
+        {
+            const IslandBatch& batch = m_IslandBatches[i];
+            int contact_count = 0;
+            for (int j = 0; j < batch.m_ManifoldCount; ++j)
+            {
+                contact_count += m_IslandManifolds[batch.m_FirstManifold + j]->getNumContacts();
+            }
+            max_contact_count = dmMath::Max(max_contact_count, contact_count);
+            max_constraint_count = dmMath::Max(max_constraint_count, batch.m_ConstraintCount);
+        }
+        for (int i = 0; i < m_WorkerSolvers.size(); ++i)
+        {
+            m_WorkerSolvers[i]->Reserve(max_contact_count, max_constraint_count);
+        }
+
+        m_SolverInfo = &solver_info;
+        RunJob3D(m_WorkerPool, SolveIslandBatch, this, (uint32_t)m_IslandBatches.size());
+        m_SolverInfo = 0x0;
+
+        m_constraintSolver->allSolved(solver_info, m_debugDrawer, m_stackAlloc);
+    }
+}
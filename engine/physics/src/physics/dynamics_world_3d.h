@@ -0,0 +1,81 @@
+// Copyright 2020-2024 The Defold Foundation
+// Copyright 2014-2020 King
+// Copyright 2009-2014 Ragnar Svensson, Christian Murray
+// Licensed under the Defold License version 1.0 (the "License"); you may not use
+// this file except in compliance with the License.
+//
+// You may obtain a copy of the License, together with FAQs at
+// https://www.defold.com/license
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#ifndef PHYSICS_DYNAMICS_WORLD_3D_H
+#define PHYSICS_DYNAMICS_WORLD_3D_H
+
+#include <stdint.h>
+
+#include "btBulletDynamicsCommon.h"
+
+namespace dmPhysics
+{
+    typedef struct WorkerPool3D* HWorkerPool3D;
+    class WorkerSolver3D;
+
+    // Processes one item of a job. The thread index is 0 for the calling thread, and 1..N for the worker threads
+    typedef void (*FWorkerJob3D)(void* context, uint32_t thread_index, uint32_t item);
+
+    // Returns 0x0 if the thread count is 0, or if the platform doesn't support threads
+    HWorkerPool3D NewWorkerPool3D(uint32_t thread_count);
+    void          DeleteWorkerPool3D(HWorkerPool3D pool);
+    uint32_t      GetWorkerCount3D(HWorkerPool3D pool);
+
+    // Processes all items, on the calling thread and the worker threads, and returns when all are done
+    void          RunJob3D(HWorkerPool3D pool, FWorkerJob3D job, void* context, uint32_t item_count);
+
+    /*
+     * Dynamics world that solves the simulation islands in parallel on the worker pool.
+     * Each thread has its own constraint solver, and since the islands don't share any
+     * dynamic bodies, the result is the same as when solving them one after the other.
+     * Everything else in the step (broadphase, narrowphase, integration and the
+     * motion state callbacks) still runs on the calling thread.
+     */
+    class DynamicsWorld3D : public btDiscreteDynamicsWorld
+    {
+    public:
+        DynamicsWorld3D(btDispatcher* dispatcher, btBroadphaseInterface* pair_cache, btConstraintSolver* solver,
+                        btCollisionConfiguration* collision_configuration, HWorkerPool3D pool);
+        virtual ~DynamicsWorld3D();
+
+    protected:
+        virtual void solveConstraints(btContactSolverInfo& solver_info);
+
+    private:
+        struct IslandBatch
+        {
+            int m_FirstBody;
+            int m_BodyCount;
+            int m_FirstManifold;
+            int m_ManifoldCount;
+            int m_FirstConstraint;
+            int m_ConstraintCount;
+        };
+
+        friend struct IslandGatherCallback3D;
+        static void SolveIslandBatch(void* context, uint32_t thread_index, uint32_t item);
+
+        HWorkerPool3D                                   m_WorkerPool;
+        // Solvers for the calling thread (index 0) and the worker threads. They stay clear of the Bullet profiler
+        btAlignedObjectArray<WorkerSolver3D*>           m_WorkerSolvers;
+        btAlignedObjectArray<btTypedConstraint*>        m_SortedConstraints;
+        btAlignedObjectArray<btCollisionObject*>        m_IslandBodies;
+        btAlignedObjectArray<btPersistentManifold*>     m_IslandManifolds;
+        btAlignedObjectArray<btTypedConstraint*>        m_IslandConstraints;
+        btAlignedObjectArray<IslandBatch>               m_IslandBatches;
+        btContactSolverInfo*                            m_SolverInfo;
+    };
+}
+
+#endif // PHYSICS_DYNAMICS_WORLD_3D_H
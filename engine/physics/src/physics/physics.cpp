@@ -20,6 +20,7 @@
 
 #include <dlib/array.h>
 #include <dlib/log.h>
+#include <dlib/memory.h>
 #include <dlib/profile.h>
 
 namespace dmPhysics
@@ -95,7 +96,7 @@ namespace dmPhysics
         }
         OverlapEntry entry;
         memset(&entry, 0, sizeof(entry));
-        entry.m_Overlaps = (Overlap*)malloc(cache->m_TriggerOverlapCapacity * sizeof(Overlap));
+        entry.m_Overlaps = (Overlap*)dmMemory::Malloc(dmMemory::TAG_PHYSICS, cache->m_TriggerOverlapCapacity * sizeof(Overlap));
         entry.m_UserData = user_data_a;
         entry.m_Group = group_a;
         // Add overlap to the entry
@@ -184,7 +185,7 @@ namespace dmPhysics
             }
             // Remove the object from the cache
             cache->m_OverlapCache.Erase((uintptr_t)object);
-            free(entry->m_Overlaps);
+            dmMemory::Free(dmMemory::TAG_PHYSICS, entry->m_Overlaps);
         }
     }
 
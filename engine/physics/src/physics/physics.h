@@ -125,6 +125,9 @@ namespace dmPhysics
     typedef void (*GetWorldTransformCallback)(void* user_data, dmTransform::Transform& world_transform);
     /**
      * Callback used to propagate the world transform from the physics simulation to an external object.
+     * In 2D, it is only called for dynamic bodies that are awake, plus once the step they fall asleep.
+     * Moving the external object of a sleeping body is therefore not reverted by the simulation,
+     * unless dynamic transforms are allowed or the body is woken up.
      *
      * @param user_data User data pointing to the external object
      * @param position Position that the external object will obtain
@@ -247,6 +250,8 @@ namespace dmPhysics
         uint32_t m_RayCastLimit3D;
         /// Maximum number of overlapping triggers
         uint32_t m_TriggerOverlapCapacity;
+        /// Number of worker threads used to solve the 3D simulation islands in parallel. 0 solves them on the calling thread
+        uint32_t m_WorkerThreadCount3D;
         /// If true, the collision objects will retrieve the position of its game object
         uint8_t m_AllowDynamicTransforms:1;
         uint8_t :7;
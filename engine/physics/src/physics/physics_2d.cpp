@@ -371,6 +371,76 @@ namespace dmPhysics
         return dmMath::Min(v[0], v[1]);
     }
 
+    static void AddSyncBody(HWorld2D world, b2Body* body)
+    {
+        if (body->GetType() == b2_kinematicBody)
+        {
+            if (world->m_KinematicBodies.Full())
+                world->m_KinematicBodies.OffsetCapacity(dmMath::Max(64U, world->m_KinematicBodies.Capacity()));
+            body->SetUserIndex((int32)world->m_KinematicBodies.Size());
+            world->m_KinematicBodies.Push(body);
+        }
+        else if (body->GetType() == b2_dynamicBody)
+        {
+            if (world->m_DynamicBodies.Full())
+                world->m_DynamicBodies.OffsetCapacity(dmMath::Max(64U, world->m_DynamicBodies.Capacity()));
+            DynamicBody2D entry;
+            entry.m_Body = body;
+            entry.m_WasAwake = 1;
+            body->SetUserIndex((int32)world->m_DynamicBodies.Size());
+            world->m_DynamicBodies.Push(entry);
+        }
+    }
+
+    static void RemoveSyncBody(HWorld2D world, b2Body* body)
+    {
+        int32 index = body->GetUserIndex();
+        if (index < 0)
+            return;
+        body->SetUserIndex(-1);
+
+        if (body->GetType() == b2_kinematicBody)
+        {
+            world->m_KinematicBodies.EraseSwap((uint32_t)index);
+            if ((uint32_t)index < world->m_KinematicBodies.Size())
+                world->m_KinematicBodies[index]->SetUserIndex(index);
+        }
+        else if (body->GetType() == b2_dynamicBody)
+        {
+            world->m_DynamicBodies.EraseSwap((uint32_t)index);
+            if ((uint32_t)index < world->m_DynamicBodies.Size())
+                world->m_DynamicBodies[index].m_Body->SetUserIndex(index);
+        }
+    }
+
+    static void UpdateKinematicBody(HWorld2D world, b2Body* body, float pos_epsilon, float rot_epsilon)
+    {
+        HContext2D context = world->m_Context;
+        Point3 old_position = GetWorldPosition2D(context, body);
+        dmTransform::Transform world_transform;
+        (*world->m_GetWorldTransformCallback)(body->GetUserData(), world_transform);
+        Point3 position = Point3(world_transform.GetTranslation());
+        // Ignore z-component
+        position.setZ(0.0f);
+        Quat rotation = world_transform.GetRotation();
+        float dp = distSqr(old_position, position);
+        float angle = atan2(2.0f * (rotation.getW() * rotation.getZ() + rotation.getX() * rotation.getY()), 1.0f - 2.0f * (rotation.getY() * rotation.getY() + rotation.getZ() * rotation.getZ()));
+        float old_angle = body->GetAngle();
+        float da = old_angle - angle;
+
+        if (dp > pos_epsilon || fabsf(da) > rot_epsilon)
+        {
+            b2Vec2 b2_position;
+            ToB2(position, b2_position, context->m_Scale);
+            body->SetTransform(b2_position, angle);
+            body->SetSleepingAllowed(false);
+        }
+        else
+        {
+            body->SetSleepingAllowed(true);
+        }
+    }
+
     static void UpdateScale(HWorld2D world, b2Body* body)
     {
         dmTransform::Transform world_transform;
@@ -430,41 +500,25 @@ namespace dmPhysics
         if (world->m_GetWorldTransformCallback)
         {
             DM_PROFILE("UpdateKinematic");
-            for (b2Body* body = world->m_World.GetBodyList(); body; body = body->GetNext())
+            uint32_t count = world->m_KinematicBodies.Size();
+            for (uint32_t i = 0; i < count; ++i)
             {
-                bool retrieve_gameworld_transform = world->m_AllowDynamicTransforms && body->GetType() != b2_staticBody;
+                UpdateKinematicBody(world, world->m_KinematicBodies[i], POS_EPSILON, ROT_EPSILON);
+            }
 
-                // translate & rotation
-                if (retrieve_gameworld_transform || body->GetType() == b2_kinematicBody)
+            if (world->m_AllowDynamicTransforms)
+            {
+                count = world->m_KinematicBodies.Size();
+                for (uint32_t i = 0; i < count; ++i)
                 {
-                    Point3 old_position = GetWorldPosition2D(context, body);
-                    dmTransform::Transform world_transform;
-                    (*world->m_GetWorldTransformCallback)(body->GetUserData(), world_transform);
-                    Point3 position = Point3(world_transform.GetTranslation());
-                    // Ignore z-component
-                    position.setZ(0.0f);
-                    Quat rotation = world_transform.GetRotation();
-                    float dp = distSqr(old_position, position);
-                    float angle = atan2(2.0f * (rotation.getW() * rotation.getZ() + rotation.getX() * rotation.getY()), 1.0f - 2.0f * (rotation.getY() * rotation.getY() + rotation.getZ() * rotation.getZ()));
-                    float old_angle = body->GetAngle();
-                    float da = old_angle - angle;
-
-                    if (dp > POS_EPSILON || fabsf(da) > ROT_EPSILON)
-                    {
-                        b2Vec2 b2_position;
-                        ToB2(position, b2_position, scale);
-                        body->SetTransform(b2_position, angle);
-                        body->SetSleepingAllowed(false);
-                    }
-                    else
-                    {
-                        body->SetSleepingAllowed(true);
-                    }
+                    UpdateScale(world, world->m_KinematicBodies[i]);
                 }
 
-                // Scaling
-                if(retrieve_gameworld_transform)
+                count = world->m_DynamicBodies.Size();
+                for (uint32_t i = 0; i < count; ++i)
                 {
+                    b2Body* body = world->m_DynamicBodies[i].m_Body;
+                    UpdateKinematicBody(world, body, POS_EPSILON, ROT_EPSILON);
                     UpdateScale(world, body);
                 }
             }
@@ -475,17 +529,25 @@ namespace dmPhysics
             world->m_World.Step(dt, 10, 10);
             float inv_scale = world->m_Context->m_InvScale;
             // Update transforms of dynamic bodies
+            // Sleeping bodies don't move, so they're only synchronized the step they fall asleep.
+            // This means that a game object moved by a script while its body sleeps keeps the new
+            // position, where it used to be snapped back to the body every step.
             if (world->m_SetWorldTransformCallback)
             {
-                for (b2Body* body = world->m_World.GetBodyList(); body; body = body->GetNext())
+                uint32_t count = world->m_DynamicBodies.Size();
+                for (uint32_t i = 0; i < count; ++i)
                 {
-                    if (body->GetType() == b2_dynamicBody && body->IsActive())
+                    DynamicBody2D& entry = world->m_DynamicBodies[i];
+                    b2Body* body = entry.m_Body;
+                    bool awake = body->IsActive() && body->IsAwake();
+                    if (awake || entry.m_WasAwake)
                     {
                         Point3 position;
                         FromB2(body->GetPosition(), position, inv_scale);
                         Quat rotation = Quat::rotationZ(body->GetAngle());
                         (*world->m_SetWorldTransformCallback)(body->GetUserData(), position, rotation);
                     }
+                    entry.m_WasAwake = awake;
                 }
             }
         }
@@ -992,6 +1054,7 @@ namespace dmPhysics
             (void)fixture;
         }
         UpdateMass2D(body, data.m_Mass);
+        AddSyncBody(world, body);
         return body;
     }
 
@@ -1004,6 +1067,7 @@ namespace dmPhysics
 
         OverlapCacheRemove(&world->m_TriggerOverlaps, collision_object);
         b2Body* body = (b2Body*)collision_object;
+        RemoveSyncBody(world, body);
         b2Fixture* fixture = body->GetFixtureList();
         while (fixture)
         {
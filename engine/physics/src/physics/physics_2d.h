@@ -42,11 +42,22 @@ namespace dmPhysics
         const StepWorldContext* m_TempStepWorldContext;
     };
 
+    struct DynamicBody2D
+    {
+        b2Body*                     m_Body;
+        uint8_t                     m_WasAwake:1; // Awake at the last transform sync
+        uint8_t                     :7;
+    };
+
     struct World2D
     {
         World2D(HContext2D context, const NewWorldParams& params);
 
         OverlapCache                m_TriggerOverlaps;
+        // Compact lists of the bodies that need their transforms synchronized each step.
+        // The index into the list is stored in b2Body::GetUserIndex(). Static bodies are never synchronized.
+        dmArray<b2Body*>            m_KinematicBodies;
+        dmArray<DynamicBody2D>      m_DynamicBodies;
         HContext2D                  m_Context;
         b2World                     m_World;
         dmArray<RayCastRequest>     m_RayCastRequests;
@@ -46,8 +46,11 @@ namespace dmPhysics
         btCollisionObject* m_CollisionObject;
         uint16_t m_CollisionGroup;
         uint16_t m_CollisionMask;
+        uint32_t m_SyncIndex;   // Index into World3D::m_SyncObjects, or INVALID_SYNC_INDEX
     };
 
+    static const uint32_t INVALID_SYNC_INDEX = 0xffffffff;
+
     static Point3 GetWorldPosition(HContext3D context, btCollisionObject* collision_object);
     static Quat GetWorldRotation(HContext3D context, btCollisionObject* collision_object);
 
@@ -117,6 +120,7 @@ namespace dmPhysics
     , m_DebugCallbacks()
     , m_Gravity(0.0f, -10.0f, 0.0f)
     , m_Socket(0)
+    , m_WorkerPool(0x0)
     , m_Scale(1.0f)
     , m_InvScale(1.0f)
     , m_ContactImpulseLimit(0.0f)
@@ -147,7 +151,7 @@ namespace dmPhysics
 
         m_Solver = new btSequentialImpulseConstraintSolver;
 
-        m_DynamicsWorld = new btDiscreteDynamicsWorld(m_Dispatcher, m_OverlappingPairCache, m_Solver, m_CollisionConfiguration);
+        m_DynamicsWorld = new DynamicsWorld3D(m_Dispatcher, m_OverlappingPairCache, m_Solver, m_CollisionConfiguration, context->m_WorkerPool);
         m_DynamicsWorld->setGravity(btVector3(context->m_Gravity.getX(), context->m_Gravity.getY(), context->m_Gravity.getZ()));
         m_DynamicsWorld->setDebugDrawer(&m_DebugDraw);
 
@@ -291,6 +295,7 @@ namespace dmPhysics
         context->m_RayCastLimit = params.m_RayCastLimit3D;
         context->m_TriggerOverlapCapacity = params.m_TriggerOverlapCapacity;
         context->m_AllowDynamicTransforms = params.m_AllowDynamicTransforms;
+        context->m_WorkerPool = NewWorkerPool3D(params.m_WorkerThreadCount3D);
         dmMessage::Result result = dmMessage::NewSocket(PHYSICS_SOCKET_NAME, &context->m_Socket);
         if (result != dmMessage::RESULT_OK)
         {
@@ -311,6 +316,7 @@ namespace dmPhysics
         }
         if (context->m_Socket != 0)
             dmMessage::DeleteSocket(context->m_Socket);
+        DeleteWorkerPool3D(context->m_WorkerPool);
         delete context;
     }
 
@@ -374,32 +380,30 @@ namespace dmPhysics
         if (world->m_GetWorldTransform != 0x0)
         {
             DM_PROFILE("UpdateTriggers");
-            int collision_object_count = world->m_DynamicsWorld->getNumCollisionObjects();
-            btCollisionObjectArray& collision_objects = world->m_DynamicsWorld->getCollisionObjectArray();
-            for (int i = 0; i < collision_object_count; ++i)
+            uint32_t sync_count = world->m_SyncObjects.Size();
+            for (uint32_t i = 0; i < sync_count; ++i)
             {
-                btCollisionObject* collision_object = collision_objects[i];
+                btCollisionObject* collision_object = world->m_SyncObjects[i]->m_CollisionObject;
+                if (!collision_object->isInWorld())
+                    continue;
 
                 bool retrieve_gameworld_transform = world->m_AllowDynamicTransforms && !collision_object->isStaticObject();
 
-                if (collision_object->getInternalType() == btCollisionObject::CO_GHOST_OBJECT || collision_object->isKinematicObject() || retrieve_gameworld_transform)
+                Point3 old_position = GetWorldPosition(context, collision_object);
+                Quat old_rotation = GetWorldRotation(context, collision_object);
+                dmTransform::Transform world_transform;
+                (*world->m_GetWorldTransform)(collision_object->getUserPointer(), world_transform);
+                Point3 position = Point3(world_transform.GetTranslation());
+                Quat rotation = Quat(world_transform.GetRotation());
+                float dp = distSqr(old_position, position);
+                float dr = norm(rotation - old_rotation);
+                if (dp > POS_EPSILON || dr > ROT_EPSILON)
                 {
-                    Point3 old_position = GetWorldPosition(context, collision_object);
-                    Quat old_rotation = GetWorldRotation(context, collision_object);
-                    dmTransform::Transform world_transform;
-                    (*world->m_GetWorldTransform)(collision_object->getUserPointer(), world_transform);
-                    Point3 position = Point3(world_transform.GetTranslation());
-                    Quat rotation = Quat(world_transform.GetRotation());
-                    float dp = distSqr(old_position, position);
-                    float dr = norm(rotation - old_rotation);
-                    if (dp > POS_EPSILON || dr > ROT_EPSILON)
-                    {
-                        btVector3 bt_pos;
-                        ToBt(position, bt_pos, scale);
-                        btTransform world_t(btQuaternion(rotation.getX(), rotation.getY(), rotation.getZ(), rotation.getW()), bt_pos);
-                        collision_object->setWorldTransform(world_t);
-                        collision_object->activate(true);
-                    }
+                    btVector3 bt_pos;
+                    ToBt(position, bt_pos, scale);
+                    btTransform world_t(btQuaternion(rotation.getX(), rotation.getY(), rotation.getZ(), rotation.getW()), bt_pos);
+                    collision_object->setWorldTransform(world_t);
+                    collision_object->activate(true);
                 }
 
                 // Scaling
@@ -796,6 +800,17 @@ namespace dmPhysics
         co->m_CollisionObject = collision_object;
         co->m_CollisionGroup = data.m_Group;
         co->m_CollisionMask = data.m_Mask;
+        co->m_SyncIndex = INVALID_SYNC_INDEX;
+
+        bool sync_transform = data.m_Type == COLLISION_OBJECT_TYPE_TRIGGER || data.m_Type == COLLISION_OBJECT_TYPE_KINEMATIC
+                            || (world->m_AllowDynamicTransforms && data.m_Type == COLLISION_OBJECT_TYPE_DYNAMIC);
+        if (sync_transform)
+        {
+            if (world->m_SyncObjects.Full())
+                world->m_SyncObjects.OffsetCapacity(dmMath::Max(64U, world->m_SyncObjects.Capacity()));
+            co->m_SyncIndex = world->m_SyncObjects.Size();
+            world->m_SyncObjects.Push(co);
+        }
         return co;
     }
 
@@ -803,6 +818,14 @@ namespace dmPhysics
     {
         CollisionObject3D* co = (CollisionObject3D*)collision_object;
         OverlapCacheRemove(&world->m_TriggerOverlaps, co->m_CollisionObject);
+        if (co->m_SyncIndex != INVALID_SYNC_INDEX)
+        {
+            uint32_t index = co->m_SyncIndex;
+            world->m_SyncObjects.EraseSwap(index);
+            if (index < world->m_SyncObjects.Size())
+                world->m_SyncObjects[index]->m_SyncIndex = index;
+            co->m_SyncIndex = INVALID_SYNC_INDEX;
+        }
         btCollisionObject* bt_co = co->m_CollisionObject;
         if (bt_co == 0x0)
             return;
@@ -20,17 +20,23 @@
 #include "physics.h"
 #include "physics_private.h"
 #include "debug_draw_3d.h"
+#include "dynamics_world_3d.h"
 
 #include "btBulletDynamicsCommon.h"
 
 namespace dmPhysics
 {
+    struct CollisionObject3D;
+
     struct World3D
     {
         World3D(HContext3D context, const NewWorldParams& params);
         ~World3D();
 
         OverlapCache                            m_TriggerOverlaps;
+        // Collision objects that retrieve their transforms from the game world each step (triggers, kinematic bodies
+        // and, if dynamic transforms are allowed, dynamic bodies). Static objects are never synchronized.
+        dmArray<CollisionObject3D*>             m_SyncObjects;
         dmArray<RayCastRequest>                 m_RayCastRequests;
         DebugDraw3D                             m_DebugDraw;
         HContext3D                              m_Context;
@@ -53,6 +59,7 @@ namespace dmPhysics
         DebugCallbacks              m_DebugCallbacks;
         btVector3                   m_Gravity;
         dmMessage::HSocket          m_Socket;
+        HWorkerPool3D               m_WorkerPool;
         float                       m_Scale;
         float                       m_InvScale;
         float                       m_ContactImpulseLimit;
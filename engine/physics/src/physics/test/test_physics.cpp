@@ -16,7 +16,9 @@
 #include <jc_test/jc_test.h>
 
 #include "test_physics.h"
+#include <vector>
 #include <dlib/math.h>
+#include <dlib/time.h>
 
 
 using namespace dmVMath;
@@ -27,6 +29,7 @@ VisualObject::VisualObject()
 , m_Scale(1.0f)
 , m_CollisionCount(0)
 , m_FirstCollisionGroup(0)
+, m_SetWorldTransformCount(0)
 {
 
 }
@@ -52,6 +55,7 @@ void SetWorldTransform(void* visual_object, const Point3& position, const Quat&
     VisualObject* o = (VisualObject*) visual_object;
     o->m_Position = position;
     o->m_Rotation = rotation;
+    ++o->m_SetWorldTransformCount;
 }
 
 bool CollisionCallback(void* user_data_a, uint16_t group_a, void* user_data_b, uint16_t group_b, void* user_data)
@@ -2226,6 +2230,96 @@ TYPED_TEST(PhysicsTest, DisabledFromStart)
     (*TestFixture::m_Test.m_DeleteCollisionShapeFunc)(shape);
 }
 
+// Steps a world with a number of separate box stacks (i.e. separate islands), and returns the final positions
+static void SimulateStacks3D(uint32_t worker_thread_count, uint32_t stack_count, std::vector<Point3>& out_positions)
+{
+    const uint32_t stack_height = 4;
+
+    dmPhysics::NewContextParams context_params;
+    context_params.m_Scale = PHYSICS_SCALE;
+    context_params.m_RayCastLimit3D = 128;
+    context_params.m_TriggerOverlapCapacity = 16;
+    context_params.m_WorkerThreadCount3D = worker_thread_count;
+    dmPhysics::HContext3D context = dmPhysics::NewContext3D(context_params);
+
+    dmPhysics::NewWorldParams world_params;
+    world_params.m_GetWorldTransformCallback = GetWorldTransform;
+    world_params.m_SetWorldTransformCallback = SetWorldTransform;
+    world_params.m_MaxCollisionObjectsCount = 1024;
+    dmPhysics::HWorld3D world = dmPhysics::NewWorld3D(context, world_params);
+
+    dmPhysics::HCollisionShape3D ground_shape = dmPhysics::NewBoxShape3D(context, Vector3(200.0f, 1.0f, 200.0f));
+    dmPhysics::HCollisionShape3D box_shape = dmPhysics::NewBoxShape3D(context, Vector3(0.5f, 0.5f, 0.5f));
+
+    VisualObject ground;
+    ground.m_Position = Point3(0.0f, -1.0f, 0.0f);
+    dmPhysics::CollisionObjectData data;
+    data.m_Type = dmPhysics::COLLISION_OBJECT_TYPE_STATIC;
+    data.m_Mass = 0.0f;
+    data.m_UserData = &ground;
+    dmPhysics::HCollisionObject3D ground_co = dmPhysics::NewCollisionObject3D(world, data, &ground_shape, 1u);
+
+    std::vector<VisualObject> boxes(stack_count * stack_height);
+    std::vector<dmPhysics::HCollisionObject3D> box_cos(boxes.size());
+    data.m_Type = dmPhysics::COLLISION_OBJECT_TYPE_DYNAMIC;
+    data.m_Mass = 1.0f;
+    for (uint32_t i = 0; i < boxes.size(); ++i)
+    {
+        uint32_t stack = i / stack_height;
+        uint32_t level = i % stack_height;
+        // Slightly offset each level, so that the stacks topple in different ways
+        boxes[i].m_Position = Point3(-100.0f + (stack % 16) * 12.0f + level * 0.1f * (stack % 3), 0.6f + level * 1.1f, -100.0f + (stack / 16) * 12.0f);
+        data.m_UserData = &boxes[i];
+        box_cos[i] = dmPhysics::NewCollisionObject3D(world, data, &box_shape, 1u);
+    }
+
+    dmPhysics::StepWorldContext step_context;
+    step_context.m_DT = 1.0f / 60.0f;
+    step_context.m_MaxFixedTimeSteps = 1;
+    for (uint32_t i = 0; i < 180; ++i)
+    {
+        dmPhysics::StepWorld3D(world, step_context);
+    }
+
+    out_positions.clear();
+    for (uint32_t i = 0; i < boxes.size(); ++i)
+    {
+        out_positions.push_back(boxes[i].m_Position);
+        dmPhysics::DeleteCollisionObject3D(world, box_cos[i]);
+    }
+    dmPhysics::DeleteCollisionObject3D(world, ground_co);
+    dmPhysics::DeleteCollisionShape3D(box_shape);
+    dmPhysics::DeleteCollisionShape3D(ground_shape);
+    dmPhysics::DeleteWorld3D(context, world);
+    dmPhysics::DeleteContext3D(context);
+}
+
+// Solving the islands on worker threads must give the same result as solving them on the main thread
+TEST(Physics3D, ParallelIslands)
+{
+    const uint32_t stack_count = 128;
+    std::vector<Point3> expected;
+    std::vector<Point3> actual;
+
+    uint64_t start = dmTime::GetTime();
+    SimulateStacks3D(0, stack_count, expected);
+    uint64_t single_time = dmTime::GetTime() - start;
+
+    start = dmTime::GetTime();
+    SimulateStacks3D(4, stack_count, actual);
+    uint64_t parallel_time = dmTime::GetTime() - start;
+
+    printf("%u stacks: %.2f ms single threaded, %.2f ms with 4 workers\n", stack_count, single_time / 1000.0f, parallel_time / 1000.0f);
+
+    ASSERT_EQ(expected.size(), actual.size());
+    for (uint32_t i = 0; i < expected.size(); ++i)
+    {
+        ASSERT_EQ(expected[i].getX(), actual[i].getX());
+        ASSERT_EQ(expected[i].getY(), actual[i].getY());
+        ASSERT_EQ(expected[i].getZ(), actual[i].getZ());
+    }
+}
+
 int main(int argc, char **argv)
 {
     jc_test_init(&argc, argv);
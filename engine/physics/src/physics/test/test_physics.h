@@ -32,6 +32,7 @@ struct VisualObject
     float                   m_Scale;
     int                     m_CollisionCount;
     uint16_t                m_FirstCollisionGroup;
+    uint32_t                m_SetWorldTransformCount;
 };
 
 void GetWorldTransform(void* visual_object, dmTransform::Transform& world_transform);
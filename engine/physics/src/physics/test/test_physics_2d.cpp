@@ -34,6 +34,7 @@ VisualObject::VisualObject()
 , m_Scale(1.0f)
 , m_CollisionCount(0)
 , m_FirstCollisionGroup(0)
+, m_SetWorldTransformCount(0)
 {
 
 }
@@ -59,6 +60,7 @@ void SetWorldTransform(void* visual_object, const dmVMath::Point3& position, con
     VisualObject* o = (VisualObject*) visual_object;
     o->m_Position = position;
     o->m_Rotation = rotation;
+    ++o->m_SetWorldTransformCount;
 }
 
 bool CollisionCallback(void* user_data_a, uint16_t group_a, void* user_data_b, uint16_t group_b, void* user_data)
@@ -1842,6 +1844,104 @@ TYPED_TEST(PhysicsTest, ScriptApiBox2D)
     (*TestFixture::m_Test.m_DeleteCollisionObjectFunc)(TestFixture::m_World, dynamic_co);
 }
 
+// Sleeping bodies shouldn't be synchronized with the game world, and removing bodies
+// from the middle of the transform sync lists must keep the other bodies synchronized.
+// A game object moved while its body sleeps keeps its position until the body wakes up.
+TYPED_TEST(PhysicsTest, SleepingBodiesSync)
+{
+    const uint32_t count = 20000;
+    std::vector<VisualObject> objects(count);
+    std::vector<typename TypeParam::CollisionObjectType> cos(count);
+
+    typename TypeParam::CollisionShapeType shape = (*TestFixture::m_Test.m_NewBoxShapeFunc)(TestFixture::m_Context, dmVMath::Vector3(0.5f, 0.5f, 0.0f));
+
+    dmPhysics::CollisionObjectData data;
+    data.m_Type = dmPhysics::COLLISION_OBJECT_TYPE_STATIC;
+    data.m_Mass = 0.0f;
+    VisualObject ground;
+    ground.m_Scale = 2.0f * (count + 10);
+    ground.m_Position = dmVMath::Point3(0.0f, -(count + 10.0f), 0.0f);
+    data.m_UserData = &ground;
+    typename TypeParam::CollisionObjectType ground_co = (*TestFixture::m_Test.m_NewCollisionObjectFunc)(TestFixture::m_World, data, &shape, 1u);
+
+    // A row of resting boxes that fall asleep
+    data.m_Type = dmPhysics::COLLISION_OBJECT_TYPE_DYNAMIC;
+    data.m_Mass = 1.0f;
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        objects[i].m_Position = dmVMath::Point3(2.0f * i - count, 0.5f, 0.0f);
+        data.m_UserData = &objects[i];
+        cos[i] = (*TestFixture::m_Test.m_NewCollisionObjectFunc)(TestFixture::m_World, data, &shape, 1u);
+    }
+
+    // Remove every 7th body, to shuffle the sync lists
+    for (uint32_t i = 0; i < count; i += 7)
+    {
+        (*TestFixture::m_Test.m_DeleteCollisionObjectFunc)(TestFixture::m_World, cos[i]);
+        cos[i] = 0;
+    }
+
+    // Let the boxes settle and fall asleep
+    for (uint32_t i = 0; i < 300; ++i)
+    {
+        (*TestFixture::m_Test.m_StepWorldFunc)(TestFixture::m_World, TestFixture::m_StepWorldContext);
+    }
+
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        if (cos[i])
+        {
+            ASSERT_TRUE(dmPhysics::IsSleeping2D(cos[i]));
+            dmVMath::Point3 p = (*TestFixture::m_Test.m_GetWorldPositionFunc)(TestFixture::m_Context, cos[i]);
+            ASSERT_NEAR(p.getY(), objects[i].m_Position.getY(), 0.001f);
+            objects[i].m_SetWorldTransformCount = 0;
+        }
+    }
+
+    // No transforms are written back while all bodies sleep
+    for (uint32_t i = 0; i < 100; ++i)
+    {
+        (*TestFixture::m_Test.m_StepWorldFunc)(TestFixture::m_World, TestFixture::m_StepWorldContext);
+    }
+
+    uint32_t set_count = 0;
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        set_count += objects[i].m_SetWorldTransformCount;
+    }
+    ASSERT_EQ(0u, set_count);
+
+    // Moving the game object of a sleeping body isn't reverted by the simulation
+    dmVMath::Point3 body_position = objects[2].m_Position;
+    objects[2].m_Position.setX(body_position.getX() + 0.5f);
+    (*TestFixture::m_Test.m_StepWorldFunc)(TestFixture::m_World, TestFixture::m_StepWorldContext);
+    ASSERT_EQ(0u, objects[2].m_SetWorldTransformCount);
+    ASSERT_NEAR(body_position.getX() + 0.5f, objects[2].m_Position.getX(), 0.001f);
+
+    // Waking a body synchronizes it again, but only that body
+    dmPhysics::Wakeup2D(cos[1]);
+    dmPhysics::Wakeup2D(cos[2]);
+    (*TestFixture::m_Test.m_StepWorldFunc)(TestFixture::m_World, TestFixture::m_StepWorldContext);
+    ASSERT_EQ(1u, objects[1].m_SetWorldTransformCount);
+    ASSERT_EQ(1u, objects[2].m_SetWorldTransformCount);
+    ASSERT_NEAR(body_position.getX(), objects[2].m_Position.getX(), 0.001f);
+
+    set_count = 0;
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        set_count += objects[i].m_SetWorldTransformCount;
+    }
+    ASSERT_EQ(2u, set_count);
+
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        if (cos[i])
+            (*TestFixture::m_Test.m_DeleteCollisionObjectFunc)(TestFixture::m_World, cos[i]);
+    }
+    (*TestFixture::m_Test.m_DeleteCollisionObjectFunc)(TestFixture::m_World, ground_co);
+    (*TestFixture::m_Test.m_DeleteCollisionShapeFunc)(shape);
+}
+
 int main(int argc, char **argv)
 {
     jc_test_init(&argc, argv);
@@ -14,10 +14,15 @@
 
 #include "profiler.h"
 
+#include <string.h>
+
 #include <dlib/dlib.h>
+#include <dlib/dstrings.h>
 #include <dlib/hash.h>
 #include <dlib/log.h>
+#include <dlib/math.h>
 #include <dlib/profile.h>
+#include <dlib/spinlock.h>
 #include <dlib/time.h>
 
 #include <render/render.h>
@@ -25,6 +30,7 @@
 
 #include "profiler_private.h"
 #include "profile_render.h"
+#include "profiler_trace.h"
 
 #include <algorithm> // std::sort
 
@@ -57,6 +63,20 @@ static dmProfileRender::ProfilerFrame*  g_ProfilerCurrentFrame = 0;
 static dmMutex::HMutex                  g_ProfilerMutex = 0;
 static dmHashTable64<int>               g_ProfilerThreadSortOrder;
 
+// Trace capture, see profiler_trace.h.
+// g_Trace is only opened and closed on the main thread, while holding g_TraceMutex. The profiler thread
+// holds g_TraceMutex while it uses the trace, so the main thread never waits for it except when opening or closing.
+static dmMutex::HMutex                          g_TraceMutex = 0;
+static dmProfilerTrace::HTrace                  g_Trace = 0;
+static char                                     g_TracePath[1024] = {0};
+static uint32_t                                 g_TraceStartFrame = 0;
+static uint32_t                                 g_TraceFrameCount = 0; // 0 means until the app exits
+static uint32_t                                 g_TraceFrame = 0;
+static uint64_t                                 g_TraceFrameEnd = 0; // End time of the latest main thread samples
+static dmSpinlock::Spinlock                     g_TraceFrameEndLock;
+static dmArray<dmProfilerTrace::TraceSample>    g_TraceSamples;
+static dmArray<dmProfilerTrace::TraceProperty>  g_TraceProperties;
+
 
 void SetUpdateFrequency(uint32_t update_frequency)
 {
@@ -573,11 +593,62 @@ static void TraverseSampleTree(dmProfileRender::ProfilerThread* thread, int inde
     }
 }
 
+static uint64_t TraceSampleTree(dmProfile::HSample sample)
+{
+    const char* name = dmProfile::SampleGetName(sample);
+    name = name ? name : "<empty_sample_name>";
+
+    dmProfilerTrace::TraceSample out;
+    out.m_NameHash = dmHashString32(name);
+    out.m_CallCount = dmProfile::SampleGetCallCount(sample);
+    out.m_Start = dmProfile::SampleGetStart(sample);
+    out.m_Time = dmProfile::SampleGetTime(sample);
+    dmProfilerTrace::WriteName(g_Trace, out.m_NameHash, name);
+
+    if (g_TraceSamples.Full())
+        g_TraceSamples.OffsetCapacity(256);
+    g_TraceSamples.Push(out);
+
+    uint64_t end = out.m_Start + out.m_Time;
+
+    dmProfile::SampleIterator iter;
+    dmProfile::SampleIterateChildren(sample, &iter);
+    while (dmProfile::SampleIterateNext(&iter))
+    {
+        end = dmMath::Max(end, TraceSampleTree(iter.m_Sample));
+    }
+    return end;
+}
+
+// Called on the profiler thread, which also does the file writes, so that the threads being traced only pay for the sampling
+static void TraceThread(const char* thread_name, dmProfile::HSample root)
+{
+    DM_MUTEX_SCOPED_LOCK(g_TraceMutex);
+    if (!g_Trace)
+        return;
+
+    uint32_t thread_name_hash = dmHashString32(thread_name);
+    dmProfilerTrace::WriteName(g_Trace, thread_name_hash, thread_name);
+
+    g_TraceSamples.SetSize(0);
+    uint64_t end = TraceSampleTree(root);
+    dmProfilerTrace::WriteSamples(g_Trace, thread_name_hash, g_TraceSamples.Begin(), g_TraceSamples.Size());
+
+    if (strcmp(thread_name, "Main") == 0)
+    {
+        DM_SPINLOCK_SCOPED_LOCK(g_TraceFrameEndLock);
+        g_TraceFrameEnd = end;
+    }
+}
+
 static void SampleTreeCallback(void* _ctx, const char* thread_name, dmProfile::HSample root)
 {
     if (g_ProfilerCurrentFrame == 0) // Possibly in the process of shutting down
         return;
 
+    if (g_Trace) // Checked again while holding the lock
+        TraceThread(thread_name, root);
+
     // TODO: Make a better selection scheme, letting the user step through the threads one by one
     if (strcmp(thread_name, "Main") != 0)
         return;
@@ -628,18 +699,108 @@ static void TraversePropertyTree(dmProfileRender::ProfilerFrame* frame, int inde
     }
 }
 
+static void TracePropertyTree(dmProfile::HProperty property)
+{
+    dmProfile::PropertyType type = dmProfile::PropertyGetType(property);
+    if (type != dmProfile::PROPERTY_TYPE_GROUP)
+    {
+        const char* name = dmProfile::PropertyGetName(property);
+        name = name ? name : "<empty_property_name>";
+        dmProfile::PropertyValue value = dmProfile::PropertyGetValue(property);
+
+        dmProfilerTrace::TraceProperty out;
+        out.m_NameHash = dmHashString32(name);
+        out.m_Type = (uint32_t)type;
+        out.m_Value = 0;
+        memcpy(&out.m_Value, &value, sizeof(out.m_Value));
+        dmProfilerTrace::WriteName(g_Trace, out.m_NameHash, name);
+
+        if (g_TraceProperties.Full())
+            g_TraceProperties.OffsetCapacity(64);
+        g_TraceProperties.Push(out);
+    }
+
+    dmProfile::PropertyIterator iter;
+    dmProfile::PropertyIterateChildren(property, &iter);
+    while (dmProfile::PropertyIterateNext(&iter))
+    {
+        TracePropertyTree(iter.m_Property);
+    }
+}
+
 static void PropertyTreeCallback(void* _ctx, dmProfile::HProperty root)
 {
     if (g_ProfilerCurrentFrame == 0) // Possibly in the process of shutting down
         return;
 
-    DM_MUTEX_SCOPED_LOCK(g_ProfilerMutex);
-
     dmProfile::PropertyIterator iter;
-    dmProfile::PropertyIterateChildren(root, &iter);
-    while (dmProfile::PropertyIterateNext(&iter))
     {
-        TraversePropertyTree(g_ProfilerCurrentFrame, 0, iter.m_Property);
+        DM_MUTEX_SCOPED_LOCK(g_ProfilerMutex);
+
+        dmProfile::PropertyIterateChildren(root, &iter);
+        while (dmProfile::PropertyIterateNext(&iter))
+        {
+            TraversePropertyTree(g_ProfilerCurrentFrame, 0, iter.m_Property);
+        }
+    }
+
+    // The snapshot is taken on the main thread at the end of the frame. Since the main thread samples
+    // arrive asynchronously, the values are stamped with the end time of the latest main thread frame.
+    // The trace is only closed on this thread, and buffers the records without waiting for the file writes.
+    if (g_Trace)
+    {
+        g_TraceProperties.SetSize(0);
+        dmProfile::PropertyIterateChildren(root, &iter);
+        while (dmProfile::PropertyIterateNext(&iter))
+        {
+            TracePropertyTree(iter.m_Property);
+        }
+
+        uint64_t frame_end;
+        {
+            DM_SPINLOCK_SCOPED_LOCK(g_TraceFrameEndLock);
+            frame_end = g_TraceFrameEnd;
+        }
+        dmProfilerTrace::WriteProperties(g_Trace, frame_end, g_TraceProperties.Begin(), g_TraceProperties.Size());
+    }
+}
+
+static void StartTrace()
+{
+    DM_MUTEX_SCOPED_LOCK(g_TraceMutex);
+    g_Trace = dmProfilerTrace::Open(g_TracePath, dmProfile::GetTicksPerSecond());
+    if (g_Trace)
+    {
+        dmLogInfo("Started profiler trace '%s'", g_TracePath);
+    }
+}
+
+static void StopTrace()
+{
+    DM_MUTEX_SCOPED_LOCK(g_TraceMutex);
+    if (g_Trace)
+    {
+        uint64_t size = dmProfilerTrace::GetSize(g_Trace);
+        dmProfilerTrace::Close(g_Trace);
+        g_Trace = 0;
+        dmLogInfo("Stopped profiler trace '%s' (%u kb)", g_TracePath, (uint32_t)(size / 1024));
+    }
+}
+
+static void UpdateTrace()
+{
+    if (g_TracePath[0] == 0 || g_ProfilerCurrentFrame == 0)
+        return;
+
+    uint32_t frame = g_TraceFrame++;
+    if (frame == g_TraceStartFrame)
+    {
+        StartTrace();
+    }
+    else if (g_TraceFrameCount != 0 && frame == g_TraceStartFrame + g_TraceFrameCount)
+    {
+        StopTrace();
+        g_TracePath[0] = 0;
     }
 }
 
@@ -709,6 +870,8 @@ static dmExtension::Result UpdateProfiler(dmExtension::Params* params)
 
     dmProfilerExt::UpdatePlatformProfiler();
 
+    UpdateTrace();
+
     return dmExtension::RESULT_OK;
 }
 
@@ -737,6 +900,10 @@ static dmExtension::Result AppInitializeProfiler(dmExtension::AppParams* params)
 
     if (!dmProfile::IsInitialized()) // We might use the null implementation
     {
+        if (dmConfigFile::GetString(params->m_ConfigFile, "profiler.trace_file", 0) != 0)
+        {
+            dmLogWarning("Profiler traces are only available in debug builds");
+        }
         delete g_ProfilerCurrentFrame;
         g_ProfilerCurrentFrame = 0;
         return dmExtension::RESULT_OK;
@@ -744,12 +911,24 @@ static dmExtension::Result AppInitializeProfiler(dmExtension::AppParams* params)
 
     // Note that the callback might come from a different thread!
     g_ProfilerMutex = dmMutex::New();
+    g_TraceMutex = dmMutex::New();
+    dmSpinlock::Create(&g_TraceFrameEndLock);
 
     g_ProfilerThreadSortOrder.SetCapacity(7, 8);
     g_ProfilerThreadSortOrder.Put(dmHashString64("Main"), 0);
     g_ProfilerThreadSortOrder.Put(dmHashString64("sound"), 1);
     g_ProfilerThreadSortOrder.Put(dmHashString64("liveupdate"), 2);
 
+    // E.g. --config=profiler.trace_file=game.dmtrace --config=profiler.trace_start_frame=60 --config=profiler.trace_frame_count=600
+    const char* trace_path = dmConfigFile::GetString(params->m_ConfigFile, "profiler.trace_file", 0);
+    if (trace_path && trace_path[0] != 0)
+    {
+        dmStrlCpy(g_TracePath, trace_path, sizeof(g_TracePath));
+        g_TraceStartFrame = (uint32_t)dmConfigFile::GetInt(params->m_ConfigFile, "profiler.trace_start_frame", 0);
+        g_TraceFrameCount = (uint32_t)dmConfigFile::GetInt(params->m_ConfigFile, "profiler.trace_frame_count", 0);
+        g_TraceFrame = 0;
+    }
+
     return dmExtension::RESULT_OK;
 }
 
@@ -764,6 +943,9 @@ static dmExtension::Result AppFinalizeProfiler(dmExtension::AppParams* params)
     dmProfile::SetPropertyTreeCallback(0, 0);
     dmProfile::Finalize();
 
+    StopTrace();
+    g_TracePath[0] = 0;
+
     if (g_ProfilerCurrentFrame)
     {
         DM_MUTEX_SCOPED_LOCK(g_ProfilerMutex);
@@ -772,6 +954,9 @@ static dmExtension::Result AppFinalizeProfiler(dmExtension::AppParams* params)
     }
     dmMutex::Delete(g_ProfilerMutex);
     g_ProfilerMutex = 0;
+    dmMutex::Delete(g_TraceMutex);
+    g_TraceMutex = 0;
+    dmSpinlock::Destroy(&g_TraceFrameEndLock);
 
     return dmExtension::RESULT_OK;
 }
@@ -0,0 +1,168 @@
+// Copyright 2020-2024 The Defold Foundation
+// Copyright 2014-2020 King
+// Copyright 2009-2014 Ragnar Svensson, Christian Murray
+// Licensed under the Defold License version 1.0 (the "License"); you may not use
+// this file except in compliance with the License.
+//
+// You may obtain a copy of the License, together with FAQs at
+// https://www.defold.com/license
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include "profiler_trace.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include <dlib/array.h>
+#include <dlib/hashtable.h>
+#include <dlib/log.h>
+#include <dlib/mutex.h>
+#include <dlib/static_assert.h>
+
+namespace dmProfilerTrace
+{
+    // The buffered records are written to the file when the buffer grows beyond this size
+    static const uint32_t FLUSH_SIZE = 64 * 1024;
+
+    DM_STATIC_ASSERT(sizeof(TraceHeader) == 16, Invalid_Struct_Size);
+    DM_STATIC_ASSERT(sizeof(RecordHeader) == 16, Invalid_Struct_Size);
+    DM_STATIC_ASSERT(sizeof(TraceSample) == 24, Invalid_Struct_Size);
+    DM_STATIC_ASSERT(sizeof(TraceProperty) == 16, Invalid_Struct_Size);
+
+    struct Trace
+    {
+        FILE*               m_File;
+        dmMutex::HMutex     m_Mutex;        // Protects the records being buffered, not the file
+        dmArray<uint8_t>    m_Buffer;
+        dmArray<uint8_t>    m_FlushBuffer;  // Swapped with m_Buffer, and written to the file outside of the lock
+        dmHashTable32<bool> m_Names;
+        uint64_t            m_Written;
+    };
+
+    // The caller holds the trace mutex
+    static void WriteData(HTrace trace, const void* data, uint32_t size)
+    {
+        if (trace->m_Buffer.Remaining() < size)
+        {
+            trace->m_Buffer.OffsetCapacity(size + FLUSH_SIZE / 4);
+        }
+        trace->m_Buffer.PushArray((const uint8_t*)data, size);
+    }
+
+    static void WriteRecordHeader(HTrace trace, RecordType type, uint32_t count, uint64_t value)
+    {
+        RecordHeader header;
+        header.m_Type = type;
+        header.m_Count = count;
+        header.m_Value = value;
+        WriteData(trace, &header, sizeof(header));
+    }
+
+    HTrace Open(const char* path, uint64_t ticks_per_second)
+    {
+        FILE* file = fopen(path, "wb");
+        if (!file)
+        {
+            dmLogError("Failed to open trace file '%s'", path);
+            return 0;
+        }
+
+        Trace* trace = new Trace;
+        trace->m_File = file;
+        trace->m_Mutex = dmMutex::New();
+        trace->m_Written = 0;
+        trace->m_Buffer.SetCapacity(FLUSH_SIZE + FLUSH_SIZE / 4);
+        trace->m_FlushBuffer.SetCapacity(FLUSH_SIZE + FLUSH_SIZE / 4);
+        trace->m_Names.SetCapacity(256, 384);
+
+        TraceHeader header;
+        memcpy(header.m_Magic, "DMTR", sizeof(header.m_Magic));
+        header.m_Version = TRACE_VERSION;
+        header.m_TicksPerSecond = ticks_per_second;
+        WriteData(trace, &header, sizeof(header));
+        return trace;
+    }
+
+    void Close(HTrace trace)
+    {
+        Flush(trace);
+        fclose(trace->m_File);
+        dmMutex::Delete(trace->m_Mutex);
+        delete trace;
+    }
+
+    void WriteName(HTrace trace, uint32_t name_hash, const char* name)
+    {
+        DM_MUTEX_SCOPED_LOCK(trace->m_Mutex);
+        if (trace->m_Names.Get(name_hash))
+        {
+            return;
+        }
+
+        if (trace->m_Names.Full())
+        {
+            uint32_t capacity = trace->m_Names.Capacity() * 2;
+            trace->m_Names.SetCapacity((capacity * 2) / 3, capacity);
+        }
+        trace->m_Names.Put(name_hash, true);
+
+        uint32_t length = (uint32_t)strlen(name);
+        WriteRecordHeader(trace, RECORD_TYPE_NAME, length, name_hash);
+        WriteData(trace, name, length);
+    }
+
+    void WriteSamples(HTrace trace, uint32_t thread_name_hash, const TraceSample* samples, uint32_t count)
+    {
+        bool flush;
+        {
+            DM_MUTEX_SCOPED_LOCK(trace->m_Mutex);
+            WriteRecordHeader(trace, RECORD_TYPE_SAMPLES, count, thread_name_hash);
+            WriteData(trace, samples, count * sizeof(TraceSample));
+            flush = trace->m_Buffer.Size() >= FLUSH_SIZE;
+        }
+
+        if (flush)
+        {
+            Flush(trace);
+        }
+    }
+
+    void WriteProperties(HTrace trace, uint64_t time, const TraceProperty* properties, uint32_t count)
+    {
+        DM_MUTEX_SCOPED_LOCK(trace->m_Mutex);
+        WriteRecordHeader(trace, RECORD_TYPE_PROPERTIES, count, time);
+        WriteData(trace, properties, count * sizeof(TraceProperty));
+    }
+
+    void Flush(HTrace trace)
+    {
+        {
+            DM_MUTEX_SCOPED_LOCK(trace->m_Mutex);
+            trace->m_Buffer.Swap(trace->m_FlushBuffer);
+            trace->m_Written += trace->m_FlushBuffer.Size();
+        }
+
+        // The other threads keep writing records to the swapped in buffer meanwhile
+        uint32_t size = trace->m_FlushBuffer.Size();
+        if (size == 0)
+        {
+            return;
+        }
+
+        if (fwrite(trace->m_FlushBuffer.Begin(), 1, size, trace->m_File) != size)
+        {
+            dmLogError("Failed to write %u bytes to the trace file", size);
+        }
+        trace->m_FlushBuffer.SetSize(0);
+    }
+
+    uint64_t GetSize(HTrace trace)
+    {
+        DM_MUTEX_SCOPED_LOCK(trace->m_Mutex);
+        return trace->m_Written + trace->m_Buffer.Size();
+    }
+}
@@ -0,0 +1,134 @@
+// Copyright 2020-2024 The Defold Foundation
+// Copyright 2014-2020 King
+// Copyright 2009-2014 Ragnar Svensson, Christian Murray
+// Licensed under the Defold License version 1.0 (the "License"); you may not use
+// this file except in compliance with the License.
+//
+// You may obtain a copy of the License, together with FAQs at
+// https://www.defold.com/license
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#ifndef DM_PROFILER_TRACE_H
+#define DM_PROFILER_TRACE_H
+
+#include <stdint.h>
+
+/**
+ * Binary trace file writer for long profiler captures.
+ *
+ * The file starts with a TraceHeader, followed by records. Each record starts with a
+ * RecordHeader, followed by its payload:
+ *
+ *   RECORD_TYPE_NAME       m_Value: name hash, payload: m_Count bytes of name (not null terminated)
+ *   RECORD_TYPE_SAMPLES    m_Value: thread name hash, payload: m_Count TraceSample
+ *   RECORD_TYPE_PROPERTIES m_Value: time in ticks, payload: m_Count TraceProperty
+ *
+ * All values are little endian. The names are written once, before the first record referring to them.
+ *
+ * The records may be written from several threads. Flush(), Close() and WriteSamples() (which flushes
+ * when the buffer is full) must not be called concurrently with each other, since they write to the file.
+ * The file is written outside of the lock protecting the records, so other threads never wait for it.
+ * Use profiler_trace.py to convert a trace to the Chrome trace event format (also read by Perfetto).
+ */
+namespace dmProfilerTrace
+{
+    typedef struct Trace* HTrace;
+
+    static const uint32_t TRACE_VERSION = 1;
+
+    enum RecordType
+    {
+        RECORD_TYPE_NAME        = 1,
+        RECORD_TYPE_SAMPLES     = 2,
+        RECORD_TYPE_PROPERTIES  = 3,
+    };
+
+    struct TraceHeader
+    {
+        char     m_Magic[4]; // "DMTR"
+        uint32_t m_Version;
+        uint64_t m_TicksPerSecond;
+    };
+
+    struct RecordHeader
+    {
+        uint32_t m_Type;
+        uint32_t m_Count;
+        uint64_t m_Value;
+    };
+
+    struct TraceSample
+    {
+        uint32_t m_NameHash;
+        uint32_t m_CallCount;
+        uint64_t m_Start;   // in ticks
+        uint64_t m_Time;    // in ticks
+    };
+
+    struct TraceProperty
+    {
+        uint32_t m_NameHash;
+        uint32_t m_Type;    // dmProfile::PropertyType
+        uint64_t m_Value;   // dmProfile::PropertyValue
+    };
+
+    /**
+     * Create a new trace file
+     * @param path path of the trace file
+     * @param ticks_per_second resolution of the sample times
+     * @return trace handle, or 0 if the file couldn't be opened
+     */
+    HTrace Open(const char* path, uint64_t ticks_per_second);
+
+    /**
+     * Flush and close the trace file
+     * @param trace trace handle
+     */
+    void Close(HTrace trace);
+
+    /**
+     * Write a name, unless it has been written before
+     * @param trace trace handle
+     * @param name_hash 32 bit hash of the name
+     * @param name the name
+     */
+    void WriteName(HTrace trace, uint32_t name_hash, const char* name);
+
+    /**
+     * Write the samples of a thread. Flushes the buffered records to the file when the buffer is full.
+     * @param trace trace handle
+     * @param thread_name_hash 32 bit hash of the thread name
+     * @param samples the samples
+     * @param count number of samples
+     */
+    void WriteSamples(HTrace trace, uint32_t thread_name_hash, const TraceSample* samples, uint32_t count);
+
+    /**
+     * Write a snapshot of property values. Never writes to the file, so it is cheap to call
+     * from the main thread, even while another thread flushes. The records are flushed with the next samples.
+     * @param trace trace handle
+     * @param time time of the snapshot in ticks
+     * @param properties the property values
+     * @param count number of properties
+     */
+    void WriteProperties(HTrace trace, uint64_t time, const TraceProperty* properties, uint32_t count);
+
+    /**
+     * Write the buffered records to the file
+     * @param trace trace handle
+     */
+    void Flush(HTrace trace);
+
+    /**
+     * Get the number of bytes written to the file, including the buffered records
+     * @param trace trace handle
+     * @return number of bytes
+     */
+    uint64_t GetSize(HTrace trace);
+}
+
+#endif // DM_PROFILER_TRACE_H
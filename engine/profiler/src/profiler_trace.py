@@ -0,0 +1,124 @@
+# Copyright 2020-2024 The Defold Foundation
+# Copyright 2014-2020 King
+# Copyright 2009-2014 Ragnar Svensson, Christian Murray
+# Licensed under the Defold License version 1.0 (the "License"); you may not use
+# this file except in compliance with the License.
+#
+# You may obtain a copy of the License, together with FAQs at
+# https://www.defold.com/license
+#
+# Unless required by applicable law or agreed to in writing, software distributed
+# under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+# CONDITIONS OF ANY KIND, either express or implied. See the License for the
+# specific language governing permissions and limitations under the License.
+
+# Converts a profiler trace (see profiler_trace.h) to the Chrome trace event format,
+# which can be opened in chrome://tracing or https://ui.perfetto.dev
+#
+# Usage: python profiler_trace.py game.dmtrace game.json
+
+import sys, struct, json
+
+TRACE_VERSION = 1
+
+RECORD_TYPE_NAME = 1
+RECORD_TYPE_SAMPLES = 2
+RECORD_TYPE_PROPERTIES = 3
+
+# dmProfile::PropertyType
+PROPERTY_TYPE_BOOL = 1
+PROPERTY_TYPE_S32 = 2
+PROPERTY_TYPE_U32 = 3
+PROPERTY_TYPE_F32 = 4
+PROPERTY_TYPE_S64 = 5
+PROPERTY_TYPE_U64 = 6
+PROPERTY_TYPE_F64 = 7
+
+PROPERTY_FORMATS = {
+    PROPERTY_TYPE_BOOL: '<?7x',
+    PROPERTY_TYPE_S32: '<i4x',
+    PROPERTY_TYPE_U32: '<I4x',
+    PROPERTY_TYPE_F32: '<f4x',
+    PROPERTY_TYPE_S64: '<q',
+    PROPERTY_TYPE_U64: '<Q',
+    PROPERTY_TYPE_F64: '<d',
+}
+
+HEADER = struct.Struct('<4sIQ')
+RECORD_HEADER = struct.Struct('<IIQ')
+SAMPLE = struct.Struct('<IIQQ')
+PROPERTY = struct.Struct('<II8s')
+
+PID = 1
+
+def property_name(name):
+    if name.startswith('rmtp_'):
+        return name[len('rmtp_'):]
+    return name
+
+def convert(data):
+    magic, version, ticks_per_second = HEADER.unpack_from(data, 0)
+    if magic != b'DMTR':
+        raise Exception('Not a profiler trace')
+    if version != TRACE_VERSION:
+        raise Exception('Unsupported trace version %d' % version)
+
+    # The trace event timestamps are in microseconds
+    us_per_tick = 1000000.0 / ticks_per_second
+
+    names = {}
+    threads = {}
+    events = []
+    offset = HEADER.size
+    while offset + RECORD_HEADER.size <= len(data):
+        record_type, count, value = RECORD_HEADER.unpack_from(data, offset)
+        offset += RECORD_HEADER.size
+
+        if record_type == RECORD_TYPE_NAME:
+            names[value] = data[offset:offset+count].decode('utf-8', 'replace')
+            offset += count
+
+        elif record_type == RECORD_TYPE_SAMPLES:
+            thread_name = names.get(value, '%08x' % value)
+            if value not in threads:
+                threads[value] = len(threads) + 1
+                events.append({'ph': 'M', 'pid': PID, 'tid': threads[value], 'name': 'thread_name', 'args': {'name': thread_name}})
+            tid = threads[value]
+
+            for i in range(count):
+                name_hash, call_count, start, time = SAMPLE.unpack_from(data, offset)
+                offset += SAMPLE.size
+                events.append({'ph': 'X', 'pid': PID, 'tid': tid,
+                               'name': names.get(name_hash, '%08x' % name_hash),
+                               'ts': start * us_per_tick, 'dur': time * us_per_tick,
+                               'args': {'count': call_count}})
+
+        elif record_type == RECORD_TYPE_PROPERTIES:
+            ts = value * us_per_tick
+            for i in range(count):
+                name_hash, property_type, raw = PROPERTY.unpack_from(data, offset)
+                offset += PROPERTY.size
+                fmt = PROPERTY_FORMATS.get(property_type)
+                if fmt is None:
+                    continue
+                v = struct.unpack(fmt, raw)[0]
+                name = property_name(names.get(name_hash, '%08x' % name_hash))
+                events.append({'ph': 'C', 'pid': PID, 'name': name, 'ts': ts, 'args': {name: int(v) if property_type == PROPERTY_TYPE_BOOL else v}})
+
+        else:
+            raise Exception('Unknown record type %d at offset %d' % (record_type, offset - RECORD_HEADER.size))
+
+    return {'traceEvents': events, 'displayTimeUnit': 'ms'}
+
+if __name__ == '__main__':
+    if len(sys.argv) < 3:
+        print ('Usage: %s <trace file> <json file>' % sys.argv[0])
+        sys.exit(5)
+
+    with open(sys.argv[1], 'rb') as f:
+        trace = convert(f.read())
+
+    with open(sys.argv[2], 'w') as f:
+        json.dump(trace, f)
+
+    print ('Wrote %d events to %s' % (len(trace['traceEvents']), sys.argv[2]))
@@ -0,0 +1,294 @@
+// Copyright 2020-2024 The Defold Foundation
+// Copyright 2014-2020 King
+// Copyright 2009-2014 Ragnar Svensson, Christian Murray
+// Licensed under the Defold License version 1.0 (the "License"); you may not use
+// this file except in compliance with the License.
+//
+// You may obtain a copy of the License, together with FAQs at
+// https://www.defold.com/license
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <dlib/atomic.h>
+#include <dlib/dstrings.h>
+#include <dlib/hash.h>
+#include <dlib/path.h>
+#include <dlib/profile.h>
+#include <dlib/sys.h>
+#include <dlib/testutil.h>
+#include <dlib/thread.h>
+#include <dlib/time.h>
+
+#define JC_TEST_IMPLEMENTATION
+#include <jc_test/jc_test.h>
+
+#define HAS_SYSTEM_FUNCTION
+#if defined(DM_NO_SYSTEM_FUNCTION)
+    #undef HAS_SYSTEM_FUNCTION
+#endif
+
+#include "../profiler_trace.h"
+
+static uint8_t* ReadFile(const char* path, uint32_t* size)
+{
+    FILE* f = fopen(path, "rb");
+    if (!f)
+        return 0;
+    fseek(f, 0, SEEK_END);
+    *size = (uint32_t)ftell(f);
+    fseek(f, 0, SEEK_SET);
+    uint8_t* data = (uint8_t*)malloc(*size);
+    fread(data, 1, *size, f);
+    fclose(f);
+    return data;
+}
+
+TEST(ProfilerTrace, WriteRead)
+{
+    char path[DMPATH_MAX_PATH];
+    dmTestUtil::MakeHostPath(path, sizeof(path), "test.dmtrace");
+
+    dmProfilerTrace::HTrace trace = dmProfilerTrace::Open(path, 1000000);
+    ASSERT_NE((dmProfilerTrace::HTrace)0, trace);
+
+    uint32_t thread_hash = dmHashString32("Main");
+    uint32_t frame_hash = dmHashString32("Frame");
+    dmProfilerTrace::WriteName(trace, thread_hash, "Main");
+    dmProfilerTrace::WriteName(trace, frame_hash, "Frame");
+    dmProfilerTrace::WriteName(trace, frame_hash, "Frame"); // Only written once
+
+    dmProfilerTrace::TraceSample samples[2] = {
+        { frame_hash, 1, 100, 16000 },
+        { frame_hash, 1, 16100, 15000 },
+    };
+    dmProfilerTrace::WriteSamples(trace, thread_hash, samples, 2);
+
+    dmProfilerTrace::TraceProperty property;
+    property.m_NameHash = frame_hash;
+    property.m_Type = dmProfile::PROPERTY_TYPE_U32;
+    property.m_Value = 42;
+    dmProfilerTrace::WriteProperties(trace, 31100, &property, 1);
+
+    uint64_t expected_size = sizeof(dmProfilerTrace::TraceHeader)
+                           + 2 * sizeof(dmProfilerTrace::RecordHeader) + 4 + 5 // names
+                           + sizeof(dmProfilerTrace::RecordHeader) + 2 * sizeof(dmProfilerTrace::TraceSample)
+                           + sizeof(dmProfilerTrace::RecordHeader) + sizeof(dmProfilerTrace::TraceProperty);
+    ASSERT_EQ(expected_size, dmProfilerTrace::GetSize(trace));
+    dmProfilerTrace::Close(trace);
+
+    uint32_t size = 0;
+    uint8_t* data = ReadFile(path, &size);
+    ASSERT_NE((uint8_t*)0, data);
+    ASSERT_EQ(expected_size, (uint64_t)size);
+
+    const uint8_t* p = data;
+    dmProfilerTrace::TraceHeader header;
+    memcpy(&header, p, sizeof(header));
+    p += sizeof(header);
+    ASSERT_EQ(0, memcmp("DMTR", header.m_Magic, 4));
+    ASSERT_EQ(dmProfilerTrace::TRACE_VERSION, header.m_Version);
+    ASSERT_EQ(1000000u, header.m_TicksPerSecond);
+
+    dmProfilerTrace::RecordHeader record;
+    memcpy(&record, p, sizeof(record));
+    p += sizeof(record);
+    ASSERT_EQ((uint32_t)dmProfilerTrace::RECORD_TYPE_NAME, record.m_Type);
+    ASSERT_EQ(4u, record.m_Count);
+    ASSERT_EQ((uint64_t)thread_hash, record.m_Value);
+    ASSERT_EQ(0, memcmp("Main", p, 4));
+    p += record.m_Count;
+
+    memcpy(&record, p, sizeof(record));
+    p += sizeof(record) + record.m_Count;
+    ASSERT_EQ((uint32_t)dmProfilerTrace::RECORD_TYPE_NAME, record.m_Type);
+    ASSERT_EQ((uint64_t)frame_hash, record.m_Value);
+
+    memcpy(&record, p, sizeof(record));
+    p += sizeof(record);
+    ASSERT_EQ((uint32_t)dmProfilerTrace::RECORD_TYPE_SAMPLES, record.m_Type);
+    ASSERT_EQ(2u, record.m_Count);
+    ASSERT_EQ((uint64_t)thread_hash, record.m_Value);
+    dmProfilerTrace::TraceSample sample;
+    memcpy(&sample, p + sizeof(sample), sizeof(sample));
+    p += record.m_Count * sizeof(sample);
+    ASSERT_EQ(16100u, sample.m_Start);
+    ASSERT_EQ(15000u, sample.m_Time);
+
+    memcpy(&record, p, sizeof(record));
+    p += sizeof(record);
+    ASSERT_EQ((uint32_t)dmProfilerTrace::RECORD_TYPE_PROPERTIES, record.m_Type);
+    ASSERT_EQ(1u, record.m_Count);
+    ASSERT_EQ(31100u, record.m_Value);
+    memcpy(&property, p, sizeof(property));
+    ASSERT_EQ(42u, property.m_Value);
+
+    free(data);
+    dmSys::Unlink(path);
+}
+
+TEST(ProfilerTrace, Flush)
+{
+    char path[DMPATH_MAX_PATH];
+    dmTestUtil::MakeHostPath(path, sizeof(path), "test_flush.dmtrace");
+
+    dmProfilerTrace::HTrace trace = dmProfilerTrace::Open(path, 1000000);
+    ASSERT_NE((dmProfilerTrace::HTrace)0, trace);
+
+    dmProfilerTrace::TraceSample samples[256];
+    memset(samples, 0, sizeof(samples));
+    for (uint32_t i = 0; i < 100; ++i)
+    {
+        dmProfilerTrace::WriteSamples(trace, 1, samples, 256);
+    }
+    uint64_t total_size = dmProfilerTrace::GetSize(trace);
+    dmProfilerTrace::Close(trace);
+
+    uint32_t size = 0;
+    uint8_t* data = ReadFile(path, &size);
+    ASSERT_NE((uint8_t*)0, data);
+    ASSERT_EQ(total_size, (uint64_t)size);
+    free(data);
+    dmSys::Unlink(path);
+}
+
+struct PropertyWriterContext
+{
+    dmProfilerTrace::HTrace m_Trace;
+    int32_atomic_t          m_Start;
+    uint32_t                m_Count;
+};
+
+static void PropertyWriterThread(void* arg)
+{
+    PropertyWriterContext* ctx = (PropertyWriterContext*)arg;
+    while (dmAtomicGet32(&ctx->m_Start) == 0)
+        dmTime::Sleep(0);
+
+    dmProfilerTrace::TraceProperty properties[4];
+    memset(properties, 0, sizeof(properties));
+    for (uint32_t i = 0; i < ctx->m_Count; ++i)
+    {
+        char name[32];
+        dmSnPrintf(name, sizeof(name), "property_%u", i % 8);
+        properties[0].m_NameHash = dmHashString32(name);
+        dmProfilerTrace::WriteName(ctx->m_Trace, properties[0].m_NameHash, name);
+        dmProfilerTrace::WriteProperties(ctx->m_Trace, i, properties, 4);
+    }
+}
+
+// Records written from another thread while the samples are flushed end up whole in the file
+TEST(ProfilerTrace, Threads)
+{
+    char path[DMPATH_MAX_PATH];
+    dmTestUtil::MakeHostPath(path, sizeof(path), "test_threads.dmtrace");
+
+    dmProfilerTrace::HTrace trace = dmProfilerTrace::Open(path, 1000000);
+    ASSERT_NE((dmProfilerTrace::HTrace)0, trace);
+
+    PropertyWriterContext ctx;
+    ctx.m_Trace = trace;
+    ctx.m_Start = 0;
+    ctx.m_Count = 2000;
+    dmThread::Thread thread = dmThread::New(PropertyWriterThread, 0x80000, &ctx, "test");
+
+    const uint32_t sample_records = 100;
+    dmProfilerTrace::TraceSample samples[256];
+    memset(samples, 0, sizeof(samples));
+    dmAtomicStore32(&ctx.m_Start, 1);
+    for (uint32_t i = 0; i < sample_records; ++i)
+    {
+        dmProfilerTrace::WriteSamples(trace, 1, samples, 256);
+    }
+    dmThread::Join(thread);
+
+    uint64_t total_size = dmProfilerTrace::GetSize(trace);
+    dmProfilerTrace::Close(trace);
+
+    uint32_t size = 0;
+    uint8_t* data = ReadFile(path, &size);
+    ASSERT_NE((uint8_t*)0, data);
+    ASSERT_EQ(total_size, (uint64_t)size);
+
+    uint32_t counts[4] = {0};
+    uint32_t offset = sizeof(dmProfilerTrace::TraceHeader);
+    while (offset + sizeof(dmProfilerTrace::RecordHeader) <= size)
+    {
+        dmProfilerTrace::RecordHeader record;
+        memcpy(&record, data + offset, sizeof(record));
+        offset += sizeof(record);
+        switch (record.m_Type)
+        {
+        case dmProfilerTrace::RECORD_TYPE_NAME:       offset += record.m_Count; break;
+        case dmProfilerTrace::RECORD_TYPE_SAMPLES:    offset += record.m_Count * sizeof(dmProfilerTrace::TraceSample); break;
+        case dmProfilerTrace::RECORD_TYPE_PROPERTIES: offset += record.m_Count * sizeof(dmProfilerTrace::TraceProperty); break;
+        default:
+            ASSERT_TRUE(false);
+        }
+        counts[record.m_Type]++;
+    }
+    ASSERT_EQ(size, offset);
+    ASSERT_EQ(8u, counts[dmProfilerTrace::RECORD_TYPE_NAME]);
+    ASSERT_EQ(sample_records, counts[dmProfilerTrace::RECORD_TYPE_SAMPLES]);
+    ASSERT_EQ(ctx.m_Count, counts[dmProfilerTrace::RECORD_TYPE_PROPERTIES]);
+
+    free(data);
+    dmSys::Unlink(path);
+}
+
+#if defined(HAS_SYSTEM_FUNCTION)
+
+// Converts a trace with profiler_trace.py, which checks the output
+TEST(ProfilerTrace, Convert)
+{
+    char path[DMPATH_MAX_PATH];
+    dmTestUtil::MakeHostPath(path, sizeof(path), "test_convert.dmtrace");
+    char json_path[DMPATH_MAX_PATH];
+    dmTestUtil::MakeHostPath(json_path, sizeof(json_path), "test_convert.json");
+
+    dmProfilerTrace::HTrace trace = dmProfilerTrace::Open(path, 1000000);
+    ASSERT_NE((dmProfilerTrace::HTrace)0, trace);
+
+    uint32_t thread_hash = dmHashString32("Main");
+    uint32_t frame_hash = dmHashString32("Frame");
+    uint32_t update_hash = dmHashString32("Update");
+    uint32_t property_hash = dmHashString32("rmtp_DrawCalls");
+    dmProfilerTrace::WriteName(trace, thread_hash, "Main");
+    dmProfilerTrace::WriteName(trace, frame_hash, "Frame");
+    dmProfilerTrace::WriteName(trace, update_hash, "Update");
+    dmProfilerTrace::WriteName(trace, property_hash, "rmtp_DrawCalls");
+
+    dmProfilerTrace::TraceSample samples[2] = {
+        { frame_hash, 1, 1000, 16000 },
+        { update_hash, 3, 2000, 5000 },
+    };
+    dmProfilerTrace::WriteSamples(trace, thread_hash, samples, 2);
+
+    dmProfilerTrace::TraceProperty property;
+    property.m_NameHash = property_hash;
+    property.m_Type = dmProfile::PROPERTY_TYPE_U32;
+    property.m_Value = 42;
+    dmProfilerTrace::WriteProperties(trace, 17000, &property, 1);
+    dmProfilerTrace::Close(trace);
+
+    char cmd[DMPATH_MAX_PATH * 3];
+    dmSnPrintf(cmd, sizeof(cmd), "python src/test/test_profiler_trace.py %s %s", path, json_path);
+    ASSERT_EQ(0, system(cmd));
+
+    dmSys::Unlink(path);
+    dmSys::Unlink(json_path);
+}
+
+#endif
+
+int main(int argc, char **argv)
+{
+    jc_test_init(&argc, argv);
+    return jc_test_run_all();
+}
@@ -0,0 +1,50 @@
+# Copyright 2020-2024 The Defold Foundation
+# Copyright 2014-2020 King
+# Copyright 2009-2014 Ragnar Svensson, Christian Murray
+# Licensed under the Defold License version 1.0 (the "License"); you may not use
+# this file except in compliance with the License.
+#
+# You may obtain a copy of the License, together with FAQs at
+# https://www.defold.com/license
+#
+# Unless required by applicable law or agreed to in writing, software distributed
+# under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+# CONDITIONS OF ANY KIND, either express or implied. See the License for the
+# specific language governing permissions and limitations under the License.
+
+# Runs profiler_trace.py on the trace written by the ProfilerTrace.Convert test
+
+import os, sys, json, subprocess
+
+trace_path = sys.argv[1]
+json_path = sys.argv[2]
+
+script = os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', 'profiler_trace.py')
+subprocess.check_call([sys.executable, script, trace_path, json_path])
+
+with open(json_path) as f:
+    trace = json.load(f)
+
+events = trace['traceEvents']
+assert len(events) == 4, 'got %d events' % len(events)
+
+thread, frame, update, counter = events
+
+assert thread['ph'] == 'M', thread
+assert thread['args']['name'] == 'Main', thread
+
+# The times are in microseconds, and the trace in 1000000 ticks per second
+assert frame['ph'] == 'X', frame
+assert frame['name'] == 'Frame', frame
+assert frame['tid'] == thread['tid'], frame
+assert frame['ts'] == 1000 and frame['dur'] == 16000, frame
+assert frame['args']['count'] == 1, frame
+
+assert update['name'] == 'Update', update
+assert update['ts'] == 2000 and update['dur'] == 5000, update
+assert update['args']['count'] == 3, update
+
+assert counter['ph'] == 'C', counter
+assert counter['name'] == 'DrawCalls', counter
+assert counter['ts'] == 17000, counter
+assert counter['args']['DrawCalls'] == 42, counter
@@ -145,13 +145,13 @@ namespace dmRender
 
         ~FontMap()
         {
-            free(m_CacheIndices);
+            dmMemory::Free(dmMemory::TAG_RENDER, m_CacheIndices);
             m_CacheIndices = 0;
 
-            free(m_Cache);
+            dmMemory::Free(dmMemory::TAG_RENDER, m_Cache);
             m_Cache = 0;
 
-            free(m_CellTempData);
+            dmMemory::Free(dmMemory::TAG_RENDER, m_CellTempData);
             m_CellTempData = 0;
 
             dmGraphics::DeleteTexture(m_Texture);
@@ -209,14 +209,14 @@ namespace dmRender
     {
         uint8_t bpp = params.m_GlyphChannels;
         uint32_t data_size = tex_params.m_Width * tex_params.m_Height * bpp;
-        tex_params.m_Data = malloc(data_size);
+        tex_params.m_Data = dmMemory::Malloc(dmMemory::TAG_RENDER, data_size);
         tex_params.m_DataSize = data_size;
         memset((void*)tex_params.m_Data, init_val, tex_params.m_DataSize);
     }
 
     static void CleanupFontmap(dmGraphics::TextureParams& tex_params)
     {
-        free((void*)tex_params.m_Data);
+        dmMemory::Free(dmMemory::TAG_RENDER, (void*)tex_params.m_Data);
         tex_params.m_DataSize = 0;
     }
 
@@ -240,9 +240,9 @@ namespace dmRender
     {
         if (font_map->m_Cache)
         {
-            free(font_map->m_Cache);
-            free(font_map->m_CellTempData);
-            free(font_map->m_CacheIndices);
+            dmMemory::Free(dmMemory::TAG_RENDER, font_map->m_Cache);
+            dmMemory::Free(dmMemory::TAG_RENDER, font_map->m_CellTempData);
+            dmMemory::Free(dmMemory::TAG_RENDER, font_map->m_CacheIndices);
             font_map->m_GlyphCache.Clear();
         }
 
@@ -254,12 +254,12 @@ namespace dmRender
         font_map->m_CacheRows = texture_height / cell_height;
         font_map->m_CacheCellCount = font_map->m_CacheColumns * font_map->m_CacheRows;
 
-        font_map->m_CellTempData = (uint8_t*)malloc(font_map->m_CacheCellWidth*font_map->m_CacheCellHeight*4);
+        font_map->m_CellTempData = (uint8_t*)dmMemory::Malloc(dmMemory::TAG_RENDER, font_map->m_CacheCellWidth*font_map->m_CacheCellHeight*4);
 
-        font_map->m_CacheIndices = (uint16_t*)malloc(sizeof(uint16_t) * font_map->m_CacheCellCount);
+        font_map->m_CacheIndices = (uint16_t*)dmMemory::Malloc(dmMemory::TAG_RENDER, sizeof(uint16_t) * font_map->m_CacheCellCount);
         memset(font_map->m_CacheIndices, 0, sizeof(uint16_t) * font_map->m_CacheCellCount);
 
-        font_map->m_Cache = (CacheGlyph*)malloc(sizeof(CacheGlyph) * font_map->m_CacheCellCount);
+        font_map->m_Cache = (CacheGlyph*)dmMemory::Malloc(dmMemory::TAG_RENDER, sizeof(CacheGlyph) * font_map->m_CacheCellCount);
         memset(font_map->m_Cache, 0, sizeof(CacheGlyph*) * font_map->m_CacheCellCount);
         for (uint32_t i = 0; i < font_map->m_CacheCellCount; ++i)
         {
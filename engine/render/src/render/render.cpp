@@ -32,6 +32,9 @@
 #include "font_renderer.h"
 
 DM_PROPERTY_GROUP(rmtp_Render, "Renderer");
+DM_PROPERTY_U32(rmtp_RenderSkippedConstants, 0, FrameReset, "# skipped material constant updates", &rmtp_Render);
+DM_PROPERTY_U32(rmtp_RenderSkippedTextures, 0, FrameReset, "# skipped texture binds", &rmtp_Render);
+DM_PROPERTY_U32(rmtp_RenderSkippedVertexBuffers, 0, FrameReset, "# skipped vertex buffer binds", &rmtp_Render);
 
 namespace dmRender
 {
@@ -1021,6 +1024,68 @@ namespace dmRender
         TrimTextureBindingTable(render_context);
     }
 
+    // The graphics state set up for the previous render object in Draw().
+    // The render objects are sorted, so consecutive objects usually come from the same
+    // batch, and share material, textures and vertex buffers.
+    struct DrawStateCache
+    {
+        static const uint32_t MAX_TEXTURE_UNITS = 32;
+
+        DrawStateCache()
+        {
+            memset(this, 0, sizeof(*this));
+        }
+
+        // Material constants
+        HMaterial                       m_ConstantsMaterial;
+        Matrix4                         m_WorldTransform;
+        Matrix4                         m_TextureTransform;
+        uint8_t                         m_ConstantsValid : 1;
+        uint8_t                         : 7;
+
+        // Textures, per texture unit
+        HMaterial                       m_SamplersMaterial;
+        dmGraphics::HTexture            m_Textures[MAX_TEXTURE_UNITS];
+        uint8_t                         m_TextureSubHandles[MAX_TEXTURE_UNITS];
+        uint32_t                        m_TextureUnitCount;
+
+        // Vertex buffers
+        dmGraphics::HProgram            m_VertexProgram;
+        dmGraphics::HVertexBuffer       m_VertexBuffers[RenderObject::MAX_VERTEX_BUFFER_COUNT];
+        dmGraphics::HVertexDeclaration  m_VertexDeclarations[RenderObject::MAX_VERTEX_BUFFER_COUNT];
+    };
+
+    static void DisableVertexBuffers(dmGraphics::HContext context, DrawStateCache& cache)
+    {
+        for (int i = 0; i < RenderObject::MAX_VERTEX_BUFFER_COUNT; ++i)
+        {
+            if (cache.m_VertexBuffers[i])
+            {
+                dmGraphics::DisableVertexBuffer(context, cache.m_VertexBuffers[i]);
+            }
+            if (cache.m_VertexDeclarations[i])
+            {
+                dmGraphics::DisableVertexDeclaration(context, cache.m_VertexDeclarations[i]);
+            }
+            cache.m_VertexBuffers[i] = 0;
+            cache.m_VertexDeclarations[i] = 0;
+        }
+        cache.m_VertexProgram = 0;
+    }
+
+    static void DisableTextures(dmGraphics::HContext context, DrawStateCache& cache, uint32_t first_unit)
+    {
+        for (uint32_t unit = first_unit; unit < cache.m_TextureUnitCount; ++unit)
+        {
+            if (cache.m_Textures[unit])
+            {
+                dmGraphics::DisableTexture(context, unit, cache.m_Textures[unit]);
+                cache.m_Textures[unit] = 0;
+            }
+        }
+        cache.m_TextureUnitCount = dmMath::Min(cache.m_TextureUnitCount, first_unit);
+    }
+
     // NOTE: Currently only used externally in 1 test (fontview.cpp)
     // TODO: Replace that occurrance with DrawRenderList
     Result Draw(HRenderContext render_context, HPredicate predicate, HNamedConstantBuffer constant_buffer)
@@ -1042,6 +1107,11 @@ namespace dmRender
 
         dmGraphics::PipelineState ps_orig = dmGraphics::GetPipelineState(context);
 
+        DrawStateCache cache;
+        uint32_t skipped_constants = 0;
+        uint32_t skipped_textures = 0;
+        uint32_t skipped_vertex_buffers = 0;
+
         for (uint32_t i = 0; i < render_context->m_RenderObjects.Size(); ++i)
         {
             RenderObject* ro = render_context->m_RenderObjects[i];
@@ -1071,17 +1141,38 @@ namespace dmRender
                 }
             }
 
-            ApplyMaterialConstants(render_context, material, ro);
+            // The material constants only depend on the material and the transforms of the render object,
+            // unless the previous object overrode some of them with its own constant buffer
+            bool constants_bound = cache.m_ConstantsValid && cache.m_ConstantsMaterial == material
+                && memcmp(&cache.m_WorldTransform, &ro->m_WorldTransform, sizeof(Matrix4)) == 0
+                && memcmp(&cache.m_TextureTransform, &ro->m_TextureTransform, sizeof(Matrix4)) == 0;
+
+            if (constants_bound)
+                ++skipped_constants;
+            else
+                ApplyMaterialConstants(render_context, material, ro);
 
             if (ro->m_ConstantBuffer) // from components/scripts
                 ApplyNamedConstantBuffer(render_context, material, ro->m_ConstantBuffer);
 
-            if (constant_buffer) // from render script
+            if (constant_buffer && (!constants_bound || ro->m_ConstantBuffer)) // from render script
                 ApplyNamedConstantBuffer(render_context, material, constant_buffer);
 
+            cache.m_ConstantsMaterial = material;
+            cache.m_WorldTransform    = ro->m_WorldTransform;
+            cache.m_TextureTransform  = ro->m_TextureTransform;
+            cache.m_ConstantsValid    = ro->m_ConstantBuffer == 0;
+
             ApplyRenderState(render_context, render_context->m_GraphicsContext, dmGraphics::GetPipelineState(context), ro);
 
-            uint8_t next_texture_unit = 0;
+            // The sampler settings come from the material
+            if (cache.m_SamplersMaterial != material)
+            {
+                DisableTextures(context, cache, 0);
+                cache.m_SamplersMaterial = material;
+            }
+
+            uint32_t next_texture_unit = 0;
             for (uint32_t i = 0; i < RenderObject::MAX_TEXTURE_COUNT; ++i)
             {
                 dmGraphics::HTexture texture = ro->m_Textures[i];
@@ -1095,64 +1186,83 @@ namespace dmRender
                     uint32_t num_texture_handles = dmGraphics::GetNumTextureHandles(texture);
                     for (int sub_handle = 0; sub_handle < num_texture_handles; ++sub_handle)
                     {
-                        HSampler sampler = GetProgramSampler(material->m_Samplers, next_texture_unit);
-                        dmGraphics::EnableTexture(context, next_texture_unit, sub_handle, texture);
-                        ApplyProgramSampler(render_context, sampler, next_texture_unit, texture);
-
-                        next_texture_unit++;
+                        uint32_t unit = next_texture_unit++;
+                        assert(unit < DrawStateCache::MAX_TEXTURE_UNITS);
+                        if (unit < cache.m_TextureUnitCount && cache.m_Textures[unit] == texture && cache.m_TextureSubHandles[unit] == sub_handle)
+                        {
+                            ++skipped_textures;
+                            continue;
+                        }
+                        if (unit < cache.m_TextureUnitCount && cache.m_Textures[unit])
+                        {
+                            dmGraphics::DisableTexture(context, unit, cache.m_Textures[unit]);
+                        }
+
+                        HSampler sampler = GetProgramSampler(material->m_Samplers, unit);
+                        dmGraphics::EnableTexture(context, unit, sub_handle, texture);
+                        ApplyProgramSampler(render_context, sampler, unit, texture);
+
+                        cache.m_Textures[unit] = texture;
+                        cache.m_TextureSubHandles[unit] = (uint8_t)sub_handle;
+                        cache.m_TextureUnitCount = dmMath::Max(cache.m_TextureUnitCount, unit + 1);
                     }
                 }
             }
+            // Unbind the units the previous object used, but this one doesn't
+            DisableTextures(context, cache, next_texture_unit);
 
             dmGraphics::HProgram material_program = GetMaterialProgram(material);
 
-            for (int i = 0; i < RenderObject::MAX_VERTEX_BUFFER_COUNT; ++i)
+            bool vertex_buffers_bound = cache.m_VertexProgram == material_program;
+            for (int i = 0; i < RenderObject::MAX_VERTEX_BUFFER_COUNT && vertex_buffers_bound; ++i)
             {
-                if (ro->m_VertexBuffers[i])
-                {
-                    dmGraphics::EnableVertexBuffer(context, ro->m_VertexBuffers[i], i);
-                }
-                if (ro->m_VertexDeclarations[i])
-                {
-                    dmGraphics::EnableVertexDeclaration(context, ro->m_VertexDeclarations[i], i, material_program);
-                }
+                vertex_buffers_bound = cache.m_VertexBuffers[i] == ro->m_VertexBuffers[i] && cache.m_VertexDeclarations[i] == ro->m_VertexDeclarations[i];
             }
 
-            if (ro->m_IndexBuffer)
-                dmGraphics::DrawElements(context, ro->m_PrimitiveType, ro->m_VertexStart, ro->m_VertexCount, ro->m_IndexType, ro->m_IndexBuffer);
+            if (vertex_buffers_bound)
+            {
+                ++skipped_vertex_buffers;
+            }
             else
-                dmGraphics::Draw(context, ro->m_PrimitiveType, ro->m_VertexStart, ro->m_VertexCount);
-
-            for (int i = 0; i < RenderObject::MAX_VERTEX_BUFFER_COUNT; ++i)
             {
-                if (ro->m_VertexBuffers[i])
-                {
-                    dmGraphics::DisableVertexBuffer(context, ro->m_VertexBuffers[i]);
-                }
+                DisableVertexBuffers(context, cache);
 
-                if (ro->m_VertexDeclarations[i])
+                for (int i = 0; i < RenderObject::MAX_VERTEX_BUFFER_COUNT; ++i)
                 {
-                    dmGraphics::DisableVertexDeclaration(context, ro->m_VertexDeclarations[i]);
+                    if (ro->m_VertexBuffers[i])
+                    {
+                        dmGraphics::EnableVertexBuffer(context, ro->m_VertexBuffers[i], i);
+                    }
+                    if (ro->m_VertexDeclarations[i])
+                    {
+                        dmGraphics::EnableVertexDeclaration(context, ro->m_VertexDeclarations[i], i, material_program);
+                    }
+                    cache.m_VertexBuffers[i] = ro->m_VertexBuffers[i];
+                    cache.m_VertexDeclarations[i] = ro->m_VertexDeclarations[i];
                 }
+                cache.m_VertexProgram = material_program;
             }
 
-            next_texture_unit = 0;
-            for (uint32_t i = 0; i < RenderObject::MAX_TEXTURE_COUNT; ++i)
+            if (ro->m_InstanceCount > 0)
             {
-                dmGraphics::HTexture texture = ro->m_Textures[i];
-                if (render_context_textures[i])
-                    texture = render_context_textures[i];
-                if (texture)
-                {
-                    for (int sub_handle = 0; sub_handle < dmGraphics::GetNumTextureHandles(texture); ++sub_handle)
-                    {
-                        dmGraphics::DisableTexture(context, next_texture_unit, texture);
-                        next_texture_unit++;
-                    }
-                }
+                if (ro->m_IndexBuffer)
+                    dmGraphics::DrawElementsInstanced(context, ro->m_PrimitiveType, ro->m_VertexStart, ro->m_VertexCount, ro->m_InstanceCount, ro->m_IndexType, ro->m_IndexBuffer);
+                else
+                    dmGraphics::DrawInstanced(context, ro->m_PrimitiveType, ro->m_VertexStart, ro->m_VertexCount, ro->m_InstanceCount);
             }
+            else if (ro->m_IndexBuffer)
+                dmGraphics::DrawElements(context, ro->m_PrimitiveType, ro->m_VertexStart, ro->m_VertexCount, ro->m_IndexType, ro->m_IndexBuffer);
+            else
+                dmGraphics::Draw(context, ro->m_PrimitiveType, ro->m_VertexStart, ro->m_VertexCount);
         }
 
+        DisableVertexBuffers(context, cache);
+        DisableTextures(context, cache, 0);
+
+        DM_PROPERTY_ADD_U32(rmtp_RenderSkippedConstants, skipped_constants);
+        DM_PROPERTY_ADD_U32(rmtp_RenderSkippedTextures, skipped_textures);
+        DM_PROPERTY_ADD_U32(rmtp_RenderSkippedVertexBuffers, skipped_vertex_buffers);
+
         ResetRenderStateIfChanged(context, ps_orig, dmGraphics::GetPipelineState(context));
 
         TrimTextureBindingTable(render_context);
@@ -39,6 +39,7 @@ namespace dmRender
     static const dmhash_t VERTEX_STREAM_TEXCOORD0  = dmHashString64("texcoord0");
     static const dmhash_t VERTEX_STREAM_TEXCOORD1  = dmHashString64("texcoord1");
     static const dmhash_t VERTEX_STREAM_PAGE_INDEX = dmHashString64("page_index");
+    static const dmhash_t VERTEX_STREAM_WORLD_MATRIX = dmHashString64("mtx_world"); // Per instance, see RenderObject::m_InstanceCount
 
     typedef struct RenderTargetSetup*       HRenderTargetSetup;
     typedef uint64_t                        HRenderType;
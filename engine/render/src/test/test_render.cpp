@@ -803,6 +803,194 @@ TEST_F(dmRenderTest, TestEnableDisableContextTextures)
     dmGraphics::DeleteVertexDeclaration(vx_decl);
 }
 
+struct TestDrawStateCacheDispatchCtx
+{
+    static const uint32_t          RENDER_OBJECT_COUNT = 4;
+    dmRender::HRenderContext       m_Context;
+    dmRender::HMaterial            m_Material;
+    dmRender::RenderObject         m_RenderObjects[RENDER_OBJECT_COUNT];
+    dmGraphics::HVertexDeclaration m_VertexDeclaration;
+    dmGraphics::HVertexBuffer      m_VertexBuffer;
+    dmGraphics::HTexture           m_Textures[2];
+};
+
+static void TestDrawStateCacheDispatch(dmRender::RenderListDispatchParams const & params)
+{
+    if (params.m_Operation == dmRender::RENDER_LIST_OPERATION_BATCH)
+    {
+        TestDrawStateCacheDispatchCtx* user_ctx = (TestDrawStateCacheDispatchCtx*) params.m_UserData;
+        for (uint32_t i = 0; i < TestDrawStateCacheDispatchCtx::RENDER_OBJECT_COUNT; ++i)
+        {
+            dmRender::RenderObject* ro = &user_ctx->m_RenderObjects[i];
+            ro->Init();
+            ro->m_Material          = user_ctx->m_Material;
+            ro->m_VertexCount       = 1;
+            ro->m_VertexDeclaration = user_ctx->m_VertexDeclaration;
+            ro->m_VertexBuffer      = user_ctx->m_VertexBuffer;
+            // Two objects per texture
+            ro->m_Textures[0]       = user_ctx->m_Textures[i / 2];
+            AddToRender(user_ctx->m_Context, ro);
+        }
+    }
+}
+
+TEST_F(dmRenderTest, TestDrawStateCache)
+{
+    dmGraphics::ShaderDesc::Shader shader = MakeDDFShader(dmGraphics::ShaderDesc::LANGUAGE_GLSL_SM140, "foo", 3);
+    dmGraphics::ShaderDesc vs_desc        = MakeDDFShaderDesc(&shader, dmGraphics::ShaderDesc::SHADER_TYPE_VERTEX, 0, 0, 0, 0);
+    dmGraphics::ShaderDesc fs_desc        = MakeDDFShaderDesc(&shader, dmGraphics::ShaderDesc::SHADER_TYPE_FRAGMENT, 0, 0, 0, 0);
+
+    dmGraphics::HVertexProgram vp   = dmGraphics::NewVertexProgram(m_GraphicsContext, &vs_desc, 0, 0);
+    dmGraphics::HFragmentProgram fp = dmGraphics::NewFragmentProgram(m_GraphicsContext, &fs_desc, 0, 0);
+    dmRender::HMaterial material    = dmRender::NewMaterial(m_Context, vp, fp);
+
+    m_Context->m_RenderObjects.SetCapacity(TestDrawStateCacheDispatchCtx::RENDER_OBJECT_COUNT);
+
+    TestDrawStateCacheDispatchCtx user_ctx;
+    user_ctx.m_Context           = m_Context;
+    user_ctx.m_Material          = material;
+    user_ctx.m_VertexDeclaration = dmGraphics::NewVertexDeclaration(m_GraphicsContext, 0, 0);
+    user_ctx.m_VertexBuffer      = dmGraphics::NewVertexBuffer(m_GraphicsContext, 0, 0, dmGraphics::BUFFER_USAGE_STATIC_DRAW);
+    user_ctx.m_Textures[0]       = MakeDummyTexture(m_GraphicsContext);
+    user_ctx.m_Textures[1]       = MakeDummyTexture(m_GraphicsContext);
+
+    dmRender::RenderListBegin(m_Context);
+    uint8_t dispatch = dmRender::RenderListMakeDispatch(m_Context, TestDrawStateCacheDispatch, 0, &user_ctx);
+    dmRender::RenderListEntry* out = dmRender::RenderListAlloc(m_Context, 1);
+    dmRender::RenderListEntry& entry = out[0];
+    entry.m_WorldPosition = Point3(0,0,0);
+    entry.m_MajorOrder    = 0;
+    entry.m_MinorOrder    = 0;
+    entry.m_TagListKey    = 0;
+    entry.m_Order         = 1;
+    entry.m_BatchKey      = 0;
+    entry.m_Dispatch      = dispatch;
+    entry.m_UserData      = 0;
+    dmRender::RenderListSubmit(m_Context, out, out + 1);
+    dmRender::RenderListEnd(m_Context);
+
+    dmGraphics::NullContext* null_context = (dmGraphics::NullContext*) m_GraphicsContext;
+    memset(&null_context->m_CallCounters, 0, sizeof(null_context->m_CallCounters));
+
+    dmRender::DrawRenderList(m_Context, 0, 0, 0);
+
+    const dmGraphics::NullCallCounters& counters = null_context->m_CallCounters;
+    // The material, vertex buffer and declaration are shared by all objects
+    ASSERT_EQ(1u, counters.m_EnableProgram);
+    ASSERT_EQ(1u, counters.m_EnableVertexBuffer);
+    ASSERT_EQ(1u, counters.m_EnableVertexDeclaration);
+    ASSERT_EQ(1u, counters.m_DisableVertexBuffer);
+    ASSERT_EQ(1u, counters.m_DisableVertexDeclaration);
+    // Bound once per texture, and everything is unbound after the draw
+    ASSERT_EQ(2u, counters.m_EnableTexture);
+    ASSERT_EQ(2u, counters.m_DisableTexture);
+    ASSERT_EQ((dmGraphics::HTexture) 0, null_context->m_Textures[0]);
+    ASSERT_EQ((dmGraphics::HVertexBuffer) 0, null_context->m_VertexBuffer);
+
+    dmGraphics::DeleteTexture(user_ctx.m_Textures[0]);
+    dmGraphics::DeleteTexture(user_ctx.m_Textures[1]);
+
+    dmGraphics::DeleteVertexProgram(vp);
+    dmGraphics::DeleteFragmentProgram(fp);
+    dmRender::DeleteMaterial(m_Context, material);
+
+    dmGraphics::DeleteVertexBuffer(user_ctx.m_VertexBuffer);
+    dmGraphics::DeleteVertexDeclaration(user_ctx.m_VertexDeclaration);
+}
+
+struct TestInstancedDrawDispatchCtx
+{
+    dmRender::HRenderContext       m_Context;
+    dmRender::HMaterial            m_Material;
+    dmRender::RenderObject         m_RenderObjects[2];
+    dmGraphics::HVertexDeclaration m_VertexDeclaration;
+    dmGraphics::HVertexDeclaration m_InstanceDeclaration;
+    dmGraphics::HVertexBuffer      m_VertexBuffer;
+    dmGraphics::HVertexBuffer      m_InstanceBuffer;
+};
+
+static void TestInstancedDrawDispatch(dmRender::RenderListDispatchParams const & params)
+{
+    if (params.m_Operation == dmRender::RENDER_LIST_OPERATION_BATCH)
+    {
+        TestInstancedDrawDispatchCtx* user_ctx = (TestInstancedDrawDispatchCtx*) params.m_UserData;
+        for (uint32_t i = 0; i < DM_ARRAY_SIZE(user_ctx->m_RenderObjects); ++i)
+        {
+            dmRender::RenderObject* ro = &user_ctx->m_RenderObjects[i];
+            ro->Init();
+            ro->m_Material              = user_ctx->m_Material;
+            ro->m_VertexCount           = 3;
+            ro->m_VertexDeclarations[0] = user_ctx->m_VertexDeclaration;
+            ro->m_VertexBuffers[0]      = user_ctx->m_VertexBuffer;
+        }
+
+        // The first object is instanced, the second one is a regular draw call
+        dmRender::RenderObject* ro  = &user_ctx->m_RenderObjects[0];
+        ro->m_VertexDeclarations[1] = user_ctx->m_InstanceDeclaration;
+        ro->m_VertexBuffers[1]      = user_ctx->m_InstanceBuffer;
+        ro->m_InstanceCount         = 5;
+
+        AddToRender(user_ctx->m_Context, &user_ctx->m_RenderObjects[0]);
+        AddToRender(user_ctx->m_Context, &user_ctx->m_RenderObjects[1]);
+    }
+}
+
+TEST_F(dmRenderTest, TestInstancedDraw)
+{
+    ASSERT_TRUE(dmGraphics::IsContextFeatureSupported(m_GraphicsContext, dmGraphics::CONTEXT_FEATURE_INSTANCING));
+
+    dmGraphics::ShaderDesc::Shader shader = MakeDDFShader(dmGraphics::ShaderDesc::LANGUAGE_GLSL_SM140, "foo", 3);
+    dmGraphics::ShaderDesc vs_desc        = MakeDDFShaderDesc(&shader, dmGraphics::ShaderDesc::SHADER_TYPE_VERTEX, 0, 0, 0, 0);
+    dmGraphics::ShaderDesc fs_desc        = MakeDDFShaderDesc(&shader, dmGraphics::ShaderDesc::SHADER_TYPE_FRAGMENT, 0, 0, 0, 0);
+
+    dmGraphics::HVertexProgram vp   = dmGraphics::NewVertexProgram(m_GraphicsContext, &vs_desc, 0, 0);
+    dmGraphics::HFragmentProgram fp = dmGraphics::NewFragmentProgram(m_GraphicsContext, &fs_desc, 0, 0);
+    dmRender::HMaterial material    = dmRender::NewMaterial(m_Context, vp, fp);
+
+    dmGraphics::HVertexStreamDeclaration stream_declaration = dmGraphics::NewVertexStreamDeclaration(m_GraphicsContext);
+    dmGraphics::AddVertexStream(stream_declaration, dmRender::VERTEX_STREAM_WORLD_MATRIX, 16, dmGraphics::TYPE_FLOAT, false);
+
+    TestInstancedDrawDispatchCtx user_ctx;
+    user_ctx.m_Context             = m_Context;
+    user_ctx.m_Material            = material;
+    user_ctx.m_VertexDeclaration   = dmGraphics::NewVertexDeclaration(m_GraphicsContext, 0, 0);
+    user_ctx.m_InstanceDeclaration = dmGraphics::NewVertexDeclaration(m_GraphicsContext, stream_declaration);
+    user_ctx.m_VertexBuffer        = dmGraphics::NewVertexBuffer(m_GraphicsContext, 0, 0, dmGraphics::BUFFER_USAGE_STATIC_DRAW);
+    user_ctx.m_InstanceBuffer      = dmGraphics::NewVertexBuffer(m_GraphicsContext, 0, 0, dmGraphics::BUFFER_USAGE_DYNAMIC_DRAW);
+    dmGraphics::SetVertexDeclarationStepFunction(user_ctx.m_InstanceDeclaration, dmGraphics::VERTEX_STEP_FUNCTION_INSTANCE);
+    dmGraphics::DeleteVertexStreamDeclaration(stream_declaration);
+
+    ASSERT_EQ(64u, dmGraphics::GetVertexDeclarationStride(user_ctx.m_InstanceDeclaration));
+
+    dmRender::RenderListBegin(m_Context);
+    uint8_t dispatch = dmRender::RenderListMakeDispatch(m_Context, TestInstancedDrawDispatch, 0, &user_ctx);
+    dmRender::RenderListEntry* out = dmRender::RenderListAlloc(m_Context, 1);
+    memset(out, 0, sizeof(dmRender::RenderListEntry));
+    out[0].m_Order    = 1;
+    out[0].m_Dispatch = dispatch;
+    dmRender::RenderListSubmit(m_Context, out, out + 1);
+    dmRender::RenderListEnd(m_Context);
+
+    dmGraphics::NullContext* null_context = (dmGraphics::NullContext*) m_GraphicsContext;
+    memset(&null_context->m_CallCounters, 0, sizeof(null_context->m_CallCounters));
+
+    dmRender::DrawRenderList(m_Context, 0, 0, 0);
+
+    const dmGraphics::NullCallCounters& counters = null_context->m_CallCounters;
+    ASSERT_EQ(2u, counters.m_Draw);
+    ASSERT_EQ(1u, counters.m_DrawInstanced);
+    ASSERT_EQ(5u, counters.m_DrawInstances);
+
+    dmGraphics::DeleteVertexProgram(vp);
+    dmGraphics::DeleteFragmentProgram(fp);
+    dmRender::DeleteMaterial(m_Context, material);
+
+    dmGraphics::DeleteVertexBuffer(user_ctx.m_VertexBuffer);
+    dmGraphics::DeleteVertexBuffer(user_ctx.m_InstanceBuffer);
+    dmGraphics::DeleteVertexDeclaration(user_ctx.m_VertexDeclaration);
+    dmGraphics::DeleteVertexDeclaration(user_ctx.m_InstanceDeclaration);
+}
+
 struct TestDefaultSamplerFiltersDispatchCtx
 {
     dmRender::HRenderContext        m_Context;
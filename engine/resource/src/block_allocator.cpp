@@ -18,6 +18,7 @@
 #include <stdlib.h>
 
 #include <dlib/align.h>
+#include <dlib/memory.h>
 
 namespace dmBlockAllocator
 {
@@ -50,7 +51,7 @@ namespace dmBlockAllocator
         uint32_t allocation_size = DM_ALIGN(sizeof(uint16_t) + size, BLOCK_ALLOCATION_ALIGNEMENT);
         if (allocation_size > BLOCK_ALLOCATION_THRESHOLD)
         {
-            uint16_t* res = (uint16_t*)malloc(sizeof(uint16_t) + size);
+            uint16_t* res = (uint16_t*)dmMemory::Malloc(dmMemory::TAG_RESOURCE, sizeof(uint16_t) + size);
             *res          = MAX_BLOCK_COUNT;
             return &res[1];
         }
@@ -83,7 +84,7 @@ namespace dmBlockAllocator
         }
         if (first_free != MAX_BLOCK_COUNT)
         {
-            Block* block                          = new Block;
+            Block* block                          = (Block*)dmMemory::Malloc(dmMemory::TAG_RESOURCE, sizeof(Block));
             BlockData* block_data                 = &context->m_BlockDatas[first_free];
             block_data->m_AllocationCount         = 1;
             block_data->m_LowWaterMark            = 0;
@@ -93,7 +94,7 @@ namespace dmBlockAllocator
             context->m_Blocks[first_free] = block;
             return &ptr[1];
         }
-        uint16_t* res = (uint16_t*)malloc(sizeof(uint16_t) + size);
+        uint16_t* res = (uint16_t*)dmMemory::Malloc(dmMemory::TAG_RESOURCE, sizeof(uint16_t) + size);
         *res          = MAX_BLOCK_COUNT;
         return &res[1];
     }
@@ -105,7 +106,7 @@ namespace dmBlockAllocator
         uint16_t block_index = *ptr;
         if (block_index == MAX_BLOCK_COUNT)
         {
-            free(ptr);
+            dmMemory::Free(dmMemory::TAG_RESOURCE, ptr);
             return;
         }
         assert(block_index < MAX_BLOCK_COUNT);
@@ -120,7 +121,7 @@ namespace dmBlockAllocator
         {
             if (block_index != 0)
             {
-                delete block;
+                dmMemory::Free(dmMemory::TAG_RESOURCE, block);
                 context->m_Blocks[block_index] = 0x0;
             }
             return;
@@ -137,7 +138,7 @@ namespace dmBlockAllocator
 
     HContext CreateContext()
     {
-        Context* context = (Context*)malloc(sizeof(Context));
+        Context* context = (Context*)dmMemory::Malloc(dmMemory::TAG_RESOURCE, sizeof(Context));
         context->m_BlockDatas[0].m_AllocationCount = 0;
         context->m_BlockDatas[0].m_LowWaterMark    = 0;
         context->m_BlockDatas[0].m_HighWaterMark   = 0;
@@ -160,6 +161,6 @@ namespace dmBlockAllocator
         {
             assert(context->m_Blocks[i] == 0x0);
         }
-        free(context);
+        dmMemory::Free(dmMemory::TAG_RESOURCE, context);
     }
 }
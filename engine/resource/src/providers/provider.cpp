@@ -163,4 +163,11 @@ Result WriteFile(HArchive archive, dmhash_t path_hash, const char* path, const u
     return RESULT_NOT_SUPPORTED;
 }
 
+Result GetFileData(HArchive archive, dmhash_t path_hash, const char* path, const uint8_t** data, uint32_t* data_len)
+{
+    if (archive->m_Loader->m_GetFileData)
+        return archive->m_Loader->m_GetFileData(archive->m_Internal, path_hash, path, data, data_len);
+    return RESULT_NOT_SUPPORTED;
+}
+
 } // namespace
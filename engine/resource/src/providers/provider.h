@@ -51,6 +51,7 @@ namespace dmResourceProvider
     typedef Result (*FGetFileSize)(HArchiveInternal archive, dmhash_t path_hash, const char* path, uint32_t* file_size);
     typedef Result (*FReadFile)(HArchiveInternal archive, dmhash_t path_hash, const char* path, uint8_t* buffer, uint32_t buffer_len);
     typedef Result (*FWriteFile)(HArchiveInternal archive, dmhash_t path_hash, const char* path, const uint8_t* buffer, uint32_t buffer_len);
+    typedef Result (*FGetFileData)(HArchiveInternal archive, dmhash_t path_hash, const char* path, const uint8_t** data, uint32_t* data_len); // Zero copy access to the file (optional)
     typedef Result (*FGetManifest)(HArchiveInternal, dmResource::HManifest*); // In order for other providers to get the base manifest
     typedef Result (*FSetManifest)(HArchiveInternal, dmResource::HManifest);  // In order to set a downloaded manifest to a provider
 
@@ -73,6 +74,10 @@ namespace dmResourceProvider
     Result ReadFile(HArchive archive, dmhash_t path_hash, const char* path, uint8_t* buffer, uint32_t buffer_len);
     Result WriteFile(HArchive archive, dmhash_t path_hash, const char* path, const uint8_t* buffer, uint32_t buffer_len);
 
+    // Gets a read only pointer to the file data, owned by the archive.
+    // Returns RESULT_NOT_SUPPORTED if the file cannot be accessed without copying it. Use ReadFile() instead.
+    Result GetFileData(HArchive archive, dmhash_t path_hash, const char* path, const uint8_t** data, uint32_t* data_len);
+
 
     // Plugin API
 
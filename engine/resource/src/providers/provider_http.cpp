@@ -17,7 +17,6 @@
 #include "../resource_util.h"
 
 #include <dlib/dstrings.h>
-#include <dlib/array.h>
 #include <dlib/hash.h>
 #include <dlib/log.h>
 #include <dlib/sys.h>
@@ -36,7 +35,10 @@ struct HttpProviderContext
     dmURI::Parts            m_BaseUri;
     dmHttpClient::HClient   m_HttpClient;
     dmHttpCache::HCache     m_HttpCache;
-    dmArray<char>           m_HttpBuffer;
+
+    // The destination of the current GET-request. The content is streamed directly into it.
+    uint8_t*                m_Buffer;
+    uint32_t                m_BufferSize;
 
     int32_t                 m_HttpContentLength;        // Total number bytes loaded in current GET-request
     uint32_t                m_HttpTotalBytesStreamed;
@@ -53,11 +55,6 @@ static void HttpHeader(dmHttpClient::HResponse response, void* user_data, int st
         archive->m_HttpContentLength = strtol(value, 0, 10);
         if (archive->m_HttpContentLength < 0) {
             dmLogError("Content-Length negative (%d)", archive->m_HttpContentLength);
-        } else {
-            if (archive->m_HttpBuffer.Capacity() < (uint32_t)archive->m_HttpContentLength) {
-                archive->m_HttpBuffer.SetCapacity(archive->m_HttpContentLength);
-            }
-            archive->m_HttpBuffer.SetSize(0);
         }
     }
 }
@@ -65,24 +62,23 @@ static void HttpHeader(dmHttpClient::HResponse response, void* user_data, int st
 static void HttpContent(dmHttpClient::HResponse, void* user_data, int status_code, const void* content_data, uint32_t content_data_size, int32_t content_length)
 {
     HttpProviderContext* archive = (HttpProviderContext*)user_data;
-    (void) status_code;
-
-    if (!content_data && content_data_size)
-    {
-        archive->m_HttpBuffer.SetSize(0);
-        return;
-    }
 
     // We must set http-status here. For direct cached result HttpHeader is not called.
     archive->m_HttpStatus = status_code;
 
-    if (archive->m_HttpBuffer.Remaining() < content_data_size) {
-        uint32_t diff = content_data_size - archive->m_HttpBuffer.Remaining();
-        // NOTE: Resizing the the array can be inefficient but sometimes we don't know the actual size, i.e. when "Content-Size" isn't set
-        archive->m_HttpBuffer.OffsetCapacity(diff + 1024 * 1024);
+    // The start of a new response body, e.g. after a retry
+    if (!content_data && !content_data_size)
+    {
+        archive->m_HttpTotalBytesStreamed = 0;
+        return;
     }
 
-    archive->m_HttpBuffer.PushArray((const char*) content_data, content_data_size);
+    // Data that doesn't fit is only counted, and the request is reported as failed
+    uint32_t offset = archive->m_HttpTotalBytesStreamed;
+    if (archive->m_Buffer && offset + content_data_size <= archive->m_BufferSize)
+    {
+        memcpy(archive->m_Buffer + offset, content_data, content_data_size);
+    }
     archive->m_HttpTotalBytesStreamed += content_data_size;
 }
 
@@ -145,18 +141,19 @@ static dmResourceProvider::Result Unmount(dmResourceProvider::HArchiveInternal a
     return dmResourceProvider::RESULT_OK;
 }
 
-static void ResetHttpInfo(HttpProviderContext* archive)
+static void ResetHttpInfo(HttpProviderContext* archive, uint8_t* buffer, uint32_t buffer_size)
 {
     archive->m_HttpContentLength = -1;
     archive->m_HttpTotalBytesStreamed = 0;
     archive->m_HttpStatus = -1;
-    archive->m_HttpBuffer.SetSize(0);
+    archive->m_Buffer = buffer;
+    archive->m_BufferSize = buffer_size;
 }
 
 // Note. This is used in a synchronous manner.
 static dmResourceProvider::Result GetRequestFromUri(HttpProviderContext* archive, const char* method, const char* path, uint32_t* buffer_length, uint8_t* buffer)
 {
-    ResetHttpInfo(archive);
+    ResetHttpInfo(archive, buffer, buffer ? *buffer_length : 0);
 
     // // Always verify cache for reloaded resources
     // if (factory->m_HttpCache)
@@ -166,6 +163,8 @@ static dmResourceProvider::Result GetRequestFromUri(HttpProviderContext* archive
     CreateEncodedUri(&archive->m_BaseUri, path, encoded_uri, sizeof(encoded_uri));
 
     dmHttpClient::Result http_result = dmHttpClient::Request(archive->m_HttpClient, method, encoded_uri);
+    archive->m_Buffer = 0;
+    archive->m_BufferSize = 0;
 
     // // Always verify cache for reloaded resources
     // if (factory->m_HttpCache)
@@ -209,11 +208,8 @@ static dmResourceProvider::Result GetRequestFromUri(HttpProviderContext* archive
         if (archive->m_HttpTotalBytesStreamed > *buffer_length)
             return dmResourceProvider::RESULT_IO_ERROR;
 
+        // The content has already been streamed into the buffer
         *buffer_length = archive->m_HttpTotalBytesStreamed;
-        if (buffer)
-        {
-            memcpy(buffer, archive->m_HttpBuffer.Begin(), *buffer_length);
-        }
     }
     return dmResourceProvider::RESULT_OK;
 }
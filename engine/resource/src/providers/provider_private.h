@@ -39,6 +39,7 @@ namespace dmResourceProvider
         FGetFileSize            m_GetFileSize;
         FReadFile               m_ReadFile;
         FWriteFile              m_WriteFile;        // For writeable archives
+        FGetFileData            m_GetFileData;      // For memory mapped archives
 
         void Verify();
 
@@ -43,6 +43,7 @@
 #include "resource.h"
 #include "resource_manifest.h"
 #include "resource_mounts.h"
+#include "resource_prefetch.h"
 #include "resource_private.h"
 #include "resource_util.h"
 #include <resource/resource_ddf.h>
@@ -110,6 +111,9 @@ struct ResourceFactory
     dmResourceProvider::HArchive                 m_BuiltinMount;
     dmResourceProvider::HArchive                 m_BaseArchiveMount;
 
+    // Records the load order, and/or prefetches resources from a previous recording
+    dmResourcePrefetch::HContext                 m_Prefetch;
+
     // Serial version that increases per resource insertion
     uint16_t                                     m_Version;
 };
@@ -167,6 +171,10 @@ void SetDefaultNewFactoryParams(struct NewFactoryParams* params)
     params->m_ArchiveIndex.m_Size = 0;
     params->m_ArchiveData.m_Data = 0;
     params->m_ArchiveData.m_Size = 0;
+
+    params->m_LoadOrderRecordPath = 0;
+    params->m_PrefetchPath = 0;
+    params->m_PrefetchMaxMemory = 16 * 1024 * 1024;
 }
 
 static Result AddBuiltinMount(HFactory factory, NewFactoryParams* params)
@@ -354,6 +362,16 @@ HFactory NewFactory(NewFactoryParams* params, const char* uri)
         AddBuiltinMount(factory, params);
     }
 
+    // Created last, so that the prefetcher sees the final mounts
+    if (params->m_LoadOrderRecordPath || params->m_PrefetchPath)
+    {
+        dmResourcePrefetch::Params prefetch_params;
+        prefetch_params.m_RecordPath = params->m_LoadOrderRecordPath;
+        prefetch_params.m_PrefetchPath = params->m_PrefetchPath;
+        prefetch_params.m_MaxMemory = params->m_PrefetchMaxMemory;
+        factory->m_Prefetch = dmResourcePrefetch::Create(factory->m_Mounts, prefetch_params);
+    }
+
     factory->m_LoadMutex = dmMutex::New();
     return factory;
 }
@@ -374,6 +392,12 @@ void DeleteFactory(HFactory factory)
         dmMutex::Delete(factory->m_LoadMutex);
     }
 
+    if (factory->m_Prefetch)
+    {
+        dmLogDebug("Resource prefetch hits: %u", dmResourcePrefetch::GetNumPrefetchHits(factory->m_Prefetch));
+        dmResourcePrefetch::Destroy(factory->m_Prefetch);
+    }
+
     ReleaseBuiltinsArchive(factory);
 
     if (factory->m_Mounts)
@@ -431,6 +455,8 @@ void UpdateFactory(HFactory factory)
 {
     DM_PROFILE(__FUNCTION__);
     dmMessage::Dispatch(factory->m_Socket, &Dispatch, factory);
+    if (factory->m_Prefetch)
+        dmResourcePrefetch::Update(factory->m_Prefetch);
     DM_PROPERTY_ADD_U32(rmtp_Resource, factory->m_Resources->Size());
 }
 
@@ -617,6 +643,14 @@ static Result LoadResourceFromBufferLocked(HFactory factory, const char* path, c
     // Let's find the resource in the current mounts
 
     dmhash_t normalized_path_hash = dmHashString64(normalized_path);
+
+    if (factory->m_Prefetch && dmResource::RESULT_OK == dmResourcePrefetch::GetPrefetched(factory->m_Prefetch, normalized_path_hash, buffer))
+    {
+        dmResourcePrefetch::RecordLoad(factory->m_Prefetch, normalized_path_hash, normalized_path);
+        *resource_size = buffer->Size();
+        return RESULT_OK;
+    }
+
     uint32_t file_size;
     dmResource::Result r = dmResourceMounts::GetResourceSize(factory->m_Mounts, normalized_path_hash, normalized_path, &file_size);
     if (r == dmResource::RESULT_OK)
@@ -631,6 +665,8 @@ static Result LoadResourceFromBufferLocked(HFactory factory, const char* path, c
         {
             buffer->SetSize(file_size);
             *resource_size = file_size;
+            if (factory->m_Prefetch)
+                dmResourcePrefetch::RecordLoad(factory->m_Prefetch, normalized_path_hash, normalized_path);
             return RESULT_OK;
         }
         return r;
@@ -665,6 +701,24 @@ Result LoadResource(HFactory factory, const char* path, const char* original_nam
     return r;
 }
 
+// Assumes m_LoadMutex is already held
+Result GetResourceData(HFactory factory, const char* path, const uint8_t** data, uint32_t* data_size)
+{
+    DM_PROFILE(__FUNCTION__);
+
+    char normalized_path[RESOURCE_PATH_MAX];
+    GetCanonicalPath(path, normalized_path);
+
+    dmhash_t normalized_path_hash = dmHashString64(normalized_path);
+    Result r = dmResourceMounts::GetResourceData(factory->m_Mounts, normalized_path_hash, normalized_path, data, data_size);
+    if (r == RESULT_OK && factory->m_Prefetch)
+    {
+        dmResourcePrefetch::Discard(factory->m_Prefetch, normalized_path_hash);
+        dmResourcePrefetch::RecordLoad(factory->m_Prefetch, normalized_path_hash, normalized_path);
+    }
+    return r;
+}
+
 const char* GetExtFromPath(const char* path)
 {
     return strrchr(path, '.');
@@ -672,7 +726,7 @@ const char* GetExtFromPath(const char* path)
 
 // Assumes m_LoadMutex is already held
 static Result DoCreateResource(HFactory factory, ResourceType* resource_type, const char* name, const char* canonical_path,
-    dmhash_t canonical_path_hash, void* buffer, uint32_t buffer_size, void** resource_out)
+    dmhash_t canonical_path_hash, const void* buffer, uint32_t buffer_size, void** resource_out)
 {
     // TODO: We should *NOT* allocate SResource dynamically...
     ResourceDescriptor tmp_resource;
@@ -832,6 +886,18 @@ static Result CreateAndLoadResource(HFactory factory, const char* name, void** r
         return RESULT_OK;
     }
 
+    // If the type allows it, we pass the memory mapped data directly to the resource type.
+    // The data is only used while the load mutex is held, so the mount cannot be removed meanwhile
+    if (resource_type->m_ZeroCopy)
+    {
+        const uint8_t* data;
+        uint32_t data_size;
+        if (GetResourceData(factory, canonical_path, &data, &data_size) == RESULT_OK)
+        {
+            return DoCreateResource(factory, resource_type, name, canonical_path, canonical_path_hash, data, data_size, resource);
+        }
+    }
+
     void* buffer         = 0;
     uint32_t buffer_size = 0;
     Result result = LoadResource(factory, canonical_path, name, &buffer, &buffer_size);
@@ -983,6 +1049,17 @@ Result GetRaw(HFactory factory, const char* name, void** resource, uint32_t* res
     char canonical_path[RESOURCE_PATH_MAX];
     GetCanonicalPath(name, canonical_path);
 
+    // We copy the data anyways, so avoid the intermediate buffer if possible
+    const uint8_t* data;
+    uint32_t data_size;
+    if (GetResourceData(factory, canonical_path, &data, &data_size) == RESULT_OK)
+    {
+        *resource = malloc(data_size);
+        memcpy(*resource, data, data_size);
+        *resource_size = data_size;
+        return RESULT_OK;
+    }
+
     void* buffer;
     uint32_t buffer_size;
     Result result = LoadResource(factory, canonical_path, name, &buffer, &buffer_size);
@@ -1255,6 +1332,16 @@ Result GetTypeFromExtension(HFactory factory, const char* extension, HResourceTy
     return GetTypeFromExtensionHash(factory, dmHashString64(extension), type);
 }
 
+Result SetTypeZeroCopy(HFactory factory, const char* extension, bool zero_copy)
+{
+    HResourceType type;
+    Result r = GetTypeFromExtension(factory, extension, &type);
+    if (r != RESULT_OK)
+        return r;
+    type->m_ZeroCopy = zero_copy;
+    return RESULT_OK;
+}
+
 Result GetExtensionFromType(HFactory factory, HResourceType type, const char** extension)
 {
     for (uint32_t i = 0; i < factory->m_ResourceTypesCount; ++i)
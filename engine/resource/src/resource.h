@@ -137,6 +137,13 @@ namespace dmResource
         EmbeddedResource m_ArchiveData;
         EmbeddedResource m_ArchiveManifest;
 
+        /// If set, the order in which resources are loaded is written to this file when the factory is deleted
+        const char* m_LoadOrderRecordPath;
+        /// If set, the resources listed in this (recorded) file are read on a background thread
+        const char* m_PrefetchPath;
+        /// Max number of prefetched bytes waiting to be loaded. Default is 16MB
+        uint32_t m_PrefetchMaxMemory;
+
         uint32_t m_Reserved[5];
 
         NewFactoryParams()
@@ -246,6 +253,22 @@ namespace dmResource
      */
     Result GetTypeFromExtensionHash(HFactory factory, dmhash_t extension_hash, HResourceType* type);
 
+    /**
+     * Let the resource type read its data directly from memory mapped archives, instead of from a copy.
+     * The buffer passed to the preload and create functions is then read only, and it must not be
+     * referenced after the create function has returned.
+     *
+     * This only applies to resources created directly by Get(), and to GetRaw(), for entries that
+     * are stored uncompressed and unencrypted in a memory mapped archive. The preloader keeps its
+     * buffers across frames, during which a mount may be removed, so it still reads a copy.
+     * Compressed entries are decompressed into the load buffer as before.
+     * @param factory Factory handle
+     * @param extension File extension
+     * @param zero_copy true to enable zero copy loading
+     * @return RESULT_OK on success
+     */
+    Result SetTypeZeroCopy(HFactory factory, const char* extension, bool zero_copy);
+
     /**
      * Get extension from type
      * @param factory Factory handle
@@ -614,6 +614,21 @@ namespace dmResourceArchive
         return dmResourceArchive::RESULT_OK;
     }
 
+    Result GetEntryData(HArchiveIndexContainer archive, const EntryData* entry, const void** out_data, uint32_t* out_size)
+    {
+        const uint32_t flags            = dmEndian::ToNetwork(entry->m_Flags);
+        const uint32_t size             = dmEndian::ToNetwork(entry->m_ResourceSize);
+        const uint32_t resource_offset  = dmEndian::ToNetwork(entry->m_ResourceDataOffset);
+
+        const ArchiveFileIndex* afi = archive->m_ArchiveFileIndex;
+        if (!afi->m_IsMemMapped || (flags & (dmResourceArchive::ENTRY_FLAG_ENCRYPTED | dmResourceArchive::ENTRY_FLAG_COMPRESSED)))
+            return dmResourceArchive::RESULT_NOT_FOUND;
+
+        *out_data = (const void*)((uintptr_t)afi->m_ResourceData + resource_offset);
+        *out_size = size;
+        return dmResourceArchive::RESULT_OK;
+    }
+
     Result WriteArchiveIndex(const char* path, ArchiveIndex* ai)
     {
         // Write to temporary index file, filename liveupdate.arci.tmp
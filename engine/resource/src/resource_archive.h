@@ -212,6 +212,18 @@ namespace dmResourceArchive
      */
     Result ReadEntry(HArchiveIndexContainer archive, const EntryData* entry, void* buffer);
 
+    /**
+     * Get a pointer to the resource data within the given archive, without copying it.
+     * Only possible if the archive data is memory mapped, and the entry is neither compressed nor encrypted.
+     * The data is valid as long as the archive is loaded.
+     * @param archive archive index handle
+     * @param entry_data entry data
+     * @param out_data pointer to the read only resource data
+     * @param out_size size of the resource data
+     * @return RESULT_OK on success, RESULT_NOT_FOUND if the entry has to be read using ReadEntry()
+     */
+    Result GetEntryData(HArchiveIndexContainer archive, const EntryData* entry, const void** out_data, uint32_t* out_size);
+
     /**
      * Delete archive index. Only required for archives created with LoadArchive function
      * @param archive archive index handle
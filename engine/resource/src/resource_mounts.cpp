@@ -41,6 +41,16 @@ struct ArchiveMount
     bool                            m_Persist;
 };
 
+// Remembers which mount last resolved a path, so that subsequent lookups
+// only need to query a single provider. This is a cache of path -> mount, filled
+// on first lookup. The providers have no entry handle to store here, so the
+// provider still looks the path up in its own table on each query.
+struct MountIndexEntry
+{
+    dmResourceProvider::HArchive    m_Archive;
+    int                             m_Priority;
+};
+
 struct CustomFile
 {
     const void* m_Resource;
@@ -51,10 +61,11 @@ struct ResourceMountsContext
 {
     // The currently mounted archives, in sorted order
     dmArray<ArchiveMount>           m_Mounts;
+    dmHashTable64<MountIndexEntry>  m_Index;
     dmHashTable64<CustomFile>       m_CustomFiles;
     dmResourceProvider::HArchive    m_ResourceBaseArchive;
     dmMutex::HMutex                 m_Mutex;
-
+    uint32_t                        m_Version; // Incremented whenever the content of the mounts may have changed
 };
 
 
@@ -76,6 +87,7 @@ HContext Create(dmResourceProvider::HArchive base_archive)
     ResourceMountsContext* ctx = new ResourceMountsContext;
     ctx->m_Mounts.SetCapacity(2);
     ctx->m_Mutex = dmMutex::New();
+    ctx->m_Version = 0;
     ctx->m_ResourceBaseArchive = base_archive;
     return ctx;
 }
@@ -86,6 +98,7 @@ void Destroy(HContext ctx)
         DM_MUTEX_SCOPED_LOCK(ctx->m_Mutex);
         DestroyMounts(ctx);
 
+        ctx->m_Index.Clear();
         ctx->m_CustomFiles.Clear();
     }
     dmMutex::Delete(ctx->m_Mutex);
@@ -105,10 +118,105 @@ static void SortMounts(dmArray<ArchiveMount>& mounts)
     std::sort(mounts.Begin(), mounts.End(), MountSortPred());
 }
 
+// ****************************************
+// Mount index
+
+// Assumes mutex lock is held
+static void AddToIndex(HContext ctx, dmhash_t path_hash, const ArchiveMount& mount)
+{
+    if (ctx->m_Index.Full())
+    {
+        uint32_t capacity = ctx->m_Index.Capacity() + 256;
+        ctx->m_Index.SetCapacity((capacity*2)/3, capacity);
+    }
+    MountIndexEntry entry;
+    entry.m_Archive = mount.m_Archive;
+    entry.m_Priority = mount.m_Priority;
+    ctx->m_Index.Put(path_hash, entry);
+}
+
+// Removes all index entries that may no longer be valid
+// If archive is set, we remove the entries for that archive.
+// Otherwise, we remove the entries that may be shadowed by a mount with the given priority
+// Assumes mutex lock is held
+static void InvalidateIndex(HContext ctx, dmResourceProvider::HArchive archive, int priority)
+{
+    if (ctx->m_Index.Empty())
+        return;
+
+    dmArray<dmhash_t> stale;
+    dmHashTable64<MountIndexEntry>::Iterator iter = ctx->m_Index.GetIterator();
+    while (iter.Next())
+    {
+        const MountIndexEntry& entry = iter.GetValue();
+        bool is_stale = archive ? entry.m_Archive == archive : entry.m_Priority <= priority;
+        if (!is_stale)
+            continue;
+
+        if (stale.Full())
+            stale.OffsetCapacity(64);
+        stale.Push(iter.GetKey());
+    }
+
+    uint32_t size = stale.Size();
+    for (uint32_t i = 0; i < size; ++i)
+    {
+        ctx->m_Index.Erase(stale[i]);
+    }
+
+    DM_RESOURCE_DBG_LOG(2, "Invalidated %u mount index entries (%u left)\n", size, ctx->m_Index.Size());
+}
+
+// Returns the mount that last resolved the path, or 0 if it isn't known
+// Assumes mutex lock is held
+static ArchiveMount* FindIndexedMount(HContext ctx, dmhash_t path_hash)
+{
+    MountIndexEntry* entry = ctx->m_Index.Get(path_hash);
+    if (!entry)
+        return 0;
+
+    uint32_t size = ctx->m_Mounts.Size();
+    for (uint32_t i = 0; i < size; ++i)
+    {
+        ArchiveMount& mount = ctx->m_Mounts[i];
+        if (mount.m_Archive == entry->m_Archive)
+            return &mount;
+    }
+
+    ctx->m_Index.Erase(path_hash);
+    return 0;
+}
+
+void InvalidateResource(HContext ctx, dmhash_t path_hash)
+{
+    DM_MUTEX_SCOPED_LOCK(ctx->m_Mutex);
+    if (ctx->m_Index.Get(path_hash))
+        ctx->m_Index.Erase(path_hash);
+    ctx->m_Version++;
+}
+
+uint32_t GetIndexSize(HContext ctx)
+{
+    DM_MUTEX_SCOPED_LOCK(ctx->m_Mutex);
+    return ctx->m_Index.Size();
+}
+
+uint32_t GetVersion(HContext ctx)
+{
+    DM_MUTEX_SCOPED_LOCK(ctx->m_Mutex);
+    return ctx->m_Version;
+}
+
+// ****************************************
+
 static void AddMountInternal(HContext ctx, const ArchiveMount& mount)
 {
     DM_MUTEX_SCOPED_LOCK(ctx->m_Mutex);
 
+    // Any resource resolved by a mount of lower priority, may now be overridden by the new mount
+    InvalidateIndex(ctx, 0, mount.m_Priority);
+    ctx->m_Version++;
+
     if (ctx->m_Mounts.Full())
         ctx->m_Mounts.OffsetCapacity(2);
 
@@ -170,6 +278,9 @@ static dmResource::Result RemoveMountByIndexInternal(HContext ctx, uint32_t inde
     if (index >= ctx->m_Mounts.Size())
         return dmResource::RESULT_RESOURCE_NOT_FOUND;
 
+    InvalidateIndex(ctx, ctx->m_Mounts[index].m_Archive, 0);
+    ctx->m_Version++;
+
     ctx->m_Mounts.EraseSwap(index); // TODO: We'd like an Erase() function in dmArray, to keep the internal ordering
     SortMounts(ctx->m_Mounts);
 
@@ -363,6 +474,7 @@ static dmResource::Result DestroyMounts(HContext ctx)
         dmResourceProvider::Unmount(mount.m_Archive);
     }
     ctx->m_Mounts.SetSize(0);
+    ctx->m_Index.Clear();
     return dmResource::RESULT_OK;
 }
 
@@ -397,9 +509,22 @@ static dmResource::Result ReadCustomResource(HContext ctx, dmhash_t path_hash, u
     return dmResource::RESULT_RESOURCE_NOT_FOUND;
 }
 
-dmResource::Result GetResourceSize(HContext ctx, dmhash_t path_hash, const char* path, uint32_t* resource_size)
+// Finds the mount that holds the resource, using the mount index first
+// Assumes mutex lock is held
+static dmResource::Result FindResourceMount(HContext ctx, dmhash_t path_hash, const char* path, ArchiveMount** out_mount, uint32_t* resource_size)
 {
-    DM_MUTEX_SCOPED_LOCK(ctx->m_Mutex);
+    ArchiveMount* indexed_mount = FindIndexedMount(ctx, path_hash);
+    if (indexed_mount)
+    {
+        dmResourceProvider::Result result = dmResourceProvider::GetFileSize(indexed_mount->m_Archive, path_hash, path, resource_size);
+        if (dmResourceProvider::RESULT_OK == result)
+            *out_mount = indexed_mount;
+        if (dmResourceProvider::RESULT_NOT_FOUND != result)
+            return ProviderResultToResult(result);
+
+        // The file was removed from the mount since we last looked
+        ctx->m_Index.Erase(path_hash);
+    }
 
     uint32_t size = ctx->m_Mounts.Size();
     for (uint32_t i = 0; i < size; ++i)
@@ -412,11 +537,24 @@ dmResource::Result GetResourceSize(HContext ctx, dmhash_t path_hash, const char*
         {
             DM_RESOURCE_DBG_LOG(3, "GetResourceSize OK: %s  " DM_HASH_FMT " (%u bytes)\n", path, path_hash, *resource_size);
             DebugPrintMount(3, mount);
-            return dmResource::RESULT_OK;
+            AddToIndex(ctx, path_hash, mount);
+            *out_mount = &mount;
         }
         return ProviderResultToResult(result);
     }
 
+    return dmResource::RESULT_RESOURCE_NOT_FOUND;
+}
+
+dmResource::Result GetResourceSize(HContext ctx, dmhash_t path_hash, const char* path, uint32_t* resource_size)
+{
+    DM_MUTEX_SCOPED_LOCK(ctx->m_Mutex);
+
+    ArchiveMount* mount = 0;
+    dmResource::Result result = FindResourceMount(ctx, path_hash, path, &mount, resource_size);
+    if (dmResource::RESULT_RESOURCE_NOT_FOUND != result)
+        return result;
+
     if (!ctx->m_CustomFiles.Empty())
         return GetCustomResourceSize(ctx, path_hash, path, resource_size);
 
@@ -433,6 +571,17 @@ dmResource::Result ReadResource(HContext ctx, dmhash_t path_hash, const char* pa
 {
     DM_MUTEX_SCOPED_LOCK(ctx->m_Mutex);
 
+    ArchiveMount* indexed_mount = FindIndexedMount(ctx, path_hash);
+    if (indexed_mount)
+    {
+        dmResourceProvider::Result result = dmResourceProvider::ReadFile(indexed_mount->m_Archive, path_hash, path, buffer, buffer_size);
+        if (dmResourceProvider::RESULT_NOT_FOUND != result)
+            return ProviderResultToResult(result);
+
+        // The file was removed from the mount since we last looked
+        ctx->m_Index.Erase(path_hash);
+    }
+
     uint32_t size = ctx->m_Mounts.Size();
     for (uint32_t i = 0; i < size; ++i)
     {
@@ -444,6 +593,7 @@ dmResource::Result ReadResource(HContext ctx, dmhash_t path_hash, const char* pa
         {
             DM_RESOURCE_DBG_LOG(3, "ReadResource: %s (%u bytes)\n", path, buffer_size);
             DebugPrintMount(3, mount);
+            AddToIndex(ctx, path_hash, mount);
             return dmResource::RESULT_OK;
         }
         return ProviderResultToResult(result);
@@ -455,28 +605,47 @@ dmResource::Result ReadResource(HContext ctx, dmhash_t path_hash, const char* pa
     return dmResource::RESULT_RESOURCE_NOT_FOUND;
 }
 
-dmResource::Result ReadResource(HContext ctx, const char* path, dmhash_t path_hash, dmArray<char>* buffer)
+dmResource::Result GetResourceData(HContext ctx, dmhash_t path_hash, const char* path, const uint8_t** data, uint32_t* data_size)
 {
     DM_MUTEX_SCOPED_LOCK(ctx->m_Mutex);
 
+    ArchiveMount* mount = 0;
     uint32_t resource_size;
-    uint32_t size = ctx->m_Mounts.Size();
-    for (uint32_t i = 0; i < size; ++i)
+    dmResource::Result find_result = FindResourceMount(ctx, path_hash, path, &mount, &resource_size);
+    if (dmResource::RESULT_OK != find_result)
+        return find_result; // custom files are always copied
+
+    dmResourceProvider::Result result = dmResourceProvider::GetFileData(mount->m_Archive, path_hash, path, data, data_size);
+    if (dmResourceProvider::RESULT_NOT_SUPPORTED == result)
+        return dmResource::RESULT_NOT_SUPPORTED;
+    if (dmResourceProvider::RESULT_OK == result)
     {
-        ArchiveMount& mount = ctx->m_Mounts[i];
-        dmResourceProvider::Result result = dmResourceProvider::GetFileSize(mount.m_Archive, path_hash, path, &resource_size);
-        if (dmResourceProvider::RESULT_OK == result)
-        {
-            if (buffer->Capacity() < resource_size)
-                buffer->SetCapacity(resource_size);
-            buffer->SetSize(resource_size);
+        DM_RESOURCE_DBG_LOG(3, "GetResourceData: %s (%u bytes)\n", path, *data_size);
+        DebugPrintMount(3, *mount);
+    }
+    return ProviderResultToResult(result);
+}
 
-            result = dmResourceProvider::ReadFile(mount.m_Archive, path_hash, path, (uint8_t*)buffer->Begin(), resource_size);
-            DM_RESOURCE_DBG_LOG(3, "ReadResource: %s (%u bytes) - result %d\n", path, resource_size, result);
-            DebugPrintMount(3, mount);
-            return ProviderResultToResult(result);
-        }
+dmResource::Result ReadResource(HContext ctx, dmhash_t path_hash, const char* path, dmArray<char>* buffer)
+{
+    DM_MUTEX_SCOPED_LOCK(ctx->m_Mutex);
+
+    ArchiveMount* mount = 0;
+    uint32_t resource_size;
+    dmResource::Result find_result = FindResourceMount(ctx, path_hash, path, &mount, &resource_size);
+    if (dmResource::RESULT_OK == find_result)
+    {
+        if (buffer->Capacity() < resource_size)
+            buffer->SetCapacity(resource_size);
+        buffer->SetSize(resource_size);
+
+        dmResourceProvider::Result result = dmResourceProvider::ReadFile(mount->m_Archive, path_hash, path, (uint8_t*)buffer->Begin(), resource_size);
+        DM_RESOURCE_DBG_LOG(3, "ReadResource: %s (%u bytes) - result %d\n", path, resource_size, result);
+        DebugPrintMount(3, *mount);
+        return ProviderResultToResult(result);
     }
+    if (dmResource::RESULT_RESOURCE_NOT_FOUND != find_result)
+        return find_result;
 
     if (!ctx->m_CustomFiles.Empty())
     {
@@ -514,6 +683,7 @@ dmResource::Result AddFile(HContext context, dmhash_t path_hash, uint32_t size,
         context->m_CustomFiles.SetCapacity((capacity*2)/3, capacity);
     }
     context->m_CustomFiles.Put(path_hash, file);
+    context->m_Version++;
     return dmResource::RESULT_OK;
 }
 
@@ -525,6 +695,7 @@ dmResource::Result RemoveFile(HContext context, dmhash_t path_hash)
         return dmResource::RESULT_RESOURCE_NOT_FOUND;
 
     context->m_CustomFiles.Erase(path_hash);
+    context->m_Version++;
     return dmResource::RESULT_OK;
 }
 
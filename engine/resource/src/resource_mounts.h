@@ -52,6 +52,20 @@ namespace dmResourceMounts
     dmResource::Result ReadResource(HContext ctx, dmhash_t path_hash, const char* path, uint8_t* buffer, uint32_t buffer_size);
     dmResource::Result ReadResource(HContext ctx, dmhash_t path_hash, const char* path, dmArray<char>* buffer);
 
+    // Gets a read only pointer to the resource data, without copying it.
+    // The data is owned by the mount, and is only valid as long as the mount is mounted.
+    // Returns RESULT_NOT_SUPPORTED if the mount cannot provide the data without copying. Use ReadResource() instead.
+    dmResource::Result GetResourceData(HContext ctx, dmhash_t path_hash, const char* path, const uint8_t** data, uint32_t* data_size);
+
+    // The mounts keep an index of which mount resolved a resource, making repeated lookups a single hash probe.
+    // The index is updated when mounts are added or removed, but if a resource is written to an existing mount,
+    // the index entry needs to be invalidated
+    void        InvalidateResource(HContext ctx, dmhash_t path_hash);
+    uint32_t    GetIndexSize(HContext ctx);
+
+    // Returns a counter that changes whenever a mount is added or removed, or a resource is invalidated
+    uint32_t    GetVersion(HContext ctx);
+
     struct SGetMountResult
     {
         const char*                  m_Name;
@@ -0,0 +1,475 @@
+// Copyright 2020-2024 The Defold Foundation
+// Copyright 2014-2020 King
+// Copyright 2009-2014 Ragnar Svensson, Christian Murray
+// Licensed under the Defold License version 1.0 (the "License"); you may not use
+// this file except in compliance with the License.
+//
+// You may obtain a copy of the License, together with FAQs at
+// https://www.defold.com/license
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "resource_prefetch.h"
+#include "resource_private.h" // for log
+
+#include <dlib/atomic.h>
+#include <dlib/condition_variable.h>
+#include <dlib/dstrings.h>
+#include <dlib/hashtable.h>
+#include <dlib/log.h>
+#include <dlib/mutex.h>
+#include <dlib/profile.h>
+#include <dlib/sys.h>
+#include <dlib/thread.h>
+#include <dlib/time.h>
+
+namespace dmResourcePrefetch
+{
+
+const int LOADORDER_HEADER_VERSION = 1;
+const uint32_t PREFETCH_BATCH_SIZE = 16;
+
+struct PrefetchEntry
+{
+    uint8_t*    m_Data;
+    uint32_t    m_Size;
+    uint32_t    m_MountsVersion; // If the mounts changed, the data may be stale
+};
+
+struct PrefetchContext
+{
+    dmResourceMounts::HContext              m_Mounts;
+
+    // Recording
+    char*                                   m_RecordPath;
+    dmArray<LoadOrderEntry>                 m_Recorded;
+    dmHashTable64<bool>                     m_RecordedSet;
+    uint64_t                                m_RecordStartTime;
+
+    // Prefetching
+    dmArray<LoadOrderEntry>                 m_Entries;
+    dmHashTable64<PrefetchEntry>            m_Prefetched;   // Resources that are read, but not yet requested
+    dmHashTable64<bool>                     m_Requested;    // Resources that were requested, and shouldn't be prefetched anymore
+    dmThread::Thread                        m_Thread;
+    dmMutex::HMutex                         m_Mutex;
+    dmConditionVariable::HConditionVariable m_Condition;
+    uint32_t                                m_MaxMemory;
+    uint32_t                                m_Memory;       // Bytes currently held in m_Prefetched
+    uint32_t                                m_NumHits;
+    uint64_t                                m_Deadline;     // When unused prefetched data is released
+    bool                                    m_Active;       // False once prefetching was stopped
+    int32_atomic_t                          m_Quit;
+    int32_atomic_t                          m_Done;         // Set by the thread when it has gone through all entries
+};
+
+Params::Params()
+{
+    memset(this, 0, sizeof(*this));
+    m_MaxMemory = 16 * 1024 * 1024;
+    m_Timeout = 10 * 1000000;
+}
+
+template<typename T>
+static void EnsureCapacity(dmHashTable64<T>& table, uint32_t grow)
+{
+    if (table.Full())
+    {
+        uint32_t capacity = table.Capacity() + grow;
+        table.SetCapacity((capacity*2)/3, capacity);
+    }
+}
+
+// ****************************************
+// Load order file
+
+dmResource::Result ReadLoadOrderFile(const char* path, dmArray<LoadOrderEntry>& entries)
+{
+    FILE* file = fopen(path, "rb");
+    if (!file)
+    {
+        dmLogError("Failed to open load order file '%s'", path);
+        return dmResource::RESULT_RESOURCE_NOT_FOUND;
+    }
+
+    char line[1024];
+    int version = -1;
+    if (!fgets(line, sizeof(line), file) || 1 != sscanf(line, "VERSION %d", &version) || version != LOADORDER_HEADER_VERSION)
+    {
+        dmLogError("Load order file '%s' has wrong version. Expected %d, got %d", path, LOADORDER_HEADER_VERSION, version);
+        fclose(file);
+        return dmResource::RESULT_VERSION_MISMATCH;
+    }
+
+    while (fgets(line, sizeof(line), file))
+    {
+        size_t len = strlen(line);
+        while (len && (line[len-1] == '\n' || line[len-1] == '\r'))
+            line[--len] = 0;
+
+        char* sep = strchr(line, ' ');
+        if (!sep || sep[1] != '/')
+            continue;
+        *sep = 0;
+
+        LoadOrderEntry entry;
+        entry.m_Time = strtoull(line, 0, 10);
+        entry.m_Path = strdup(sep + 1);
+
+        if (entries.Full())
+            entries.OffsetCapacity(64);
+        entries.Push(entry);
+    }
+
+    fclose(file);
+    return dmResource::RESULT_OK;
+}
+
+dmResource::Result WriteLoadOrderFile(const char* path, const dmArray<LoadOrderEntry>& entries)
+{
+    FILE* file = fopen(path, "wb");
+    if (!file)
+    {
+        dmLogError("Failed to open load order file '%s' for writing", path);
+        return dmResource::RESULT_IO_ERROR;
+    }
+
+    fprintf(file, "VERSION %d\n", LOADORDER_HEADER_VERSION);
+
+    uint32_t size = entries.Size();
+    for (uint32_t i = 0; i < size; ++i)
+    {
+        const LoadOrderEntry& entry = entries[i];
+        fprintf(file, "%llu %s\n", (unsigned long long)entry.m_Time, entry.m_Path);
+    }
+
+    fclose(file);
+    return dmResource::RESULT_OK;
+}
+
+void FreeLoadOrderFile(dmArray<LoadOrderEntry>& entries)
+{
+    uint32_t size = entries.Size();
+    for (uint32_t i = 0; i < size; ++i)
+    {
+        free((void*)entries[i].m_Path);
+    }
+    entries.SetSize(0);
+}
+
+// ****************************************
+// Prefetching
+
+struct BatchItem
+{
+    dmhash_t    m_PathHash;
+    uint32_t    m_Index;
+    uint32_t    m_Size;
+    uint8_t*    m_Data;
+};
+
+static void FreePrefetched(PrefetchContext* ctx)
+{
+    // Lock should already be held
+    dmHashTable64<PrefetchEntry>::Iterator iter = ctx->m_Prefetched.GetIterator();
+    while (iter.Next())
+    {
+        free((void*)iter.GetValue().m_Data);
+    }
+    ctx->m_Prefetched.Clear();
+    ctx->m_Memory = 0;
+}
+
+static void PrefetchThread(void* _ctx)
+{
+    PrefetchContext* ctx = (PrefetchContext*)_ctx;
+
+    BatchItem batch[PREFETCH_BATCH_SIZE];
+    uint32_t num_prefetched = 0;
+    uint32_t required = 1; // Bytes that must fit in the memory budget before we can continue
+    uint32_t next = 0;
+    uint32_t size = ctx->m_Entries.Size();
+    while (next < size && !dmAtomicGet32(&ctx->m_Quit))
+    {
+        uint32_t batch_size = 0;
+        uint32_t budget = 0;
+        {
+            DM_MUTEX_SCOPED_LOCK(ctx->m_Mutex);
+            while (ctx->m_Memory + required > ctx->m_MaxMemory && !dmAtomicGet32(&ctx->m_Quit))
+            {
+                dmConditionVariable::Wait(ctx->m_Condition, ctx->m_Mutex);
+            }
+            budget = ctx->m_MaxMemory - ctx->m_Memory;
+
+            for (; next < size && batch_size < PREFETCH_BATCH_SIZE; ++next)
+            {
+                dmhash_t path_hash = dmHashString64(ctx->m_Entries[next].m_Path);
+                if (ctx->m_Requested.Get(path_hash) || ctx->m_Prefetched.Get(path_hash))
+                    continue;
+
+                BatchItem& item = batch[batch_size++];
+                item.m_PathHash = path_hash;
+                item.m_Index = next;
+                item.m_Size = 0;
+                item.m_Data = 0;
+            }
+        }
+
+        uint32_t mounts_version = dmResourceMounts::GetVersion(ctx->m_Mounts);
+
+        // Read the whole batch back to back, in load order, without touching the shared state in between
+        required = 1;
+        uint32_t batch_memory = 0;
+        for (uint32_t i = 0; i < batch_size && !dmAtomicGet32(&ctx->m_Quit); ++i)
+        {
+            BatchItem& item = batch[i];
+            const char* path = ctx->m_Entries[item.m_Index].m_Path;
+
+            uint32_t resource_size;
+            dmResource::Result r = dmResourceMounts::GetResourceSize(ctx->m_Mounts, item.m_PathHash, path, &resource_size);
+            if (dmResource::RESULT_OK != r || resource_size > ctx->m_MaxMemory)
+                continue;
+
+            if (batch_memory + resource_size > budget)
+            {
+                // Continue with this resource once enough prefetched data has been consumed
+                next = item.m_Index;
+                required = resource_size;
+                batch_size = i;
+                break;
+            }
+
+            item.m_Data = (uint8_t*)malloc(resource_size);
+            r = dmResourceMounts::ReadResource(ctx->m_Mounts, item.m_PathHash, path, item.m_Data, resource_size);
+            if (dmResource::RESULT_OK != r)
+            {
+                free(item.m_Data);
+                item.m_Data = 0;
+                continue;
+            }
+            item.m_Size = resource_size;
+            batch_memory += resource_size;
+        }
+
+        DM_MUTEX_SCOPED_LOCK(ctx->m_Mutex);
+        for (uint32_t i = 0; i < batch_size; ++i)
+        {
+            BatchItem& item = batch[i];
+            if (!item.m_Data)
+                continue;
+
+            // It was loaded while we were reading it, or we're shutting down
+            if (ctx->m_Requested.Get(item.m_PathHash) || dmAtomicGet32(&ctx->m_Quit))
+            {
+                free(item.m_Data);
+                continue;
+            }
+
+            PrefetchEntry entry;
+            entry.m_Data = item.m_Data;
+            entry.m_Size = item.m_Size;
+            entry.m_MountsVersion = mounts_version;
+            EnsureCapacity(ctx->m_Prefetched, 64);
+            ctx->m_Prefetched.Put(item.m_PathHash, entry);
+            ctx->m_Memory += item.m_Size;
+            ++num_prefetched;
+        }
+    }
+
+    dmAtomicStore32(&ctx->m_Done, 1);
+    DM_RESOURCE_DBG_LOG(1, "Prefetched %u out of %u resources\n", num_prefetched, size);
+}
+
+// Stops the prefetch thread, and releases any data that wasn't consumed
+static void StopPrefetching(PrefetchContext* ctx)
+{
+    if (!ctx->m_Thread)
+        return;
+
+    {
+        DM_MUTEX_SCOPED_LOCK(ctx->m_Mutex);
+        ctx->m_Active = false;
+        dmAtomicStore32(&ctx->m_Quit, 1);
+        dmConditionVariable::Broadcast(ctx->m_Condition);
+    }
+    dmThread::Join(ctx->m_Thread);
+    ctx->m_Thread = 0;
+
+    DM_MUTEX_SCOPED_LOCK(ctx->m_Mutex);
+    DM_RESOURCE_DBG_LOG(1, "Stopped prefetching. Released %u unused resources (%u bytes)\n", ctx->m_Prefetched.Size(), ctx->m_Memory);
+    FreePrefetched(ctx);
+}
+
+HContext Create(dmResourceMounts::HContext mounts, const Params& params)
+{
+    PrefetchContext* ctx = new PrefetchContext;
+    ctx->m_Mounts = mounts;
+    ctx->m_RecordPath = params.m_RecordPath ? strdup(params.m_RecordPath) : 0;
+    ctx->m_RecordStartTime = dmTime::GetTime();
+    ctx->m_Thread = 0;
+    ctx->m_Mutex = dmMutex::New();
+    ctx->m_Condition = dmConditionVariable::New();
+    ctx->m_MaxMemory = params.m_MaxMemory;
+    ctx->m_Memory = 0;
+    ctx->m_NumHits = 0;
+    ctx->m_Deadline = 0;
+    ctx->m_Active = false;
+    ctx->m_Quit = 0;
+    ctx->m_Done = 0;
+
+    if (params.m_PrefetchPath && dmSys::Exists(params.m_PrefetchPath))
+    {
+        if (!dmThread::PlatformHasThreadSupport())
+        {
+            dmLogWarning("Resource prefetching requires thread support");
+        }
+        else if (dmResource::RESULT_OK == ReadLoadOrderFile(params.m_PrefetchPath, ctx->m_Entries) && !ctx->m_Entries.Empty())
+        {
+            dmLogInfo("Prefetching %u resources from '%s'", ctx->m_Entries.Size(), params.m_PrefetchPath);
+            // Give up on data that the game hasn't asked for some time after the recorded sequence ended
+            ctx->m_Deadline = ctx->m_RecordStartTime + ctx->m_Entries.Back().m_Time + params.m_Timeout;
+            ctx->m_Active = true;
+            ctx->m_Thread = dmThread::New(PrefetchThread, 0x80000, ctx, "res_prefetch");
+        }
+    }
+    return ctx;
+}
+
+void Destroy(HContext ctx)
+{
+    StopPrefetching(ctx);
+
+    if (ctx->m_RecordPath)
+    {
+        if (dmResource::RESULT_OK == WriteLoadOrderFile(ctx->m_RecordPath, ctx->m_Recorded))
+            dmLogInfo("Wrote resource load order (%u resources) to '%s'", ctx->m_Recorded.Size(), ctx->m_RecordPath);
+        free((void*)ctx->m_RecordPath);
+    }
+
+    FreeLoadOrderFile(ctx->m_Recorded);
+    FreeLoadOrderFile(ctx->m_Entries);
+    dmConditionVariable::Delete(ctx->m_Condition);
+    dmMutex::Delete(ctx->m_Mutex);
+    delete ctx;
+}
+
+void Update(HContext ctx)
+{
+    if (!ctx->m_Thread)
+        return;
+
+    bool finished;
+    {
+        DM_MUTEX_SCOPED_LOCK(ctx->m_Mutex);
+        finished = dmAtomicGet32(&ctx->m_Done) && ctx->m_Prefetched.Empty();
+    }
+
+    if (finished || dmTime::GetTime() >= ctx->m_Deadline)
+        StopPrefetching(ctx);
+}
+
+bool IsPrefetching(HContext ctx)
+{
+    DM_MUTEX_SCOPED_LOCK(ctx->m_Mutex);
+    return ctx->m_Active && !dmAtomicGet32(&ctx->m_Done);
+}
+
+void RecordLoad(HContext ctx, dmhash_t path_hash, const char* path)
+{
+    if (!ctx->m_RecordPath)
+        return;
+
+    // Only the first load is of interest for the startup sequence
+    if (ctx->m_RecordedSet.Get(path_hash))
+        return;
+
+    EnsureCapacity(ctx->m_RecordedSet, 256);
+    ctx->m_RecordedSet.Put(path_hash, true);
+
+    LoadOrderEntry entry;
+    entry.m_Path = strdup(path);
+    entry.m_Time = dmTime::GetTime() - ctx->m_RecordStartTime;
+
+    if (ctx->m_Recorded.Full())
+        ctx->m_Recorded.OffsetCapacity(256);
+    ctx->m_Recorded.Push(entry);
+}
+
+dmResource::Result GetPrefetched(HContext ctx, dmhash_t path_hash, dmResource::LoadBufferType* buffer)
+{
+    if (ctx->m_Entries.Empty()) // Not prefetching
+        return dmResource::RESULT_RESOURCE_NOT_FOUND;
+
+    DM_PROFILE(__FUNCTION__);
+
+    uint32_t mounts_version = dmResourceMounts::GetVersion(ctx->m_Mounts);
+
+    DM_MUTEX_SCOPED_LOCK(ctx->m_Mutex);
+    if (!ctx->m_Active)
+        return dmResource::RESULT_RESOURCE_NOT_FOUND;
+
+    PrefetchEntry* entry = ctx->m_Prefetched.Get(path_hash);
+    if (!entry)
+    {
+        // Make sure the prefetcher doesn't load it later
+        EnsureCapacity(ctx->m_Requested, 256);
+        ctx->m_Requested.Put(path_hash, true);
+        return dmResource::RESULT_RESOURCE_NOT_FOUND;
+    }
+
+    dmResource::Result result = dmResource::RESULT_RESOURCE_NOT_FOUND;
+    if (entry->m_MountsVersion == mounts_version)
+    {
+        if (buffer->Capacity() < entry->m_Size)
+            buffer->SetCapacity(entry->m_Size);
+        buffer->SetSize(entry->m_Size);
+        memcpy(buffer->Begin(), entry->m_Data, entry->m_Size);
+        ++ctx->m_NumHits;
+        result = dmResource::RESULT_OK;
+    }
+
+    ctx->m_Memory -= entry->m_Size;
+    free((void*)entry->m_Data);
+    ctx->m_Prefetched.Erase(path_hash);
+
+    EnsureCapacity(ctx->m_Requested, 256);
+    ctx->m_Requested.Put(path_hash, true);
+
+    dmConditionVariable::Signal(ctx->m_Condition);
+    return result;
+}
+
+void Discard(HContext ctx, dmhash_t path_hash)
+{
+    if (ctx->m_Entries.Empty()) // Not prefetching
+        return;
+
+    DM_MUTEX_SCOPED_LOCK(ctx->m_Mutex);
+    if (!ctx->m_Active)
+        return;
+
+    PrefetchEntry* entry = ctx->m_Prefetched.Get(path_hash);
+    if (entry)
+    {
+        ctx->m_Memory -= entry->m_Size;
+        free((void*)entry->m_Data);
+        ctx->m_Prefetched.Erase(path_hash);
+        dmConditionVariable::Signal(ctx->m_Condition);
+    }
+
+    EnsureCapacity(ctx->m_Requested, 256);
+    ctx->m_Requested.Put(path_hash, true);
+}
+
+uint32_t GetNumPrefetchHits(HContext ctx)
+{
+    DM_MUTEX_SCOPED_LOCK(ctx->m_Mutex);
+    return ctx->m_NumHits;
+}
+
+}
@@ -0,0 +1,79 @@
+// Copyright 2020-2024 The Defold Foundation
+// Copyright 2014-2020 King
+// Copyright 2009-2014 Ragnar Svensson, Christian Murray
+// Licensed under the Defold License version 1.0 (the "License"); you may not use
+// this file except in compliance with the License.
+//
+// You may obtain a copy of the License, together with FAQs at
+// https://www.defold.com/license
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#ifndef DM_RESOURCE_PREFETCH_H
+#define DM_RESOURCE_PREFETCH_H
+
+#include "resource.h"
+#include "resource_mounts.h"
+#include <dlib/array.h>
+#include <dlib/hash.h>
+
+// The prefetcher has two modes:
+//  * Recording: The load order of the resources is recorded, and written to file when the context is destroyed
+//  * Prefetching: The recorded load order is read from file, and a background thread reads the resources
+//    in that order, before they are requested by the resource factory.
+
+namespace dmResourcePrefetch
+{
+    typedef struct PrefetchContext* HContext;
+
+    struct Params
+    {
+        Params();
+
+        const char* m_RecordPath;   // If set, the load order is recorded to this file
+        const char* m_PrefetchPath; // If set (and the file exists), the resources in this file are prefetched
+        uint32_t    m_MaxMemory;    // Max number of bytes of prefetched data not yet consumed
+        uint64_t    m_Timeout;      // Time (microseconds) after the end of the recorded sequence, when unused data is released
+    };
+
+    HContext    Create(dmResourceMounts::HContext mounts, const Params& params);
+
+    // Stops any prefetching, and writes the recorded load order to disc
+    void        Destroy(HContext ctx);
+
+    // Called once per frame. Stops the prefetching when all data has been consumed, or the timeout has passed
+    void        Update(HContext ctx);
+
+    // Called by the factory after a resource was loaded from the mounts
+    void        RecordLoad(HContext ctx, dmhash_t path_hash, const char* path);
+
+    // If the resource has been prefetched, the data is copied to the buffer, and the prefetched data is released.
+    // Returns RESULT_RESOURCE_NOT_FOUND if the resource isn't prefetched (yet)
+    dmResource::Result GetPrefetched(HContext ctx, dmhash_t path_hash, dmResource::LoadBufferType* buffer);
+
+    // Releases any prefetched data, and stops the resource from being prefetched.
+    // Used when the resource was loaded by other means (e.g. directly from a memory mapped archive)
+    void        Discard(HContext ctx, dmhash_t path_hash);
+
+    // Exposed for unit tests
+    struct LoadOrderEntry
+    {
+        char*       m_Path;
+        uint64_t    m_Time;     // Time since the recording started (microseconds)
+    };
+
+    dmResource::Result ReadLoadOrderFile(const char* path, dmArray<LoadOrderEntry>& entries);
+    dmResource::Result WriteLoadOrderFile(const char* path, const dmArray<LoadOrderEntry>& entries);
+    void               FreeLoadOrderFile(dmArray<LoadOrderEntry>& entries);
+
+    // Returns the number of resources that were prefetched and consumed by the factory
+    uint32_t           GetNumPrefetchHits(HContext ctx);
+
+    // Returns true while the background thread still has resources left to read
+    bool               IsPrefetching(HContext ctx);
+}
+
+#endif // DM_RESOURCE_PREFETCH_H
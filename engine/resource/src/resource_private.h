@@ -76,6 +76,7 @@ struct ResourceType
     FResourceDestroy    m_DestroyFunction;
     FResourceRecreate   m_RecreateFunction;
     uint8_t             m_Index;
+    uint8_t             m_ZeroCopy:1; // The type may read the data directly from a memory mapped archive
 };
 
 struct ResourceTypeContext
@@ -98,6 +99,9 @@ namespace dmResource
     // load with default internal buffer and its management, returns buffer ptr in 'buffer'
     Result LoadResource(HFactory factory, const char* path, const char* original_name, void** buffer, uint32_t* resource_size);
 
+    // get a read only pointer to the resource data, if the resource can be read without copying it
+    Result GetResourceData(HFactory factory, const char* path, const uint8_t** data, uint32_t* data_size);
+
     Result InsertResource(HFactory factory, const char* path, uint64_t canonical_path_hash, HResourceDescriptor descriptor);
     uint32_t GetCanonicalPathFromBase(const char* base_dir, const char* relative_dir, char* buf);
 
@@ -291,6 +291,53 @@ TEST_P(ArchiveProviderArchiveInMemory, ReadFile)
         dmMemory::AlignedFree((void*)expected_file);
     }
 }
+TEST_P(ArchiveProviderArchiveInMemory, GetFileData)
+{
+    uint32_t num_zero_copy = 0;
+    for (uint32_t i = 0; i < DM_ARRAY_SIZE(FILE_PATHS); ++i)
+    {
+        const char* path = FILE_PATHS[i];
+        dmhash_t path_hash = dmHashString64(path);
+        uint32_t expected_file_size;
+
+        char path_buffer1[256];
+        char path_buffer2[256];
+        dmSnPrintf(path_buffer2, sizeof(path_buffer2), "build/src/test%s", path);
+        const char* file_path = dmTestUtil::MakeHostPath(path_buffer1, sizeof(path_buffer1), path_buffer2);
+        const uint8_t* expected_file = dmTestUtil::ReadFile(file_path, &expected_file_size);
+        ASSERT_NE((uint8_t*)0, expected_file);
+
+        const uint8_t* data = 0;
+        uint32_t data_size = 0;
+        dmResourceProvider::Result result = dmResourceProvider::GetFileData(m_Archive, path_hash, path, &data, &data_size);
+
+        // Compressed or encrypted entries need to be read with ReadFile()
+        if (result == dmResourceProvider::RESULT_OK)
+        {
+            ASSERT_EQ(expected_file_size, data_size);
+            ASSERT_ARRAY_EQ_LEN(expected_file, data, data_size);
+            ++num_zero_copy;
+        }
+        else
+        {
+            ASSERT_EQ(dmResourceProvider::RESULT_NOT_SUPPORTED, result);
+        }
+
+        dmMemory::AlignedFree((void*)expected_file);
+    }
+
+    // In-memory archives are treated as memory mapped, so at least the uncompressed entries should be accessible
+    if (GetParam().m_ArcdData == RESOURCES_ARCD)
+    {
+        ASSERT_EQ(DM_ARRAY_SIZE(FILE_PATHS) - 1, num_zero_copy); // file5.scriptc is encrypted
+    }
+
+    const char* path = "src/test/files/not_exist";
+    const uint8_t* data = 0;
+    uint32_t data_size = 0;
+    ASSERT_EQ(dmResourceProvider::RESULT_NOT_FOUND, dmResourceProvider::GetFileData(m_Archive, dmHashString64(path), path, &data, &data_size));
+}
+
 InMemoryParams params_in_memory_archives[] = {
     {RESOURCES_DMANIFEST, RESOURCES_DMANIFEST_SIZE, RESOURCES_ARCI, RESOURCES_ARCI_SIZE, RESOURCES_ARCD, RESOURCES_ARCD_SIZE},
     {RESOURCES_COMPRESSED_DMANIFEST, RESOURCES_COMPRESSED_DMANIFEST_SIZE, RESOURCES_COMPRESSED_ARCI, RESOURCES_COMPRESSED_ARCI_SIZE, RESOURCES_COMPRESSED_ARCD, RESOURCES_COMPRESSED_ARCD_SIZE},
@@ -224,6 +224,66 @@ TEST_F(ArchiveProvidersMulti, ReadFile)
     }
 }
 
+TEST_F(ArchiveProvidersMulti, MountIndex)
+{
+    const char* path = "/archive_data/file2.adc"; // exists in archive, but overridden in file mount
+    dmhash_t path_hash = dmHashString64(path);
+
+    uint32_t override_size = 0;
+    uint8_t* override_file = GetRawFile(path, &override_size, true);
+    ASSERT_NE((uint8_t*)0, override_file);
+    uint32_t archive_size = 0;
+    uint8_t* archive_file = GetRawFile(path, &archive_size, false);
+    ASSERT_NE((uint8_t*)0, archive_file);
+
+    ASSERT_EQ(0u, dmResourceMounts::GetIndexSize(m_Mounts));
+
+    uint32_t resource_size = 0;
+    ASSERT_EQ(dmResource::RESULT_OK, dmResourceMounts::GetResourceSize(m_Mounts, path_hash, path, &resource_size));
+    ASSERT_EQ(override_size, resource_size);
+    ASSERT_EQ(1u, dmResourceMounts::GetIndexSize(m_Mounts));
+
+    // Second lookup should use the index
+    ASSERT_EQ(dmResource::RESULT_OK, dmResourceMounts::GetResourceSize(m_Mounts, path_hash, path, &resource_size));
+    ASSERT_EQ(override_size, resource_size);
+    ASSERT_EQ(1u, dmResourceMounts::GetIndexSize(m_Mounts));
+
+    // Removing the mount should remove its entries from the index
+    ASSERT_EQ(dmResource::RESULT_OK, dmResourceMounts::RemoveMount(m_Mounts, m_Archives[0]));
+    ASSERT_EQ(0u, dmResourceMounts::GetIndexSize(m_Mounts));
+
+    ASSERT_EQ(dmResource::RESULT_OK, dmResourceMounts::GetResourceSize(m_Mounts, path_hash, path, &resource_size));
+    ASSERT_EQ(archive_size, resource_size);
+    ASSERT_EQ(1u, dmResourceMounts::GetIndexSize(m_Mounts));
+
+    // Adding a mount with higher priority should invalidate the entries that may be overridden
+    ASSERT_EQ(dmResource::RESULT_OK, dmResourceMounts::AddMount(m_Mounts, "a", m_Archives[0], 30, false));
+    ASSERT_EQ(0u, dmResourceMounts::GetIndexSize(m_Mounts));
+
+    uint8_t* resource = new uint8_t[override_size];
+    ASSERT_EQ(dmResource::RESULT_OK, dmResourceMounts::ReadResource(m_Mounts, path_hash, path, resource, override_size));
+    ASSERT_ARRAY_EQ_LEN(override_file, resource, override_size);
+    ASSERT_EQ(1u, dmResourceMounts::GetIndexSize(m_Mounts));
+
+    dmResourceMounts::InvalidateResource(m_Mounts, path_hash);
+    ASSERT_EQ(0u, dmResourceMounts::GetIndexSize(m_Mounts));
+
+    // The array version uses the same index
+    dmArray<char> array;
+    ASSERT_EQ(dmResource::RESULT_OK, dmResourceMounts::ReadResource(m_Mounts, path_hash, path, &array));
+    ASSERT_EQ(override_size, array.Size());
+    ASSERT_ARRAY_EQ_LEN(override_file, (uint8_t*)array.Begin(), override_size);
+    ASSERT_EQ(1u, dmResourceMounts::GetIndexSize(m_Mounts));
+
+    ASSERT_EQ(dmResource::RESULT_OK, dmResourceMounts::ReadResource(m_Mounts, path_hash, path, &array));
+    ASSERT_EQ(override_size, array.Size());
+    ASSERT_EQ(1u, dmResourceMounts::GetIndexSize(m_Mounts));
+
+    delete[] resource;
+    dmMemory::AlignedFree(override_file);
+    dmMemory::AlignedFree(archive_file);
+}
+
 TEST_F(ArchiveProvidersMulti, ReadCustomFile)
 {
     uint8_t     file0_data[] = {0,1,2,3,4,5,6,7,8,9};
@@ -17,6 +17,7 @@
 #include "../resource_archive.h"
 #include "../resource_mounts.h"
 #include "../resource_mounts_file.h"
+#include "../resource_prefetch.h"
 #include "../resource_private.h"
 #include "../providers/provider.h"
 
@@ -25,9 +26,12 @@
 #include <dlib/log.h>
 #include <dlib/sys.h>
 #include <dlib/testutil.h>
+#include <dlib/thread.h>
+#include <dlib/time.h>
 #include <testmain/testmain.h>
 
 const char* MOUNTFILE_PATH = "liveupdate.mounts";
+const char* LOADORDER_PATH = "resources.loadorder";
 
 #define DM_SUPPORT_MUTABLE_ARCHIVE
 #if defined(DM_PLATFORM_VENDOR) // Let's deprecated it now, starting with consoles
@@ -193,6 +197,158 @@ TEST(MountsFile, ReadFileWithSpaces)
     dmResourceMounts::FreeMountsFile(entries);
 }
 
+TEST(LoadOrderFile, WriteAndRead)
+{
+    dmArray<dmResourcePrefetch::LoadOrderEntry> entries;
+    entries.SetCapacity(3);
+
+    const char* paths[] = {"/main/main.collectionc", "/main/a b.texturec", "/main/main.scriptc"};
+    for (uint32_t i = 0; i < DM_ARRAY_SIZE(paths); ++i)
+    {
+        dmResourcePrefetch::LoadOrderEntry entry;
+        entry.m_Path = strdup(paths[i]);
+        entry.m_Time = i * 1000;
+        entries.Push(entry);
+    }
+
+    char path[1024];
+    dmTestUtil::MakeHostPath(path, sizeof(path), LOADORDER_PATH);
+    ASSERT_EQ(dmResource::RESULT_OK, dmResourcePrefetch::WriteLoadOrderFile(path, entries));
+    dmResourcePrefetch::FreeLoadOrderFile(entries);
+    ASSERT_EQ(0u, entries.Size());
+
+    ASSERT_EQ(dmResource::RESULT_OK, dmResourcePrefetch::ReadLoadOrderFile(path, entries));
+    ASSERT_EQ((uint32_t)DM_ARRAY_SIZE(paths), entries.Size());
+    for (uint32_t i = 0; i < DM_ARRAY_SIZE(paths); ++i)
+    {
+        ASSERT_STREQ(paths[i], entries[i].m_Path);
+        ASSERT_EQ(i * 1000, (uint32_t)entries[i].m_Time);
+    }
+    dmResourcePrefetch::FreeLoadOrderFile(entries);
+
+    dmSys::Unlink(path);
+    ASSERT_EQ(dmResource::RESULT_RESOURCE_NOT_FOUND, dmResourcePrefetch::ReadLoadOrderFile(path, entries));
+}
+
+class ResourcePrefetch : public jc_test_base_class
+{
+protected:
+    virtual void SetUp()
+    {
+        m_Mounts = dmResourceMounts::Create(0);
+        m_Prefetch = 0;
+
+        dmArray<dmResourcePrefetch::LoadOrderEntry> entries;
+        entries.SetCapacity(DM_ARRAY_SIZE(PATHS));
+        for (uint32_t i = 0; i < DM_ARRAY_SIZE(PATHS); ++i)
+        {
+            ASSERT_EQ(dmResource::RESULT_OK, dmResourceMounts::AddFile(m_Mounts, dmHashString64(PATHS[i]), strlen(DATA[i]), DATA[i]));
+
+            dmResourcePrefetch::LoadOrderEntry entry;
+            entry.m_Path = strdup(PATHS[i]);
+            entry.m_Time = 0;
+            entries.Push(entry);
+        }
+
+        dmTestUtil::MakeHostPath(m_Path, sizeof(m_Path), LOADORDER_PATH);
+        ASSERT_EQ(dmResource::RESULT_OK, dmResourcePrefetch::WriteLoadOrderFile(m_Path, entries));
+        dmResourcePrefetch::FreeLoadOrderFile(entries);
+    }
+
+    virtual void TearDown()
+    {
+        if (m_Prefetch)
+            dmResourcePrefetch::Destroy(m_Prefetch);
+        dmResourceMounts::Destroy(m_Mounts);
+        dmSys::Unlink(m_Path);
+    }
+
+    // Creates the prefetcher, and waits until all resources have been read
+    void CreatePrefetch(uint64_t timeout)
+    {
+        dmResourcePrefetch::Params params;
+        params.m_PrefetchPath = m_Path;
+        params.m_Timeout = timeout;
+        m_Prefetch = dmResourcePrefetch::Create(m_Mounts, params);
+        while (dmResourcePrefetch::IsPrefetching(m_Prefetch))
+            dmTime::Sleep(1000);
+    }
+
+    static const char* PATHS[3];
+    static const char* DATA[3];
+
+    dmResourceMounts::HContext   m_Mounts;
+    dmResourcePrefetch::HContext m_Prefetch;
+    char                         m_Path[1024];
+};
+
+const char* ResourcePrefetch::PATHS[3] = {"/a.foo", "/b.foo", "/c.foo"};
+const char* ResourcePrefetch::DATA[3] = {"data_a", "data_b", "data_c"};
+
+TEST_F(ResourcePrefetch, Hit)
+{
+    if (!dmThread::PlatformHasThreadSupport())
+        return;
+    CreatePrefetch(10 * 1000000);
+
+    dmResource::LoadBufferType buffer;
+    ASSERT_EQ(dmResource::RESULT_OK, dmResourcePrefetch::GetPrefetched(m_Prefetch, dmHashString64(PATHS[0]), &buffer));
+    ASSERT_EQ((uint32_t)strlen(DATA[0]), buffer.Size());
+    ASSERT_EQ(0, memcmp(DATA[0], buffer.Begin(), buffer.Size()));
+    ASSERT_EQ(1u, dmResourcePrefetch::GetNumPrefetchHits(m_Prefetch));
+
+    // The prefetched data is only used once
+    ASSERT_EQ(dmResource::RESULT_RESOURCE_NOT_FOUND, dmResourcePrefetch::GetPrefetched(m_Prefetch, dmHashString64(PATHS[0]), &buffer));
+    ASSERT_EQ(dmResource::RESULT_RESOURCE_NOT_FOUND, dmResourcePrefetch::GetPrefetched(m_Prefetch, dmHashString64("/unknown.foo"), &buffer));
+
+    ASSERT_EQ(dmResource::RESULT_OK, dmResourcePrefetch::GetPrefetched(m_Prefetch, dmHashString64(PATHS[2]), &buffer));
+    ASSERT_EQ(0, memcmp(DATA[2], buffer.Begin(), buffer.Size()));
+    ASSERT_EQ(2u, dmResourcePrefetch::GetNumPrefetchHits(m_Prefetch));
+}
+
+TEST_F(ResourcePrefetch, Discard)
+{
+    if (!dmThread::PlatformHasThreadSupport())
+        return;
+    CreatePrefetch(10 * 1000000);
+
+    dmResourcePrefetch::Discard(m_Prefetch, dmHashString64(PATHS[1]));
+
+    dmResource::LoadBufferType buffer;
+    ASSERT_EQ(dmResource::RESULT_RESOURCE_NOT_FOUND, dmResourcePrefetch::GetPrefetched(m_Prefetch, dmHashString64(PATHS[1]), &buffer));
+    ASSERT_EQ(dmResource::RESULT_OK, dmResourcePrefetch::GetPrefetched(m_Prefetch, dmHashString64(PATHS[0]), &buffer));
+    ASSERT_EQ(1u, dmResourcePrefetch::GetNumPrefetchHits(m_Prefetch));
+}
+
+TEST_F(ResourcePrefetch, Invalidate)
+{
+    if (!dmThread::PlatformHasThreadSupport())
+        return;
+    CreatePrefetch(10 * 1000000);
+
+    // Any change to the mounts may make the prefetched data stale
+    dmResourceMounts::InvalidateResource(m_Mounts, dmHashString64(PATHS[0]));
+
+    dmResource::LoadBufferType buffer;
+    ASSERT_EQ(dmResource::RESULT_RESOURCE_NOT_FOUND, dmResourcePrefetch::GetPrefetched(m_Prefetch, dmHashString64(PATHS[0]), &buffer));
+    ASSERT_EQ(dmResource::RESULT_RESOURCE_NOT_FOUND, dmResourcePrefetch::GetPrefetched(m_Prefetch, dmHashString64(PATHS[1]), &buffer));
+    ASSERT_EQ(0u, dmResourcePrefetch::GetNumPrefetchHits(m_Prefetch));
+}
+
+TEST_F(ResourcePrefetch, Timeout)
+{
+    if (!dmThread::PlatformHasThreadSupport())
+        return;
+    CreatePrefetch(0);
+
+    // The recorded sequence has ended, so the unused data is released
+    dmResourcePrefetch::Update(m_Prefetch);
+
+    dmResource::LoadBufferType buffer;
+    ASSERT_EQ(dmResource::RESULT_RESOURCE_NOT_FOUND, dmResourcePrefetch::GetPrefetched(m_Prefetch, dmHashString64(PATHS[0]), &buffer));
+    ASSERT_EQ(0u, dmResourcePrefetch::GetNumPrefetchHits(m_Prefetch));
+}
+
 
 class ArchiveProvidersMounts : public jc_test_base_class
 {
@@ -186,6 +186,9 @@ namespace dmRig
     float GetPlaybackRate(HRigInstance instance);
     Result SetPlaybackRate(HRigInstance instance, float playback_rate);
     dmArray<BonePose>* GetPose(HRigInstance instance);
+    // Returns the skinning matrices (pose * inverse bind pose) of the instance, one per bone.
+    // After an update they point into a buffer shared by all instances of the context, valid until the next update.
+    const dmVMath::Matrix4* GetPoseMatrices(HRigContext context, HRigInstance instance, uint32_t* out_count);
     IKTarget* GetIKTarget(HRigInstance instance, dmhash_t constraint_id);
     bool ResetIKTarget(HRigInstance instance, dmhash_t constraint_id);
     void SetEnabled(HRigInstance instance, bool enabled);
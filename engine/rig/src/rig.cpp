@@ -15,6 +15,7 @@
 #include "rig.h"
 #include "rig_private.h"
 
+#include <dlib/hash.h>
 #include <dlib/log.h>
 #include <dlib/math.h>
 #include <dlib/vmath.h>
@@ -32,7 +33,7 @@ namespace dmRig
     static const dmhash_t NULL_ANIMATION = dmHashString64("");
     static const float CURSOR_EPSILON = 0.0001f;
 
-    static void DoAnimate(HRigContext context, RigInstance* instance, float dt);
+    static void DoAnimate(HRigContext context, RigInstance* instance, float dt, bool share_pose);
     static bool DoPostUpdate(RigInstance* instance);
 
     struct RigContext
@@ -46,6 +47,12 @@ namespace dmRig
         dmArray<dmVMath::Vector3>       m_ScratchPositionBuffer;
         dmArray<dmVMath::Vector3>       m_ScratchNormalBuffer;
         dmArray<dmVMath::Vector4>       m_ScratchTangentBuffer;
+        // Instances that evaluated their pose this frame, keyed on skeleton, animation and sample time.
+        // Other instances at the same key copy that pose instead of sampling the animation again.
+        dmHashTable64<RigInstance*>     m_SharedPoses;
+        // The skinning matrices (pose * inverse bind pose) of all instances, stored back to back.
+        // Each instance points into it with m_PoseMatrixOffset.
+        dmArray<dmVMath::Matrix4>       m_PoseMatrices;
     };
 
 
@@ -58,6 +65,8 @@ namespace dmRig
 
         context->m_Instances.SetCapacity(params.m_MaxRigInstanceCount);
         context->m_ScratchPoseMatrixBuffer.SetCapacity(0);
+        uint32_t shared_pose_capacity = dmMath::Max(1U, params.m_MaxRigInstanceCount);
+        context->m_SharedPoses.SetCapacity(dmMath::Max(1U, shared_pose_capacity / 2), shared_pose_capacity);
         *out = context;
         return dmRig::RESULT_OK;
     }
@@ -387,13 +396,18 @@ namespace dmRig
         return t;
     }
 
+    static float GetSampleTime(RigPlayer* player, const dmRigDDF::RigAnimation* animation)
+    {
+        float duration = GetCursorDuration(player, animation);
+        return CursorToTime(player->m_Cursor, duration, player->m_Backwards, player->m_Playback == dmRig::PLAYBACK_ONCE_PINGPONG);
+    }
+
     static void ApplyAnimation(RigInstance* instance, RigPlayer* player, dmArray<BonePose>& pose, dmArray<IKAnimation>& ik_animation, float blend_weight)
     {
         const dmRigDDF::RigAnimation* animation = player->m_Animation;
         if (!animation)
             return;
-        float duration = GetCursorDuration(player, animation);
-        float t = CursorToTime(player->m_Cursor, duration, player->m_Backwards, player->m_Playback == dmRig::PLAYBACK_ONCE_PINGPONG);
+        float t = GetSampleTime(player, animation);
 
         float fraction = t * animation->m_SampleRate;
         uint32_t sample = (uint32_t)fraction;
@@ -450,10 +464,12 @@ namespace dmRig
 
         const dmArray<RigInstance*>& instances = context->m_Instances.GetRawObjects();
         uint32_t n = instances.Size();
+        context->m_SharedPoses.Clear();
         for (uint32_t i = 0; i < n; ++i)
         {
             RigInstance* instance = instances[i];
-            DoAnimate(context, instance, dt);
+            instance->m_PoseSource = 0x0;
+            DoAnimate(context, instance, dt, true);
         }
     }
 
@@ -482,16 +498,107 @@ namespace dmRig
         }
     }
 
-    static void PoseToMatrix(const dmArray<BonePose>& pose, dmArray<Matrix4>& out_matrices)
+    static dmhash_t GetSharedPoseKey(RigInstance* instance, RigPlayer* player)
+    {
+        float t = GetSampleTime(player, player->m_Animation);
+        HashState64 state;
+        dmHashInit64(&state, false);
+        dmHashUpdateBuffer64(&state, &instance->m_Skeleton, sizeof(instance->m_Skeleton));
+        dmHashUpdateBuffer64(&state, &instance->m_BoneIndices, sizeof(instance->m_BoneIndices));
+        dmHashUpdateBuffer64(&state, &player->m_Animation, sizeof(player->m_Animation));
+        dmHashUpdateBuffer64(&state, &t, sizeof(t));
+        return dmHashFinal64(&state);
+    }
+
+    // Copies the pose of an instance that already sampled the same animation at the same time this frame.
+    // Returns false if there is none, and registers this instance as the one to copy from.
+    static bool CopySharedPose(HRigContext context, RigInstance* instance, RigPlayer* player)
+    {
+        dmhash_t key = GetSharedPoseKey(instance, player);
+        RigInstance** source = context->m_SharedPoses.Get(key);
+        if (source)
+        {
+            RigInstance* src = *source;
+            if (src->m_Skeleton == instance->m_Skeleton && src->m_BoneIndices == instance->m_BoneIndices && src->m_Pose.Size() == instance->m_Pose.Size())
+            {
+                memcpy(instance->m_Pose.Begin(), src->m_Pose.Begin(), sizeof(BonePose) * src->m_Pose.Size());
+                instance->m_PoseSource = src;
+                return true;
+            }
+            return false;
+        }
+
+        if (!context->m_SharedPoses.Full())
+        {
+            context->m_SharedPoses.Put(key, instance);
+        }
+        return false;
+    }
+
+    static void PoseToSkinningMatrices(const dmArray<BonePose>& pose, const dmArray<RigBone>& bind_pose, Matrix4* out_matrices)
     {
+        // Premultiply pose matrices with the bind pose inverse so they
+        // can be directly be used to transform each vertex.
         uint32_t bone_count = pose.Size();
         for (uint32_t bi = 0; bi < bone_count; ++bi)
         {
-            out_matrices[bi] = dmTransform::ToMatrix4(pose[bi].m_World);
+            out_matrices[bi] = dmTransform::ToMatrix4(pose[bi].m_World) * bind_pose[bi].m_ModelToLocal;
         }
     }
 
-    static void DoAnimate(HRigContext context, RigInstance* instance, float dt)
+    // Writes the skinning matrices of all instances into one contiguous buffer, ready to be uploaded.
+    // Instances that copied their pose from another instance this frame also share its matrices.
+    static void UpdatePoseMatrices(HRigContext context)
+    {
+        DM_PROFILE("RigPoseMatrices");
+
+        const dmArray<RigInstance*>& instances = context->m_Instances.GetRawObjects();
+        uint32_t n = instances.Size();
+
+        uint32_t matrix_count = 0;
+        for (uint32_t i = 0; i < n; ++i)
+        {
+            RigInstance* instance = instances[i];
+            if (instance->m_DoRender && instance->m_PoseSource == 0x0)
+                matrix_count += instance->m_Pose.Size();
+        }
+
+        dmArray<Matrix4>& pose_matrices = context->m_PoseMatrices;
+        if (pose_matrices.Capacity() < matrix_count)
+        {
+            pose_matrices.OffsetCapacity(matrix_count - pose_matrices.Capacity());
+        }
+        pose_matrices.SetSize(matrix_count);
+
+        uint32_t offset = 0;
+        for (uint32_t i = 0; i < n; ++i)
+        {
+            RigInstance* instance = instances[i];
+            instance->m_PoseMatricesValid = 0;
+            uint32_t bone_count = instance->m_Pose.Size();
+            if (!instance->m_DoRender || bone_count == 0)
+                continue;
+
+            RigInstance* source = instance->m_PoseSource;
+            if (source)
+            {
+                if (source->m_PoseMatricesValid && source->m_BindPose == instance->m_BindPose)
+                {
+                    instance->m_PoseMatrixOffset = source->m_PoseMatrixOffset;
+                    instance->m_PoseMatricesValid = 1;
+                }
+                // Otherwise they are generated when needed, see GetSkinningMatrices
+                continue;
+            }
+
+            PoseToSkinningMatrices(instance->m_Pose, *instance->m_BindPose, pose_matrices.Begin() + offset);
+            instance->m_PoseMatrixOffset = offset;
+            instance->m_PoseMatricesValid = 1;
+            offset += bone_count;
+        }
+    }
+
+    static void DoAnimate(HRigContext context, RigInstance* instance, float dt, bool share_pose)
     {
         // NOTE we previously checked for (!instance->m_Enabled || !instance->m_AddedToUpdate) here also
         RigPlayer* player = GetPlayer(instance);
@@ -545,6 +652,12 @@ namespace dmRig
         else
         {
             UpdatePlayer(instance, player, dt, 1.0f);
+
+            // The event callbacks may have changed the animation
+            if (share_pose && player->m_Animation && CopySharedPose(context, instance, player))
+            {
+                return;
+            }
             ApplyAnimation(instance, player, pose, ik_animation, 1.0f);
         }
 
@@ -604,6 +717,7 @@ namespace dmRig
         DM_PROFILE("RigUpdate");
 
         Animate(context, dt);
+        UpdatePoseMatrices(context);
 
         return PostUpdate(context);
     }
@@ -1109,6 +1223,32 @@ namespace dmRig
         array.SetSize(size);
     }
 
+    // Returns the skinning matrices from the pose matrix buffer, or generates them into the scratch buffer
+    // if the pose hasn't been through an update yet.
+    static const Matrix4* GetSkinningMatrices(HRigContext context, RigInstance* instance, uint32_t bone_count)
+    {
+        if (instance->m_PoseMatricesValid)
+        {
+            return context->m_PoseMatrices.Begin() + instance->m_PoseMatrixOffset;
+        }
+
+        dmArray<Matrix4>& pose_matrices = context->m_ScratchPoseMatrixBuffer;
+        EnsureSize(pose_matrices, bone_count);
+        PoseToSkinningMatrices(instance->m_Pose, *instance->m_BindPose, pose_matrices.Begin());
+        return pose_matrices.Begin();
+    }
+
+    const Matrix4* GetPoseMatrices(HRigContext context, HRigInstance instance, uint32_t* out_count)
+    {
+        uint32_t bone_count = GetBoneCount(instance);
+        *out_count = bone_count;
+        if (!bone_count)
+        {
+            return 0x0;
+        }
+        return GetSkinningMatrices(context, instance, bone_count);
+    }
+
     uint8_t* GenerateVertexDataFromAttributes(dmRig::HRigContext context, dmRig::HRigInstance instance, dmRigDDF::Mesh* mesh, const dmVMath::Matrix4& world_matrix, const dmGraphics::VertexAttributeInfos* attribute_infos, uint32_t vertex_stride, uint8_t* vertex_data_out)
     {
         const dmRigDDF::Model* model = instance->m_Model;
@@ -1118,7 +1258,6 @@ namespace dmRig
             return vertex_data_out;
         }
 
-        dmArray<Matrix4>& pose_matrices = context->m_ScratchPoseMatrixBuffer;
         dmArray<Vector3>& positions     = context->m_ScratchPositionBuffer;
         dmArray<Vector3>& normals       = context->m_ScratchNormalBuffer;
         dmArray<Vector4>& tangents      = context->m_ScratchTangentBuffer;
@@ -1135,7 +1274,8 @@ namespace dmRig
             stream_normal   |= attribute_infos->m_Infos[i].m_SemanticType == dmGraphics::VertexAttribute::SEMANTIC_TYPE_NORMAL;
         }
 
-        pose_matrices.SetSize(0);
+        // Wraps the skinning matrices, which are owned by the context
+        dmArray<Matrix4> pose_matrices;
 
         float* positions_buffer = 0;
         float* normals_buffer   = 0;
@@ -1145,24 +1285,7 @@ namespace dmRig
         {
             if (bone_count)
             {
-                // Make sure pose scratch buffers have enough space
-                if (pose_matrices.Capacity() < bone_count)
-                {
-                    uint32_t size_offset = bone_count - pose_matrices.Capacity();
-                    pose_matrices.OffsetCapacity(size_offset);
-                }
-                pose_matrices.SetSize(bone_count);
-
-                PoseToMatrix(instance->m_Pose, pose_matrices);
-
-                // Premultiply pose matrices with the bind pose inverse so they
-                // can be directly be used to transform each vertex.
-                const dmArray<RigBone>& bind_pose = *instance->m_BindPose;
-                for (uint32_t bi = 0; bi < pose_matrices.Size(); ++bi)
-                {
-                    Matrix4& pose_matrix = pose_matrices[bi];
-                    pose_matrix = pose_matrix * bind_pose[bi].m_ModelToLocal;
-                }
+                pose_matrices.Set((Matrix4*)GetSkinningMatrices(context, instance, bone_count), bone_count, bone_count, true);
             }
 
             EnsureSize(positions, vertex_count);
@@ -1195,34 +1318,18 @@ namespace dmRig
             return vertex_data_out;
         }
 
-        dmArray<Matrix4>& pose_matrices      = context->m_ScratchPoseMatrixBuffer;
         dmArray<Vector3>& positions          = context->m_ScratchPositionBuffer;
         dmArray<Vector3>& normals            = context->m_ScratchNormalBuffer;
         dmArray<Vector4>& tangents           = context->m_ScratchTangentBuffer;
 
+        // Wraps the skinning matrices, which are owned by the context
+        dmArray<Matrix4> pose_matrices;
+
         // If the rig has bones, update the pose to be local-to-model
         uint32_t bone_count = GetBoneCount(instance);
         if (bone_count)
         {
-            // Make sure pose scratch buffers have enough space
-            if (pose_matrices.Capacity() < bone_count) {
-                uint32_t size_offset = bone_count - pose_matrices.Capacity();
-                pose_matrices.OffsetCapacity(size_offset);
-            }
-            pose_matrices.SetSize(bone_count);
-
-            PoseToMatrix(instance->m_Pose, pose_matrices);
-
-            // Premultiply pose matrices with the bind pose inverse so they
-            // can be directly be used to transform each vertex.
-            const dmArray<RigBone>& bind_pose = *instance->m_BindPose;
-            for (uint32_t bi = 0; bi < pose_matrices.Size(); ++bi)
-            {
-                Matrix4& pose_matrix = pose_matrices[bi];
-                pose_matrix = pose_matrix * bind_pose[bi].m_ModelToLocal;
-            }
-        } else {
-            pose_matrices.SetSize(0);
+            pose_matrices.Set((Matrix4*)GetSkinningMatrices(context, instance, bone_count), bone_count, bone_count, true);
         }
 
         Matrix4 normal_matrix = dmVMath::Inverse(world_matrix);
@@ -1408,7 +1515,7 @@ namespace dmRig
         // before that happens, for example cloning a GUI spine node happens in script update,
         // which comes after the regular dmRig::Update.
         if (params.m_ForceAnimatePose) {
-            DoAnimate(context, instance, 0.0f);
+            DoAnimate(context, instance, 0.0f, false);
         }
 
         *out_instance = instance;
@@ -59,6 +59,12 @@ namespace dmRig
         return 0;
     }
 
+    const dmVMath::Matrix4* GetPoseMatrices(HRigContext context, HRigInstance instance, uint32_t* out_count)
+    {
+        *out_count = 0;
+        return 0;
+    }
+
 
     float GetCursor(HRigInstance instance, bool normalized)
     {
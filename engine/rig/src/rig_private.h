@@ -72,6 +72,10 @@ namespace dmRig
         void*                         m_EventCBUserData2;
         /// Animated pose, every transform is local-to-model-space and describes the delta between bind pose and animation
         dmArray<BonePose>             m_Pose;
+        /// Instance the pose was copied from during the last update, if any
+        RigInstance*                  m_PoseSource;
+        /// Offset of the skinning matrices in the pose matrix buffer of the context
+        uint32_t                      m_PoseMatrixOffset;
 
         /// Animated IK
         dmArray<IKAnimation>          m_IKAnimation;
@@ -92,7 +96,8 @@ namespace dmRig
         uint8_t                       m_Blending : 1;
         uint8_t                       m_Enabled : 1;
         uint8_t                       m_DoRender : 1;
-        uint8_t                       : 4;
+        uint8_t                       m_PoseMatricesValid : 1;
+        uint8_t                       : 3;
     };
 }
 
@@ -1815,6 +1815,63 @@ TEST_F(RigInstanceTest, BoneTranslationRotation)
     ASSERT_EQ(Quat::rotationZ((float)M_PI / 2.0f), pose[0].m_World.GetRotation());
 }
 
+TEST_F(RigInstanceTest, SharedPose)
+{
+    dmRig::InstanceCreateParams create_params = {0};
+    create_params.m_BindPose         = &m_BindPose;
+    create_params.m_BoneIndices      = &m_BoneIndices;
+    create_params.m_Skeleton         = m_Skeleton;
+    create_params.m_MeshSet          = m_MeshSet;
+    create_params.m_AnimationSet     = m_AnimationSet;
+    create_params.m_ModelId          = dmHashString64((const char*)"test");
+    create_params.m_DefaultAnimation = dmHashString64((const char*)"");
+
+    dmRig::HRigInstance instance = 0x0;
+    ASSERT_EQ(dmRig::RESULT_OK, dmRig::InstanceCreate(m_Context, create_params, &instance));
+
+    // Before the first update, the matrices are generated from the bind pose
+    uint32_t bone_count = 0;
+    const Matrix4* matrices = dmRig::GetPoseMatrices(m_Context, instance, &bone_count);
+    ASSERT_EQ(2U, bone_count);
+    ASSERT_EQ(Vector4(1.0f, 0.0f, 0.0f, 1.0f), matrices[1] * Point3(1.0f, 0.0f, 0.0f));
+
+    ASSERT_EQ(dmRig::RESULT_OK, dmRig::Update(m_Context, 1.0f));
+    ASSERT_EQ(dmRig::RESULT_OK, dmRig::PlayAnimation(m_Instance, dmHashString64("valid"), dmRig::PLAYBACK_LOOP_FORWARD, 0.0f, 0.0f, 1.0f));
+    ASSERT_EQ(dmRig::RESULT_OK, dmRig::PlayAnimation(instance, dmHashString64("valid"), dmRig::PLAYBACK_LOOP_FORWARD, 0.0f, 0.0f, 1.0f));
+    ASSERT_EQ(dmRig::RESULT_OK, dmRig::Update(m_Context, 1.0f));
+    ASSERT_EQ(dmRig::RESULT_OK, dmRig::Update(m_Context, 1.0f));
+
+    // sample 2, the same for both instances
+    dmArray<dmRig::BonePose>& pose_a = *dmRig::GetPose(m_Instance);
+    dmArray<dmRig::BonePose>& pose_b = *dmRig::GetPose(instance);
+    ASSERT_EQ(Vector3(0.0f, 1.0f, 0.0f), pose_a[1].m_World.GetTranslation());
+    ASSERT_EQ(Vector3(0.0f, 1.0f, 0.0f), pose_b[1].m_World.GetTranslation());
+    ASSERT_EQ(Quat::rotationZ((float)M_PI / 2.0f), pose_b[0].m_World.GetRotation());
+
+    uint32_t bone_count_a = 0;
+    uint32_t bone_count_b = 0;
+    const Matrix4* matrices_a = dmRig::GetPoseMatrices(m_Context, m_Instance, &bone_count_a);
+    const Matrix4* matrices_b = dmRig::GetPoseMatrices(m_Context, instance, &bone_count_b);
+    ASSERT_EQ(2U, bone_count_a);
+    ASSERT_EQ(2U, bone_count_b);
+    ASSERT_EQ(matrices_a, matrices_b);
+    ASSERT_EQ(Vector4(0.0f, 1.0f, 0.0f, 1.0f), matrices_b[1] * Point3(1.0f, 0.0f, 0.0f));
+
+    // Different cursors, different poses
+    ASSERT_EQ(dmRig::RESULT_OK, dmRig::SetCursor(instance, 0.0f, false));
+    ASSERT_EQ(dmRig::RESULT_OK, dmRig::Update(m_Context, 0.0f));
+    ASSERT_EQ(Vector3(0.0f, 1.0f, 0.0f), pose_a[1].m_World.GetTranslation());
+    ASSERT_EQ(Vector3(1.0f, 0.0f, 0.0f), pose_b[1].m_World.GetTranslation());
+
+    matrices_a = dmRig::GetPoseMatrices(m_Context, m_Instance, &bone_count_a);
+    matrices_b = dmRig::GetPoseMatrices(m_Context, instance, &bone_count_b);
+    ASSERT_NE(matrices_a, matrices_b);
+    ASSERT_EQ(Vector4(0.0f, 1.0f, 0.0f, 1.0f), matrices_a[1] * Point3(1.0f, 0.0f, 0.0f));
+    ASSERT_EQ(Vector4(1.0f, 0.0f, 0.0f, 1.0f), matrices_b[1] * Point3(1.0f, 0.0f, 0.0f));
+
+    ASSERT_EQ(dmRig::RESULT_OK, dmRig::InstanceDestroy(m_Context, instance));
+}
+
 // DEF-3121 - Starting new animation from inside a "animation completed callback" would previously
 // use the wrong animation for one frame.
 // In the test we register a "completion callback", play one animation forward once, then play another
@@ -14,18 +14,25 @@
 
 #include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <dlib/array.h>
+#include <dlib/condition_variable.h>
 #include <dlib/dstrings.h>
+#include <dlib/hash.h>
+#include <dlib/hashtable.h>
+#include <dlib/socket.h>
 #include <dlib/thread.h>
 #include <dlib/time.h>
 #include <dlib/message.h>
 #include <dlib/http_client.h>
 #include <dlib/http_cache.h>
 #include <dlib/log.h>
+#include <dlib/path.h>
 #include <dlib/sys.h>
 #include <dlib/uri.h>
 #include <dlib/math.h>
+#include <dlib/mutex.h>
 #include <ddf/ddf.h>
 #include "http_ddf.h"
 #include "http_service.h"
@@ -42,9 +49,156 @@ namespace dmHttpService
     const uint32_t DEFAULT_RESPONSE_BUFFER_SIZE = 64 * 1024;
     const uint32_t DEFAULT_HEADER_BUFFER_SIZE = 16 * 1024;
 
+    // Plain "http://" requests are multiplexed over non-blocking sockets on a single
+    // engine thread. Requests over https are still handled by the blocking workers.
+    const uint32_t ENGINE_MAX_ACTIVE_REQUESTS = 64;
+    const uint32_t ENGINE_MAX_IDLE_CONNECTIONS = 32;
+    const uint64_t ENGINE_IDLE_CONNECTION_TIMEOUT = 10 * 1000000U;
+    const uint32_t ENGINE_ADDRESS_CACHE_SIZE = 64;
+    const uint64_t ENGINE_ADDRESS_CACHE_TIMEOUT = 60 * 1000000U;
+    const uint32_t ENGINE_RESOLVER_COUNT = 4;
+    const uint64_t ENGINE_RESOLVE_TIMEOUT = 30 * 1000000U; // For requests without a timeout
+    const dmhash_t ENGINE_LOOKUP_MESSAGE_ID = dmHashString64("http_lookup_done");
+    const uint32_t ENGINE_RECEIVE_SIZE = 16 * 1024;
+    const uint32_t ENGINE_MAX_HEADER_SIZE = 64 * 1024;
+    const uint32_t ENGINE_MAX_CHUNK_LINE_SIZE = 1024;
+    const int32_t  ENGINE_SELECT_TIMEOUT = 10 * 1000;
+    const uint32_t ENGINE_MAXIMUM_CACHE_AGE = 30U * 24U * 60U * 60U; // 30 days, same as dmHttpClient
 
     struct HttpService;
 
+    enum EngineState
+    {
+        ENGINE_STATE_RESOLVE,
+        ENGINE_STATE_SEND,
+        ENGINE_STATE_RECEIVE_HEADERS,
+        ENGINE_STATE_RECEIVE_BODY,
+    };
+
+    enum EngineBodyMode
+    {
+        ENGINE_BODY_NONE,
+        ENGINE_BODY_LENGTH,
+        ENGINE_BODY_CHUNKED,
+        ENGINE_BODY_UNTIL_CLOSE,
+    };
+
+    enum EngineChunkState
+    {
+        ENGINE_CHUNK_SIZE,
+        ENGINE_CHUNK_DATA,
+        ENGINE_CHUNK_DATA_END,
+        ENGINE_CHUNK_TRAILER,
+    };
+
+    struct EngineConnection
+    {
+        dmSocket::Socket m_Socket;
+        dmhash_t         m_Key;
+        uint64_t         m_Expires;
+    };
+
+    struct EngineAddress
+    {
+        dmSocket::Address m_Address;
+        uint64_t          m_Expires;
+    };
+
+    // A host name lookup. The lookups are done by the resolver threads, and
+    // the result is posted back to the engine socket.
+    struct EngineLookup
+    {
+        char              m_Hostname[dmURI::MAX_LOCATION_LEN];
+        dmhash_t          m_HostHash;
+        uint64_t          m_Timeout;
+        dmSocket::Address m_Address;
+        dmSocket::Result  m_Result;
+    };
+
+    // Response body streamed to a file while it is received, instead of
+    // keeping it in memory. The data is written to a temporary file which
+    // replaces the target file once the request has succeeded.
+    struct ResponseFile
+    {
+        char                  m_Path[DMPATH_MAX_PATH];
+        char                  m_TempPath[DMPATH_MAX_PATH];
+        FILE*                 m_File;
+        bool                  m_Error;
+    };
+
+    struct EngineRequest
+    {
+        char*                 m_Url;
+        char*                 m_Hostname;
+        dmhash_t              m_HostHash;
+        uint16_t              m_Port;
+        // Cache key, in the same format as dmHttpClient uses
+        char                  m_URI[dmURI::MAX_URI_LEN];
+        dmMessage::URL        m_Requester;
+        uintptr_t             m_UserData1;
+        uintptr_t             m_UserData2;
+        uint64_t              m_Timeout;
+        uint64_t              m_Start;
+        dmhash_t              m_ConnectionKey;
+        dmSocket::Socket      m_Socket;
+        dmSocket::Result      m_SocketResult;
+        EngineState           m_State;
+        EngineBodyMode        m_BodyMode;
+        EngineChunkState      m_ChunkState;
+
+        // The complete request, i.e. request line, headers and body
+        dmArray<char>         m_Send;
+        uint32_t              m_SendOffset;
+        uint32_t              m_BodyOffset;
+        uint32_t              m_BodyLength;
+
+        // Received data not yet consumed. NOTE: Extra byte for null-termination
+        dmArray<char>         m_Receive;
+        uint32_t              m_TotalReceived;
+        uint32_t              m_ContentOffset;
+        uint32_t              m_Remaining;
+
+        int                   m_Status;
+        int32_t               m_ContentLength;
+        uint32_t              m_MaxAge;
+        char                  m_ETag[64];
+        dmHttpCache::HCacheCreator m_CacheCreator;
+
+        dmArray<char>         m_Headers;
+        dmArray<char>         m_Response;
+        uint32_t              m_BytesReceived;
+        ResponseFile          m_ResponseFile;
+
+        uint32_t              m_Head : 1;
+        uint32_t              m_UseCache : 1;
+        uint32_t              m_Chunked : 1;
+        uint32_t              m_CloseConnection : 1;
+        uint32_t              m_Reused : 1;
+        uint32_t              m_Retried : 1;
+        uint32_t              m_ReportProgress : 1;
+    };
+
+    struct HttpEngine
+    {
+        dmThread::Thread              m_Thread;
+        dmMessage::HSocket            m_Socket;
+        const HttpService*            m_Service;
+        dmArray<EngineRequest*>       m_Pending;
+        dmArray<EngineRequest*>       m_Active;
+        dmArray<EngineConnection>     m_Idle;
+        dmHashTable64<EngineAddress>  m_Addresses;
+        dmSocket::Selector            m_Selector;
+        volatile bool                 m_Run;
+        int                           m_Canceled;
+
+        // Host name lookups block, so they are done on separate threads
+        dmThread::Thread              m_Resolvers[ENGINE_RESOLVER_COUNT];
+        dmMutex::HMutex               m_LookupMutex;
+        dmConditionVariable::HConditionVariable m_LookupCondition;
+        dmArray<EngineLookup>         m_Lookups;        // Protected by m_LookupMutex
+        bool                          m_ResolverRun;    // Protected by m_LookupMutex
+    };
+
     struct Worker
     {
         dmThread::Thread      m_Thread;
@@ -53,12 +207,13 @@ namespace dmHttpService
         dmURI::Parts          m_CurrentURL;
         dmMessage::URL        m_CurrentRequesterURL;
         dmHttpDDF::HttpRequest*   m_Request;
-        const char*           m_Filepath;
         int                   m_Status;
         uintptr_t             m_ResponseUserData1;
         uintptr_t             m_ResponseUserData2;
         dmArray<char>         m_Response;
         dmArray<char>         m_Headers;
+        uint32_t              m_BytesReceived;
+        ResponseFile          m_ResponseFile;
         const HttpService*    m_Service;
         bool                  m_CacheFlusher;
         volatile bool         m_Run;
@@ -73,10 +228,12 @@ namespace dmHttpService
             m_Balancer = 0;
             m_Socket = 0;
             m_HttpCache = 0;
+            m_Engine = 0;
             m_LoadBalanceCount = 0;
             m_Run = false;
         }
         dmArray<Worker*>          m_Workers;
+        HttpEngine*               m_Engine;
         dmThread::Thread          m_Balancer;
         dmMessage::HSocket        m_Socket;
         dmHttpCache::HCache       m_HttpCache;
@@ -85,6 +242,84 @@ namespace dmHttpService
         volatile bool             m_Run;
     };
 
+    static void ResponseFileInit(ResponseFile* file, const char* path)
+    {
+        file->m_Path[0] = '\0';
+        file->m_TempPath[0] = '\0';
+        file->m_File = 0;
+        file->m_Error = false;
+        if (path)
+        {
+            dmStrlCpy(file->m_Path, path, sizeof(file->m_Path));
+            dmStrlCpy(file->m_TempPath, path, sizeof(file->m_TempPath));
+            dmStrlCat(file->m_TempPath, "._httptmp", sizeof(file->m_TempPath));
+        }
+    }
+
+    static void ResponseFileWrite(ResponseFile* file, const void* data, uint32_t data_len)
+    {
+        if (file->m_Error)
+            return;
+
+        if (!file->m_File)
+        {
+            file->m_File = fopen(file->m_TempPath, "wb");
+            if (!file->m_File)
+            {
+                dmLogError("Failed to open '%s' for writing", file->m_TempPath);
+                file->m_Error = true;
+                return;
+            }
+        }
+
+        if (data_len > 0 && fwrite(data, 1, data_len, file->m_File) != data_len)
+        {
+            dmLogError("Failed to write '%u' bytes to '%s'", data_len, file->m_Path);
+            file->m_Error = true;
+        }
+    }
+
+    // Discards everything written so far, e.g. when the request is retried
+    static void ResponseFileReset(ResponseFile* file)
+    {
+        if (file->m_File)
+        {
+            fclose(file->m_File);
+            file->m_File = 0;
+            dmSys::Unlink(file->m_TempPath);
+        }
+        file->m_Error = false;
+    }
+
+    // Moves the received file into place. Returns false if any part of it couldn't be written
+    static bool ResponseFileCommit(ResponseFile* file)
+    {
+        // NOTE: Create the file even if the response was empty
+        ResponseFileWrite(file, 0, 0);
+        if (file->m_File)
+        {
+            if (fclose(file->m_File) != 0)
+            {
+                dmLogError("Failed to write to '%s'", file->m_Path);
+                file->m_Error = true;
+            }
+            file->m_File = 0;
+        }
+
+        if (!file->m_Error && dmSys::RESULT_OK != dmSys::Rename(file->m_Path, file->m_TempPath))
+        {
+            dmLogError("Failed to rename '%s' to '%s'", file->m_TempPath, file->m_Path);
+            file->m_Error = true;
+        }
+
+        if (file->m_Error)
+        {
+            dmSys::Unlink(file->m_TempPath);
+            return false;
+        }
+        return true;
+    }
+
     void HttpHeader(dmHttpClient::HResponse response, void* user_data, int status_code, const char* key, const char* value)
     {
         Worker* worker = (Worker*) user_data;
@@ -110,21 +345,31 @@ namespace dmHttpService
         if (!content_data && !content_data_size)
         {
             r.SetSize(0);
+            worker->m_BytesReceived = 0;
+            ResponseFileReset(&worker->m_ResponseFile);
             return;
         }
 
-        uint32_t left = r.Capacity() - r.Size();
-        if (left < content_data_size) {
-            r.OffsetCapacity((int32_t) dmMath::Max(content_data_size - left, 128U * 1024U));
+        if (worker->m_ResponseFile.m_Path[0] != '\0' && status_code == 200)
+        {
+            ResponseFileWrite(&worker->m_ResponseFile, content_data, content_data_size);
+        }
+        else
+        {
+            uint32_t left = r.Capacity() - r.Size();
+            if (left < content_data_size) {
+                r.OffsetCapacity((int32_t) dmMath::Max(content_data_size - left, 128U * 1024U));
+            }
+            r.PushArray((char*) content_data, content_data_size);
         }
-        r.PushArray((char*) content_data, content_data_size);
+        worker->m_BytesReceived += content_data_size;
 
         if (worker->m_ReportProgress && content_data_size > 0)
         {
             assert(worker->m_Service->m_ReportProgressCallback);
 
             dmHttpDDF::HttpRequestProgress progress = {};
-            progress.m_BytesReceived                = r.Size();
+            progress.m_BytesReceived                = worker->m_BytesReceived;
             progress.m_BytesTotal                   = content_length;
             worker->m_Service->m_ReportProgressCallback(&progress, &worker->m_CurrentRequesterURL, worker->m_ResponseUserData2);
         }
@@ -193,12 +438,15 @@ namespace dmHttpService
         dmHttpDDF::HttpResponse* response = (dmHttpDDF::HttpResponse*)message->m_Data;
         free((void*) response->m_Headers);
         free((void*) response->m_Response);
+        free((void*) response->m_Path);
     }
 
+    // If the response body was streamed to the requested path, 'file' is that file and
+    // 'file_ok' tells whether it was successfully written
     static void SendResponse(const dmMessage::URL* requester, uintptr_t userdata1, uintptr_t userdata2, int status,
                              const char* headers, uint32_t headers_length,
                              const char* response, uint32_t response_length,
-                             const char* filepath)
+                             const char* filepath, bool streamed = false, bool streamed_ok = true)
     {
         dmHttpDDF::HttpResponse resp;
         resp.m_Status = status;
@@ -209,21 +457,909 @@ namespace dmHttpService
         memcpy((void*) resp.m_Headers, headers, headers_length);
         resp.m_Response = (uint64_t) malloc(response_length);
         memcpy((void*) resp.m_Response, response, response_length);
-        resp.m_Path = filepath;
+        resp.m_Path = filepath && filepath[0] != '\0' ? strdup(filepath) : 0;
+        resp.m_PathStreamed = streamed;
+        resp.m_PathError = streamed && !streamed_ok;
 
         if (dmMessage::RESULT_OK != dmMessage::Post(0, requester, dmHttpDDF::HttpResponse::m_DDFHash, userdata1, userdata2, (uintptr_t) dmHttpDDF::HttpResponse::m_DDFDescriptor, &resp, sizeof(resp), MessageDestroyCallback) )
         {
             free((void*) resp.m_Headers);
             free((void*) resp.m_Response);
+            free((void*) resp.m_Path);
             dmLogWarning("Failed to return http-response. Requester deleted?");
         }
     }
 
+    static void EngineAppend(dmArray<char>& buffer, const char* data, uint32_t size)
+    {
+        uint32_t left = buffer.Capacity() - buffer.Size();
+        if (left < size) {
+            buffer.OffsetCapacity((int32_t) dmMath::Max(size - left, 1024U));
+        }
+        buffer.PushArray(data, size);
+    }
+
+    static void EngineAppendString(dmArray<char>& buffer, const char* str)
+    {
+        EngineAppend(buffer, str, strlen(str));
+    }
+
+    static void EngineDeleteRequest(EngineRequest* req)
+    {
+        if (req->m_Socket != dmSocket::INVALID_SOCKET_HANDLE)
+        {
+            dmSocket::Delete(req->m_Socket);
+        }
+        ResponseFileReset(&req->m_ResponseFile);
+        free(req->m_Url);
+        free(req->m_Hostname);
+        delete req;
+    }
+
+    static void EngineReportProgress(HttpEngine* engine, EngineRequest* req, uint32_t bytes_sent, uint32_t bytes_received, int32_t bytes_total)
+    {
+        assert(engine->m_Service->m_ReportProgressCallback);
+        dmHttpDDF::HttpRequestProgress progress = {};
+        progress.m_BytesSent                    = bytes_sent;
+        progress.m_BytesReceived                = bytes_received;
+        progress.m_BytesTotal                   = bytes_total;
+        engine->m_Service->m_ReportProgressCallback(&progress, &req->m_Requester, req->m_UserData2);
+    }
+
+    static void EngineAddContent(HttpEngine* engine, EngineRequest* req, const char* data, uint32_t size)
+    {
+        if (size == 0)
+            return;
+
+        if (req->m_ResponseFile.m_Path[0] != '\0' && req->m_Status == 200)
+        {
+            ResponseFileWrite(&req->m_ResponseFile, data, size);
+        }
+        else
+        {
+            // Grow geometrically, as the content length isn't always known up front
+            dmArray<char>& r = req->m_Response;
+            uint32_t left = r.Capacity() - r.Size();
+            if (left < size) {
+                r.OffsetCapacity((int32_t) dmMath::Max(size - left, dmMath::Max(r.Capacity(), 16U * 1024U)));
+            }
+            r.PushArray(data, size);
+        }
+        req->m_BytesReceived += size;
+
+        if (req->m_CacheCreator)
+        {
+            dmHttpCache::Add(engine->m_Service->m_HttpCache, req->m_CacheCreator, data, size);
+        }
+
+        if (req->m_ReportProgress)
+        {
+            EngineReportProgress(engine, req, 0, req->m_BytesReceived, req->m_ContentLength);
+        }
+    }
+
+    // Reads a cached response into the request. Used both for NOT MODIFIED (304) responses
+    // and for entries the cache allows us to use without asking the server.
+    static bool EngineReadCache(HttpEngine* engine, EngineRequest* req, const char* etag)
+    {
+        dmHttpCache::HCache cache = engine->m_Service->m_HttpCache;
+        FILE* file = 0;
+        uint32_t file_size = 0;
+        uint64_t checksum;
+        if (dmHttpCache::Get(cache, req->m_URI, etag, &file, &file_size, &checksum) != dmHttpCache::RESULT_OK)
+        {
+            return false;
+        }
+
+        req->m_Response.SetSize(0);
+        if (file_size > 0)
+        {
+            req->m_Response.SetCapacity(file_size);
+            req->m_Response.SetSize(file_size);
+            size_t nread = fread(req->m_Response.Begin(), 1, file_size, file);
+            req->m_Response.SetSize((uint32_t) nread);
+        }
+        dmHttpCache::Release(cache, req->m_URI, etag, file);
+        return true;
+    }
+
+    static void EngineHandleVersion(void* user_data, int major, int minor, int status, const char* status_str)
+    {
+        EngineRequest* req = (EngineRequest*) user_data;
+        req->m_Status = status;
+        // HTTP/1.0 servers close the connection unless told otherwise
+        if (major == 1 && minor == 0)
+        {
+            req->m_CloseConnection = 1;
+        }
+    }
+
+    static void EngineHandleHeader(void* user_data, const char* key, const char* value)
+    {
+        EngineRequest* req = (EngineRequest*) user_data;
+
+        if (dmStrCaseCmp(key, "Content-Length") == 0)
+        {
+            req->m_ContentLength = strtol(value, 0, 10);
+        }
+        else if (dmStrCaseCmp(key, "Transfer-Encoding") == 0 && dmStrCaseCmp(value, "chunked") == 0)
+        {
+            req->m_Chunked = 1;
+        }
+        else if (dmStrCaseCmp(key, "Connection") == 0 && dmStrCaseCmp(value, "close") == 0)
+        {
+            req->m_CloseConnection = 1;
+        }
+        else if (dmStrCaseCmp(key, "ETag") == 0)
+        {
+            dmStrlCpy(req->m_ETag, value, sizeof(req->m_ETag));
+        }
+        else if (dmStrCaseCmp(key, "Cache-Control") == 0)
+        {
+            const char* substr = "max-age=";
+            const char* max_age = strstr(value, substr);
+            if (max_age) {
+                req->m_MaxAge = dmMath::Min((uint32_t) dmMath::Max(0, atoi(max_age + strlen(substr))), ENGINE_MAXIMUM_CACHE_AGE);
+            }
+        }
+
+        dmArray<char>& h = req->m_Headers;
+        EngineAppendString(h, key);
+        EngineAppend(h, ":", 1);
+        EngineAppendString(h, value);
+        EngineAppend(h, "\n", 1);
+    }
+
+    static void EngineHandleContent(void* user_data, int offset)
+    {
+        EngineRequest* req = (EngineRequest*) user_data;
+        req->m_ContentOffset = (uint32_t) offset;
+    }
+
+    static EngineRequest* EngineNewRequest(HttpEngine* engine, const dmMessage::URL* requester, uintptr_t userdata1, uintptr_t userdata2, dmHttpDDF::HttpRequest* request)
+    {
+        dmURI::Parts url;
+        request->m_Method = (const char*) ((uintptr_t) request + (uintptr_t) request->m_Method);
+        request->m_Url = (const char*) ((uintptr_t) request + (uintptr_t) request->m_Url);
+        if (request->m_Path)
+            request->m_Path = (const char*) ((uintptr_t) request + (uintptr_t) request->m_Path);
+        dmURI::Result ur =  dmURI::Parse(request->m_Url, &url);
+        if (ur != dmURI::RESULT_OK)
+        {
+            SendResponse(requester, 0, 0, 0, 0, 0, 0, 0, 0);
+            return 0;
+        }
+        if (url.m_Path[0] == '\0') {
+            // NOTE: Default to / for empty path
+            url.m_Path[0] = '/';
+            url.m_Path[1] = '\0';
+        }
+
+        const char* method = request->m_Method;
+        dmHttpCache::HCache cache = engine->m_Service->m_HttpCache;
+
+        EngineRequest* req = new EngineRequest;
+        req->m_Url = strdup(request->m_Url);
+        req->m_Hostname = strdup(url.m_Hostname);
+        req->m_HostHash = dmHashString64(url.m_Hostname);
+        req->m_Port = (uint16_t) url.m_Port;
+        dmSnPrintf(req->m_URI, sizeof(req->m_URI), "http://%s:%d/%s", url.m_Hostname, url.m_Port, url.m_Path);
+        memcpy(&req->m_Requester, requester, sizeof(dmMessage::URL));
+        req->m_UserData1 = userdata1;
+        req->m_UserData2 = userdata2;
+        ResponseFileInit(&req->m_ResponseFile, request->m_Path);
+        req->m_BytesReceived = 0;
+        req->m_Timeout = request->m_Timeout;
+        req->m_Start = 0;
+
+        char key[dmURI::MAX_LOCATION_LEN + 16];
+        dmSnPrintf(key, sizeof(key), "%s:%d", url.m_Hostname, url.m_Port);
+        req->m_ConnectionKey = dmHashString64(key);
+
+        req->m_Socket = dmSocket::INVALID_SOCKET_HANDLE;
+        req->m_SocketResult = dmSocket::RESULT_OK;
+        req->m_State = ENGINE_STATE_SEND;
+        req->m_BodyMode = ENGINE_BODY_NONE;
+        req->m_ChunkState = ENGINE_CHUNK_SIZE;
+        req->m_SendOffset = 0;
+        req->m_BodyOffset = 0;
+        req->m_BodyLength = 0;
+        req->m_TotalReceived = 0;
+        req->m_ContentOffset = 0;
+        req->m_Remaining = 0;
+        req->m_Status = 0;
+        req->m_ContentLength = -1;
+        req->m_MaxAge = 0;
+        req->m_ETag[0] = '\0';
+        req->m_CacheCreator = 0;
+        req->m_Head = strcmp(method, "HEAD") == 0;
+        req->m_UseCache = cache != 0 && !request->m_IgnoreCache;
+        req->m_Chunked = 0;
+        req->m_CloseConnection = 0;
+        req->m_Reused = 0;
+        req->m_Retried = 0;
+        req->m_ReportProgress = request->m_ReportProgress;
+
+        if (req->m_UseCache && strcmp(method, "GET") == 0)
+        {
+            // Same policy as dmHttpClient::Get(): use the cached entry without asking
+            // the server if we trust the cache or if it hasn't reached its max-age
+            dmHttpCache::EntryInfo info;
+            if (dmHttpCache::GetInfo(cache, req->m_URI, &info) == dmHttpCache::RESULT_OK)
+            {
+                bool ok_etag = info.m_Verified && dmHttpCache::GetConsistencyPolicy(cache) == dmHttpCache::CONSISTENCY_POLICY_TRUST_CACHE;
+                if ((ok_etag || info.m_Valid) && EngineReadCache(engine, req, info.m_ETag))
+                {
+                    SendResponse(requester, userdata1, userdata2, 304, 0, 0, req->m_Response.Begin(), req->m_Response.Size(), req->m_ResponseFile.m_Path);
+                    EngineDeleteRequest(req);
+                    return 0;
+                }
+            }
+        }
+
+        dmArray<char>& s = req->m_Send;
+        s.SetCapacity(1024 + request->m_HeadersLength + request->m_RequestLength);
+        EngineAppendString(s, method);
+        EngineAppendString(s, " ");
+        EngineAppendString(s, url.m_Path);
+        EngineAppendString(s, " HTTP/1.1\r\nHost: ");
+        EngineAppendString(s, url.m_Hostname);
+        EngineAppendString(s, "\r\n");
+
+        // The script headers are stored as "key:value\n" lines
+        const char* headers = (const char*) request->m_Headers;
+        const char* headers_end = headers + request->m_HeadersLength;
+        while (headers && headers < headers_end)
+        {
+            const char* line_end = (const char*) memchr(headers, '\n', headers_end - headers);
+            if (!line_end)
+                line_end = headers_end;
+            const char* colon = (const char*) memchr(headers, ':', line_end - headers);
+            if (colon)
+            {
+                EngineAppend(s, headers, colon - headers);
+                EngineAppendString(s, ": ");
+                EngineAppend(s, colon + 1, line_end - (colon + 1));
+                EngineAppendString(s, "\r\n");
+            }
+            headers = line_end + 1;
+        }
+
+        if (req->m_UseCache)
+        {
+            char etag[64];
+            if (dmHttpCache::GetETag(cache, req->m_URI, etag, sizeof(etag)) == dmHttpCache::RESULT_OK)
+            {
+                EngineAppendString(s, "If-None-Match: ");
+                EngineAppendString(s, etag);
+                EngineAppendString(s, "\r\n");
+            }
+        }
+
+        bool has_body = strcmp(method, "POST") == 0 || strcmp(method, "PUT") == 0 || strcmp(method, "PATCH") == 0;
+        if (has_body)
+        {
+            char buf[64];
+            dmSnPrintf(buf, sizeof(buf), "Content-Length: %d\r\n", request->m_RequestLength);
+            EngineAppendString(s, buf);
+        }
+        EngineAppendString(s, "\r\n");
+
+        req->m_BodyOffset = s.Size();
+        if (has_body && request->m_RequestLength > 0)
+        {
+            EngineAppend(s, (const char*) request->m_Request, request->m_RequestLength);
+            req->m_BodyLength = request->m_RequestLength;
+        }
+
+        return req;
+    }
+
+    static void EngineReleaseConnection(HttpEngine* engine, dmhash_t key, dmSocket::Socket socket)
+    {
+        if (engine->m_Idle.Full())
+        {
+            // Make room by closing the connection that expires first
+            uint32_t oldest = 0;
+            for (uint32_t i = 1; i < engine->m_Idle.Size(); ++i)
+            {
+                if (engine->m_Idle[i].m_Expires < engine->m_Idle[oldest].m_Expires)
+                    oldest = i;
+            }
+            dmSocket::Delete(engine->m_Idle[oldest].m_Socket);
+            engine->m_Idle.EraseSwap(oldest);
+        }
+
+        EngineConnection c;
+        c.m_Socket = socket;
+        c.m_Key = key;
+        c.m_Expires = dmTime::GetTime() + ENGINE_IDLE_CONNECTION_TIMEOUT;
+        engine->m_Idle.Push(c);
+    }
+
+    static void ResolverLoop(void* arg)
+    {
+        HttpEngine* engine = (HttpEngine*) arg;
+        while (true)
+        {
+            EngineLookup lookup;
+            {
+                DM_MUTEX_SCOPED_LOCK(engine->m_LookupMutex);
+                while (engine->m_ResolverRun && engine->m_Lookups.Empty())
+                {
+                    dmConditionVariable::Wait(engine->m_LookupCondition, engine->m_LookupMutex);
+                }
+                if (!engine->m_ResolverRun)
+                    break;
+
+                // First in, first out
+                uint32_t left = engine->m_Lookups.Size() - 1;
+                lookup = engine->m_Lookups[0];
+                memmove(engine->m_Lookups.Begin(), engine->m_Lookups.Begin() + 1, left * sizeof(EngineLookup));
+                engine->m_Lookups.SetSize(left);
+            }
+
+            lookup.m_Result = dmSocket::GetHostByNameT(lookup.m_Hostname, &lookup.m_Address, lookup.m_Timeout, &engine->m_Canceled);
+
+            dmMessage::URL url;
+            url.m_Socket = engine->m_Socket;
+            url.m_Path = 0;
+            url.m_Fragment = 0;
+            dmMessage::Post(0, &url, ENGINE_LOOKUP_MESSAGE_ID, 0, 0, &lookup, sizeof(lookup), 0);
+        }
+    }
+
+    static void EngineQueueLookup(HttpEngine* engine, EngineRequest* req)
+    {
+        // Requests to the same host share the lookup
+        for (uint32_t i = 0; i < engine->m_Active.Size(); ++i)
+        {
+            EngineRequest* other = engine->m_Active[i];
+            if (other != req && other->m_State == ENGINE_STATE_RESOLVE && other->m_HostHash == req->m_HostHash)
+                return;
+        }
+
+        EngineLookup lookup;
+        dmStrlCpy(lookup.m_Hostname, req->m_Hostname, sizeof(lookup.m_Hostname));
+        lookup.m_HostHash = req->m_HostHash;
+        lookup.m_Timeout = req->m_Timeout > 0 ? req->m_Timeout : ENGINE_RESOLVE_TIMEOUT;
+        lookup.m_Result = dmSocket::RESULT_OK;
+
+        DM_MUTEX_SCOPED_LOCK(engine->m_LookupMutex);
+        if (engine->m_Lookups.Full())
+        {
+            engine->m_Lookups.OffsetCapacity(16);
+        }
+        engine->m_Lookups.Push(lookup);
+        dmConditionVariable::Signal(engine->m_LookupCondition);
+    }
+
+    static bool EngineOpen(HttpEngine* engine, EngineRequest* req, const dmSocket::Address& address)
+    {
+        req->m_State = ENGINE_STATE_SEND;
+        dmSocket::Result r = dmSocket::New(address.m_family, dmSocket::TYPE_STREAM, dmSocket::PROTOCOL_TCP, &req->m_Socket);
+        if (r == dmSocket::RESULT_OK)
+            r = dmSocket::SetBlocking(req->m_Socket, false);
+        if (r == dmSocket::RESULT_OK)
+            r = dmSocket::SetNoDelay(req->m_Socket, true);
+        if (r == dmSocket::RESULT_OK)
+            r = dmSocket::Connect(req->m_Socket, address, req->m_Port);
+
+        if (r != dmSocket::RESULT_OK)
+        {
+            if (req->m_Socket != dmSocket::INVALID_SOCKET_HANDLE)
+            {
+                dmSocket::Delete(req->m_Socket);
+                req->m_Socket = dmSocket::INVALID_SOCKET_HANDLE;
+            }
+            req->m_SocketResult = r;
+            dmLogError("HTTP request to '%s' failed (socket result: %d)", req->m_Url, r);
+            return false;
+        }
+        return true;
+    }
+
+    // Connects the request, or leaves it in ENGINE_STATE_RESOLVE until the host name lookup has finished
+    static bool EngineConnect(HttpEngine* engine, EngineRequest* req, bool allow_reuse)
+    {
+        uint64_t now = dmTime::GetTime();
+        if (allow_reuse)
+        {
+            for (uint32_t i = 0; i < engine->m_Idle.Size(); ++i)
+            {
+                EngineConnection& c = engine->m_Idle[i];
+                if (c.m_Key == req->m_ConnectionKey && c.m_Expires > now)
+                {
+                    req->m_Socket = c.m_Socket;
+                    req->m_Reused = 1;
+                    engine->m_Idle.EraseSwap(i);
+                    return true;
+                }
+            }
+        }
+
+        req->m_Reused = 0;
+
+        EngineAddress* cached = engine->m_Addresses.Get(req->m_HostHash);
+        if (cached && cached->m_Expires > now)
+        {
+            return EngineOpen(engine, req, cached->m_Address);
+        }
+
+        EngineQueueLookup(engine, req);
+        req->m_State = ENGINE_STATE_RESOLVE;
+        return true;
+    }
+
+    static void EngineFinishRequest(HttpEngine* engine, EngineRequest* req, bool ok);
+
+    static void EngineLookupDone(HttpEngine* engine, const EngineLookup* lookup)
+    {
+        if (lookup->m_Result == dmSocket::RESULT_OK)
+        {
+            EngineAddress entry;
+            entry.m_Address = lookup->m_Address;
+            entry.m_Expires = dmTime::GetTime() + ENGINE_ADDRESS_CACHE_TIMEOUT;
+            EngineAddress* cached = engine->m_Addresses.Get(lookup->m_HostHash);
+            if (cached)
+            {
+                *cached = entry;
+            }
+            else
+            {
+                if (engine->m_Addresses.Full())
+                {
+                    engine->m_Addresses.Clear();
+                }
+                engine->m_Addresses.Put(lookup->m_HostHash, entry);
+            }
+        }
+
+        for (uint32_t i = 0; i < engine->m_Active.Size();)
+        {
+            EngineRequest* req = engine->m_Active[i];
+            if (req->m_State != ENGINE_STATE_RESOLVE || req->m_HostHash != lookup->m_HostHash)
+            {
+                ++i;
+                continue;
+            }
+
+            bool ok;
+            if (lookup->m_Result == dmSocket::RESULT_OK)
+            {
+                ok = EngineOpen(engine, req, lookup->m_Address);
+            }
+            else
+            {
+                req->m_SocketResult = lookup->m_Result;
+                dmLogError("Unable to create HTTP connection to '%s'. No route to host?", req->m_Url);
+                ok = false;
+            }
+
+            if (ok)
+            {
+                ++i;
+            }
+            else
+            {
+                engine->m_Active.EraseSwap(i);
+                EngineFinishRequest(engine, req, false);
+            }
+        }
+    }
+
+    // A reused keep-alive connection might have been closed by the server
+    // before our request reached it. In that case, try once more on a new connection.
+    static bool EngineRetry(HttpEngine* engine, EngineRequest* req)
+    {
+        if (!req->m_Reused || req->m_Retried || req->m_TotalReceived > 0)
+            return false;
+
+        dmSocket::Delete(req->m_Socket);
+        req->m_Socket = dmSocket::INVALID_SOCKET_HANDLE;
+        req->m_Retried = 1;
+        req->m_SocketResult = dmSocket::RESULT_OK;
+        req->m_State = ENGINE_STATE_SEND;
+        req->m_SendOffset = 0;
+        req->m_Receive.SetSize(0);
+        return EngineConnect(engine, req, false);
+    }
+
+    static bool EngineSend(HttpEngine* engine, EngineRequest* req)
+    {
+        dmArray<char>& s = req->m_Send;
+        while (req->m_SendOffset < s.Size())
+        {
+            int sent_bytes = 0;
+            dmSocket::Result r = dmSocket::Send(req->m_Socket, s.Begin() + req->m_SendOffset, s.Size() - req->m_SendOffset, &sent_bytes);
+            if (r == dmSocket::RESULT_WOULDBLOCK || r == dmSocket::RESULT_TRY_AGAIN)
+            {
+                return true;
+            }
+            if (r != dmSocket::RESULT_OK)
+            {
+                req->m_SocketResult = r;
+                return false;
+            }
+            req->m_SendOffset += sent_bytes;
+
+            if (req->m_ReportProgress && req->m_BodyLength > 0 && req->m_SendOffset > req->m_BodyOffset)
+            {
+                EngineReportProgress(engine, req, req->m_SendOffset - req->m_BodyOffset, 0, req->m_BodyLength);
+            }
+        }
+
+        req->m_State = ENGINE_STATE_RECEIVE_HEADERS;
+        return true;
+    }
+
+    static void EngineBeginBody(HttpEngine* engine, EngineRequest* req)
+    {
+        if (req->m_Head || req->m_Status == 204 /* No Content */ || req->m_Status == 304 /* NOT MODIFIED */)
+        {
+            req->m_BodyMode = ENGINE_BODY_NONE;
+        }
+        else if (req->m_Chunked)
+        {
+            req->m_BodyMode = ENGINE_BODY_CHUNKED;
+            req->m_ChunkState = ENGINE_CHUNK_SIZE;
+        }
+        else if (req->m_ContentLength >= 0)
+        {
+            req->m_BodyMode = ENGINE_BODY_LENGTH;
+            req->m_Remaining = (uint32_t) req->m_ContentLength;
+            if (req->m_ResponseFile.m_Path[0] == '\0' || req->m_Status != 200)
+            {
+                req->m_Response.SetCapacity((uint32_t) req->m_ContentLength);
+            }
+        }
+        else
+        {
+            // Without Content-Length the body ends when the server closes
+            // the connection, so keep-alive isn't possible
+            req->m_BodyMode = ENGINE_BODY_UNTIL_CLOSE;
+            req->m_CloseConnection = 1;
+        }
+
+        if (req->m_UseCache && req->m_Status == 200 /* OK */ && req->m_BodyMode != ENGINE_BODY_NONE)
+        {
+            dmHttpCache::Begin(engine->m_Service->m_HttpCache, req->m_URI, req->m_ETag, req->m_MaxAge, &req->m_CacheCreator);
+        }
+
+        req->m_State = ENGINE_STATE_RECEIVE_BODY;
+    }
+
+    static bool EngineProcessBody(HttpEngine* engine, EngineRequest* req, bool eof, bool* done)
+    {
+        dmArray<char>& buffer = req->m_Receive;
+        uint32_t consumed = 0;
+        bool finished = false;
+        bool need_more = false;
+        bool error = false;
+
+        while (!finished && !need_more && !error)
+        {
+            const char* data = buffer.Begin() + consumed;
+            uint32_t left = buffer.Size() - consumed;
+
+            if (req->m_BodyMode == ENGINE_BODY_NONE)
+            {
+                finished = true;
+            }
+            else if (req->m_BodyMode == ENGINE_BODY_UNTIL_CLOSE)
+            {
+                EngineAddContent(engine, req, data, left);
+                consumed += left;
+                finished = eof;
+                need_more = !eof;
+            }
+            else if (req->m_BodyMode == ENGINE_BODY_LENGTH || req->m_ChunkState == ENGINE_CHUNK_DATA)
+            {
+                uint32_t n = dmMath::Min(left, req->m_Remaining);
+                EngineAddContent(engine, req, data, n);
+                consumed += n;
+                req->m_Remaining -= n;
+                if (req->m_Remaining > 0)
+                    need_more = true;
+                else if (req->m_BodyMode == ENGINE_BODY_LENGTH)
+                    finished = true;
+                else
+                    req->m_ChunkState = ENGINE_CHUNK_DATA_END;
+            }
+            else
+            {
+                // Chunk sizes, chunk terminators and trailers are all "\r\n" terminated lines
+                const char* line_end = strstr(data, "\r\n");
+                if (!line_end)
+                {
+                    need_more = true;
+                    error = left > ENGINE_MAX_CHUNK_LINE_SIZE;
+                    continue;
+                }
+                uint32_t line_length = (uint32_t) (line_end - data);
+                consumed += line_length + 2;
+
+                if (req->m_ChunkState == ENGINE_CHUNK_SIZE)
+                {
+                    req->m_Remaining = (uint32_t) strtoul(data, 0, 16);
+                    req->m_ChunkState = req->m_Remaining > 0 ? ENGINE_CHUNK_DATA : ENGINE_CHUNK_TRAILER;
+                }
+                else if (req->m_ChunkState == ENGINE_CHUNK_DATA_END)
+                {
+                    error = line_length != 0;
+                    req->m_ChunkState = ENGINE_CHUNK_SIZE;
+                }
+                else
+                {
+                    finished = line_length == 0;
+                }
+            }
+        }
+
+        // Move unconsumed bytes to buffer start
+        memmove(buffer.Begin(), buffer.Begin() + consumed, buffer.Size() - consumed);
+        buffer.SetSize(buffer.Size() - consumed);
+        *buffer.End() = '\0';
+
+        if (error)
+        {
+            dmLogError("Invalid chunked transfer encoding in response from '%s'", req->m_Url);
+            return false;
+        }
+        if (!finished && eof)
+        {
+            dmLogWarning("Unexpected eof for socket connection.");
+            return false;
+        }
+        if (finished && !buffer.Empty())
+        {
+            // Don't reuse a connection that is out of sync with the server
+            req->m_CloseConnection = 1;
+        }
+
+        *done = finished;
+        return true;
+    }
+
+    static bool EngineReceive(HttpEngine* engine, EngineRequest* req, bool* done)
+    {
+        dmArray<char>& buffer = req->m_Receive;
+        if (buffer.Capacity() - buffer.Size() < ENGINE_RECEIVE_SIZE + 1)
+        {
+            buffer.OffsetCapacity(ENGINE_RECEIVE_SIZE + 1);
+        }
+
+        int recv_bytes = 0;
+        dmSocket::Result r = dmSocket::Receive(req->m_Socket, buffer.End(), buffer.Capacity() - buffer.Size() - 1, &recv_bytes);
+        if (r == dmSocket::RESULT_WOULDBLOCK || r == dmSocket::RESULT_TRY_AGAIN)
+        {
+            return true;
+        }
+        if (r != dmSocket::RESULT_OK)
+        {
+            req->m_SocketResult = r;
+            return false;
+        }
+
+        req->m_TotalReceived += recv_bytes;
+        buffer.SetSize(buffer.Size() + recv_bytes);
+        // NOTE: We have an extra byte for null-termination so no buffer overrun here.
+        *buffer.End() = '\0';
+        bool eof = recv_bytes == 0;
+
+        if (req->m_State == ENGINE_STATE_RECEIVE_HEADERS)
+        {
+            if (eof && buffer.Empty())
+            {
+                req->m_SocketResult = dmSocket::RESULT_CONNRESET;
+                return false;
+            }
+
+            dmHttpClient::ParseResult parse_res = dmHttpClient::ParseHeader(buffer.Begin(), req, eof, &EngineHandleVersion, &EngineHandleHeader, &EngineHandleContent);
+            if (parse_res == dmHttpClient::PARSE_RESULT_NEED_MORE_DATA)
+            {
+                if (eof)
+                {
+                    dmLogWarning("Unexpected eof for socket connection.");
+                    return false;
+                }
+                if (buffer.Size() >= ENGINE_MAX_HEADER_SIZE)
+                {
+                    dmLogError("Too large HTTP headers in response from '%s'", req->m_Url);
+                    return false;
+                }
+                return true;
+            }
+            else if (parse_res == dmHttpClient::PARSE_RESULT_SYNTAX_ERROR)
+            {
+                dmLogError("Invalid HTTP headers in response from '%s'", req->m_Url);
+                return false;
+            }
+
+            // Keep only the content that followed the headers
+            uint32_t offset = dmMath::Min(req->m_ContentOffset, buffer.Size());
+            memmove(buffer.Begin(), buffer.Begin() + offset, buffer.Size() - offset);
+            buffer.SetSize(buffer.Size() - offset);
+            *buffer.End() = '\0';
+
+            EngineBeginBody(engine, req);
+        }
+
+        return EngineProcessBody(engine, req, eof, done);
+    }
+
+    static void EngineFinishRequest(HttpEngine* engine, EngineRequest* req, bool ok)
+    {
+        dmHttpCache::HCache cache = engine->m_Service->m_HttpCache;
+        if (req->m_CacheCreator)
+        {
+            if (!ok)
+            {
+                dmHttpCache::SetError(cache, req->m_CacheCreator);
+            }
+            dmHttpCache::End(cache, req->m_CacheCreator);
+            req->m_CacheCreator = 0;
+        }
+
+        if (ok && req->m_Status == 304 /* NOT MODIFIED */ && req->m_UseCache)
+        {
+            char cache_etag[64];
+            ok = dmHttpCache::GetETag(cache, req->m_URI, cache_etag, sizeof(cache_etag)) == dmHttpCache::RESULT_OK;
+            if (ok && req->m_ETag[0] != '\0' && strcmp(cache_etag, req->m_ETag) != 0)
+            {
+                dmLogError("ETag mismatch (%s vs %s)", cache_etag, req->m_ETag);
+                ok = false;
+            }
+            ok = ok && EngineReadCache(engine, req, cache_etag);
+            if (ok)
+            {
+                dmHttpCache::SetVerified(cache, req->m_URI, true);
+            }
+        }
+
+        if (!ok)
+        {
+            // Failed requests are reported with status 0, the same as from the blocking workers
+            dmLogError("HTTP request to '%s' failed (socket result: %d)", req->m_Url, req->m_SocketResult);
+        }
+
+        bool streamed = ok && req->m_Status == 200 && req->m_ResponseFile.m_Path[0] != '\0';
+        bool streamed_ok = streamed && ResponseFileCommit(&req->m_ResponseFile);
+
+        SendResponse(&req->m_Requester, req->m_UserData1, req->m_UserData2, ok ? req->m_Status : 0,
+                     req->m_Headers.Begin(), req->m_Headers.Size(), req->m_Response.Begin(), req->m_Response.Size(), req->m_ResponseFile.m_Path,
+                     streamed, streamed_ok);
+
+        if (ok && !req->m_CloseConnection && req->m_Socket != dmSocket::INVALID_SOCKET_HANDLE)
+        {
+            EngineReleaseConnection(engine, req->m_ConnectionKey, req->m_Socket);
+            req->m_Socket = dmSocket::INVALID_SOCKET_HANDLE;
+        }
+        EngineDeleteRequest(req);
+    }
+
+    static void EngineStartPending(HttpEngine* engine)
+    {
+        uint32_t started = 0;
+        while (started < engine->m_Pending.Size() && !engine->m_Active.Full())
+        {
+            EngineRequest* req = engine->m_Pending[started++];
+            req->m_Start = dmTime::GetTime();
+            if (EngineConnect(engine, req, true))
+            {
+                engine->m_Active.Push(req);
+            }
+            else
+            {
+                SendResponse(&req->m_Requester, req->m_UserData1, req->m_UserData2, 0, 0, 0, 0, 0, req->m_ResponseFile.m_Path);
+                EngineDeleteRequest(req);
+            }
+        }
+
+        if (started > 0)
+        {
+            uint32_t left = engine->m_Pending.Size() - started;
+            memmove(engine->m_Pending.Begin(), engine->m_Pending.Begin() + started, left * sizeof(EngineRequest*));
+            engine->m_Pending.SetSize(left);
+        }
+    }
+
+    static bool EngineIsSet(dmSocket::Selector* selector, dmSocket::SelectorKind kind, dmSocket::Socket socket)
+    {
+        // Errors and hang-ups are reported regardless of what we asked for
+        return dmSocket::SelectorIsSet(selector, kind, socket) || dmSocket::SelectorIsSet(selector, dmSocket::SELECTOR_KIND_EXCEPT, socket);
+    }
+
+    static void EnginePoll(HttpEngine* engine)
+    {
+        dmSocket::Selector* selector = &engine->m_Selector;
+        dmSocket::SelectorZero(selector);
+        uint32_t socket_count = 0;
+        for (uint32_t i = 0; i < engine->m_Active.Size(); ++i)
+        {
+            EngineRequest* req = engine->m_Active[i];
+            if (req->m_State == ENGINE_STATE_RESOLVE)
+                continue;
+            dmSocket::SelectorSet(selector, req->m_State == ENGINE_STATE_SEND ? dmSocket::SELECTOR_KIND_WRITE : dmSocket::SELECTOR_KIND_READ, req->m_Socket);
+            ++socket_count;
+        }
+
+        // Requests waiting for a lookup are woken up by the lookup message instead
+        if (socket_count > 0)
+        {
+            // Idle connections aren't expecting any data. If they become readable, the server has closed them.
+            for (uint32_t i = 0; i < engine->m_Idle.Size(); ++i)
+            {
+                dmSocket::SelectorSet(selector, dmSocket::SELECTOR_KIND_READ, engine->m_Idle[i].m_Socket);
+            }
+
+            dmSocket::Result sr = dmSocket::Select(selector, ENGINE_SELECT_TIMEOUT);
+            if (sr != dmSocket::RESULT_OK && sr != dmSocket::RESULT_WOULDBLOCK)
+            {
+                dmLogError("Failed to poll http sockets (%d)", sr);
+                dmSocket::SelectorZero(selector);
+            }
+        }
+
+        uint64_t now = dmTime::GetTime();
+
+        for (uint32_t i = 0; i < engine->m_Idle.Size();)
+        {
+            EngineConnection& c = engine->m_Idle[i];
+            if (now >= c.m_Expires || EngineIsSet(selector, dmSocket::SELECTOR_KIND_READ, c.m_Socket))
+            {
+                dmSocket::Delete(c.m_Socket);
+                engine->m_Idle.EraseSwap(i);
+            }
+            else
+            {
+                ++i;
+            }
+        }
+
+        for (uint32_t i = 0; i < engine->m_Active.Size();)
+        {
+            EngineRequest* req = engine->m_Active[i];
+            bool ok = true;
+            bool done = false;
+
+            dmSocket::SelectorKind kind = req->m_State == ENGINE_STATE_SEND ? dmSocket::SELECTOR_KIND_WRITE : dmSocket::SELECTOR_KIND_READ;
+            if (req->m_State != ENGINE_STATE_RESOLVE && EngineIsSet(selector, kind, req->m_Socket))
+            {
+                if (req->m_State == ENGINE_STATE_SEND)
+                    ok = EngineSend(engine, req);
+                else
+                    ok = EngineReceive(engine, req, &done);
+
+                if (!ok && EngineRetry(engine, req))
+                    ok = true;
+            }
+
+            if (ok && !done && req->m_Timeout > 0 && now - req->m_Start >= req->m_Timeout)
+            {
+                req->m_SocketResult = dmSocket::RESULT_WOULDBLOCK;
+                ok = false;
+            }
+
+            if (!ok || done)
+            {
+                engine->m_Active.EraseSwap(i);
+                EngineFinishRequest(engine, req, ok);
+            }
+            else
+            {
+                ++i;
+            }
+        }
+    }
+
     void HandleRequest(Worker* worker, const dmMessage::URL* requester, uintptr_t userdata1, uintptr_t userdata2, dmHttpDDF::HttpRequest* request)
     {
         dmURI::Parts url;
         request->m_Method = (const char*) ((uintptr_t) request + (uintptr_t) request->m_Method);
         request->m_Url = (const char*) ((uintptr_t) request + (uintptr_t) request->m_Url);
+        if (request->m_Path)
+            request->m_Path = (const char*) ((uintptr_t) request + (uintptr_t) request->m_Path);
         dmURI::Result ur =  dmURI::Parse(request->m_Url, &url);
         if (ur != dmURI::RESULT_OK)
         {
@@ -262,7 +1398,8 @@ namespace dmHttpService
         worker->m_Response.SetCapacity(DEFAULT_RESPONSE_BUFFER_SIZE);
         worker->m_Headers.SetSize(0);
         worker->m_Headers.SetCapacity(DEFAULT_HEADER_BUFFER_SIZE);
-        worker->m_Filepath = request->m_Path;
+        worker->m_BytesReceived = 0;
+        ResponseFileInit(&worker->m_ResponseFile, request->m_Path);
 
         if (request->m_ReportProgress)
         {
@@ -281,15 +1418,18 @@ namespace dmHttpService
             dmHttpClient::Result r = dmHttpClient::Request(worker->m_Client, request->m_Method, url.m_Path);
 
             if (r == dmHttpClient::RESULT_OK || r == dmHttpClient::RESULT_NOT_200_OK) {
-                SendResponse(requester, userdata1, userdata2, worker->m_Status, worker->m_Headers.Begin(), worker->m_Headers.Size(), worker->m_Response.Begin(), worker->m_Response.Size(), worker->m_Filepath);
+                bool streamed = worker->m_Status == 200 && worker->m_ResponseFile.m_Path[0] != '\0';
+                bool streamed_ok = streamed && ResponseFileCommit(&worker->m_ResponseFile);
+                SendResponse(requester, userdata1, userdata2, worker->m_Status, worker->m_Headers.Begin(), worker->m_Headers.Size(), worker->m_Response.Begin(), worker->m_Response.Size(), worker->m_ResponseFile.m_Path, streamed, streamed_ok);
             } else {
                 // TODO: Error codes to lua?
                 dmLogError("HTTP request to '%s' failed (http result: %d  socket result: %d)", request->m_Url, r, GetLastSocketResult(worker->m_Client));
-                SendResponse(requester, userdata1, userdata2, 0, worker->m_Headers.Begin(), worker->m_Headers.Size(), worker->m_Response.Begin(), worker->m_Response.Size(), worker->m_Filepath);
+                SendResponse(requester, userdata1, userdata2, 0, worker->m_Headers.Begin(), worker->m_Headers.Size(), worker->m_Response.Begin(), worker->m_Response.Size(), worker->m_ResponseFile.m_Path);
             }
+            ResponseFileReset(&worker->m_ResponseFile);
         } else {
             // TODO: Error codes to lua?
-            SendResponse(requester, userdata1, userdata2, 0, worker->m_Headers.Begin(), worker->m_Headers.Size(), worker->m_Response.Begin(), worker->m_Response.Size(), worker->m_Filepath);
+            SendResponse(requester, userdata1, userdata2, 0, worker->m_Headers.Begin(), worker->m_Headers.Size(), worker->m_Response.Begin(), worker->m_Response.Size(), worker->m_ResponseFile.m_Path);
             dmLogError("Unable to create HTTP connection to '%s'. No route to host?", request->m_Url);
         }
     }
@@ -338,22 +1478,111 @@ namespace dmHttpService
         }
     }
 
+    static void EngineDispatch(dmMessage::Message *message, void* user_ptr)
+    {
+        HttpEngine* engine = (HttpEngine*) user_ptr;
+        if (!engine->m_Run) {
+            return;
+        }
+
+        if (message->m_Descriptor == (uintptr_t) dmHttpDDF::HttpRequest::m_DDFDescriptor)
+        {
+            dmHttpDDF::HttpRequest* request = (dmHttpDDF::HttpRequest*) &message->m_Data[0];
+            EngineRequest* req = EngineNewRequest(engine, &message->m_Sender, 0, message->m_UserData2, request);
+            free((void*) request->m_Headers);
+            free((void*) request->m_Request);
+
+            if (req)
+            {
+                if (engine->m_Pending.Full())
+                {
+                    engine->m_Pending.OffsetCapacity(ENGINE_MAX_ACTIVE_REQUESTS);
+                }
+                engine->m_Pending.Push(req);
+            }
+        }
+        else if (message->m_Id == ENGINE_LOOKUP_MESSAGE_ID)
+        {
+            EngineLookupDone(engine, (const EngineLookup*) &message->m_Data[0]);
+        }
+        else if (message->m_Descriptor == (uintptr_t) dmHttpDDF::StopHttp::m_DDFDescriptor)
+        {
+            engine->m_Run = false;
+        }
+    }
+
+    static bool EngineHasSockets(HttpEngine* engine)
+    {
+        for (uint32_t i = 0; i < engine->m_Active.Size(); ++i)
+        {
+            if (engine->m_Active[i]->m_State != ENGINE_STATE_RESOLVE)
+                return true;
+        }
+        return false;
+    }
+
+    static void EngineLoop(void* arg)
+    {
+        HttpEngine* engine = (HttpEngine*) arg;
+        while (engine->m_Run)
+        {
+            // Without any sockets to poll, the only thing to wait for is a message: a new request,
+            // or a finished lookup. NOTE: A request that shares the lookup of another request
+            // times out when that lookup has finished at the latest.
+            bool can_start = !engine->m_Pending.Empty() && !engine->m_Active.Full();
+            if (!can_start && !EngineHasSockets(engine))
+            {
+                dmMessage::DispatchBlocking(engine->m_Socket, &EngineDispatch, engine);
+            }
+            else
+            {
+                dmMessage::Dispatch(engine->m_Socket, &EngineDispatch, engine);
+            }
+
+            if (!engine->m_Run)
+                break;
+
+            EngineStartPending(engine);
+            if (!engine->m_Active.Empty())
+            {
+                EnginePoll(engine);
+            }
+        }
+    }
+
+    // Only plain http requests are handled by the engine, as the ssl sockets are blocking
+    static bool IsEngineRequest(dmMessage::Message *message)
+    {
+        if (message->m_Descriptor != (uintptr_t) dmHttpDDF::HttpRequest::m_DDFDescriptor)
+            return false;
+        const dmHttpDDF::HttpRequest* request = (const dmHttpDDF::HttpRequest*) &message->m_Data[0];
+        const char* url = (const char*) ((uintptr_t) request + (uintptr_t) request->m_Url);
+        return strncmp(url, "http://", 7) == 0;
+    }
+
+    static void Forward(dmMessage::Message *message, dmMessage::HSocket socket)
+    {
+        dmMessage::URL r = message->m_Receiver;
+        r.m_Socket = socket;
+        dmMessage::Post(&message->m_Sender,
+                        &r,
+                        message->m_Id,
+                        message->m_UserData1,
+                        message->m_UserData2,
+                        message->m_Descriptor,
+                        message->m_Data,
+                        message->m_DataSize, 0);
+    }
+
     void LoadBalance(dmMessage::Message *message, void* user_ptr)
     {
         HttpService* service = (HttpService*) user_ptr;
         if (message->m_Descriptor == (uintptr_t) dmHttpDDF::StopHttp::m_DDFDescriptor) {
             service->m_Run = false;
+        } else if (service->m_Engine && IsEngineRequest(message)) {
+            Forward(message, service->m_Engine->m_Socket);
         } else {
-            dmMessage::URL r = message->m_Receiver;
-            r.m_Socket = service->m_Workers[service->m_LoadBalanceCount % service->m_Workers.Size()]->m_Socket;
-            dmMessage::Post(&message->m_Sender,
-                            &r,
-                            message->m_Id,
-                            message->m_UserData1,
-                            message->m_UserData2,
-                            message->m_Descriptor,
-                            message->m_Data,
-                            message->m_DataSize, 0);
+            Forward(message, service->m_Workers[service->m_LoadBalanceCount % service->m_Workers.Size()]->m_Socket);
             service->m_LoadBalanceCount++;
         }
     }
@@ -444,6 +1673,26 @@ namespace dmHttpService
             worker->m_Thread = t;
         }
 
+        HttpEngine* engine = new HttpEngine();
+        dmMessage::NewSocket("@__http_engine", &engine->m_Socket);
+        engine->m_Service = service;
+        engine->m_Active.SetCapacity(ENGINE_MAX_ACTIVE_REQUESTS);
+        engine->m_Pending.SetCapacity(ENGINE_MAX_ACTIVE_REQUESTS);
+        engine->m_Idle.SetCapacity(ENGINE_MAX_IDLE_CONNECTIONS);
+        engine->m_Addresses.SetCapacity(ENGINE_ADDRESS_CACHE_SIZE / 2 + 1, ENGINE_ADDRESS_CACHE_SIZE);
+        engine->m_Run = true;
+        engine->m_Canceled = 0;
+        engine->m_LookupMutex = dmMutex::New();
+        engine->m_LookupCondition = dmConditionVariable::New();
+        engine->m_Lookups.SetCapacity(16);
+        engine->m_ResolverRun = true;
+        for (uint32_t i = 0; i < ENGINE_RESOLVER_COUNT; ++i)
+        {
+            engine->m_Resolvers[i] = dmThread::New(&ResolverLoop, THREAD_STACK_SIZE, engine, "http_resolve");
+        }
+        engine->m_Thread = dmThread::New(&EngineLoop, THREAD_STACK_SIZE, engine, "http_engine");
+        service->m_Engine = engine;
+
         dmThread::Thread t = dmThread::New(&LoadBalancer, THREAD_STACK_SIZE, service, "http_balance");
         service->m_Balancer = t;
 
@@ -477,6 +1726,11 @@ namespace dmHttpService
             worker->m_Canceled = 1;
         }
 
+        HttpEngine* engine = http_service->m_Engine;
+        url.m_Socket = engine->m_Socket;
+        dmMessage::Post(0, &url, 0, 0, (uintptr_t) dmHttpDDF::StopHttp::m_DDFDescriptor, 0, 0, 0);
+        engine->m_Canceled = 1;
+
         for (uint32_t i = 0; i < http_service->m_Workers.Size(); ++i)
         {
             dmHttpService::Worker* worker = http_service->m_Workers[i];
@@ -497,6 +1751,43 @@ namespace dmHttpService
             delete worker;
         }
 
+        dmThread::Join(engine->m_Thread);
+
+        // The canceled flag makes any ongoing lookup return
+        {
+            DM_MUTEX_SCOPED_LOCK(engine->m_LookupMutex);
+            engine->m_ResolverRun = false;
+            dmConditionVariable::Broadcast(engine->m_LookupCondition);
+        }
+        for (uint32_t i = 0; i < ENGINE_RESOLVER_COUNT; ++i)
+        {
+            dmThread::Join(engine->m_Resolvers[i]);
+        }
+        dmConditionVariable::Delete(engine->m_LookupCondition);
+        dmMutex::Delete(engine->m_LookupMutex);
+
+        dmMessage::DeleteSocket(engine->m_Socket);
+        // Unfinished requests are dropped without a response, same as for the workers
+        for (uint32_t i = 0; i < engine->m_Active.Size(); ++i)
+        {
+            EngineRequest* req = engine->m_Active[i];
+            if (req->m_CacheCreator)
+            {
+                dmHttpCache::SetError(http_service->m_HttpCache, req->m_CacheCreator);
+                dmHttpCache::End(http_service->m_HttpCache, req->m_CacheCreator);
+            }
+            EngineDeleteRequest(req);
+        }
+        for (uint32_t i = 0; i < engine->m_Pending.Size(); ++i)
+        {
+            EngineDeleteRequest(engine->m_Pending[i]);
+        }
+        for (uint32_t i = 0; i < engine->m_Idle.Size(); ++i)
+        {
+            dmSocket::Delete(engine->m_Idle[i].m_Socket);
+        }
+        delete engine;
+
         dmMessage::DeleteSocket(http_service->m_Socket);
         if (http_service->m_HttpCache)
             dmHttpCache::Close(http_service->m_HttpCache);
@@ -21,6 +21,7 @@
 
 #include <dlib/dstrings.h>
 #include <dlib/math.h>
+#include <dlib/memory.h>
 #include <dlib/message.h>
 #include <dlib/log.h>
 #include <dlib/path.h>
@@ -123,7 +124,7 @@ namespace dmScript
         uint32_t size;
         GetLuaSource(source, &buf, &size);
 
-        module.m_Script = (char*) malloc(size);
+        module.m_Script = (char*) dmMemory::Malloc(dmMemory::TAG_SCRIPT, size);
         module.m_ScriptSize = size;
         memcpy(module.m_Script, buf, size);
 
@@ -160,7 +161,7 @@ namespace dmScript
         uint32_t size;
         GetLuaSource(source, &buf, &size);
 
-        module->m_Script = (char*) realloc(module->m_Script, size);
+        module->m_Script = (char*) dmMemory::Realloc(dmMemory::TAG_SCRIPT, module->m_Script, size);
         module->m_ScriptSize = size;
         memcpy(module->m_Script, buf, size);
 
@@ -190,7 +191,7 @@ namespace dmScript
         if (value->m_Resource != 0) {
             dmResource::Release((dmResource::HFactory)context, value->m_Resource);
         }
-        free(value->m_Script);
+        dmMemory::Free(dmMemory::TAG_SCRIPT, value->m_Script);
         free(value->m_Name);
         free(value->m_Filename);
     }
@@ -0,0 +1,236 @@
+// Copyright 2020-2024 The Defold Foundation
+// Copyright 2014-2020 King
+// Copyright 2009-2014 Ragnar Svensson, Christian Murray
+// Licensed under the Defold License version 1.0 (the "License"); you may not use
+// this file except in compliance with the License.
+//
+// You may obtain a copy of the License, together with FAQs at
+// https://www.defold.com/license
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include <jc_test/jc_test.h>
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <testmain/testmain.h>
+#include <dlib/configfile.h>
+#include <dlib/dstrings.h>
+#include <dlib/log.h>
+#include <dlib/message.h>
+#include <dlib/socket.h>
+#include <dlib/sys.h>
+#include <dlib/testutil.h>
+#include <dlib/time.h>
+
+#include "script/http_ddf.h"
+#include "http_service.h"
+
+static int g_HttpPort = 9001;
+char g_HttpAddress[128] = "localhost";
+
+// The expected outcome of each kind of request in the load test
+struct LoadRequest
+{
+    const char* m_Method;
+    const char* m_Path;        // Appended to the server address, or a full url if it starts with "http"
+    const char* m_Data;
+    float       m_Timeout;     // Seconds, 0 for no timeout
+    int         m_Status;      // 0 for failed requests
+    uint32_t    m_ResponseLength;
+};
+
+static const LoadRequest LOAD_REQUESTS[] =
+{
+    {"GET",  "/",              0,      0.0f, 200, 5},        // "Hello", read until close
+    {"GET",  "/size/100",      0,      0.0f, 200, 100},      // Content-Length
+    {"GET",  "/size/1048576",  0,      0.0f, 200, 1048576},  // Large body
+    {"POST", "/",              "ping", 0.0f, 200, 8},        // "PONGping"
+    {"HEAD", "/",              0,      0.0f, 200, 0},        // Content-Length without a body
+    {"GET",  "/missing",       0,      0.0f, 404, 0},
+    {"GET",  "/sleep/2",       0,      0.2f, 0,   0},        // Timeout
+    {"GET",  "http://localhost:1/", 0, 1.0f, 0,   0},        // Connection refused, or dropped
+};
+
+static const uint32_t LOAD_REQUEST_KINDS = sizeof(LOAD_REQUESTS) / sizeof(LOAD_REQUESTS[0]);
+
+class HttpServiceTest : public jc_test_base_class
+{
+public:
+    dmHttpService::HHttpService m_Service;
+    dmMessage::URL              m_Requester;
+    dmArray<int>                m_Statuses;
+    dmArray<uint32_t>           m_ResponseLengths;
+    uint32_t                    m_ResponseCount;
+
+protected:
+    virtual void SetUp()
+    {
+        dmHttpService::Params params;
+        params.m_UseHttpCache = 0;
+        m_Service = dmHttpService::New(&params);
+        ASSERT_NE((dmHttpService::HHttpService) 0, m_Service);
+
+        dmMessage::ResetURL(&m_Requester);
+        ASSERT_EQ(dmMessage::RESULT_OK, dmMessage::NewSocket("test_http_service", &m_Requester.m_Socket));
+        m_ResponseCount = 0;
+    }
+
+    virtual void TearDown()
+    {
+        dmHttpService::Delete(m_Service);
+        dmMessage::DeleteSocket(m_Requester.m_Socket);
+    }
+
+    void Post(uint32_t index, const LoadRequest* request)
+    {
+        char url[256];
+        if (strncmp(request->m_Path, "http", 4) == 0)
+            dmStrlCpy(url, request->m_Path, sizeof(url));
+        else
+            dmSnPrintf(url, sizeof(url), "http://%s:%d%s", g_HttpAddress, g_HttpPort, request->m_Path);
+
+        uint32_t method_len = strlen(request->m_Method);
+        uint32_t url_len = strlen(url);
+
+        // The strings are stored after the message, and referenced by their offsets
+        char buf[sizeof(dmHttpDDF::HttpRequest) + 16 + sizeof(url)];
+        char* string_buf = buf + sizeof(dmHttpDDF::HttpRequest);
+        dmStrlCpy(string_buf, request->m_Method, method_len + 1);
+        dmStrlCpy(string_buf + method_len + 1, url, url_len + 1);
+
+        // The service frees the request data
+        char* request_data = 0;
+        uint32_t request_data_length = 0;
+        if (request->m_Data)
+        {
+            request_data_length = strlen(request->m_Data);
+            request_data = (char*) malloc(request_data_length);
+            memcpy(request_data, request->m_Data, request_data_length);
+        }
+
+        dmHttpDDF::HttpRequest* msg = (dmHttpDDF::HttpRequest*) buf;
+        memset(msg, 0, sizeof(*msg));
+        msg->m_Method = (const char*) (sizeof(*msg));
+        msg->m_Url = (const char*) (sizeof(*msg) + method_len + 1);
+        msg->m_Request = (uint64_t) request_data;
+        msg->m_RequestLength = request_data_length;
+        msg->m_Timeout = (uint64_t) (request->m_Timeout * 1000000.0f);
+        msg->m_ChunkedTransfer = true;
+
+        dmMessage::URL receiver;
+        dmMessage::ResetURL(&receiver);
+        receiver.m_Socket = dmHttpService::GetSocket(m_Service);
+
+        uint32_t post_len = sizeof(*msg) + method_len + 1 + url_len + 1;
+        dmMessage::Result r = dmMessage::Post(&m_Requester, &receiver, dmHttpDDF::HttpRequest::m_DDFHash, 0, index,
+                                              (uintptr_t) dmHttpDDF::HttpRequest::m_DDFDescriptor, buf, post_len, 0);
+        ASSERT_EQ(dmMessage::RESULT_OK, r);
+    }
+};
+
+static void DispatchResponse(dmMessage::Message* message, void* user_ptr)
+{
+    HttpServiceTest* test = (HttpServiceTest*) user_ptr;
+    if (message->m_Descriptor != (uintptr_t) dmHttpDDF::HttpResponse::m_DDFDescriptor)
+        return;
+
+    dmHttpDDF::HttpResponse* response = (dmHttpDDF::HttpResponse*) &message->m_Data[0];
+    uint32_t index = (uint32_t) message->m_UserData2;
+    test->m_Statuses[index] = response->m_Status;
+    test->m_ResponseLengths[index] = response->m_ResponseLength;
+    test->m_ResponseCount++;
+}
+
+// Sends more requests than the http service keeps in flight, mixing successful, failed and
+// slow requests, and checks that every request gets the expected response
+TEST_F(HttpServiceTest, Load)
+{
+    const uint32_t request_count = 480;
+    m_Statuses.SetCapacity(request_count);
+    m_Statuses.SetSize(request_count);
+    m_ResponseLengths.SetCapacity(request_count);
+    m_ResponseLengths.SetSize(request_count);
+    for (uint32_t i = 0; i < request_count; ++i)
+    {
+        m_Statuses[i] = -1;
+        m_ResponseLengths[i] = 0;
+    }
+
+    uint64_t start = dmTime::GetTime();
+    for (uint32_t i = 0; i < request_count; ++i)
+    {
+        Post(i, &LOAD_REQUESTS[i % LOAD_REQUEST_KINDS]);
+    }
+
+    while (m_ResponseCount < request_count)
+    {
+        dmSys::PumpMessageQueue();
+        dmMessage::Dispatch(m_Requester.m_Socket, DispatchResponse, this);
+        dmTime::Sleep(1000);
+
+        if ((dmTime::GetTime() - start) / 1000000 > 60)
+        {
+            dmLogError("The test timed out with %u of %u responses", m_ResponseCount, request_count);
+            ASSERT_TRUE(0);
+        }
+    }
+    uint64_t elapsed = dmTime::GetTime() - start;
+    printf("%u http requests in %.2f ms (%.0f requests/s)\n", request_count, elapsed / 1000.0, request_count / (elapsed / 1000000.0));
+
+    for (uint32_t i = 0; i < request_count; ++i)
+    {
+        const LoadRequest& request = LOAD_REQUESTS[i % LOAD_REQUEST_KINDS];
+        ASSERT_EQ(request.m_Status, m_Statuses[i]);
+        if (request.m_Status != 0)
+        {
+            ASSERT_EQ(request.m_ResponseLength, m_ResponseLengths[i]);
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    TestMainPlatformInit();
+    dmLog::LogParams params;
+    dmLog::LogInitialize(&params);
+    dmSocket::Initialize();
+
+    if (argc > 1)
+    {
+        char path[512];
+        dmTestUtil::MakeHostPath(path, sizeof(path), argv[1]);
+
+        dmConfigFile::HConfig config;
+        if (dmConfigFile::Load(path, argc, (const char**)argv, &config) != dmConfigFile::RESULT_OK)
+        {
+            dmLogError("Could not read config file '%s'", argv[1]);
+            return 1;
+        }
+        dmTestUtil::GetSocketsFromConfig(config, &g_HttpPort, 0, 0);
+        if (!dmTestUtil::GetIpFromConfig(config, g_HttpAddress, sizeof(g_HttpAddress))) {
+            dmLogError("Failed to get server ip!");
+        } else {
+            dmLogInfo("Server ip: %s:%d", g_HttpAddress, g_HttpPort);
+        }
+
+        dmConfigFile::Delete(config);
+    }
+    else
+    {
+        dmLogError("No config file specified!");
+        return 1;
+    }
+
+    jc_test_init(&argc, argv);
+    int ret = jc_test_run_all();
+
+    dmSocket::Finalize();
+    dmLog::LogFinalize();
+    return ret;
+}
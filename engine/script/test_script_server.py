@@ -53,6 +53,15 @@ class Handler(BaseHTTPRequestHandler):
             sys.stdout.flush()
             time.sleep( sleeptime )
             to_send = "slept for %f" % sleeptime
+
+        elif self.path.startswith('/size/'):
+            # Sends a body of the requested size, with a content length
+            try:
+                size = int(self.path.split('/')[2])
+            except:
+                size = 0
+            to_send = 'a' * size
+            extra_headers = {'Content-Length': size}
         else:
             try:
                 import test_script_server_plugin
@@ -106,6 +115,8 @@ class Handler(BaseHTTPRequestHandler):
 
 class ThreadedHTTPServer(ThreadingMixIn, HTTPServer):
     """ """
+    # The http service opens many connections at once (see test_script_http_service.cpp)
+    request_queue_size = 128
 
 
 class Server(Thread):
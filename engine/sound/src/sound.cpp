@@ -19,6 +19,7 @@
 #include <dlib/index_pool.h>
 #include <dlib/log.h>
 #include <dlib/math.h>
+#include <dlib/memory.h>
 #include <dlib/mutex.h>
 #include <dlib/profile.h>
 #include <dlib/thread.h>
@@ -297,7 +298,7 @@ namespace dmSound
         group->m_NameHash = group_hash;
         group->m_Gain.Reset(1.0f);
         size_t mix_buffer_size = sound->m_FrameCount * sizeof(float) * SOUND_MAX_MIX_CHANNELS;
-        group->m_MixBuffer = (float*) malloc(mix_buffer_size);
+        group->m_MixBuffer = (float*) dmMemory::Malloc(dmMemory::TAG_SOUND, mix_buffer_size);
         memset(group->m_MixBuffer, 0, mix_buffer_size);
         sound->m_GroupMap.Put(group_hash, index);
         return index;
@@ -366,7 +367,7 @@ namespace dmSound
             instance->m_SoundDataIndex = 0xffff;
             // NOTE: +1 for "over-fetch" when up-sampling
             // NOTE: and x SOUND_MAX_SPEED for potential pitch range
-            instance->m_Frames = malloc((params->m_FrameCount * SOUND_MAX_SPEED + 1) * sizeof(int16_t) * SOUND_MAX_MIX_CHANNELS);
+            instance->m_Frames = dmMemory::Malloc(dmMemory::TAG_SOUND, (params->m_FrameCount * SOUND_MAX_SPEED + 1) * sizeof(int16_t) * SOUND_MAX_MIX_CHANNELS);
             instance->m_FrameCount = 0;
             instance->m_Speed = 1.0f;
         }
@@ -382,7 +383,7 @@ namespace dmSound
         sound->m_MixRate = device_info.m_MixRate;
         sound->m_FrameCount = params->m_FrameCount;
         for (int i = 0; i < SOUND_OUTBUFFER_COUNT; ++i) {
-            sound->m_OutBuffers[i] = (int16_t*) malloc(params->m_FrameCount * sizeof(int16_t) * SOUND_MAX_MIX_CHANNELS);
+            sound->m_OutBuffers[i] = (int16_t*) dmMemory::Malloc(dmMemory::TAG_SOUND, params->m_FrameCount * sizeof(int16_t) * SOUND_MAX_MIX_CHANNELS);
         }
         sound->m_NextOutBuffer = 0;
 
@@ -436,18 +437,18 @@ namespace dmSound
                 SoundInstance* instance = &sound->m_Instances[i];
                 instance->m_Index = 0xffff;
                 instance->m_SoundDataIndex = 0xffff;
-                free(instance->m_Frames);
+                dmMemory::Free(dmMemory::TAG_SOUND, instance->m_Frames);
                 memset(instance, 0, sizeof(*instance));
             }
 
             for (int i = 0; i < SOUND_OUTBUFFER_COUNT; ++i) {
-                free((void*) sound->m_OutBuffers[i]);
+                dmMemory::Free(dmMemory::TAG_SOUND, (void*) sound->m_OutBuffers[i]);
             }
 
             for (uint32_t i = 0; i < MAX_GROUPS; i++) {
                 SoundGroup* g = &sound->m_Groups[i];
                 if (g->m_MixBuffer) {
-                    free((void*) g->m_MixBuffer);
+                    dmMemory::Free(dmMemory::TAG_SOUND, (void*) g->m_MixBuffer);
                 }
             }
 
@@ -472,8 +473,8 @@ namespace dmSound
 
     static Result SetSoundDataNoLock(HSoundData sound_data, const void* sound_buffer, uint32_t sound_buffer_size)
     {
-        free(sound_data->m_Data);
-        sound_data->m_Data = malloc(sound_buffer_size);
+        dmMemory::Free(dmMemory::TAG_SOUND, sound_data->m_Data);
+        sound_data->m_Data = dmMemory::Malloc(dmMemory::TAG_SOUND, sound_buffer_size);
         sound_data->m_Size = sound_buffer_size;
         memcpy(sound_data->m_Data, sound_buffer, sound_buffer_size);
         return RESULT_OK;
@@ -535,7 +536,7 @@ namespace dmSound
         }
 
         if (sound_data->m_Data != 0x0)
-            free((void*) sound_data->m_Data);
+            dmMemory::Free(dmMemory::TAG_SOUND, (void*) sound_data->m_Data);
 
         SoundSystem* sound = g_SoundSystem;
         sound->m_SoundDataPool.Push(sound_data->m_Index);